@@ -0,0 +1,207 @@
+#include "Clip.hpp"
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <opencv2/highgui/highgui.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+
+namespace openMVG_ofx {
+namespace Host {
+
+Clip::Clip(const std::string &name, const PropertySet &descriptorProps, bool isOutput)
+  : _name(name)
+  , _isOutput(isOutput)
+{
+  _props.merge(descriptorProps);
+  _props.setString(kOfxPropType, kOfxTypeClip);
+  _props.setString(kOfxPropName, name);
+  _props.setString(kOfxImageEffectPropPixelDepth, kOfxBitDepthFloat);
+  _props.setString(kOfxImageEffectPropComponents, kOfxImageComponentRGBA);
+  _props.setString(kOfxImageClipPropUnmappedPixelDepth, kOfxBitDepthFloat);
+  _props.setString(kOfxImageClipPropUnmappedComponents, kOfxImageComponentRGBA);
+  _props.setString(kOfxImageEffectPropPreMultiplication, kOfxImageOpaque);
+  _props.setDouble(kOfxImagePropPixelAspectRatio, 1.0);
+  _props.setDouble(kOfxImageEffectPropFrameRate, 25.0);
+  _props.setDoubles(kOfxImageEffectPropFrameRange, {0.0, 0.0});
+  _props.setString(kOfxImageClipPropFieldOrder, kOfxImageFieldNone);
+  _props.setDouble(kOfxImageEffectPropUnmappedFrameRate, 25.0);
+  _props.setDoubles(kOfxImageEffectPropUnmappedFrameRange, {0.0, 0.0});
+  _props.setInt(kOfxImageClipPropContinuousSamples, 0);
+  _props.setInt(kOfxImageClipPropConnected, isOutput ? 1 : 0);
+}
+
+void Clip::connect(const std::string &pattern, OfxTime first, OfxTime last, double frameRate)
+{
+  clearCache();
+  _pattern = pattern;
+  _props.setInt(kOfxImageClipPropConnected, 1);
+  _props.setDouble(kOfxImageEffectPropFrameRate, frameRate);
+  _props.setDoubles(kOfxImageEffectPropFrameRange, {first, last});
+  _props.setDouble(kOfxImageEffectPropUnmappedFrameRate, frameRate);
+  _props.setDoubles(kOfxImageEffectPropUnmappedFrameRange, {first, last});
+}
+
+void Clip::disconnect()
+{
+  clearCache();
+  _pattern.clear();
+  _props.setInt(kOfxImageClipPropConnected, 0);
+}
+
+void Clip::clearCache()
+{
+  std::lock_guard<std::mutex> guard(_framesMutex);
+  _frames.clear();
+  _framesUsage.clear();
+}
+
+std::string Clip::getFramePath(const std::string &pattern, OfxTime time) const
+{
+  const int frame = static_cast<int>(std::lround(time));
+
+  //printf pattern
+  if(pattern.find('%') != std::string::npos)
+  {
+    char path[4096];
+    std::snprintf(path, sizeof(path), pattern.c_str(), frame);
+    return path;
+  }
+
+  //'#' padded pattern
+  const std::size_t begin = pattern.find('#');
+  if(begin == std::string::npos)
+    return pattern;
+  std::size_t end = begin;
+  while(end < pattern.size() && pattern[end] == '#')
+    ++end;
+  std::string number = std::to_string(frame);
+  if(number.size() < end - begin)
+    number.insert(0, end - begin - number.size(), '0');
+  return pattern.substr(0, begin) + number + pattern.substr(end);
+}
+
+std::shared_ptr< std::vector<float> > Clip::loadFrame(OfxTime time, int &width, int &height)
+{
+  std::lock_guard<std::mutex> guard(_framesMutex);
+  auto it = _frames.find(time);
+  if(it != _frames.end())
+  {
+    _framesUsage.splice(_framesUsage.begin(), _framesUsage, it->second.usage);
+    width = it->second.width;
+    height = it->second.height;
+    return it->second.pixels;
+  }
+
+  Frame frame;
+  if(_isOutput)
+  {
+    frame.width = static_cast<int>(_outputRoD.x2 - _outputRoD.x1);
+    frame.height = static_cast<int>(_outputRoD.y2 - _outputRoD.y1);
+    frame.pixels = std::make_shared< std::vector<float> >(frame.width * frame.height * 4, 0.f);
+  }
+  else
+  {
+    const std::string path = getFramePath(_pattern, time);
+    cv::Mat bgr = cv::imread(path, CV_LOAD_IMAGE_COLOR);
+    if(bgr.empty())
+      return nullptr;
+    cv::Mat rgba;
+    cv::cvtColor(bgr, rgba, CV_BGR2RGBA);
+    cv::Mat rgbaFloat;
+    rgba.convertTo(rgbaFloat, CV_32FC4, 1.0 / 255.0);
+
+    frame.width = rgbaFloat.cols;
+    frame.height = rgbaFloat.rows;
+    frame.pixels = std::make_shared< std::vector<float> >(frame.width * frame.height * 4);
+    //OFX images are bottom-up
+    for(int y = 0; y < frame.height; ++y)
+    {
+      const float *src = rgbaFloat.ptr<float>(frame.height - 1 - y);
+      std::copy(src, src + frame.width * 4, frame.pixels->data() + y * frame.width * 4);
+    }
+  }
+  //Least recently used frames are dropped, the images fetched by the plugin keep their pixels
+  _framesUsage.push_front(time);
+  frame.usage = _framesUsage.begin();
+  _frames[time] = frame;
+  while(_frames.size() > kMaxCachedFrames)
+  {
+    _frames.erase(_framesUsage.back());
+    _framesUsage.pop_back();
+  }
+  width = frame.width;
+  height = frame.height;
+  return frame.pixels;
+}
+
+OfxRectD Clip::getRegionOfDefinition(OfxTime time)
+{
+  if(_isOutput)
+    return _outputRoD;
+  int width = 0;
+  int height = 0;
+  if(!isConnected() || !loadFrame(time, width, height))
+    return OfxRectD{0.0, 0.0, 0.0, 0.0};
+  return OfxRectD{0.0, 0.0, static_cast<double>(width), static_cast<double>(height)};
+}
+
+Image* Clip::createImage(OfxTime time, const OfxPointD &renderScale)
+{
+  if(!isConnected())
+    return nullptr;
+  int width = 0;
+  int height = 0;
+  std::shared_ptr< std::vector<float> > pixels = loadFrame(time, width, height);
+  if(!pixels || width <= 0 || height <= 0)
+    return nullptr;
+
+  Image *image = new Image();
+  image->pixels = pixels;
+  PropertySet &props = image->props;
+  props.setString(kOfxPropType, kOfxTypeImage);
+  props.setPointer(kOfxImagePropData, pixels->data());
+  props.setInts(kOfxImagePropBounds, {0, 0, width, height});
+  props.setInts(kOfxImagePropRegionOfDefinition, {0, 0, width, height});
+  props.setInt(kOfxImagePropRowBytes, width * 4 * static_cast<int>(sizeof(float)));
+  props.setString(kOfxImageEffectPropPixelDepth, kOfxBitDepthFloat);
+  props.setString(kOfxImageEffectPropComponents, kOfxImageComponentRGBA);
+  props.setString(kOfxImageEffectPropPreMultiplication, kOfxImageOpaque);
+  props.setDouble(kOfxImagePropPixelAspectRatio, 1.0);
+  props.setDoubles(kOfxImageEffectPropRenderScale, {renderScale.x, renderScale.y});
+  props.setString(kOfxImagePropField, kOfxImageFieldNone);
+  props.setString(kOfxImagePropUniqueIdentifier, _name + "@" + std::to_string(time));
+  props.setDouble(kOfxPropTime, time);
+  return image;
+}
+
+bool Clip::writeOutput(OfxTime time)
+{
+  if(!_isOutput || _outputPattern.empty())
+    return true;
+  Frame frame;
+  {
+    std::lock_guard<std::mutex> guard(_framesMutex);
+    auto it = _frames.find(time);
+    if(it == _frames.end())
+      return false;
+    frame = it->second;
+  }
+  cv::Mat rgbaFloat(frame.height, frame.width, CV_32FC4);
+  for(int y = 0; y < frame.height; ++y)
+  {
+    const float *src = frame.pixels->data() + y * frame.width * 4;
+    std::copy(src, src + frame.width * 4, rgbaFloat.ptr<float>(frame.height - 1 - y));
+  }
+  cv::Mat rgba;
+  rgbaFloat.convertTo(rgba, CV_8UC4, 255.0);
+  cv::Mat bgr;
+  cv::cvtColor(rgba, bgr, CV_RGBA2BGR);
+  return cv::imwrite(getFramePath(_outputPattern, time), bgr);
+}
+
+} //namespace Host
+} //namespace openMVG_ofx
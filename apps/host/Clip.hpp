@@ -0,0 +1,125 @@
+#pragma once
+
+#include "PropertySet.hpp"
+
+#include <ofxImageEffect.h>
+
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace openMVG_ofx {
+namespace Host {
+
+/**
+ * @brief Image returned to the plugin, RGBA float with the OFX bottom-up row order
+ */
+struct Image
+{
+  PropertySet props;
+  std::shared_ptr< std::vector<float> > pixels;
+};
+
+/**
+ * @brief Host side OFX clip
+ * An input clip is backed by image files: a single image, or a sequence
+ * with a '#' padded or printf frame pattern (e.g. /path/img.####.png, /path/img.%04d.png).
+ * The last decoded frames are kept in memory, so that a frame fetched by several actions
+ * is read once and render timings don't include its disk read.
+ * An output clip allocates a buffer per frame, optionally written to disk.
+ */
+class Clip
+{
+public:
+  Clip(const std::string &name, const PropertySet &descriptorProps, bool isOutput);
+
+  OfxImageClipHandle getHandle()
+  {
+    return reinterpret_cast<OfxImageClipHandle>(this);
+  }
+
+  static Clip* fromHandle(OfxImageClipHandle handle)
+  {
+    return reinterpret_cast<Clip*>(handle);
+  }
+
+  const std::string& getName() const { return _name; }
+  PropertySet& getProps() { return _props; }
+  bool isOutput() const { return _isOutput; }
+  bool isConnected() const { return _props.getInt(kOfxImageClipPropConnected) != 0; }
+
+  /**
+   * @brief Connect the clip to image files
+   * @param[in] pattern - image file or sequence pattern
+   * @param[in] first - first frame
+   * @param[in] last - last frame
+   * @param[in] frameRate
+   */
+  void connect(const std::string &pattern, OfxTime first, OfxTime last, double frameRate);
+
+  void disconnect();
+
+  /**
+   * @brief Set the region of definition of the output images
+   * @param[in] rod
+   */
+  void setOutputRoD(const OfxRectD &rod) { _outputRoD = rod; }
+
+  /**
+   * @brief Set the file pattern where output images are written, empty to disable
+   * @param[in] pattern
+   */
+  void setOutputPattern(const std::string &pattern) { _outputPattern = pattern; }
+
+  OfxRectD getRegionOfDefinition(OfxTime time);
+
+  /**
+   * @brief Create an image, the caller owns it
+   * @param[in] time
+   * @param[in] renderScale
+   * @return image, null if no frame at this time
+   */
+  Image* createImage(OfxTime time, const OfxPointD &renderScale);
+
+  /**
+   * @brief Write the output image rendered at time, if an output pattern is set
+   * @param[in] time
+   * @return false if writing failed
+   */
+  bool writeOutput(OfxTime time);
+
+  /**
+   * @brief Drop the decoded and rendered frames
+   */
+  void clearCache();
+
+private:
+  std::string getFramePath(const std::string &pattern, OfxTime time) const;
+  std::shared_ptr< std::vector<float> > loadFrame(OfxTime time, int &width, int &height);
+
+  const std::string _name;
+  const bool _isOutput;
+  PropertySet _props;
+
+  std::string _pattern;
+  OfxRectD _outputRoD = {0.0, 0.0, 0.0, 0.0};
+  std::string _outputPattern;
+
+  struct Frame
+  {
+    int width = 0;
+    int height = 0;
+    std::shared_ptr< std::vector<float> > pixels;
+    std::list<OfxTime>::iterator usage; //position in _framesUsage
+  };
+  static const std::size_t kMaxCachedFrames = 8;
+  std::mutex _framesMutex;
+  std::map<OfxTime, Frame> _frames;
+  std::list<OfxTime> _framesUsage; //most recently used first
+};
+
+} //namespace Host
+} //namespace openMVG_ofx
@@ -0,0 +1,59 @@
+#include "Effect.hpp"
+
+namespace openMVG_ofx {
+namespace Host {
+
+PropertySet& Effect::defineClip(const std::string &name)
+{
+  for(auto &clipDescriptor : _clipDescriptors)
+  {
+    if(clipDescriptor.first == name)
+      return clipDescriptor.second;
+  }
+  _clipDescriptors.emplace_back(name, PropertySet());
+  PropertySet &props = _clipDescriptors.back().second;
+  props.setString(kOfxPropType, kOfxTypeClip);
+  props.setString(kOfxPropName, name);
+  props.setString(kOfxPropLabel, name);
+  props.setStrings(kOfxImageEffectPropSupportedComponents, {});
+  props.setInt(kOfxImageEffectPropTemporalClipAccess, 0);
+  props.setInt(kOfxImageClipPropOptional, 0);
+  props.setInt(kOfxImageClipPropIsMask, 0);
+  props.setString(kOfxImageClipPropFieldExtraction, kOfxImageFieldDoubled);
+  props.setInt(kOfxImageEffectPropSupportsTiles, 1);
+  return props;
+}
+
+void Effect::cloneFrom(const Effect &descriptor)
+{
+  _props.merge(descriptor._props);
+  _paramSet.cloneFrom(descriptor._paramSet);
+  for(const auto &clipDescriptor : descriptor._clipDescriptors)
+  {
+    const bool isOutput = (clipDescriptor.first == kOfxImageEffectOutputClipName);
+    _clips.emplace_back(new Clip(clipDescriptor.first, clipDescriptor.second, isOutput));
+  }
+}
+
+Clip* Effect::findClip(const std::string &name)
+{
+  for(auto &clip : _clips)
+  {
+    if(clip->getName() == name)
+      return clip.get();
+  }
+  return nullptr;
+}
+
+Clip* Effect::getFirstConnectedInput()
+{
+  for(auto &clip : _clips)
+  {
+    if(!clip->isOutput() && clip->isConnected())
+      return clip.get();
+  }
+  return nullptr;
+}
+
+} //namespace Host
+} //namespace openMVG_ofx
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "PropertySet.hpp"
+#include "Param.hpp"
+#include "Clip.hpp"
+
+#include <ofxImageEffect.h>
+#include <ofxInteract.h>
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace openMVG_ofx {
+namespace Host {
+
+/**
+ * @brief Host side OFX image effect, used for both descriptors and instances
+ */
+class Effect
+{
+public:
+  Effect() = default;
+  Effect(const Effect&) = delete;
+  Effect& operator=(const Effect&) = delete;
+
+  OfxImageEffectHandle getHandle()
+  {
+    return reinterpret_cast<OfxImageEffectHandle>(this);
+  }
+
+  static Effect* fromHandle(OfxImageEffectHandle handle)
+  {
+    return reinterpret_cast<Effect*>(handle);
+  }
+
+  PropertySet& getProps() { return _props; }
+  ParamSet& getParamSet() { return _paramSet; }
+
+  /**
+   * @brief Define a clip on a descriptor
+   * @param[in] name
+   * @return clip properties
+   */
+  PropertySet& defineClip(const std::string &name);
+
+  const std::vector< std::pair<std::string, PropertySet> >& getClipDescriptors() const { return _clipDescriptors; }
+
+  /**
+   * @brief Create the instance clips and parameters from a descriptor
+   * @param[in] descriptor
+   */
+  void cloneFrom(const Effect &descriptor);
+
+  Clip* findClip(const std::string &name);
+  const std::vector< std::unique_ptr<Clip> >& getClips() const { return _clips; }
+
+  /**
+   * @brief Get the first connected input clip
+   * @return clip, null if no input is connected
+   */
+  Clip* getFirstConnectedInput();
+
+  bool isAborted() const { return _abort.load(); }
+  void setAbort(bool abort) { _abort.store(abort); }
+
+private:
+  PropertySet _props;
+  ParamSet _paramSet;
+  std::vector< std::pair<std::string, PropertySet> > _clipDescriptors; //ordered by definition
+  std::vector< std::unique_ptr<Clip> > _clips;
+  std::atomic<bool> _abort{false};
+};
+
+/**
+ * @brief Host side OFX interact, used for the effect overlay
+ */
+class Interact
+{
+public:
+  OfxInteractHandle getHandle()
+  {
+    return reinterpret_cast<OfxInteractHandle>(this);
+  }
+
+  static Interact* fromHandle(OfxInteractHandle handle)
+  {
+    return reinterpret_cast<Interact*>(handle);
+  }
+
+  PropertySet& getProps() { return _props; }
+
+  std::size_t getNbRedraws() const { return _nbRedraws.load(); }
+  void requestRedraw() { ++_nbRedraws; }
+
+private:
+  PropertySet _props;
+  std::atomic<std::size_t> _nbRedraws{0};
+};
+
+} //namespace Host
+} //namespace openMVG_ofx
@@ -0,0 +1,528 @@
+#include "Host.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <windows.h>
+#define ofxHostLoadLibrary(path) static_cast<void*>(LoadLibraryA(path))
+#define ofxHostGetSymbol(library, name) reinterpret_cast<void*>(GetProcAddress(static_cast<HMODULE>(library), name))
+#define ofxHostFreeLibrary(library) FreeLibrary(static_cast<HMODULE>(library))
+#else
+#include <dlfcn.h>
+#define ofxHostLoadLibrary(path) dlopen(path, RTLD_LAZY | RTLD_LOCAL)
+#define ofxHostGetSymbol(library, name) dlsym(library, name)
+#define ofxHostFreeLibrary(library) dlclose(library)
+#endif
+
+namespace openMVG_ofx {
+namespace Host {
+
+namespace {
+
+typedef int (*OfxGetNumberOfPluginsFunc)(void);
+typedef OfxPlugin* (*OfxGetPluginFunc)(int);
+
+bool isSuccess(OfxStatus status)
+{
+  return status == kOfxStatOK || status == kOfxStatReplyDefault ||
+         status == kOfxStatReplyYes || status == kOfxStatReplyNo;
+}
+
+} //namespace
+
+void ActionTiming::add(double durationMs)
+{
+  minMs = (count == 0) ? durationMs : std::min(minMs, durationMs);
+  maxMs = (count == 0) ? durationMs : std::max(maxMs, durationMs);
+  totalMs += durationMs;
+  ++count;
+}
+
+Host& Host::instance()
+{
+  static Host host;
+  return host;
+}
+
+Host::Host()
+{
+  initHostProps();
+  _ofxHost.host = _hostProps.getHandle();
+  _ofxHost.fetchSuite = &Host::fetchSuite;
+}
+
+Host::~Host()
+{
+  try
+  {
+    destroyInstance();
+    if(_plugin)
+      callAction(kOfxActionUnload, nullptr, nullptr, nullptr);
+  }
+  catch(std::exception &e)
+  {
+    std::clog << "[host] " << e.what() << std::endl;
+  }
+  if(_library)
+    ofxHostFreeLibrary(_library);
+}
+
+void Host::initHostProps()
+{
+  PropertySet &props = _hostProps;
+  props.setString(kOfxPropType, kOfxTypeImageEffectHost);
+  props.setString(kOfxPropName, "openmvg.ofxhost");
+  props.setString(kOfxPropLabel, "ofxMVG host");
+  props.setInts(kOfxPropAPIVersion, {1, 3});
+  props.setInts(kOfxPropVersion, {1, 0, 0});
+  props.setString(kOfxPropVersionLabel, "1.0");
+  props.setInt(kOfxImageEffectHostPropIsBackground, 1);
+  props.setInt(kOfxImageEffectPropSupportsOverlays, 1);
+  props.setInt(kOfxImageEffectPropSupportsMultiResolution, 1);
+  props.setInt(kOfxImageEffectPropSupportsTiles, 1);
+  props.setInt(kOfxImageEffectPropTemporalClipAccess, 1);
+  props.setInt(kOfxImageEffectPropSupportsMultipleClipDepths, 0);
+  props.setInt(kOfxImageEffectPropSupportsMultipleClipPARs, 0);
+  props.setInt(kOfxImageEffectPropSetableFrameRate, 0);
+  props.setInt(kOfxImageEffectPropSetableFielding, 0);
+  props.setInt(kOfxImageEffectInstancePropSequentialRender, 1);
+  props.setStrings(kOfxImageEffectPropSupportedComponents, {kOfxImageComponentRGBA, kOfxImageComponentAlpha});
+  props.setStrings(kOfxImageEffectPropSupportedContexts, {kOfxImageEffectContextGenerator, kOfxImageEffectContextFilter, kOfxImageEffectContextGeneral, kOfxImageEffectContextPaint});
+  props.setStrings(kOfxImageEffectPropSupportedPixelDepths, {kOfxBitDepthFloat});
+  props.setInt(kOfxParamHostPropSupportsCustomInteract, 0);
+  props.setInt(kOfxParamHostPropSupportsStringAnimation, 1);
+  props.setInt(kOfxParamHostPropSupportsChoiceAnimation, 1);
+  props.setInt(kOfxParamHostPropSupportsBooleanAnimation, 1);
+  props.setInt(kOfxParamHostPropSupportsCustomAnimation, 1);
+  props.setInt(kOfxParamHostPropMaxParameters, -1);
+  props.setInt(kOfxParamHostPropMaxPages, 0);
+  props.setInts(kOfxParamHostPropPageRowColumnCount, {0, 0});
+#ifdef kOfxParamHostPropSupportsParametricAnimation
+  props.setInt(kOfxParamHostPropSupportsParametricAnimation, 0);
+#endif
+#ifdef kOfxImageEffectHostPropNativeOrigin
+  props.setString(kOfxImageEffectHostPropNativeOrigin, kOfxImageEffectHostPropNativeOriginBottomLeft);
+#endif
+#ifdef kOfxImageEffectPropOpenGLRenderSupported
+  props.setString(kOfxImageEffectPropOpenGLRenderSupported, "false");
+#endif
+#ifdef kOfxImageEffectPropRenderQualityDraft
+  props.setInt(kOfxImageEffectPropRenderQualityDraft, 0);
+#endif
+}
+
+void Host::checkStatus(OfxStatus status, const char *action) const
+{
+  if(!isSuccess(status))
+    throw std::runtime_error(std::string("Action ") + action + " failed with status " + std::to_string(status));
+}
+
+OfxStatus Host::callAction(const char *action, const void *handle, PropertySet *inArgs, PropertySet *outArgs)
+{
+  if(!_plugin)
+    throw std::logic_error("No plugin loaded.");
+  const auto start = std::chrono::steady_clock::now();
+  const OfxStatus status = _plugin->mainEntry(action, handle,
+                                              inArgs ? inArgs->getHandle() : nullptr,
+                                              outArgs ? outArgs->getHandle() : nullptr);
+  _timings[action].add(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+  return status;
+}
+
+void Host::loadPlugin(const std::string &binaryPath, const std::string &pluginIdentifier)
+{
+  if(_library)
+    throw std::logic_error("A plugin binary is already loaded.");
+  _library = ofxHostLoadLibrary(binaryPath.c_str());
+  if(!_library)
+    throw std::runtime_error("Can't load the plugin binary : " + binaryPath);
+
+  OfxGetNumberOfPluginsFunc getNumberOfPlugins = reinterpret_cast<OfxGetNumberOfPluginsFunc>(ofxHostGetSymbol(_library, "OfxGetNumberOfPlugins"));
+  OfxGetPluginFunc getPlugin = reinterpret_cast<OfxGetPluginFunc>(ofxHostGetSymbol(_library, "OfxGetPlugin"));
+  if(!getNumberOfPlugins || !getPlugin)
+    throw std::runtime_error("Not an OFX plugin binary : " + binaryPath);
+
+  const int nbPlugins = getNumberOfPlugins();
+  for(int i = 0; i < nbPlugins && !_plugin; ++i)
+  {
+    OfxPlugin *plugin = getPlugin(i);
+    if(plugin && pluginIdentifier == plugin->pluginIdentifier && std::string(plugin->pluginApi) == kOfxImageEffectPluginApi)
+      _plugin = plugin;
+  }
+  if(!_plugin)
+    throw std::runtime_error("Plugin " + pluginIdentifier + " not found in " + binaryPath);
+
+  _plugin->setHost(&_ofxHost);
+  checkStatus(callAction(kOfxActionLoad, nullptr, nullptr, nullptr), kOfxActionLoad);
+
+  _descriptor.reset(new Effect());
+  PropertySet &props = _descriptor->getProps();
+  props.setString(kOfxPropType, kOfxTypeImageEffect);
+  props.setString(kOfxPropLabel, pluginIdentifier);
+  props.setString(kOfxImageEffectPluginPropGrouping, "");
+  props.setStrings(kOfxImageEffectPropSupportedContexts, {});
+  props.setStrings(kOfxImageEffectPropSupportedPixelDepths, {});
+  props.setInt(kOfxImageEffectPluginPropSingleInstance, 0);
+  props.setString(kOfxImageEffectPluginRenderThreadSafety, kOfxImageEffectRenderInstanceSafe);
+  props.setInt(kOfxImageEffectPluginPropHostFrameThreading, 0);
+  props.setPointer(kOfxImageEffectPluginPropOverlayInteractV1, nullptr);
+  props.setInt(kOfxImageEffectPropSupportsMultiResolution, 1);
+  props.setInt(kOfxImageEffectPropSupportsTiles, 1);
+  props.setInt(kOfxImageEffectPropTemporalClipAccess, 0);
+  props.setInt(kOfxImageEffectPluginPropFieldRenderTwiceAlways, 1);
+  props.setInt(kOfxImageEffectPropSupportsMultipleClipDepths, 0);
+  props.setInt(kOfxImageEffectPropSupportsMultipleClipPARs, 0);
+  props.setStrings(kOfxImageEffectPropClipPreferencesSlaveParam, {});
+  props.setString(kOfxPluginPropFilePath, binaryPath.substr(0, binaryPath.find_last_of("/\\")));
+
+  checkStatus(callAction(kOfxActionDescribe, _descriptor->getHandle(), nullptr, nullptr), kOfxActionDescribe);
+}
+
+void Host::describeInContext(const std::string &context)
+{
+  if(!_descriptor)
+    throw std::logic_error("No plugin loaded.");
+
+  const PropertySet &props = _descriptor->getProps();
+  bool isSupported = false;
+  for(std::size_t i = 0; i < props.getDimension(kOfxImageEffectPropSupportedContexts); ++i)
+    isSupported |= (props.getString(kOfxImageEffectPropSupportedContexts, i) == context);
+  if(!isSupported)
+    throw std::invalid_argument("Context not supported by the plugin : " + context);
+
+  std::unique_ptr<Effect> descriptor(new Effect());
+  descriptor->getProps().merge(props);
+  PropertySet inArgs;
+  inArgs.setString(kOfxImageEffectPropContext, context);
+  checkStatus(callAction(kOfxImageEffectActionDescribeInContext, descriptor->getHandle(), &inArgs, nullptr), kOfxImageEffectActionDescribeInContext);
+
+  _contextDescriptors[context] = std::move(descriptor);
+  _context = context;
+}
+
+void Host::createInstance()
+{
+  if(_instance)
+    throw std::logic_error("The instance is already created.");
+  if(_context.empty())
+    throw std::logic_error("No context described.");
+
+  _instance.reset(new Effect());
+  _instance->cloneFrom(*_contextDescriptors[_context]);
+  _instance->getParamSet().setTime(_time);
+
+  PropertySet &props = _instance->getProps();
+  props.setString(kOfxPropType, kOfxTypeImageEffectInstance);
+  props.setString(kOfxImageEffectPropContext, _context);
+  props.setPointer(kOfxPropInstanceData, nullptr);
+  props.setDoubles(kOfxImageEffectPropProjectSize, {1920.0, 1080.0});
+  props.setDoubles(kOfxImageEffectPropProjectOffset, {0.0, 0.0});
+  props.setDoubles(kOfxImageEffectPropProjectExtent, {1920.0, 1080.0});
+  props.setDouble(kOfxImageEffectPropProjectPixelAspectRatio, 1.0);
+  props.setDouble(kOfxImageEffectInstancePropEffectDuration, _timeLast - _timeFirst + 1.0);
+  props.setInt(kOfxImageEffectInstancePropSequentialRender, 0);
+  props.setDouble(kOfxImageEffectPropFrameRate, _frameRate);
+  props.setInt(kOfxPropIsInteractive, 0);
+  props.setDoubles(kOfxImageEffectPropFrameRange, {_timeFirst, _timeLast});
+
+  for(const PendingClip &pendingClip : _pendingClips)
+  {
+    Clip *clip = _instance->findClip(pendingClip.name);
+    if(!clip || clip->isOutput())
+      throw std::invalid_argument("Unknown input clip : " + pendingClip.name);
+    clip->connect(pendingClip.pattern, pendingClip.first, pendingClip.last, _frameRate);
+  }
+  _pendingClips.clear();
+
+  //Project size from the main input
+  const OfxRectD rod = getInputRoD(_timeFirst);
+  if(rod.x2 > rod.x1 && rod.y2 > rod.y1)
+  {
+    props.setDoubles(kOfxImageEffectPropProjectSize, {rod.x2 - rod.x1, rod.y2 - rod.y1});
+    props.setDoubles(kOfxImageEffectPropProjectExtent, {rod.x2 - rod.x1, rod.y2 - rod.y1});
+  }
+
+  checkStatus(callAction(kOfxActionCreateInstance, _instance->getHandle(), nullptr, nullptr), kOfxActionCreateInstance);
+  _isInstanceCreated = true;
+
+  PropertySet clipPreferences;
+  checkStatus(callAction(kOfxImageEffectActionGetClipPreferences, _instance->getHandle(), nullptr, &clipPreferences), kOfxImageEffectActionGetClipPreferences);
+}
+
+void Host::destroyInstance()
+{
+  if(_interact)
+  {
+    _interactEntry(kOfxActionDestroyInstance, _interact->getHandle(), nullptr, nullptr);
+    _interact.reset();
+  }
+  _isInstanceCreated = false;
+  if(_instance)
+  {
+    callAction(kOfxActionDestroyInstance, _instance->getHandle(), nullptr, nullptr);
+    _instance.reset();
+  }
+}
+
+Effect& Host::getInstance()
+{
+  if(!_instance)
+    throw std::logic_error("No instance created.");
+  return *_instance;
+}
+
+void Host::connectClip(const std::string &clipName, const std::string &pattern, OfxTime first, OfxTime last)
+{
+  if(!_instance)
+  {
+    //Connected at the instance creation
+    _pendingClips.push_back(PendingClip{clipName, pattern, first, last});
+    return;
+  }
+  Clip *clip = getInstance().findClip(clipName);
+  if(!clip || clip->isOutput())
+    throw std::invalid_argument("Unknown input clip : " + clipName);
+  clip->connect(pattern, first, last, _frameRate);
+  instanceChanged(kOfxTypeClip, clipName);
+
+  PropertySet clipPreferences;
+  checkStatus(callAction(kOfxImageEffectActionGetClipPreferences, _instance->getHandle(), nullptr, &clipPreferences), kOfxImageEffectActionGetClipPreferences);
+}
+
+void Host::disconnectClip(const std::string &clipName)
+{
+  Clip *clip = getInstance().findClip(clipName);
+  if(!clip || clip->isOutput())
+    throw std::invalid_argument("Unknown input clip : " + clipName);
+  clip->disconnect();
+  instanceChanged(kOfxTypeClip, clipName);
+}
+
+void Host::fillRenderScale(PropertySet &args) const
+{
+  args.setDoubles(kOfxImageEffectPropRenderScale, {1.0, 1.0});
+}
+
+void Host::instanceChanged(const std::string &type, const std::string &name, const char *reason)
+{
+  Effect &instance = getInstance();
+
+  //The plugin edits made by these actions are nested notifications
+  struct DepthScope
+  {
+    std::size_t &depth;
+    explicit DepthScope(std::size_t &d) : depth(d) { ++depth; }
+    ~DepthScope() { --depth; }
+  } depthScope(_instanceChangedDepth);
+
+  PropertySet beginArgs;
+  beginArgs.setString(kOfxPropChangeReason, reason);
+  checkStatus(callAction(kOfxActionBeginInstanceChanged, instance.getHandle(), &beginArgs, nullptr), kOfxActionBeginInstanceChanged);
+
+  PropertySet inArgs;
+  inArgs.setString(kOfxPropType, type);
+  inArgs.setString(kOfxPropName, name);
+  inArgs.setString(kOfxPropChangeReason, reason);
+  inArgs.setDouble(kOfxPropTime, _time);
+  fillRenderScale(inArgs);
+  checkStatus(callAction(kOfxActionInstanceChanged, instance.getHandle(), &inArgs, nullptr), kOfxActionInstanceChanged);
+
+  checkStatus(callAction(kOfxActionEndInstanceChanged, instance.getHandle(), &beginArgs, nullptr), kOfxActionEndInstanceChanged);
+}
+
+void Host::pluginChangedParam(Param &param)
+{
+  if(!_isInstanceCreated || &param.getParamSet() != &_instance->getParamSet())
+    return;
+  if(_instanceChangedDepth >= kMaxInstanceChangedDepth)
+  {
+    std::clog << "[host][warning] plugin edit of " << param.getName() << " not notified, "
+              << _instanceChangedDepth << " nested instance changes" << std::endl;
+    return;
+  }
+  instanceChanged(kOfxTypeParameter, param.getName(), kOfxChangePluginEdited);
+}
+
+OfxRectD Host::getInputRoD(OfxTime time)
+{
+  Clip *input = getInstance().getFirstConnectedInput();
+  if(!input)
+    return OfxRectD{0.0, 0.0, 0.0, 0.0};
+  return input->getRegionOfDefinition(time);
+}
+
+void Host::render(OfxTime first, OfxTime last, OfxTime step)
+{
+  Effect &instance = getInstance();
+  Clip *output = instance.findClip(kOfxImageEffectOutputClipName);
+  if(!output)
+    throw std::logic_error("The plugin has no output clip.");
+  if(step <= 0.0)
+    throw std::invalid_argument("Invalid render step.");
+
+  PropertySet sequenceArgs;
+  sequenceArgs.setDoubles(kOfxImageEffectPropFrameRange, {first, last});
+  sequenceArgs.setDouble(kOfxImageEffectPropFrameStep, step);
+  sequenceArgs.setInt(kOfxPropIsInteractive, 0);
+  fillRenderScale(sequenceArgs);
+  sequenceArgs.setInt(kOfxImageEffectPropSequentialRenderStatus, 1);
+  sequenceArgs.setInt(kOfxImageEffectPropInteractiveRenderStatus, 0);
+  checkStatus(callAction(kOfxImageEffectActionBeginSequenceRender, instance.getHandle(), &sequenceArgs, nullptr), kOfxImageEffectActionBeginSequenceRender);
+
+  for(OfxTime time = first; time <= last; time += step)
+  {
+    setTime(time);
+
+    //Region of definition, the input one by default
+    PropertySet rodArgs;
+    rodArgs.setDouble(kOfxPropTime, time);
+    fillRenderScale(rodArgs);
+    const OfxRectD inputRoD = getInputRoD(time);
+    PropertySet rodOutArgs;
+    rodOutArgs.setDoubles(kOfxImageEffectPropRegionOfDefinition, {inputRoD.x1, inputRoD.y1, inputRoD.x2, inputRoD.y2});
+    checkStatus(callAction(kOfxImageEffectActionGetRegionOfDefinition, instance.getHandle(), &rodArgs, &rodOutArgs), kOfxImageEffectActionGetRegionOfDefinition);
+    const OfxRectD rod = {rodOutArgs.getDouble(kOfxImageEffectPropRegionOfDefinition, 0),
+                          rodOutArgs.getDouble(kOfxImageEffectPropRegionOfDefinition, 1),
+                          rodOutArgs.getDouble(kOfxImageEffectPropRegionOfDefinition, 2),
+                          rodOutArgs.getDouble(kOfxImageEffectPropRegionOfDefinition, 3)};
+    output->setOutputRoD(rod);
+    output->clearCache();
+
+    PropertySet renderArgs;
+    renderArgs.setDouble(kOfxPropTime, time);
+    renderArgs.setString(kOfxImageEffectPropFieldToRender, kOfxImageFieldNone);
+    renderArgs.setInts(kOfxImageEffectPropRenderWindow, {static_cast<int>(rod.x1), static_cast<int>(rod.y1), static_cast<int>(rod.x2), static_cast<int>(rod.y2)});
+    fillRenderScale(renderArgs);
+    renderArgs.setInt(kOfxImageEffectPropSequentialRenderStatus, 1);
+    renderArgs.setInt(kOfxImageEffectPropInteractiveRenderStatus, 0);
+#ifdef kOfxImageEffectPropRenderQualityDraft
+    renderArgs.setInt(kOfxImageEffectPropRenderQualityDraft, 0);
+#endif
+
+    PropertySet identityOutArgs;
+    identityOutArgs.setString(kOfxPropName, "");
+    identityOutArgs.setDouble(kOfxPropTime, time);
+    const OfxStatus identityStatus = callAction(kOfxImageEffectActionIsIdentity, instance.getHandle(), &renderArgs, &identityOutArgs);
+    checkStatus(identityStatus, kOfxImageEffectActionIsIdentity);
+    if(identityStatus == kOfxStatOK)
+      continue;
+
+    checkStatus(callAction(kOfxImageEffectActionRender, instance.getHandle(), &renderArgs, nullptr), kOfxImageEffectActionRender);
+    if(!output->writeOutput(time))
+      std::clog << "[host] can't write the output image at time " << time << std::endl;
+  }
+
+  checkStatus(callAction(kOfxImageEffectActionEndSequenceRender, instance.getHandle(), &sequenceArgs, nullptr), kOfxImageEffectActionEndSequenceRender);
+}
+
+void Host::drawOverlay(OfxTime first, OfxTime last)
+{
+  Effect &instance = getInstance();
+  const OfxRectD rod = getInputRoD(first);
+
+  if(!_interact)
+  {
+    _interactEntry = reinterpret_cast<OfxPluginEntryPoint*>(instance.getProps().getPointer(kOfxImageEffectPluginPropOverlayInteractV1));
+    if(!_interactEntry)
+      throw std::logic_error("The plugin has no overlay interact.");
+
+    _interactDescriptor.reset(new Interact());
+    _interactDescriptor->getProps().setInt(kOfxInteractPropHasAlpha, 0);
+    _interactDescriptor->getProps().setInt(kOfxInteractPropBitDepth, 8);
+    checkStatus(_interactEntry(kOfxActionDescribe, _interactDescriptor->getHandle(), nullptr, nullptr), kOfxActionDescribe);
+
+    _interact.reset(new Interact());
+    PropertySet &props = _interact->getProps();
+    props.merge(_interactDescriptor->getProps());
+    props.setPointer(kOfxPropEffectInstance, instance.getHandle());
+    props.setPointer(kOfxPropInstanceData, nullptr);
+    props.setDoubles(kOfxInteractPropPixelScale, {1.0, 1.0});
+    props.setDoubles(kOfxInteractPropBackgroundColour, {0.0, 0.0, 0.0});
+    props.setDoubles(kOfxInteractPropViewportSize, {rod.x2 - rod.x1, rod.y2 - rod.y1});
+    props.setStrings(kOfxInteractPropSlaveToParam, {});
+    checkStatus(_interactEntry(kOfxActionCreateInstance, _interact->getHandle(), nullptr, nullptr), kOfxActionCreateInstance);
+  }
+
+  for(OfxTime time = first; time <= last; time += 1.0)
+  {
+    setTime(time);
+    PropertySet drawArgs;
+    drawArgs.setPointer(kOfxPropEffectInstance, instance.getHandle());
+    drawArgs.setDouble(kOfxPropTime, time);
+    fillRenderScale(drawArgs);
+    drawArgs.setDoubles(kOfxInteractPropPixelScale, {1.0, 1.0});
+    drawArgs.setDoubles(kOfxInteractPropBackgroundColour, {0.0, 0.0, 0.0});
+    drawArgs.setDoubles(kOfxInteractPropViewportSize, {rod.x2 - rod.x1, rod.y2 - rod.y1});
+
+    const auto start = std::chrono::steady_clock::now();
+    const OfxStatus status = _interactEntry(kOfxInteractActionDraw, _interact->getHandle(), drawArgs.getHandle(), nullptr);
+    _timings[std::string("interact.") + kOfxInteractActionDraw].add(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    checkStatus(status, kOfxInteractActionDraw);
+  }
+}
+
+void Host::syncPrivateData()
+{
+  checkStatus(callAction(kOfxActionSyncPrivateData, getInstance().getHandle(), nullptr, nullptr), kOfxActionSyncPrivateData);
+}
+
+void Host::setTime(OfxTime time)
+{
+  _time = time;
+  if(_instance)
+    _instance->getParamSet().setTime(time);
+}
+
+void Host::setTimeBounds(OfxTime first, OfxTime last, double frameRate)
+{
+  _timeFirst = first;
+  _timeLast = last;
+  _frameRate = frameRate;
+}
+
+void Host::printTimings(std::ostream &os, bool csv) const
+{
+  if(csv)
+    os << "action,count,totalMs,avgMs,minMs,maxMs" << std::endl;
+  for(const auto &timing : _timings)
+  {
+    const ActionTiming &t = timing.second;
+    const double avgMs = t.count ? t.totalMs / t.count : 0.0;
+    if(csv)
+    {
+      os << timing.first << "," << t.count << "," << t.totalMs << "," << avgMs << "," << t.minMs << "," << t.maxMs << std::endl;
+    }
+    else
+    {
+      os << std::left << std::setw(48) << timing.first << std::right
+         << " count=" << std::setw(6) << t.count
+         << std::fixed << std::setprecision(3)
+         << " total=" << std::setw(12) << t.totalMs << "ms"
+         << " avg=" << std::setw(10) << avgMs << "ms"
+         << " min=" << std::setw(10) << t.minMs << "ms"
+         << " max=" << std::setw(10) << t.maxMs << "ms" << std::endl;
+      os.unsetf(std::ios::fixed);
+    }
+  }
+}
+
+OfxPropertySetHandle Host::registerImage(Image *image)
+{
+  std::lock_guard<std::mutex> guard(_imagesMutex);
+  OfxPropertySetHandle handle = image->props.getHandle();
+  _images[handle].reset(image);
+  return handle;
+}
+
+bool Host::releaseImage(OfxPropertySetHandle handle)
+{
+  std::lock_guard<std::mutex> guard(_imagesMutex);
+  return _images.erase(handle) > 0;
+}
+
+} //namespace Host
+} //namespace openMVG_ofx
@@ -0,0 +1,212 @@
+#pragma once
+
+#include "PropertySet.hpp"
+#include "Effect.hpp"
+
+#include <ofxCore.h>
+#include <ofxImageEffect.h>
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace openMVG_ofx {
+namespace Host {
+
+/**
+ * @brief Duration statistics of an action
+ */
+struct ActionTiming
+{
+  std::size_t count = 0;
+  double totalMs = 0.0;
+  double minMs = 0.0;
+  double maxMs = 0.0;
+
+  void add(double durationMs);
+};
+
+/**
+ * @brief Minimal in-process OFX host
+ * Loads a plugin binary, implements the suites needed by the OFX support library
+ * and calls the plugin actions, measuring the duration of each of them.
+ * Actions are called on the calling thread, in the order a host like Nuke calls them.
+ * Changes made by the plugin on its own parameters are notified back, as plugin edits.
+ */
+class Host
+{
+public:
+
+  /**
+   * @brief Get the process-wide host, the OFX suites are C functions without context
+   * @return host instance
+   */
+  static Host& instance();
+
+  ~Host();
+
+  /**
+   * @brief Load a plugin binary and describe one of its plugins
+   * @param[in] binaryPath - .ofx file
+   * @param[in] pluginIdentifier
+   */
+  void loadPlugin(const std::string &binaryPath, const std::string &pluginIdentifier);
+
+  /**
+   * @brief Describe the plugin in a context
+   * @param[in] context - OFX context
+   */
+  void describeInContext(const std::string &context);
+
+  /**
+   * @brief Create the effect instance, with the clips connected before
+   */
+  void createInstance();
+  void destroyInstance();
+
+  bool hasInstance() const { return _instance != nullptr; }
+  Effect& getInstance();
+
+  /**
+   * @brief Connect an input clip to image files
+   * Before the instance creation, the connection is applied at creation.
+   * @param[in] clipName
+   * @param[in] pattern
+   * @param[in] first
+   * @param[in] last
+   */
+  void connectClip(const std::string &clipName, const std::string &pattern, OfxTime first, OfxTime last);
+  void disconnectClip(const std::string &clipName);
+
+  /**
+   * @brief Notify the instance of a change of a parameter or a clip
+   * @param[in] type - kOfxTypeParameter or kOfxTypeClip
+   * @param[in] name
+   * @param[in] reason - kOfxChangeUserEdited or kOfxChangePluginEdited
+   */
+  void instanceChanged(const std::string &type, const std::string &name, const char *reason = kOfxChangeUserEdited);
+
+  /**
+   * @brief Notify the instance of a change made by the plugin on one of its parameters
+   * Not notified during the instance creation and destruction, nor beyond kMaxInstanceChangedDepth
+   * nested notifications: a plugin setting a parameter on each change would recurse forever.
+   * @param[in] param - parameter set by the plugin
+   */
+  void pluginChangedParam(Param &param);
+
+  /**
+   * @brief Render a frame range as a sequence render
+   * @param[in] first
+   * @param[in] last
+   * @param[in] step
+   */
+  void render(OfxTime first, OfxTime last, OfxTime step);
+
+  /**
+   * @brief Draw the overlay interact at each frame of the range
+   * The current OpenGL context is used, without context the GL calls are no-ops
+   * on GLVND dispatching drivers and only the plugin side cost is measured.
+   * @param[in] first
+   * @param[in] last
+   */
+  void drawOverlay(OfxTime first, OfxTime last);
+
+  /**
+   * @brief Call the sync private data action
+   */
+  void syncPrivateData();
+
+  OfxTime getTime() const { return _time; }
+  void setTime(OfxTime time);
+  void setTimeBounds(OfxTime first, OfxTime last, double frameRate);
+  void getTimeBounds(OfxTime &first, OfxTime &last) const { first = _timeFirst; last = _timeLast; }
+
+  /**
+   * @brief Call a plugin action and record its duration
+   * @param[in] action
+   * @param[in] handle
+   * @param[in] inArgs
+   * @param[in] outArgs
+   * @return plugin status
+   */
+  OfxStatus callAction(const char *action, const void *handle, PropertySet *inArgs, PropertySet *outArgs);
+
+  const std::map<std::string, ActionTiming>& getTimings() const { return _timings; }
+  void clearTimings() { _timings.clear(); }
+
+  /**
+   * @brief Write the action timings, one line per action
+   * @param[in] os
+   * @param[in] csv - comma separated values instead of aligned columns
+   */
+  void printTimings(std::ostream &os, bool csv) const;
+
+  /**
+   * @brief Count an error or fatal message posted by the plugin
+   */
+  void addErrorMessage() { ++_nbErrorMessages; }
+  std::size_t getNbErrorMessages() const { return _nbErrorMessages; }
+
+  /**
+   * @brief Image registry, images are released by property set handle
+   */
+  OfxPropertySetHandle registerImage(Image *image);
+  bool releaseImage(OfxPropertySetHandle handle);
+
+  static const void* fetchSuite(OfxPropertySetHandle host, const char *suiteName, int suiteVersion);
+
+private:
+  Host();
+  Host(const Host&) = delete;
+  Host& operator=(const Host&) = delete;
+
+  void initHostProps();
+  void checkStatus(OfxStatus status, const char *action) const;
+  OfxRectD getInputRoD(OfxTime time);
+  void fillRenderScale(PropertySet &args) const;
+
+  PropertySet _hostProps;
+  OfxHost _ofxHost;
+
+  void *_library = nullptr;
+  OfxPlugin *_plugin = nullptr;
+
+  std::unique_ptr<Effect> _descriptor;
+  std::map< std::string, std::unique_ptr<Effect> > _contextDescriptors;
+  std::string _context;
+  std::unique_ptr<Effect> _instance;
+  bool _isInstanceCreated = false; //created and not being destroyed
+
+  static const std::size_t kMaxInstanceChangedDepth = 8;
+  std::size_t _instanceChangedDepth = 0;
+
+  struct PendingClip
+  {
+    std::string name;
+    std::string pattern;
+    OfxTime first;
+    OfxTime last;
+  };
+  std::vector<PendingClip> _pendingClips;
+
+  std::unique_ptr<Interact> _interactDescriptor;
+  std::unique_ptr<Interact> _interact;
+  OfxPluginEntryPoint *_interactEntry = nullptr;
+
+  OfxTime _time = 0.0;
+  OfxTime _timeFirst = 0.0;
+  OfxTime _timeLast = 0.0;
+  double _frameRate = 25.0;
+
+  std::map<std::string, ActionTiming> _timings;
+  std::size_t _nbErrorMessages = 0;
+
+  std::mutex _imagesMutex;
+  std::map< OfxPropertySetHandle, std::unique_ptr<Image> > _images;
+};
+
+} //namespace Host
+} //namespace openMVG_ofx
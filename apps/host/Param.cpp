@@ -0,0 +1,652 @@
+#include "Param.hpp"
+#include "Host.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdarg>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+namespace openMVG_ofx {
+namespace Host {
+
+namespace {
+
+void setDefaultProps(PropertySet &props, const std::string &type, const std::string &name, std::size_t dimension, bool isInteger)
+{
+  props.setString(kOfxPropType, kOfxTypeParameter);
+  props.setString(kOfxParamPropType, type);
+  props.setString(kOfxPropName, name);
+  props.setString(kOfxPropLabel, name);
+  props.setString(kOfxPropShortLabel, name);
+  props.setString(kOfxPropLongLabel, name);
+  props.setString(kOfxParamPropScriptName, name);
+  props.setString(kOfxParamPropHint, "");
+  props.setString(kOfxParamPropParent, "");
+  props.setInt(kOfxParamPropSecret, 0);
+  props.setInt(kOfxParamPropEnabled, 1);
+  props.setPointer(kOfxParamPropDataPtr, nullptr);
+
+  if(type == kOfxParamTypeGroup)
+  {
+    props.setInt(kOfxParamPropGroupOpen, 1);
+    return;
+  }
+  if(type == kOfxParamTypePage)
+  {
+    props.setStrings(kOfxParamPropPageChild, {});
+    return;
+  }
+  if(type == kOfxParamTypePushButton)
+    return;
+
+  //Value parameters
+  props.setInt(kOfxParamPropAnimates, 1);
+  props.setInt(kOfxParamPropIsAnimating, 0);
+  props.setInt(kOfxParamPropIsAutoKeying, 0);
+  props.setInt(kOfxParamPropPersistant, 1);
+  props.setInt(kOfxParamPropEvaluateOnChange, 1);
+  props.setInt(kOfxParamPropPluginMayWrite, 0);
+  props.setInt(kOfxParamPropCanUndo, 1);
+  props.setString(kOfxParamPropCacheInvalidation, kOfxParamInvalidateValueChange);
+  props.setPointer(kOfxParamPropInteractV1, nullptr);
+
+  if(type == kOfxParamTypeString || type == kOfxParamTypeCustom)
+  {
+    props.setString(kOfxParamPropDefault, "");
+    props.setString(kOfxParamPropStringMode, kOfxParamStringIsSingleLine);
+    props.setInt(kOfxParamPropStringFilePathExists, 1);
+    return;
+  }
+  if(type == kOfxParamTypeChoice)
+    props.setStrings(kOfxParamPropChoiceOption, {});
+
+  if(isInteger)
+  {
+    props.setInts(kOfxParamPropDefault, std::vector<int>(dimension, 0));
+    if(type != kOfxParamTypeBoolean && type != kOfxParamTypeChoice)
+    {
+      props.setInts(kOfxParamPropMin, std::vector<int>(dimension, -2147483647));
+      props.setInts(kOfxParamPropMax, std::vector<int>(dimension, 2147483647));
+      props.setInts(kOfxParamPropDisplayMin, std::vector<int>(dimension, -2147483647));
+      props.setInts(kOfxParamPropDisplayMax, std::vector<int>(dimension, 2147483647));
+    }
+  }
+  else
+  {
+    props.setDoubles(kOfxParamPropDefault, std::vector<double>(dimension, 0.0));
+    props.setDoubles(kOfxParamPropMin, std::vector<double>(dimension, -1.7e308));
+    props.setDoubles(kOfxParamPropMax, std::vector<double>(dimension, 1.7e308));
+    props.setDoubles(kOfxParamPropDisplayMin, std::vector<double>(dimension, -1.7e308));
+    props.setDoubles(kOfxParamPropDisplayMax, std::vector<double>(dimension, 1.7e308));
+    props.setDouble(kOfxParamPropIncrement, 1.0);
+    props.setInt(kOfxParamPropDigits, 2);
+    props.setString(kOfxParamPropDoubleType, kOfxParamDoubleTypePlain);
+  }
+  const char *dimensionLabels[] = {"x", "y", "z", "w"};
+  for(std::size_t i = 0; i < dimension && dimension > 1; ++i)
+    props.setString(kOfxParamPropDimensionLabel, dimensionLabels[i], i);
+}
+
+} //namespace
+
+Param::Param(ParamSet &paramSet, const std::string &type, const std::string &name)
+  : _paramSet(paramSet)
+  , _type(type)
+  , _name(name)
+{
+  setDefaultProps(_props, type, name, getDimension(), isInteger());
+  resetToDefault();
+}
+
+std::size_t Param::getDimension() const
+{
+  if(_type == kOfxParamTypeInteger || _type == kOfxParamTypeDouble ||
+     _type == kOfxParamTypeBoolean || _type == kOfxParamTypeChoice)
+    return 1;
+  if(_type == kOfxParamTypeInteger2D || _type == kOfxParamTypeDouble2D)
+    return 2;
+  if(_type == kOfxParamTypeInteger3D || _type == kOfxParamTypeDouble3D || _type == kOfxParamTypeRGB)
+    return 3;
+  if(_type == kOfxParamTypeRGBA)
+    return 4;
+  if(_type == kOfxParamTypeString || _type == kOfxParamTypeCustom)
+    return 1;
+  return 0;
+}
+
+bool Param::isString() const
+{
+  return _type == kOfxParamTypeString || _type == kOfxParamTypeCustom;
+}
+
+bool Param::isInteger() const
+{
+  return _type == kOfxParamTypeInteger || _type == kOfxParamTypeInteger2D || _type == kOfxParamTypeInteger3D ||
+         _type == kOfxParamTypeBoolean || _type == kOfxParamTypeChoice;
+}
+
+bool Param::isAnimatable() const
+{
+  return getDimension() > 0;
+}
+
+void Param::resetToDefault()
+{
+  _keys.clear();
+  _stringKeys.clear();
+  if(isString())
+  {
+    _stringValue = _props.getString(kOfxParamPropDefault);
+    return;
+  }
+  _value.resize(getDimension());
+  for(std::size_t i = 0; i < _value.size(); ++i)
+    _value[i] = _props.getDouble(kOfxParamPropDefault, i);
+}
+
+std::vector<double> Param::getValueAtTime(OfxTime time) const
+{
+  if(_keys.empty())
+    return _value;
+
+  auto next = _keys.lower_bound(time);
+  if(next == _keys.begin())
+    return next->second;
+  if(next == _keys.end())
+    return _keys.rbegin()->second;
+  if(next->first == time)
+    return next->second;
+
+  auto previous = std::prev(next);
+  if(isInteger())
+    return previous->second;
+
+  //Linear interpolation between the two surrounding keys
+  const double t = (time - previous->first) / (next->first - previous->first);
+  std::vector<double> value(previous->second.size());
+  for(std::size_t i = 0; i < value.size(); ++i)
+    value[i] = previous->second[i] + t * (next->second[i] - previous->second[i]);
+  return value;
+}
+
+const std::string& Param::getStringAtTime(OfxTime time) const
+{
+  if(_stringKeys.empty())
+    return _stringValue;
+  auto next = _stringKeys.upper_bound(time);
+  if(next == _stringKeys.begin())
+    return next->second;
+  return std::prev(next)->second;
+}
+
+void Param::setValue(OfxTime time, const std::vector<double> &value)
+{
+  if(_keys.empty())
+    _value = value;
+  else
+    setKey(time, value);
+}
+
+void Param::setString(OfxTime time, const std::string &value)
+{
+  if(_stringKeys.empty())
+    _stringValue = value;
+  else
+    setStringKey(time, value);
+}
+
+void Param::setKey(OfxTime time, const std::vector<double> &value)
+{
+  _keys[time] = value;
+  _props.setInt(kOfxParamPropIsAnimating, 1);
+}
+
+void Param::setStringKey(OfxTime time, const std::string &value)
+{
+  _stringKeys[time] = value;
+  _props.setInt(kOfxParamPropIsAnimating, 1);
+}
+
+std::vector<OfxTime> Param::getKeyTimes() const
+{
+  std::vector<OfxTime> times;
+  for(const auto &key : _keys)
+    times.push_back(key.first);
+  for(const auto &key : _stringKeys)
+    times.push_back(key.first);
+  return times;
+}
+
+bool Param::deleteKey(OfxTime time)
+{
+  const bool found = (_keys.erase(time) + _stringKeys.erase(time)) > 0;
+  if(_keys.empty() && _stringKeys.empty())
+    _props.setInt(kOfxParamPropIsAnimating, 0);
+  return found;
+}
+
+void Param::deleteAllKeys()
+{
+  //Keep the last evaluated value as static value
+  if(!_keys.empty())
+    _value = _keys.rbegin()->second;
+  if(!_stringKeys.empty())
+    _stringValue = _stringKeys.rbegin()->second;
+  _keys.clear();
+  _stringKeys.clear();
+  _props.setInt(kOfxParamPropIsAnimating, 0);
+}
+
+void Param::copyFrom(const Param &other, OfxTime offset, const OfxRangeD *range)
+{
+  _value = other._value;
+  _stringValue = other._stringValue;
+  _keys.clear();
+  _stringKeys.clear();
+  for(const auto &key : other._keys)
+  {
+    if(range == nullptr || (key.first >= range->min && key.first <= range->max))
+      _keys[key.first + offset] = key.second;
+  }
+  for(const auto &key : other._stringKeys)
+  {
+    if(range == nullptr || (key.first >= range->min && key.first <= range->max))
+      _stringKeys[key.first + offset] = key.second;
+  }
+  _props.setInt(kOfxParamPropIsAnimating, (_keys.empty() && _stringKeys.empty()) ? 0 : 1);
+}
+
+std::string Param::toString(OfxTime time) const
+{
+  if(isString())
+    return getStringAtTime(time);
+  std::ostringstream os;
+  const std::vector<double> value = getValueAtTime(time);
+  for(std::size_t i = 0; i < value.size(); ++i)
+    os << (i ? " " : "") << value[i];
+  return os.str();
+}
+
+std::vector<double> Param::parseValues(const std::vector<std::string> &args) const
+{
+  if(args.size() != getDimension())
+    throw std::invalid_argument("Parameter " + _name + " expects " + std::to_string(getDimension()) + " value(s)");
+  std::vector<double> values;
+  for(const std::string &arg : args)
+  {
+    if(_type == kOfxParamTypeBoolean && (arg == "true" || arg == "false"))
+    {
+      values.push_back(arg == "true" ? 1.0 : 0.0);
+      continue;
+    }
+    if(_type == kOfxParamTypeChoice)
+    {
+      //Choice options can be given by label
+      const std::size_t nbOptions = _props.getDimension(kOfxParamPropChoiceOption);
+      std::size_t option = 0;
+      while(option < nbOptions && _props.getString(kOfxParamPropChoiceOption, option) != arg)
+        ++option;
+      if(option < nbOptions)
+      {
+        values.push_back(static_cast<double>(option));
+        continue;
+      }
+    }
+    values.push_back(std::stod(arg));
+  }
+  return values;
+}
+
+Param* ParamSet::define(const std::string &type, const std::string &name)
+{
+  if(_paramsByName.count(name))
+    return nullptr;
+  _params.emplace_back(new Param(*this, type, name));
+  Param *param = _params.back().get();
+  _paramsByName[name] = param;
+  return param;
+}
+
+Param* ParamSet::find(const std::string &name)
+{
+  auto it = _paramsByName.find(name);
+  return (it == _paramsByName.end()) ? nullptr : it->second;
+}
+
+void ParamSet::cloneFrom(const ParamSet &descriptor)
+{
+  _props.merge(descriptor._props);
+  for(const auto &descriptorParam : descriptor._params)
+  {
+    Param *param = define(descriptorParam->getType(), descriptorParam->getName());
+    if(param == nullptr)
+      continue;
+    param->getProps().merge(descriptorParam->getProps());
+    param->resetToDefault();
+  }
+}
+
+namespace {
+
+//Parameter suite entry points
+
+OfxStatus readValue(const Param &param, OfxTime time, va_list ap)
+{
+  if(param.getDimension() == 0)
+    return kOfxStatErrBadHandle;
+  if(param.isString())
+  {
+    const char **value = va_arg(ap, const char**);
+    *value = param.getStringAtTime(time).c_str();
+    return kOfxStatOK;
+  }
+  const std::vector<double> value = param.getValueAtTime(time);
+  for(double v : value)
+  {
+    if(param.isInteger())
+      *va_arg(ap, int*) = static_cast<int>(std::lround(v));
+    else
+      *va_arg(ap, double*) = v;
+  }
+  return kOfxStatOK;
+}
+
+OfxStatus writeValue(Param &param, OfxTime time, bool isKey, va_list ap)
+{
+  if(param.getDimension() == 0)
+    return kOfxStatErrBadHandle;
+  if(param.isString())
+  {
+    const char *value = va_arg(ap, const char*);
+    if(isKey)
+      param.setStringKey(time, value ? value : "");
+    else
+      param.setString(time, value ? value : "");
+    return kOfxStatOK;
+  }
+  std::vector<double> value(param.getDimension());
+  for(double &v : value)
+  {
+    if(param.isInteger())
+      v = va_arg(ap, int);
+    else
+      v = va_arg(ap, double);
+  }
+  if(isKey)
+    param.setKey(time, value);
+  else
+    param.setValue(time, value);
+  return kOfxStatOK;
+}
+
+OfxStatus paramDefine(OfxParamSetHandle paramSet, const char *paramType, const char *name, OfxPropertySetHandle *propertySet)
+{
+  if(paramSet == nullptr)
+    return kOfxStatErrBadHandle;
+  Param *param = ParamSet::fromHandle(paramSet)->define(paramType, name);
+  if(param == nullptr)
+    return kOfxStatErrExists;
+  if(propertySet)
+    *propertySet = param->getProps().getHandle();
+  return kOfxStatOK;
+}
+
+OfxStatus paramGetHandle(OfxParamSetHandle paramSet, const char *name, OfxParamHandle *param, OfxPropertySetHandle *propertySet)
+{
+  if(paramSet == nullptr)
+    return kOfxStatErrBadHandle;
+  Param *p = ParamSet::fromHandle(paramSet)->find(name);
+  if(p == nullptr)
+    return kOfxStatErrUnknown;
+  *param = p->getHandle();
+  if(propertySet)
+    *propertySet = p->getProps().getHandle();
+  return kOfxStatOK;
+}
+
+OfxStatus paramSetGetPropertySet(OfxParamSetHandle paramSet, OfxPropertySetHandle *propHandle)
+{
+  if(paramSet == nullptr)
+    return kOfxStatErrBadHandle;
+  *propHandle = ParamSet::fromHandle(paramSet)->getProps().getHandle();
+  return kOfxStatOK;
+}
+
+OfxStatus paramGetPropertySet(OfxParamHandle param, OfxPropertySetHandle *propHandle)
+{
+  if(param == nullptr)
+    return kOfxStatErrBadHandle;
+  *propHandle = Param::fromHandle(param)->getProps().getHandle();
+  return kOfxStatOK;
+}
+
+OfxStatus paramGetValue(OfxParamHandle paramHandle, ...)
+{
+  if(paramHandle == nullptr)
+    return kOfxStatErrBadHandle;
+  Param *param = Param::fromHandle(paramHandle);
+  va_list ap;
+  va_start(ap, paramHandle);
+  const OfxStatus stat = readValue(*param, param->getParamSet().getTime(), ap);
+  va_end(ap);
+  return stat;
+}
+
+OfxStatus paramGetValueAtTime(OfxParamHandle paramHandle, OfxTime time, ...)
+{
+  if(paramHandle == nullptr)
+    return kOfxStatErrBadHandle;
+  va_list ap;
+  va_start(ap, time);
+  const OfxStatus stat = readValue(*Param::fromHandle(paramHandle), time, ap);
+  va_end(ap);
+  return stat;
+}
+
+OfxStatus paramGetDerivative(OfxParamHandle paramHandle, OfxTime time, ...)
+{
+  if(paramHandle == nullptr)
+    return kOfxStatErrBadHandle;
+  const Param *param = Param::fromHandle(paramHandle);
+  if(param->isString() || param->isInteger())
+    return kOfxStatErrBadHandle;
+  const double dt = 0.001;
+  const std::vector<double> before = param->getValueAtTime(time - dt);
+  const std::vector<double> after = param->getValueAtTime(time + dt);
+  va_list ap;
+  va_start(ap, time);
+  for(std::size_t i = 0; i < before.size(); ++i)
+    *va_arg(ap, double*) = (after[i] - before[i]) / (2.0 * dt);
+  va_end(ap);
+  return kOfxStatOK;
+}
+
+OfxStatus paramGetIntegral(OfxParamHandle paramHandle, OfxTime time1, OfxTime time2, ...)
+{
+  if(paramHandle == nullptr)
+    return kOfxStatErrBadHandle;
+  const Param *param = Param::fromHandle(paramHandle);
+  if(param->isString() || param->isInteger())
+    return kOfxStatErrBadHandle;
+  //Trapezoidal integration, exact for the piecewise linear curves of this host
+  const int nbSteps = 100;
+  const double step = (time2 - time1) / nbSteps;
+  std::vector<double> integral(param->getDimension(), 0.0);
+  for(int s = 0; s < nbSteps; ++s)
+  {
+    const std::vector<double> a = param->getValueAtTime(time1 + s * step);
+    const std::vector<double> b = param->getValueAtTime(time1 + (s + 1) * step);
+    for(std::size_t i = 0; i < integral.size(); ++i)
+      integral[i] += 0.5 * (a[i] + b[i]) * step;
+  }
+  va_list ap;
+  va_start(ap, time2);
+  for(double value : integral)
+    *va_arg(ap, double*) = value;
+  va_end(ap);
+  return kOfxStatOK;
+}
+
+//Notify the instance like the user edits, errors can't cross the suite call
+OfxStatus notifyPluginEdit(Param &param)
+{
+  try
+  {
+    Host::instance().pluginChangedParam(param);
+  }
+  catch(std::exception &e)
+  {
+    Host::instance().addErrorMessage();
+    std::clog << "[host][error] plugin edit of " << param.getName() << ": " << e.what() << std::endl;
+  }
+  return kOfxStatOK;
+}
+
+OfxStatus paramSetValue(OfxParamHandle paramHandle, ...)
+{
+  if(paramHandle == nullptr)
+    return kOfxStatErrBadHandle;
+  Param *param = Param::fromHandle(paramHandle);
+  va_list ap;
+  va_start(ap, paramHandle);
+  const OfxStatus stat = writeValue(*param, param->getParamSet().getTime(), false, ap);
+  va_end(ap);
+  if(stat != kOfxStatOK)
+    return stat;
+  return notifyPluginEdit(*param);
+}
+
+OfxStatus paramSetValueAtTime(OfxParamHandle paramHandle, OfxTime time, ...)
+{
+  if(paramHandle == nullptr)
+    return kOfxStatErrBadHandle;
+  Param *param = Param::fromHandle(paramHandle);
+  va_list ap;
+  va_start(ap, time);
+  const OfxStatus stat = writeValue(*param, time, true, ap);
+  va_end(ap);
+  if(stat != kOfxStatOK)
+    return stat;
+  return notifyPluginEdit(*param);
+}
+
+OfxStatus paramGetNumKeys(OfxParamHandle paramHandle, unsigned int *numberOfKeys)
+{
+  if(paramHandle == nullptr)
+    return kOfxStatErrBadHandle;
+  *numberOfKeys = static_cast<unsigned int>(Param::fromHandle(paramHandle)->getKeyTimes().size());
+  return kOfxStatOK;
+}
+
+OfxStatus paramGetKeyTime(OfxParamHandle paramHandle, unsigned int nthKey, OfxTime *time)
+{
+  if(paramHandle == nullptr)
+    return kOfxStatErrBadHandle;
+  const std::vector<OfxTime> times = Param::fromHandle(paramHandle)->getKeyTimes();
+  if(nthKey >= times.size())
+    return kOfxStatErrBadIndex;
+  *time = times[nthKey];
+  return kOfxStatOK;
+}
+
+OfxStatus paramGetKeyIndex(OfxParamHandle paramHandle, OfxTime time, int direction, int *index)
+{
+  if(paramHandle == nullptr)
+    return kOfxStatErrBadHandle;
+  const std::vector<OfxTime> times = Param::fromHandle(paramHandle)->getKeyTimes();
+  for(std::size_t i = 0; i < times.size(); ++i)
+  {
+    if((direction == 0 && times[i] == time) || (direction > 0 && times[i] > time))
+    {
+      *index = static_cast<int>(i);
+      return kOfxStatOK;
+    }
+  }
+  if(direction < 0)
+  {
+    for(std::size_t i = times.size(); i > 0; --i)
+    {
+      if(times[i - 1] < time)
+      {
+        *index = static_cast<int>(i - 1);
+        return kOfxStatOK;
+      }
+    }
+  }
+  return kOfxStatFailed;
+}
+
+OfxStatus paramDeleteKey(OfxParamHandle paramHandle, OfxTime time)
+{
+  if(paramHandle == nullptr)
+    return kOfxStatErrBadHandle;
+  return Param::fromHandle(paramHandle)->deleteKey(time) ? kOfxStatOK : kOfxStatErrBadIndex;
+}
+
+OfxStatus paramDeleteAllKeys(OfxParamHandle paramHandle)
+{
+  if(paramHandle == nullptr)
+    return kOfxStatErrBadHandle;
+  Param::fromHandle(paramHandle)->deleteAllKeys();
+  return kOfxStatOK;
+}
+
+OfxStatus paramCopy(OfxParamHandle paramTo, OfxParamHandle paramFrom, OfxTime dstOffset, const OfxRangeD *frameRange)
+{
+  if(paramTo == nullptr || paramFrom == nullptr)
+    return kOfxStatErrBadHandle;
+  Param *to = Param::fromHandle(paramTo);
+  const Param *from = Param::fromHandle(paramFrom);
+  if(to->getType() != from->getType())
+    return kOfxStatErrValue;
+  to->copyFrom(*from, dstOffset, frameRange);
+  return kOfxStatOK;
+}
+
+OfxStatus paramEditBegin(OfxParamSetHandle paramSet, const char *name)
+{
+  if(paramSet == nullptr)
+    return kOfxStatErrBadHandle;
+  ParamSet::fromHandle(paramSet)->beginEdit();
+  return kOfxStatOK;
+}
+
+OfxStatus paramEditEnd(OfxParamSetHandle paramSet)
+{
+  if(paramSet == nullptr)
+    return kOfxStatErrBadHandle;
+  ParamSet::fromHandle(paramSet)->endEdit();
+  return kOfxStatOK;
+}
+
+} //namespace
+
+const OfxParameterSuiteV1* ParamSet::getSuite()
+{
+  static const OfxParameterSuiteV1 suite = {
+    paramDefine,
+    paramGetHandle,
+    paramSetGetPropertySet,
+    paramGetPropertySet,
+    paramGetValue,
+    paramGetValueAtTime,
+    paramGetDerivative,
+    paramGetIntegral,
+    paramSetValue,
+    paramSetValueAtTime,
+    paramGetNumKeys,
+    paramGetKeyTime,
+    paramGetKeyIndex,
+    paramDeleteKey,
+    paramDeleteAllKeys,
+    paramCopy,
+    paramEditBegin,
+    paramEditEnd
+  };
+  return &suite;
+}
+
+} //namespace Host
+} //namespace openMVG_ofx
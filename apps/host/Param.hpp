@@ -0,0 +1,170 @@
+#pragma once
+
+#include "PropertySet.hpp"
+
+#include <ofxParam.h>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace openMVG_ofx {
+namespace Host {
+
+class ParamSet;
+
+/**
+ * @brief Host side OFX parameter, with animation keys
+ * Numerical values are stored as doubles for all the dimensions.
+ * Double parameters are linearly interpolated between keys,
+ * the other types hold the previous key value.
+ */
+class Param
+{
+public:
+  Param(ParamSet &paramSet, const std::string &type, const std::string &name);
+
+  OfxParamHandle getHandle()
+  {
+    return reinterpret_cast<OfxParamHandle>(this);
+  }
+
+  static Param* fromHandle(OfxParamHandle handle)
+  {
+    return reinterpret_cast<Param*>(handle);
+  }
+
+  const std::string& getType() const { return _type; }
+  const std::string& getName() const { return _name; }
+  PropertySet& getProps() { return _props; }
+  const PropertySet& getProps() const { return _props; }
+  ParamSet& getParamSet() { return _paramSet; }
+
+  /**
+   * @brief Number of values, 0 for the parameters without value (group, page, push button)
+   * @return dimension
+   */
+  std::size_t getDimension() const;
+
+  bool isString() const;
+  bool isInteger() const;
+  bool isAnimatable() const;
+
+  /**
+   * @brief Initialize the value from the kOfxParamPropDefault property
+   */
+  void resetToDefault();
+
+  std::vector<double> getValueAtTime(OfxTime time) const;
+  const std::string& getStringAtTime(OfxTime time) const;
+
+  /**
+   * @brief Set the static value, or a key at the given time if the parameter is animated
+   */
+  void setValue(OfxTime time, const std::vector<double> &value);
+  void setString(OfxTime time, const std::string &value);
+
+  void setKey(OfxTime time, const std::vector<double> &value);
+  void setStringKey(OfxTime time, const std::string &value);
+
+  std::vector<OfxTime> getKeyTimes() const;
+  bool deleteKey(OfxTime time);
+  void deleteAllKeys();
+
+  /**
+   * @brief Copy values and keys from another parameter of the same type
+   * @param[in] other
+   * @param[in] offset - time offset applied to the keys
+   * @param[in] range - copy only the keys in this range, all the keys if null
+   */
+  void copyFrom(const Param &other, OfxTime offset, const OfxRangeD *range);
+
+  /**
+   * @brief Format the value at time as a string, values separated by spaces
+   * @param[in] time
+   * @return printable value
+   */
+  std::string toString(OfxTime time) const;
+
+  /**
+   * @brief Parse values from script arguments
+   * @param[in] args
+   * @return numerical values
+   */
+  std::vector<double> parseValues(const std::vector<std::string> &args) const;
+
+private:
+  ParamSet &_paramSet;
+  const std::string _type;
+  const std::string _name;
+  PropertySet _props;
+
+  std::vector<double> _value;
+  std::string _stringValue;
+  std::map<OfxTime, std::vector<double> > _keys;
+  std::map<OfxTime, std::string> _stringKeys;
+};
+
+/**
+ * @brief Host side OFX parameter set, of an effect descriptor or instance
+ */
+class ParamSet
+{
+public:
+  OfxParamSetHandle getHandle()
+  {
+    return reinterpret_cast<OfxParamSetHandle>(this);
+  }
+
+  static ParamSet* fromHandle(OfxParamSetHandle handle)
+  {
+    return reinterpret_cast<ParamSet*>(handle);
+  }
+
+  PropertySet& getProps() { return _props; }
+
+  /**
+   * @brief Define a new parameter, with the default properties of its type
+   * @param[in] type - OFX parameter type
+   * @param[in] name
+   * @return the parameter, null if it already exists
+   */
+  Param* define(const std::string &type, const std::string &name);
+
+  Param* find(const std::string &name);
+
+  const std::vector< std::unique_ptr<Param> >& getParams() const { return _params; }
+
+  /**
+   * @brief Clone the parameters of a descriptor, values are set to their default
+   * @param[in] descriptor
+   */
+  void cloneFrom(const ParamSet &descriptor);
+
+  /**
+   * @brief Current time, used by setValue on animated parameters
+   */
+  OfxTime getTime() const { return _time; }
+  void setTime(OfxTime time) { _time = time; }
+
+  int getEditLevel() const { return _editLevel; }
+  void beginEdit() { ++_editLevel; }
+  void endEdit() { if(_editLevel > 0) --_editLevel; }
+
+  /**
+   * @brief Get the OFX parameter suite implemented on this class
+   * @return suite
+   */
+  static const OfxParameterSuiteV1* getSuite();
+
+private:
+  PropertySet _props;
+  std::vector< std::unique_ptr<Param> > _params;
+  std::map<std::string, Param*> _paramsByName;
+  OfxTime _time = 0.0;
+  int _editLevel = 0;
+};
+
+} //namespace Host
+} //namespace openMVG_ofx
@@ -0,0 +1,405 @@
+#include "PropertySet.hpp"
+
+namespace openMVG_ofx {
+namespace Host {
+
+std::size_t PropertySet::Property::getDimension() const
+{
+  switch(type)
+  {
+    case eTypeInt : return ints.size();
+    case eTypeDouble : return doubles.size();
+    case eTypeString : return strings.size();
+    case eTypePointer : return pointers.size();
+  }
+  return 0;
+}
+
+void PropertySet::Property::resize(std::size_t dimension)
+{
+  switch(type)
+  {
+    case eTypeInt : ints.resize(dimension, 0); break;
+    case eTypeDouble : doubles.resize(dimension, 0.0); break;
+    case eTypeString : strings.resize(dimension); break;
+    case eTypePointer : pointers.resize(dimension, nullptr); break;
+  }
+}
+
+PropertySet::Property* PropertySet::find(const std::string &name)
+{
+  auto it = _properties.find(name);
+  return (it == _properties.end()) ? nullptr : &it->second;
+}
+
+const PropertySet::Property* PropertySet::find(const std::string &name) const
+{
+  auto it = _properties.find(name);
+  return (it == _properties.end()) ? nullptr : &it->second;
+}
+
+PropertySet::Property& PropertySet::fetch(const std::string &name, EType type)
+{
+  auto it = _properties.find(name);
+  if(it != _properties.end())
+    return it->second;
+  Property &property = _properties[name];
+  property.type = type;
+  return property;
+}
+
+namespace {
+
+void ensureIndex(PropertySet::Property &property, std::size_t index)
+{
+  if(index >= property.getDimension())
+    property.resize(index + 1);
+}
+
+} //namespace
+
+void PropertySet::setInt(const std::string &name, int value, std::size_t index)
+{
+  Property &property = fetch(name, eTypeInt);
+  ensureIndex(property, index);
+  if(property.type == eTypeDouble)
+    property.doubles[index] = value;
+  else
+    property.ints[index] = value;
+}
+
+void PropertySet::setDouble(const std::string &name, double value, std::size_t index)
+{
+  Property &property = fetch(name, eTypeDouble);
+  ensureIndex(property, index);
+  if(property.type == eTypeInt)
+    property.ints[index] = static_cast<int>(value);
+  else
+    property.doubles[index] = value;
+}
+
+void PropertySet::setString(const std::string &name, const std::string &value, std::size_t index)
+{
+  Property &property = fetch(name, eTypeString);
+  property.type = eTypeString;
+  ensureIndex(property, index);
+  property.strings[index] = value;
+}
+
+void PropertySet::setPointer(const std::string &name, void *value, std::size_t index)
+{
+  Property &property = fetch(name, eTypePointer);
+  property.type = eTypePointer;
+  ensureIndex(property, index);
+  property.pointers[index] = value;
+}
+
+void PropertySet::setInts(const std::string &name, const std::vector<int> &values)
+{
+  Property &property = fetch(name, eTypeInt);
+  property.type = eTypeInt;
+  property.ints = values;
+}
+
+void PropertySet::setDoubles(const std::string &name, const std::vector<double> &values)
+{
+  Property &property = fetch(name, eTypeDouble);
+  property.type = eTypeDouble;
+  property.doubles = values;
+}
+
+void PropertySet::setStrings(const std::string &name, const std::vector<std::string> &values)
+{
+  Property &property = fetch(name, eTypeString);
+  property.type = eTypeString;
+  property.strings = values;
+}
+
+int PropertySet::getInt(const std::string &name, std::size_t index, int defaultValue) const
+{
+  const Property *property = find(name);
+  if(property == nullptr || index >= property->getDimension())
+    return defaultValue;
+  if(property->type == eTypeDouble)
+    return static_cast<int>(property->doubles[index]);
+  if(property->type == eTypeInt)
+    return property->ints[index];
+  return defaultValue;
+}
+
+double PropertySet::getDouble(const std::string &name, std::size_t index, double defaultValue) const
+{
+  const Property *property = find(name);
+  if(property == nullptr || index >= property->getDimension())
+    return defaultValue;
+  if(property->type == eTypeInt)
+    return property->ints[index];
+  if(property->type == eTypeDouble)
+    return property->doubles[index];
+  return defaultValue;
+}
+
+std::string PropertySet::getString(const std::string &name, std::size_t index, const std::string &defaultValue) const
+{
+  const Property *property = find(name);
+  if(property == nullptr || property->type != eTypeString || index >= property->strings.size())
+    return defaultValue;
+  return property->strings[index];
+}
+
+void* PropertySet::getPointer(const std::string &name, std::size_t index) const
+{
+  const Property *property = find(name);
+  if(property == nullptr || property->type != eTypePointer || index >= property->pointers.size())
+    return nullptr;
+  return property->pointers[index];
+}
+
+std::size_t PropertySet::getDimension(const std::string &name) const
+{
+  const Property *property = find(name);
+  return property ? property->getDimension() : 0;
+}
+
+void PropertySet::merge(const PropertySet &other)
+{
+  for(const auto &property : other._properties)
+    _properties[property.first] = property.second;
+}
+
+namespace {
+
+//Property suite entry points
+
+template<PropertySet::EType type>
+OfxStatus getProperty(OfxPropertySetHandle handle, const char *name, int index, PropertySet::Property* &property)
+{
+  if(handle == nullptr)
+    return kOfxStatErrBadHandle;
+  property = PropertySet::fromHandle(handle)->find(name);
+  if(property == nullptr)
+    return kOfxStatErrUnknown;
+  if(index < 0 || static_cast<std::size_t>(index) >= property->getDimension())
+    return kOfxStatErrBadIndex;
+  const bool isNumerical = (type == PropertySet::eTypeInt || type == PropertySet::eTypeDouble);
+  const bool isPropertyNumerical = (property->type == PropertySet::eTypeInt || property->type == PropertySet::eTypeDouble);
+  if(property->type != type && !(isNumerical && isPropertyNumerical))
+    return kOfxStatErrValue;
+  return kOfxStatOK;
+}
+
+OfxStatus propSetPointer(OfxPropertySetHandle properties, const char *property, int index, void *value)
+{
+  if(properties == nullptr)
+    return kOfxStatErrBadHandle;
+  if(index < 0)
+    return kOfxStatErrBadIndex;
+  PropertySet::fromHandle(properties)->setPointer(property, value, index);
+  return kOfxStatOK;
+}
+
+OfxStatus propSetString(OfxPropertySetHandle properties, const char *property, int index, const char *value)
+{
+  if(properties == nullptr)
+    return kOfxStatErrBadHandle;
+  if(index < 0)
+    return kOfxStatErrBadIndex;
+  PropertySet::fromHandle(properties)->setString(property, value ? value : "", index);
+  return kOfxStatOK;
+}
+
+OfxStatus propSetDouble(OfxPropertySetHandle properties, const char *property, int index, double value)
+{
+  if(properties == nullptr)
+    return kOfxStatErrBadHandle;
+  if(index < 0)
+    return kOfxStatErrBadIndex;
+  PropertySet::fromHandle(properties)->setDouble(property, value, index);
+  return kOfxStatOK;
+}
+
+OfxStatus propSetInt(OfxPropertySetHandle properties, const char *property, int index, int value)
+{
+  if(properties == nullptr)
+    return kOfxStatErrBadHandle;
+  if(index < 0)
+    return kOfxStatErrBadIndex;
+  PropertySet::fromHandle(properties)->setInt(property, value, index);
+  return kOfxStatOK;
+}
+
+OfxStatus propSetPointerN(OfxPropertySetHandle properties, const char *property, int count, void *const *value)
+{
+  for(int i = 0; i < count; ++i)
+  {
+    const OfxStatus stat = propSetPointer(properties, property, i, value[i]);
+    if(stat != kOfxStatOK)
+      return stat;
+  }
+  return kOfxStatOK;
+}
+
+OfxStatus propSetStringN(OfxPropertySetHandle properties, const char *property, int count, const char *const *value)
+{
+  for(int i = 0; i < count; ++i)
+  {
+    const OfxStatus stat = propSetString(properties, property, i, value[i]);
+    if(stat != kOfxStatOK)
+      return stat;
+  }
+  return kOfxStatOK;
+}
+
+OfxStatus propSetDoubleN(OfxPropertySetHandle properties, const char *property, int count, const double *value)
+{
+  for(int i = 0; i < count; ++i)
+  {
+    const OfxStatus stat = propSetDouble(properties, property, i, value[i]);
+    if(stat != kOfxStatOK)
+      return stat;
+  }
+  return kOfxStatOK;
+}
+
+OfxStatus propSetIntN(OfxPropertySetHandle properties, const char *property, int count, const int *value)
+{
+  for(int i = 0; i < count; ++i)
+  {
+    const OfxStatus stat = propSetInt(properties, property, i, value[i]);
+    if(stat != kOfxStatOK)
+      return stat;
+  }
+  return kOfxStatOK;
+}
+
+OfxStatus propGetPointer(OfxPropertySetHandle properties, const char *property, int index, void **value)
+{
+  PropertySet::Property *prop = nullptr;
+  const OfxStatus stat = getProperty<PropertySet::eTypePointer>(properties, property, index, prop);
+  if(stat == kOfxStatOK)
+    *value = prop->pointers[index];
+  return stat;
+}
+
+OfxStatus propGetString(OfxPropertySetHandle properties, const char *property, int index, char **value)
+{
+  PropertySet::Property *prop = nullptr;
+  const OfxStatus stat = getProperty<PropertySet::eTypeString>(properties, property, index, prop);
+  if(stat == kOfxStatOK)
+    *value = const_cast<char*>(prop->strings[index].c_str());
+  return stat;
+}
+
+OfxStatus propGetDouble(OfxPropertySetHandle properties, const char *property, int index, double *value)
+{
+  PropertySet::Property *prop = nullptr;
+  const OfxStatus stat = getProperty<PropertySet::eTypeDouble>(properties, property, index, prop);
+  if(stat == kOfxStatOK)
+    *value = (prop->type == PropertySet::eTypeInt) ? prop->ints[index] : prop->doubles[index];
+  return stat;
+}
+
+OfxStatus propGetInt(OfxPropertySetHandle properties, const char *property, int index, int *value)
+{
+  PropertySet::Property *prop = nullptr;
+  const OfxStatus stat = getProperty<PropertySet::eTypeInt>(properties, property, index, prop);
+  if(stat == kOfxStatOK)
+    *value = (prop->type == PropertySet::eTypeDouble) ? static_cast<int>(prop->doubles[index]) : prop->ints[index];
+  return stat;
+}
+
+OfxStatus propGetPointerN(OfxPropertySetHandle properties, const char *property, int count, void **value)
+{
+  for(int i = 0; i < count; ++i)
+  {
+    const OfxStatus stat = propGetPointer(properties, property, i, &value[i]);
+    if(stat != kOfxStatOK)
+      return stat;
+  }
+  return kOfxStatOK;
+}
+
+OfxStatus propGetStringN(OfxPropertySetHandle properties, const char *property, int count, char **value)
+{
+  for(int i = 0; i < count; ++i)
+  {
+    const OfxStatus stat = propGetString(properties, property, i, &value[i]);
+    if(stat != kOfxStatOK)
+      return stat;
+  }
+  return kOfxStatOK;
+}
+
+OfxStatus propGetDoubleN(OfxPropertySetHandle properties, const char *property, int count, double *value)
+{
+  for(int i = 0; i < count; ++i)
+  {
+    const OfxStatus stat = propGetDouble(properties, property, i, &value[i]);
+    if(stat != kOfxStatOK)
+      return stat;
+  }
+  return kOfxStatOK;
+}
+
+OfxStatus propGetIntN(OfxPropertySetHandle properties, const char *property, int count, int *value)
+{
+  for(int i = 0; i < count; ++i)
+  {
+    const OfxStatus stat = propGetInt(properties, property, i, &value[i]);
+    if(stat != kOfxStatOK)
+      return stat;
+  }
+  return kOfxStatOK;
+}
+
+OfxStatus propReset(OfxPropertySetHandle properties, const char *property)
+{
+  if(properties == nullptr)
+    return kOfxStatErrBadHandle;
+  PropertySet::Property *prop = PropertySet::fromHandle(properties)->find(property);
+  if(prop == nullptr)
+    return kOfxStatErrUnknown;
+  prop->resize(0);
+  return kOfxStatOK;
+}
+
+OfxStatus propGetDimension(OfxPropertySetHandle properties, const char *property, int *count)
+{
+  if(properties == nullptr)
+    return kOfxStatErrBadHandle;
+  const PropertySet::Property *prop = PropertySet::fromHandle(properties)->find(property);
+  if(prop == nullptr)
+    return kOfxStatErrUnknown;
+  *count = static_cast<int>(prop->getDimension());
+  return kOfxStatOK;
+}
+
+} //namespace
+
+const OfxPropertySuiteV1* PropertySet::getSuite()
+{
+  static const OfxPropertySuiteV1 suite = {
+    propSetPointer,
+    propSetString,
+    propSetDouble,
+    propSetInt,
+    propSetPointerN,
+    propSetStringN,
+    propSetDoubleN,
+    propSetIntN,
+    propGetPointer,
+    propGetString,
+    propGetDouble,
+    propGetInt,
+    propGetPointerN,
+    propGetStringN,
+    propGetDoubleN,
+    propGetIntN,
+    propReset,
+    propGetDimension
+  };
+  return &suite;
+}
+
+} //namespace Host
+} //namespace openMVG_ofx
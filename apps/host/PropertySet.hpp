@@ -0,0 +1,103 @@
+#pragma once
+
+#include <ofxCore.h>
+#include <ofxProperty.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace openMVG_ofx {
+namespace Host {
+
+/**
+ * @brief Host side OFX property set
+ * A property is typed by its first assignment, values are stored per dimension.
+ * The handle given to the plugin is the address of the property set.
+ */
+class PropertySet
+{
+public:
+  enum EType
+  {
+    eTypeInt = 0,
+    eTypeDouble,
+    eTypeString,
+    eTypePointer
+  };
+
+  struct Property
+  {
+    EType type = eTypeInt;
+    std::vector<int> ints;
+    std::vector<double> doubles;
+    std::vector<std::string> strings;
+    std::vector<void*> pointers;
+
+    std::size_t getDimension() const;
+    void resize(std::size_t dimension);
+  };
+
+  OfxPropertySetHandle getHandle()
+  {
+    return reinterpret_cast<OfxPropertySetHandle>(this);
+  }
+
+  static PropertySet* fromHandle(OfxPropertySetHandle handle)
+  {
+    return reinterpret_cast<PropertySet*>(handle);
+  }
+
+  bool has(const std::string &name) const
+  {
+    return _properties.count(name) > 0;
+  }
+
+  Property* find(const std::string &name);
+  const Property* find(const std::string &name) const;
+
+  /**
+   * @brief Get or create a property, the type is only set at creation
+   * @param[in] name
+   * @param[in] type
+   * @return property
+   */
+  Property& fetch(const std::string &name, EType type);
+
+  void setInt(const std::string &name, int value, std::size_t index = 0);
+  void setDouble(const std::string &name, double value, std::size_t index = 0);
+  void setString(const std::string &name, const std::string &value, std::size_t index = 0);
+  void setPointer(const std::string &name, void *value, std::size_t index = 0);
+
+  void setInts(const std::string &name, const std::vector<int> &values);
+  void setDoubles(const std::string &name, const std::vector<double> &values);
+  void setStrings(const std::string &name, const std::vector<std::string> &values);
+
+  /**
+   * @brief Getters, numerical types are converted, missing values return the default
+   */
+  int getInt(const std::string &name, std::size_t index = 0, int defaultValue = 0) const;
+  double getDouble(const std::string &name, std::size_t index = 0, double defaultValue = 0.0) const;
+  std::string getString(const std::string &name, std::size_t index = 0, const std::string &defaultValue = "") const;
+  void* getPointer(const std::string &name, std::size_t index = 0) const;
+
+  std::size_t getDimension(const std::string &name) const;
+
+  /**
+   * @brief Copy all the properties of another set, overwriting existing ones
+   * @param[in] other
+   */
+  void merge(const PropertySet &other);
+
+  /**
+   * @brief Get the OFX property suite implemented on this class
+   * @return suite
+   */
+  static const OfxPropertySuiteV1* getSuite();
+
+private:
+  std::map<std::string, Property> _properties;
+};
+
+} //namespace Host
+} //namespace openMVG_ofx
@@ -0,0 +1,300 @@
+#include "ScriptRunner.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+
+namespace openMVG_ofx {
+namespace Host {
+
+namespace {
+
+void checkNbArgs(const std::vector<std::string> &args, std::size_t min, std::size_t max)
+{
+  if(args.size() < min + 1 || args.size() > max + 1)
+    throw std::invalid_argument("Wrong number of arguments for the command " + args.front());
+}
+
+} //namespace
+
+ScriptRunner::ScriptRunner(const std::string &pluginBinary)
+  : _host(Host::instance())
+  , _pluginBinary(pluginBinary)
+{}
+
+std::vector<std::string> ScriptRunner::tokenize(const std::string &line)
+{
+  std::vector<std::string> tokens;
+  std::string token;
+  bool inQuotes = false;
+  bool hasToken = false;
+  for(char c : line)
+  {
+    if(c == '"')
+    {
+      inQuotes = !inQuotes;
+      hasToken = true;
+    }
+    else if(!inQuotes && c == '#')
+      break;
+    else if(!inQuotes && (c == ' ' || c == '\t' || c == '\r'))
+    {
+      if(hasToken)
+        tokens.push_back(token);
+      token.clear();
+      hasToken = false;
+    }
+    else
+    {
+      token += c;
+      hasToken = true;
+    }
+  }
+  if(inQuotes)
+    throw std::invalid_argument("Unterminated quotes");
+  if(hasToken)
+    tokens.push_back(token);
+  return tokens;
+}
+
+bool ScriptRunner::run(std::istream &is, const std::string &scriptName)
+{
+  std::string line;
+  std::size_t lineNumber = 0;
+  while(std::getline(is, line))
+  {
+    ++lineNumber;
+    try
+    {
+      const std::vector<std::string> args = tokenize(line);
+      if(!args.empty())
+        runCommand(args);
+    }
+    catch(std::exception &e)
+    {
+      std::cerr << scriptName << ":" << lineNumber << ": " << e.what() << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+Param& ScriptRunner::getParam(const std::string &name)
+{
+  Param *param = _host.getInstance().getParamSet().find(name);
+  if(!param)
+    throw std::invalid_argument("Unknown parameter : " + name);
+  return *param;
+}
+
+void ScriptRunner::setParam(Param &param, OfxTime time, const std::vector<std::string> &values, bool key)
+{
+  if(param.isString())
+  {
+    if(values.size() != 1)
+      throw std::invalid_argument("Parameter " + param.getName() + " expects 1 value");
+    if(key)
+      param.setStringKey(time, values.front());
+    else
+      param.setString(time, values.front());
+  }
+  else if(key)
+    param.setKey(time, param.parseValues(values));
+  else
+    param.setValue(time, param.parseValues(values));
+}
+
+void ScriptRunner::runCommand(const std::vector<std::string> &args)
+{
+  const std::string &command = args.front();
+  const std::vector<std::string> values(args.begin() + 1, args.end());
+
+  if(command == "plugin")
+  {
+    checkNbArgs(args, 1, 1);
+    _host.loadPlugin(_pluginBinary, args[1]);
+  }
+  else if(command == "context")
+  {
+    checkNbArgs(args, 1, 1);
+    _host.describeInContext(args[1]);
+    _isDescribed = true;
+  }
+  else if(command == "timeline")
+  {
+    checkNbArgs(args, 2, 3);
+    _host.setTimeBounds(std::stod(args[1]), std::stod(args[2]), (args.size() > 3) ? std::stod(args[3]) : 25.0);
+  }
+  else if(command == "clip")
+  {
+    checkNbArgs(args, 2, 4);
+    OfxTime first = 0.0;
+    OfxTime last = 0.0;
+    _host.getTimeBounds(first, last);
+    if(args.size() > 3)
+      first = std::stod(args[3]);
+    if(args.size() > 4)
+      last = std::stod(args[4]);
+    _host.connectClip(args[1], args[2], first, last);
+  }
+  else if(command == "disconnect")
+  {
+    checkNbArgs(args, 1, 1);
+    _host.disconnectClip(args[1]);
+  }
+  else if(command == "output")
+  {
+    checkNbArgs(args, 1, 1);
+    _outputPattern = args[1];
+    if(_host.hasInstance())
+      _host.getInstance().findClip(kOfxImageEffectOutputClipName)->setOutputPattern(_outputPattern);
+  }
+  else if(command == "create")
+  {
+    checkNbArgs(args, 0, 0);
+    if(!_isDescribed)
+    {
+      _host.describeInContext(kOfxImageEffectContextGeneral);
+      _isDescribed = true;
+    }
+    _host.createInstance();
+    Clip *output = _host.getInstance().findClip(kOfxImageEffectOutputClipName);
+    if(output && !_outputPattern.empty())
+      output->setOutputPattern(_outputPattern);
+  }
+  else if(command == "destroy")
+  {
+    checkNbArgs(args, 0, 0);
+    _host.destroyInstance();
+  }
+  else if(command == "set")
+  {
+    if(args.size() < 2)
+      throw std::invalid_argument("Wrong number of arguments for the command set");
+    Param &param = getParam(args[1]);
+    setParam(param, _host.getTime(), std::vector<std::string>(values.begin() + 1, values.end()), false);
+    _host.instanceChanged(kOfxTypeParameter, param.getName());
+  }
+  else if(command == "setkey")
+  {
+    if(args.size() < 3)
+      throw std::invalid_argument("Wrong number of arguments for the command setkey");
+    Param &param = getParam(args[1]);
+    setParam(param, std::stod(args[2]), std::vector<std::string>(values.begin() + 2, values.end()), true);
+  }
+  else if(command == "delkeys")
+  {
+    checkNbArgs(args, 1, 1);
+    getParam(args[1]).deleteAllKeys();
+  }
+  else if(command == "press")
+  {
+    checkNbArgs(args, 1, 1);
+    _host.instanceChanged(kOfxTypeParameter, getParam(args[1]).getName());
+  }
+  else if(command == "get")
+  {
+    checkNbArgs(args, 1, 2);
+    const OfxTime time = (args.size() > 2) ? std::stod(args[2]) : _host.getTime();
+    std::cout << args[1] << " = " << getParam(args[1]).toString(time) << std::endl;
+  }
+  else if(command == "expect")
+  {
+    //Check of the scripted tests, string values are compared exactly
+    if(args.size() < 4)
+      throw std::invalid_argument("Wrong number of arguments for the command expect");
+    Param &param = getParam(args[1]);
+    const OfxTime time = _host.getTime();
+    const double tolerance = std::stod(args[2]);
+    const std::vector<std::string> expectedValues(args.begin() + 3, args.end());
+    bool isExpected = true;
+    if(param.isString())
+    {
+      isExpected = (expectedValues.size() == 1 && param.getStringAtTime(time) == expectedValues.front());
+    }
+    else
+    {
+      const std::vector<double> expected = param.parseValues(expectedValues);
+      const std::vector<double> value = param.getValueAtTime(time);
+      for(std::size_t i = 0; i < value.size(); ++i)
+        isExpected = isExpected && (std::abs(value[i] - expected[i]) <= tolerance);
+    }
+    if(!isExpected)
+      throw std::runtime_error("Unexpected value " + args[1] + " = " + param.toString(time));
+    std::cout << args[1] << " = " << param.toString(time) << std::endl;
+  }
+  else if(command == "time")
+  {
+    checkNbArgs(args, 1, 1);
+    _host.setTime(std::stod(args[1]));
+  }
+  else if(command == "render")
+  {
+    checkNbArgs(args, 1, 3);
+    const OfxTime first = std::stod(args[1]);
+    const OfxTime last = (args.size() > 2) ? std::stod(args[2]) : first;
+    const OfxTime step = (args.size() > 3) ? std::stod(args[3]) : 1.0;
+    _host.render(first, last, step);
+  }
+  else if(command == "overlay")
+  {
+    checkNbArgs(args, 1, 2);
+    const OfxTime first = std::stod(args[1]);
+    _host.drawOverlay(first, (args.size() > 2) ? std::stod(args[2]) : first);
+  }
+  else if(command == "sync")
+  {
+    checkNbArgs(args, 0, 0);
+    _host.syncPrivateData();
+  }
+  else if(command == "wait")
+  {
+    //Background tasks of the plugins report to the host through the actions
+    checkNbArgs(args, 2, 3);
+    Param &param = getParam(args[1]);
+    const double timeout = (args.size() > 3) ? std::stod(args[3]) : 600.0;
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for(;;)
+    {
+      _host.syncPrivateData();
+      if(param.toString(_host.getTime()) == args[2])
+        break;
+      if(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() > timeout)
+        throw std::runtime_error("Timeout waiting for " + args[1] + " = " + args[2]);
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+  }
+  else if(command == "timings")
+  {
+    checkNbArgs(args, 0, 2);
+    const bool csv = (args.size() > 2 && args[2] == "csv");
+    if(args.size() > 1 && args[1] != "-")
+    {
+      std::ofstream file(args[1]);
+      if(!file)
+        throw std::runtime_error("Can't write the timings file : " + args[1]);
+      _host.printTimings(file, csv);
+    }
+    else
+      _host.printTimings(std::cout, csv);
+  }
+  else if(command == "cleartimings")
+  {
+    checkNbArgs(args, 0, 0);
+    _host.clearTimings();
+  }
+  else if(command == "echo")
+  {
+    for(std::size_t i = 1; i < args.size(); ++i)
+      std::cout << ((i > 1) ? " " : "") << args[i];
+    std::cout << std::endl;
+  }
+  else
+    throw std::invalid_argument("Unknown command : " + command);
+}
+
+} //namespace Host
+} //namespace openMVG_ofx
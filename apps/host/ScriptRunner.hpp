@@ -0,0 +1,79 @@
+#pragma once
+
+#include "Host.hpp"
+
+#include <istream>
+#include <string>
+#include <vector>
+
+namespace openMVG_ofx {
+namespace Host {
+
+/**
+ * @brief Run a host script, one command per line
+ *
+ * Tokens are separated by spaces, double quotes group a token, # starts a comment.
+ * Commands:
+ *   plugin <identifier>                 load and describe a plugin of the binary
+ *   context <context>                   describe in context (default general)
+ *   timeline <first> <last> [fps]       set the host time line
+ *   clip <clip> <pattern> [first last]  connect an input clip to image files
+ *   disconnect <clip>                   disconnect an input clip
+ *   output <pattern>                    write the rendered frames to image files
+ *   create | destroy                    create or destroy the effect instance
+ *   set <param> <values...>             user edit of a parameter value
+ *   setkey <param> <time> <values...>   set a parameter key
+ *   delkeys <param>                     delete all the keys of a parameter
+ *   press <param>                       press a push button
+ *   get <param> [time]                  print a parameter value
+ *   expect <param> <tolerance> <values...>  fail if a parameter value differs by more than the tolerance
+ *   time <time>                         move the current time
+ *   render <first> [last] [step]        sequence render
+ *   overlay <first> [last]              draw the overlay on a frame range
+ *   sync                                sync private data
+ *   wait <param> <value> [timeout]      sync private data until a parameter has a value (default timeout 600s)
+ *   timings [file] [csv]                print the action timings
+ *   cleartimings                        reset the action timings
+ *   echo <text...>                      print a message
+ */
+class ScriptRunner
+{
+public:
+  /**
+   * @param[in] pluginBinary - .ofx file loaded by the plugin command
+   */
+  explicit ScriptRunner(const std::string &pluginBinary);
+
+  /**
+   * @brief Run all the commands of a script
+   * @param[in] is - script stream
+   * @param[in] scriptName - used in the error messages
+   * @return false if a command failed, the next commands are not run
+   */
+  bool run(std::istream &is, const std::string &scriptName);
+
+  /**
+   * @brief Run a single command
+   * @param[in] args - command name and arguments
+   */
+  void runCommand(const std::vector<std::string> &args);
+
+  /**
+   * @brief Split a script line in tokens
+   * @param[in] line
+   * @return tokens, empty for blank and comment lines
+   */
+  static std::vector<std::string> tokenize(const std::string &line);
+
+private:
+  Param& getParam(const std::string &name);
+  void setParam(Param &param, OfxTime time, const std::vector<std::string> &values, bool key);
+
+  Host &_host;
+  const std::string _pluginBinary;
+  std::string _outputPattern;
+  bool _isDescribed = false;
+};
+
+} //namespace Host
+} //namespace openMVG_ofx
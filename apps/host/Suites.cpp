@@ -0,0 +1,411 @@
+#include "Host.hpp"
+
+#include <ofxMemory.h>
+#include <ofxMultiThread.h>
+#include <ofxMessage.h>
+#include <ofxInteract.h>
+#include <ofxProgress.h>
+#include <ofxTimeLine.h>
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace openMVG_ofx {
+namespace Host {
+
+namespace {
+
+//Image effect suite
+
+OfxStatus getPropertySet(OfxImageEffectHandle imageEffect, OfxPropertySetHandle *propHandle)
+{
+  if(imageEffect == nullptr)
+    return kOfxStatErrBadHandle;
+  *propHandle = Effect::fromHandle(imageEffect)->getProps().getHandle();
+  return kOfxStatOK;
+}
+
+OfxStatus getParamSet(OfxImageEffectHandle imageEffect, OfxParamSetHandle *paramSet)
+{
+  if(imageEffect == nullptr)
+    return kOfxStatErrBadHandle;
+  *paramSet = Effect::fromHandle(imageEffect)->getParamSet().getHandle();
+  return kOfxStatOK;
+}
+
+OfxStatus clipDefine(OfxImageEffectHandle imageEffect, const char *name, OfxPropertySetHandle *propertySet)
+{
+  if(imageEffect == nullptr)
+    return kOfxStatErrBadHandle;
+  PropertySet &props = Effect::fromHandle(imageEffect)->defineClip(name);
+  if(propertySet)
+    *propertySet = props.getHandle();
+  return kOfxStatOK;
+}
+
+OfxStatus clipGetHandle(OfxImageEffectHandle imageEffect, const char *name, OfxImageClipHandle *clip, OfxPropertySetHandle *propertySet)
+{
+  if(imageEffect == nullptr)
+    return kOfxStatErrBadHandle;
+  Clip *c = Effect::fromHandle(imageEffect)->findClip(name);
+  if(c == nullptr)
+    return kOfxStatErrBadHandle;
+  *clip = c->getHandle();
+  if(propertySet)
+    *propertySet = c->getProps().getHandle();
+  return kOfxStatOK;
+}
+
+OfxStatus clipGetPropertySet(OfxImageClipHandle clip, OfxPropertySetHandle *propHandle)
+{
+  if(clip == nullptr)
+    return kOfxStatErrBadHandle;
+  *propHandle = Clip::fromHandle(clip)->getProps().getHandle();
+  return kOfxStatOK;
+}
+
+OfxStatus clipGetImage(OfxImageClipHandle clip, OfxTime time, const OfxRectD *region, OfxPropertySetHandle *imageHandle)
+{
+  if(clip == nullptr)
+    return kOfxStatErrBadHandle;
+  const OfxPointD renderScale = {1.0, 1.0};
+  Image *image = Clip::fromHandle(clip)->createImage(time, renderScale);
+  if(image == nullptr)
+    return kOfxStatFailed;
+  *imageHandle = Host::instance().registerImage(image);
+  return kOfxStatOK;
+}
+
+OfxStatus clipReleaseImage(OfxPropertySetHandle imageHandle)
+{
+  return Host::instance().releaseImage(imageHandle) ? kOfxStatOK : kOfxStatErrBadHandle;
+}
+
+OfxStatus clipGetRegionOfDefinition(OfxImageClipHandle clip, OfxTime time, OfxRectD *bounds)
+{
+  if(clip == nullptr)
+    return kOfxStatErrBadHandle;
+  *bounds = Clip::fromHandle(clip)->getRegionOfDefinition(time);
+  return kOfxStatOK;
+}
+
+int abort(OfxImageEffectHandle imageEffect)
+{
+  return (imageEffect && Effect::fromHandle(imageEffect)->isAborted()) ? 1 : 0;
+}
+
+struct ImageMemory
+{
+  std::vector<char> data;
+  int lockCount = 0;
+};
+
+OfxStatus imageMemoryAlloc(OfxImageEffectHandle instanceHandle, size_t nBytes, OfxImageMemoryHandle *memoryHandle)
+{
+  ImageMemory *memory = new ImageMemory();
+  memory->data.resize(nBytes);
+  *memoryHandle = reinterpret_cast<OfxImageMemoryHandle>(memory);
+  return kOfxStatOK;
+}
+
+OfxStatus imageMemoryFree(OfxImageMemoryHandle memoryHandle)
+{
+  if(memoryHandle == nullptr)
+    return kOfxStatErrBadHandle;
+  delete reinterpret_cast<ImageMemory*>(memoryHandle);
+  return kOfxStatOK;
+}
+
+OfxStatus imageMemoryLock(OfxImageMemoryHandle memoryHandle, void **returnedPtr)
+{
+  if(memoryHandle == nullptr)
+    return kOfxStatErrBadHandle;
+  ImageMemory *memory = reinterpret_cast<ImageMemory*>(memoryHandle);
+  ++memory->lockCount;
+  *returnedPtr = memory->data.data();
+  return kOfxStatOK;
+}
+
+OfxStatus imageMemoryUnlock(OfxImageMemoryHandle memoryHandle)
+{
+  if(memoryHandle == nullptr)
+    return kOfxStatErrBadHandle;
+  ImageMemory *memory = reinterpret_cast<ImageMemory*>(memoryHandle);
+  if(memory->lockCount > 0)
+    --memory->lockCount;
+  return kOfxStatOK;
+}
+
+const OfxImageEffectSuiteV1 gImageEffectSuite = {
+  getPropertySet,
+  getParamSet,
+  clipDefine,
+  clipGetHandle,
+  clipGetPropertySet,
+  clipGetImage,
+  clipReleaseImage,
+  clipGetRegionOfDefinition,
+  abort,
+  imageMemoryAlloc,
+  imageMemoryFree,
+  imageMemoryLock,
+  imageMemoryUnlock
+};
+
+//Memory suite
+
+OfxStatus memoryAlloc(void *handle, size_t nBytes, void **allocatedData)
+{
+  *allocatedData = std::malloc(nBytes);
+  return (*allocatedData || nBytes == 0) ? kOfxStatOK : kOfxStatErrMemory;
+}
+
+OfxStatus memoryFree(void *allocatedData)
+{
+  std::free(allocatedData);
+  return kOfxStatOK;
+}
+
+const OfxMemorySuiteV1 gMemorySuite = {
+  memoryAlloc,
+  memoryFree
+};
+
+//Multi-thread suite
+
+thread_local unsigned int gThreadIndex = 0;
+thread_local bool gIsSpawnedThread = false;
+
+OfxStatus multiThread(OfxThreadFunctionV1 func, unsigned int nThreads, void *customArg)
+{
+  if(nThreads == 0)
+    nThreads = std::max(1u, std::thread::hardware_concurrency());
+  if(nThreads == 1)
+  {
+    func(0, 1, customArg);
+    return kOfxStatOK;
+  }
+  std::vector<std::thread> threads;
+  for(unsigned int i = 0; i < nThreads; ++i)
+  {
+    threads.emplace_back([=]() {
+      gThreadIndex = i;
+      gIsSpawnedThread = true;
+      func(i, nThreads, customArg);
+    });
+  }
+  for(std::thread &thread : threads)
+    thread.join();
+  return kOfxStatOK;
+}
+
+OfxStatus multiThreadNumCPUs(unsigned int *nCPUs)
+{
+  *nCPUs = std::max(1u, std::thread::hardware_concurrency());
+  return kOfxStatOK;
+}
+
+OfxStatus multiThreadIndex(unsigned int *threadIndex)
+{
+  *threadIndex = gThreadIndex;
+  return kOfxStatOK;
+}
+
+int multiThreadIsSpawnedThread(void)
+{
+  return gIsSpawnedThread ? 1 : 0;
+}
+
+OfxStatus mutexCreate(OfxMutexHandle *mutex, int lockCount)
+{
+  std::recursive_mutex *m = new std::recursive_mutex();
+  for(int i = 0; i < lockCount; ++i)
+    m->lock();
+  *mutex = reinterpret_cast<OfxMutexHandle>(m);
+  return kOfxStatOK;
+}
+
+OfxStatus mutexDestroy(const OfxMutexHandle mutex)
+{
+  if(mutex == nullptr)
+    return kOfxStatErrBadHandle;
+  delete reinterpret_cast<std::recursive_mutex*>(mutex);
+  return kOfxStatOK;
+}
+
+OfxStatus mutexLock(const OfxMutexHandle mutex)
+{
+  if(mutex == nullptr)
+    return kOfxStatErrBadHandle;
+  reinterpret_cast<std::recursive_mutex*>(mutex)->lock();
+  return kOfxStatOK;
+}
+
+OfxStatus mutexUnLock(const OfxMutexHandle mutex)
+{
+  if(mutex == nullptr)
+    return kOfxStatErrBadHandle;
+  reinterpret_cast<std::recursive_mutex*>(mutex)->unlock();
+  return kOfxStatOK;
+}
+
+OfxStatus mutexTryLock(const OfxMutexHandle mutex)
+{
+  if(mutex == nullptr)
+    return kOfxStatErrBadHandle;
+  return reinterpret_cast<std::recursive_mutex*>(mutex)->try_lock() ? kOfxStatOK : kOfxStatFailed;
+}
+
+const OfxMultiThreadSuiteV1 gMultiThreadSuite = {
+  multiThread,
+  multiThreadNumCPUs,
+  multiThreadIndex,
+  multiThreadIsSpawnedThread,
+  mutexCreate,
+  mutexDestroy,
+  mutexLock,
+  mutexUnLock,
+  mutexTryLock
+};
+
+//Message suite
+
+OfxStatus message(void *handle, const char *messageType, const char *messageId, const char *format, ...)
+{
+  char text[4096];
+  va_list ap;
+  va_start(ap, format);
+  std::vsnprintf(text, sizeof(text), format, ap);
+  va_end(ap);
+
+  const std::string type(messageType ? messageType : "");
+  if(type == kOfxMessageError || type == kOfxMessageFatal)
+    Host::instance().addErrorMessage();
+  std::clog << "[host][message][" << type << "] " << (messageId ? messageId : "") << ": " << text << std::endl;
+
+  //Non interactive: questions are answered yes
+  return (type == kOfxMessageQuestion) ? kOfxStatReplyYes : kOfxStatOK;
+}
+
+const OfxMessageSuiteV1 gMessageSuite = {
+  message
+};
+
+//Interact suite
+
+OfxStatus interactSwapBuffers(OfxInteractHandle interactInstance)
+{
+  return interactInstance ? kOfxStatOK : kOfxStatErrBadHandle;
+}
+
+OfxStatus interactRedraw(OfxInteractHandle interactInstance)
+{
+  if(interactInstance == nullptr)
+    return kOfxStatErrBadHandle;
+  Interact::fromHandle(interactInstance)->requestRedraw();
+  return kOfxStatOK;
+}
+
+OfxStatus interactGetPropertySet(OfxInteractHandle interactInstance, OfxPropertySetHandle *property)
+{
+  if(interactInstance == nullptr)
+    return kOfxStatErrBadHandle;
+  *property = Interact::fromHandle(interactInstance)->getProps().getHandle();
+  return kOfxStatOK;
+}
+
+const OfxInteractSuiteV1 gInteractSuite = {
+  interactSwapBuffers,
+  interactRedraw,
+  interactGetPropertySet
+};
+
+//Progress suite
+
+OfxStatus progressStart(void *effectInstance, const char *label)
+{
+  std::clog << "[host][progress] start: " << (label ? label : "") << std::endl;
+  return kOfxStatOK;
+}
+
+OfxStatus progressUpdate(void *effectInstance, double progress)
+{
+  //Non interactive: never cancelled
+  return kOfxStatOK;
+}
+
+OfxStatus progressEnd(void *effectInstance)
+{
+  std::clog << "[host][progress] end" << std::endl;
+  return kOfxStatOK;
+}
+
+const OfxProgressSuiteV1 gProgressSuite = {
+  progressStart,
+  progressUpdate,
+  progressEnd
+};
+
+//Time line suite
+
+OfxStatus getTime(void *instance, double *time)
+{
+  *time = Host::instance().getTime();
+  return kOfxStatOK;
+}
+
+OfxStatus gotoTime(void *instance, double time)
+{
+  Host::instance().setTime(time);
+  return kOfxStatOK;
+}
+
+OfxStatus getTimeBounds(void *instance, double *firstTime, double *lastTime)
+{
+  Host::instance().getTimeBounds(*firstTime, *lastTime);
+  return kOfxStatOK;
+}
+
+const OfxTimeLineSuiteV1 gTimeLineSuite = {
+  getTime,
+  gotoTime,
+  getTimeBounds
+};
+
+} //namespace
+
+const void* Host::fetchSuite(OfxPropertySetHandle host, const char *suiteName, int suiteVersion)
+{
+  const std::string name(suiteName);
+  if(suiteVersion != 1)
+    return nullptr;
+  if(name == kOfxPropertySuite)
+    return PropertySet::getSuite();
+  if(name == kOfxParameterSuite)
+    return ParamSet::getSuite();
+  if(name == kOfxImageEffectSuite)
+    return &gImageEffectSuite;
+  if(name == kOfxMemorySuite)
+    return &gMemorySuite;
+  if(name == kOfxMultiThreadSuite)
+    return &gMultiThreadSuite;
+  if(name == kOfxMessageSuite)
+    return &gMessageSuite;
+  if(name == kOfxInteractSuite)
+    return &gInteractSuite;
+  if(name == kOfxProgressSuite)
+    return &gProgressSuite;
+  if(name == kOfxTimeLineSuite)
+    return &gTimeLineSuite;
+  return nullptr;
+}
+
+} //namespace Host
+} //namespace openMVG_ofx
@@ -0,0 +1,476 @@
+#include "localizer/CameraLocalizer.hpp"
+#include "localizer/TrackFile.hpp"
+#include "synthetic/SyntheticScene.hpp"
+#include "common/Trace.hpp"
+#include "common/Logger.hpp"
+
+#include <openMVG/dataio/FeedProvider.hpp>
+#include <openMVG/rig/Rig.hpp>
+
+#include <cereal/archives/xml.hpp>
+#include <cereal/types/map.hpp>
+#include <cereal/types/utility.hpp>
+
+#include <boost/program_options.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <initializer_list>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace po = boost::program_options;
+using namespace openMVG_ofx;
+using namespace openMVG_ofx::Localizer;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+/**
+ * @brief Accumulated duration of a processing stage
+ */
+struct StageTimer
+{
+  const char *name;
+  double totalMs = 0.0;
+  std::size_t count = 0;
+
+  explicit StageTimer(const char *stageName)
+    : name(stageName)
+  {}
+
+  void add(const Clock::time_point &start)
+  {
+    totalMs += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    ++count;
+  }
+};
+
+/**
+ * @brief Get the index of a choice label, as displayed in the plugin
+ * @param[in] value
+ * @param[in] choices
+ * @return choice index
+ */
+int getChoiceIndex(const std::string &value, const std::vector< std::pair<std::string, std::string> > &choices)
+{
+  for(std::size_t i = 0; i < choices.size(); ++i)
+  {
+    if(choices[i].first == value)
+      return static_cast<int>(i);
+  }
+  throw std::invalid_argument("Unrecognized option value : " + value);
+}
+
+std::string getChoiceLabels(const std::vector< std::pair<std::string, std::string> > &choices)
+{
+  std::string labels;
+  for(const auto &choice : choices)
+    labels += (labels.empty() ? "" : ", ") + choice.first;
+  return labels;
+}
+
+} //namespace
+
+int main(int argc, char **argv)
+{
+  std::string sfmFilePath;
+  std::string descriptorsFolder;
+  std::string voctreeFilePath;
+  std::string voctreeWeightsFilePath;
+  std::vector<std::string> mediaPaths;
+  std::vector<std::string> calibrationPaths;
+  std::string rigCalibrationPath;
+  std::string outputFilePath;
+  std::string trackFilePath;
+  std::string featuresType = kStringParamFeaturesType[eParamFeaturesTypeSIFT].first;
+  std::string featuresPreset = kStringParamFeaturesPreset[eParamFeaturesPresetNormal].first;
+  std::string algorithm = kStringParamAlgorithm[eParamAlgorithmAllResults].first;
+  std::string estimatorMatching = kStringParamEstimatorMatching[eParamEstimatorMatchingACRansac].first;
+  std::string estimatorResection = kStringParamEstimatorResection[eParamEstimatorResectionACRansac].first;
+  double reprojectionError = 4.0;
+  std::size_t nbImageMatch = 4;
+  std::size_t maxResults = 10;
+  double matchingError = 4.0;
+  double distanceRatio = 0.8;
+  bool useGuidedMatching = false;
+  std::size_t cctagNbNearestKeyFrames = 5;
+  double frameOffset = 0.0;
+  std::string debugFolder;
+  std::string groundTruthFilePath;
+  std::string traceFolder;
+  std::string logLevel;
+
+  po::options_description requiredParams("Required parameters");
+  requiredParams.add_options()
+    ("sfmdata", po::value<std::string>(&sfmFilePath)->required(), "The sfm_data.json kind of file generated by openMVG.")
+    ("descriptorPath", po::value<std::string>(&descriptorsFolder)->required(), "Folder containing the .desc files.")
+    ("mediaPath", po::value<std::vector<std::string> >(&mediaPaths)->required()->multitoken(), "Image sequence, image folder or video file of each camera. Several medias localize a rig.")
+    ("output", po::value<std::string>(&outputFilePath)->required(), "Output file, in the CameraLocalizer serialized cache format.");
+
+  po::options_description optionalParams("Optional parameters");
+  optionalParams.add_options()
+    ("help,h", "Print this message.")
+    ("voctree", po::value<std::string>(&voctreeFilePath), "Vocabulary tree file (SIFT features).")
+    ("weights", po::value<std::string>(&voctreeWeightsFilePath), "Vocabulary tree weights file (SIFT features).")
+    ("calibration", po::value<std::vector<std::string> >(&calibrationPaths)->multitoken(), "Lens calibration file of each camera (width height focal ppx ppy k1 k2 k3).")
+    ("rigCalibration", po::value<std::string>(&rigCalibrationPath), "Rig calibration file. If empty, each camera is localized independently.")
+    ("featuresType", po::value<std::string>(&featuresType)->default_value(featuresType), ("Features type: " + getChoiceLabels(kStringParamFeaturesType)).c_str())
+    ("preset", po::value<std::string>(&featuresPreset)->default_value(featuresPreset), ("Features preset: " + getChoiceLabels(kStringParamFeaturesPreset)).c_str())
+    ("algorithm", po::value<std::string>(&algorithm)->default_value(algorithm), ("Voctree algorithm: " + getChoiceLabels(kStringParamAlgorithm)).c_str())
+    ("matchingEstimator", po::value<std::string>(&estimatorMatching)->default_value(estimatorMatching), ("Matching robust estimator: " + getChoiceLabels(kStringParamEstimatorMatching)).c_str())
+    ("resectionEstimator", po::value<std::string>(&estimatorResection)->default_value(estimatorResection), ("Resection robust estimator: " + getChoiceLabels(kStringParamEstimatorResection)).c_str())
+    ("reprojectionError", po::value<double>(&reprojectionError)->default_value(reprojectionError), "Maximum reprojection error (in pixels) allowed for resectioning.")
+    ("nbImageMatch", po::value<std::size_t>(&nbImageMatch)->default_value(nbImageMatch), "Number of images to retrieve in database.")
+    ("maxResults", po::value<std::size_t>(&maxResults)->default_value(maxResults), "Maximum number of matching images to consider.")
+    ("matchingError", po::value<double>(&matchingError)->default_value(matchingError), "Maximum matching error (in pixels) allowed for image matching.")
+    ("distanceRatio", po::value<double>(&distanceRatio)->default_value(distanceRatio), "Ratio distance between the two nearest neighbours.")
+    ("useGuidedMatching", po::value<bool>(&useGuidedMatching)->default_value(useGuidedMatching), "Use the found model to improve the pairwise correspondences.")
+    ("cctagNbNearestKeyFrames", po::value<std::size_t>(&cctagNbNearestKeyFrames)->default_value(cctagNbNearestKeyFrames), "Number of images to retrieve in database (CCTag features).")
+    ("frameOffset", po::value<double>(&frameOffset)->default_value(frameOffset), "Time of the first media frame in the host timeline.")
+    ("trackFile", po::value<std::string>(&trackFilePath), "Track file, in JSON-lines, written as the frames are localized.")
+    ("debugFolder", po::value<std::string>(&debugFolder), "Folder for the localizer visual debug images.")
+    ("groundTruth", po::value<std::string>(&groundTruthFilePath), "Ground truth poses of the first camera, as written by mvg_syntheticScene, to measure the localization accuracy.")
+    ("traceFolder", po::value<std::string>(&traceFolder), "Folder of the exported trace-event file.")
+    ("logLevel", po::value<std::string>(&logLevel), "Log level: trace, debug, info, warning, error or none.");
+
+  po::options_description allParams("Localize the cameras of an image sequence or a video in an openMVG reconstruction.");
+  allParams.add(requiredParams).add(optionalParams);
+
+  po::variables_map vm;
+  try
+  {
+    po::store(po::parse_command_line(argc, argv, allParams), vm);
+    if(vm.count("help") || (argc == 1))
+    {
+      std::cout << allParams << std::endl;
+      return EXIT_SUCCESS;
+    }
+    po::notify(vm);
+  }
+  catch(po::error &e)
+  {
+    std::cerr << "ERROR: " << e.what() << std::endl << std::endl << allParams << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  Common::Logger &logger = Common::Logger::instance();
+  if(!logLevel.empty())
+    logger.setLevel(Common::Logger::getLevelFromString(logLevel, logger.getLevel()));
+  if(!traceFolder.empty())
+    Common::Tracer::instance().enable(traceFolder);
+
+  StageTimer timerSetup("setup");
+  StageTimer timerRead("read");
+  StageTimer timerExtract("extractFeatures");
+  StageTimer timerLocalize("localize");
+  StageTimer timerSerialize("serialize");
+
+  const std::size_t nbCameras = mediaPaths.size();
+  LocalizerProcessData processData;
+  std::vector< std::unique_ptr<openMVG::dataio::FeedProvider> > feeds;
+  std::vector<openMVG::geometry::Pose3> subPoses;
+  std::map<std::size_t, openMVG::geometry::Pose3> groundTruth;
+  std::vector<double> positionErrors;
+  std::vector<double> rotationErrorsDeg;
+
+  try
+  {
+    Clock::time_point start = Clock::now();
+    const EParamFeaturesType describer = static_cast<EParamFeaturesType>(getChoiceIndex(featuresType, kStringParamFeaturesType));
+    switch(describer)
+    {
+      case eParamFeaturesTypeSIFT :
+      case eParamFeaturesTypeSIFTAndCCTag :
+      {
+        processData.localizer.reset(new openMVG::localization::VoctreeLocalizer(sfmFilePath,
+                                                                                descriptorsFolder,
+                                                                                voctreeFilePath,
+                                                                                voctreeWeightsFilePath
+#if HAVE_CCTAG
+                                                                                ,(eParamFeaturesTypeSIFTAndCCTag == describer)
+#endif
+                                                                                ));
+        openMVG::localization::VoctreeLocalizer::Parameters *param = new openMVG::localization::VoctreeLocalizer::Parameters();
+        processData.param.reset(param);
+        param->_algorithm = LocalizerProcessData::getAlgorithm(static_cast<EParamAlgorithm>(getChoiceIndex(algorithm, kStringParamAlgorithm)));
+        param->_numResults = nbImageMatch;
+        param->_maxResults = maxResults;
+        param->_numCommonViews = 3;
+        param->_ccTagUseCuda = false;
+        param->_matchingError = matchingError;
+        param->_useGuidedMatching = useGuidedMatching;
+      } break;
+#if HAVE_CCTAG
+      case eParamFeaturesTypeCCTag :
+      {
+        processData.localizer.reset(new openMVG::localization::CCTagLocalizer(sfmFilePath, descriptorsFolder));
+        openMVG::localization::CCTagLocalizer::Parameters *param = new openMVG::localization::CCTagLocalizer::Parameters();
+        processData.param.reset(param);
+        param->_nNearestKeyFrames = cctagNbNearestKeyFrames;
+      } break;
+#endif
+      default : throw std::invalid_argument("Unrecognized Features Type : " + featuresType);
+    }
+
+    processData.param->_matchingEstimator = LocalizerProcessData::getMatchingEstimator(static_cast<EParamEstimatorMatching>(getChoiceIndex(estimatorMatching, kStringParamEstimatorMatching)));
+    processData.param->_resectionEstimator = LocalizerProcessData::getResectionEstimator(static_cast<EParamEstimatorResection>(getChoiceIndex(estimatorResection, kStringParamEstimatorResection)));
+    processData.param->_featurePreset = LocalizerProcessData::getDescriberPreset(static_cast<EParamFeaturesPreset>(getChoiceIndex(featuresPreset, kStringParamFeaturesPreset)));
+    processData.param->_refineIntrinsics = false;
+    processData.param->_visualDebug = debugFolder;
+    processData.param->_errorMax = reprojectionError;
+    processData.param->_fDistRatio = distanceRatio;
+
+    if(!processData.localizer->isInit())
+      throw std::runtime_error("Cannot initialize the camera localizer.");
+
+    if(!calibrationPaths.empty() && calibrationPaths.size() != nbCameras)
+      throw std::invalid_argument("One calibration file is expected per media.");
+
+    for(std::size_t camera = 0; camera < nbCameras; ++camera)
+    {
+      feeds.emplace_back(new openMVG::dataio::FeedProvider(mediaPaths[camera], calibrationPaths.empty() ? "" : calibrationPaths[camera]));
+      if(!feeds.back()->isInit())
+        throw std::runtime_error("Cannot initialize the feed : " + mediaPaths[camera]);
+    }
+
+    if(nbCameras > 1 && !rigCalibrationPath.empty())
+    {
+      openMVG::rig::loadRigCalibration(rigCalibrationPath, subPoses);
+      if(subPoses.size() != nbCameras - 1)
+        throw std::invalid_argument("The rig calibration doesn't match the number of medias.");
+    }
+    if(!groundTruthFilePath.empty())
+    {
+      std::vector<Synthetic::GroundTruthPose> groundTruthPoses;
+      if(!Synthetic::readGroundTruth(groundTruthFilePath, groundTruthPoses))
+        throw std::runtime_error("Cannot read the ground truth : " + groundTruthFilePath);
+      for(const Synthetic::GroundTruthPose &groundTruthPose : groundTruthPoses)
+        groundTruth[groundTruthPose.frame] = groundTruthPose.pose;
+    }
+    timerSetup.add(start);
+  }
+  catch(std::exception &e)
+  {
+    OFXMVG_LOG_ERROR("setup") << e.what();
+    logger.flush();
+    return EXIT_FAILURE;
+  }
+
+  OFXMVG_LOG_INFO("setup") << "localizer initialized"
+    << Common::kv("nbCameras", nbCameras)
+    << Common::kv("nbViews", processData.localizer->getSfMData().views.size())
+    << Common::kv("nbStructures", processData.localizer->getSfMData().structure.size())
+    << Common::kv("durationMs", timerSetup.totalMs);
+
+  std::map<OfxTime, std::map<std::size_t, FrameData> > framesData;
+  std::unique_ptr<TrackFileWriter> trackFileWriter;
+  if(!trackFilePath.empty())
+  {
+    try
+    {
+      trackFileWriter.reset(new TrackFileWriter(trackFilePath, false));
+    }
+    catch(std::exception &e)
+    {
+      OFXMVG_LOG_ERROR("setup") << e.what();
+      logger.flush();
+      return EXIT_FAILURE;
+    }
+  }
+  std::size_t nbLocalized = 0;
+  std::size_t nbQueries = 0;
+  std::size_t nbFailedFrames = 0;
+
+  for(std::size_t frame = 0; ; ++frame)
+  {
+    OFXMVG_TRACE_SCOPE("frame");
+    const OfxTime time = frameOffset + frame;
+
+    //Read one image per camera
+    Clock::time_point start = Clock::now();
+    std::map<std::size_t, openMVG::image::Image<unsigned char> > mapImageGray;
+    std::vector<openMVG::cameras::Pinhole_Intrinsic_Radial_K3> vecQueryIntrinsics(nbCameras);
+    std::vector<bool> vecQueryHasIntrinsics(nbCameras);
+    std::vector< std::pair<std::size_t, std::size_t> > vecQueryImageSize(nbCameras);
+    bool hasFrame = true;
+    bool isFrameRead = true;
+    {
+      OFXMVG_TRACE_SCOPE("read");
+      for(std::size_t camera = 0; camera < nbCameras && hasFrame; ++camera)
+      {
+        std::string currentImagePath;
+        bool hasIntrinsics = false;
+        try
+        {
+          hasFrame = feeds[camera]->readImage(mapImageGray[camera], vecQueryIntrinsics[camera], currentImagePath, hasIntrinsics);
+        }
+        catch(std::exception &e)
+        {
+          //The feeds still move to the next frame, to stay aligned
+          OFXMVG_LOG_ERROR("read") << e.what() << Common::kv("time", time) << Common::kv("camera", camera);
+          isFrameRead = false;
+        }
+        vecQueryHasIntrinsics[camera] = hasIntrinsics;
+        vecQueryImageSize[camera] = std::make_pair(mapImageGray[camera].Width(), mapImageGray[camera].Height());
+        if(!hasIntrinsics)
+          vecQueryIntrinsics[camera] = openMVG::cameras::Pinhole_Intrinsic_Radial_K3(mapImageGray[camera].Width(), mapImageGray[camera].Height());
+        feeds[camera]->goToNextFrame();
+      }
+    }
+    if(!hasFrame)
+      break;
+    timerRead.add(start);
+    if(!isFrameRead)
+    {
+      ++nbFailedFrames;
+      continue;
+    }
+
+    //A frame failing to extract or localize is skipped, the next ones are still localized
+    std::vector< std::unique_ptr<openMVG::features::Regions> > vecQueryRegions(nbCameras);
+    std::vector<openMVG::localization::LocalizationResult> vecLocResults(nbCameras);
+    try
+    {
+      //Extract features
+      start = Clock::now();
+      processData.extractFeatures(mapImageGray, vecQueryRegions);
+      timerExtract.add(start);
+
+      //Localize
+      start = Clock::now();
+      {
+        OFXMVG_TRACE_SCOPE("localize");
+        if(!subPoses.empty())
+        {
+          openMVG::geometry::Pose3 rigPose;
+          processData.localizeRig(vecQueryRegions, vecQueryImageSize, vecQueryIntrinsics, subPoses, rigPose, vecLocResults);
+        }
+        else
+        {
+          for(std::size_t camera = 0; camera < nbCameras; ++camera)
+            processData.localize(vecQueryRegions[camera], vecQueryImageSize[camera], vecQueryHasIntrinsics[camera], vecQueryIntrinsics[camera], vecLocResults[camera]);
+        }
+      }
+      timerLocalize.add(start);
+    }
+    catch(std::exception &e)
+    {
+      OFXMVG_LOG_ERROR("localize") << e.what() << Common::kv("time", time);
+      ++nbFailedFrames;
+      continue;
+    }
+
+    //The cache stores SIFT features: other describers fail on every frame
+    std::vector<const openMVG::features::SIFT_Regions*> vecSiftRegions(nbCameras);
+    for(std::size_t camera = 0; camera < nbCameras; ++camera)
+    {
+      vecSiftRegions[camera] = dynamic_cast<const openMVG::features::SIFT_Regions*>(vecQueryRegions[camera].get());
+      if(vecSiftRegions[camera] == nullptr)
+      {
+        OFXMVG_LOG_ERROR("localize") << "the extracted regions are not SIFT regions" << Common::kv("time", time) << Common::kv("camera", camera);
+        logger.flush();
+        return EXIT_FAILURE;
+      }
+    }
+
+    //Fill the cache, as the plugin render does
+    std::map<std::size_t, FrameData> &frameDataCache = framesData[time];
+    for(std::size_t camera = 0; camera < vecLocResults.size(); ++camera)
+    {
+      FrameData &frameData = frameDataCache[camera];
+      frameData.extractedFeatures = vecSiftRegions[camera]->Features();
+      frameData.localizationResult = vecLocResults[camera];
+      ++nbQueries;
+      if(vecLocResults[camera].isValid())
+      {
+        ++nbLocalized;
+        if(trackFileWriter)
+        {
+          TrackRecord record;
+          getTrackRecord(time, camera, frameData, record);
+          trackFileWriter->write(record);
+        }
+      }
+
+      OFXMVG_LOG_INFO("localize") << (vecLocResults[camera].isValid() ? "localized" : "not localized")
+        << Common::kv("time", time)
+        << Common::kv("camera", camera)
+        << Common::kv("nbFeatures", frameData.extractedFeatures.size())
+        << Common::kv("nbInliers", vecLocResults[camera].getInliers().size());
+    }
+
+    //Accuracy of the first camera against the ground truth
+    const auto groundTruthIt = groundTruth.find(frame);
+    if(groundTruthIt != groundTruth.end() && vecLocResults.front().isValid())
+    {
+      const openMVG::geometry::Pose3 &pose = vecLocResults.front().getPose();
+      const openMVG::geometry::Pose3 &expected = groundTruthIt->second;
+      const double cosAngle = ((expected.rotation().transpose() * pose.rotation()).trace() - 1.0) / 2.0;
+      positionErrors.push_back((pose.center() - expected.center()).norm());
+      rotationErrorsDeg.push_back(std::acos(std::min(1.0, std::max(-1.0, cosAngle))) * 180.0 / M_PI);
+    }
+  }
+
+  //Write the cache, readable by the plugin serialized results parameter
+  {
+    OFXMVG_TRACE_SCOPE("serialize");
+    Clock::time_point start = Clock::now();
+    std::ofstream outputFile(outputFilePath);
+    if(!outputFile.is_open())
+    {
+      OFXMVG_LOG_ERROR("serialize") << "can't write output file" << Common::kv("path", outputFilePath);
+      logger.flush();
+      return EXIT_FAILURE;
+    }
+    {
+      cereal::XMLOutputArchive archive(outputFile);
+      archive(cereal::make_nvp("_framesData", framesData));
+    }
+    timerSerialize.add(start);
+  }
+
+  OFXMVG_LOG_INFO("summary") << "localization done"
+    << Common::kv("nbFrames", framesData.size())
+    << Common::kv("nbLocalized", nbLocalized)
+    << Common::kv("nbQueries", nbQueries)
+    << Common::kv("nbFailedFrames", nbFailedFrames);
+
+  if(!groundTruth.empty())
+  {
+    //Median and maximal errors of the localized frames
+    auto median = [](std::vector<double> values)
+    {
+      if(values.empty())
+        return 0.0;
+      std::nth_element(values.begin(), values.begin() + values.size() / 2, values.end());
+      return values[values.size() / 2];
+    };
+    OFXMVG_LOG_INFO("accuracy") << "ground truth comparison"
+      << Common::kv("nbCompared", positionErrors.size())
+      << Common::kv("nbGroundTruth", groundTruth.size())
+      << Common::kv("medianPositionError", median(positionErrors))
+      << Common::kv("maxPositionError", positionErrors.empty() ? 0.0 : *std::max_element(positionErrors.begin(), positionErrors.end()))
+      << Common::kv("medianRotationErrorDeg", median(rotationErrorsDeg))
+      << Common::kv("maxRotationErrorDeg", rotationErrorsDeg.empty() ? 0.0 : *std::max_element(rotationErrorsDeg.begin(), rotationErrorsDeg.end()));
+  }
+
+  for(const StageTimer *timer : {&timerSetup, &timerRead, &timerExtract, &timerLocalize, &timerSerialize})
+  {
+    OFXMVG_LOG_INFO("timing") << timer->name
+      << Common::kv("totalMs", timer->totalMs)
+      << Common::kv("count", timer->count)
+      << Common::kv("avgMs", timer->count > 0 ? timer->totalMs / timer->count : 0.0);
+  }
+
+  if(Common::Tracer::instance().isEnabled())
+    Common::Tracer::instance().disable();
+  logger.flush();
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,307 @@
+#include "lensCalibration/LensCalibration.hpp"
+#include "common/Trace.hpp"
+#include "common/Logger.hpp"
+
+#include <openMVG/dataio/FeedProvider.hpp>
+#include <openMVG/calibration/patternDetect.hpp>
+
+#include <boost/program_options.hpp>
+
+#include <opencv2/core/core.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace po = boost::program_options;
+using namespace openMVG_ofx;
+using namespace openMVG_ofx::LensCalibration;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double getElapsedMs(const Clock::time_point &start)
+{
+  return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+} //namespace
+
+int main(int argc, char **argv)
+{
+  std::string mediaPath;
+  std::string outputFilePath;
+  std::string patternTypeName = kStringParamPatternType[eParamPatternTypeChessboard].first;
+  std::string solverName = kStringParamCalibSolver[eParamCalibSolverOpenCV].first;
+  std::vector<int> patternSize = {10, 7};
+  std::size_t maxFrames = 0;
+  std::size_t frameStep = 1;
+  std::string stMapFilePath;
+  bool isRedistortSTMap = false;
+  bool isHalfSTMap = false;
+  std::string traceFolder;
+  std::string logLevel;
+  CalibrationSettings settings;
+  DetectionSettings detectionSettings;
+  FrameFilterSettings filterSettings;
+  bool isTracking = false;
+  bool isComparingSolvers = false;
+
+  po::options_description requiredParams("Required parameters");
+  requiredParams.add_options()
+    ("mediaPath", po::value<std::string>(&mediaPath)->required(), "Image sequence, image folder or video file.")
+    ("output", po::value<std::string>(&outputFilePath)->required(), "Output calibration file (width height focal ppx ppy k1 k2 k3).");
+
+  po::options_description optionalParams("Optional parameters");
+  optionalParams.add_options()
+    ("help,h", "Print this message.")
+    ("patternType", po::value<std::string>(&patternTypeName)->default_value(patternTypeName), "Pattern type: Chessboard, Circles grid, Asymmetric circles grid or CCTag.")
+    ("patternSize", po::value<std::vector<int> >(&patternSize)->multitoken(), "Number of inner corners per one of board dimension Width Height (default: 10 7).")
+    ("detectionMaxSize", po::value<int>(&detectionSettings.maxDetectionSize)->default_value(detectionSettings.maxDetectionSize), "Largest image side of the pattern search, refined at full resolution (0: full resolution).")
+    ("trackPattern", po::value<bool>(&isTracking)->default_value(isTracking), "Track the pattern found on the previous read frame, search it when the tracking fails.")
+    ("minHashDistance", po::value<int>(&filterSettings.minHashDistance)->default_value(filterSettings.minHashDistance), "Skip the frames whose 64 bits image hash differs by fewer bits from a frame with a detected pattern (0: disabled).")
+    ("minSharpness", po::value<double>(&filterSettings.minSharpness)->default_value(filterSettings.minSharpness), "Skip the frames whose Laplacian variance is below this value (0: disabled).")
+    ("squareSize", po::value<double>(&settings.squareSize)->default_value(settings.squareSize), "Size of the grid's square cells (mm).")
+    ("nbRadialCoef", po::value<int>(&settings.nbRadialCoef)->default_value(settings.nbRadialCoef), "Number of radial distortion coefficients to be calculated.")
+    ("maxFrames", po::value<std::size_t>(&maxFrames)->default_value(maxFrames), "Maximal number of frames to extract from the media (0: all).")
+    ("frameStep", po::value<std::size_t>(&frameStep)->default_value(frameStep), "Step between two read frames.")
+    ("maxCalibFrames", po::value<std::size_t>(&settings.maxCalibFrames)->default_value(settings.maxCalibFrames), "Maximal number of frames to use to calibrate from the selected frames.")
+    ("calibGridSize", po::value<std::size_t>(&settings.calibGridSize)->default_value(settings.calibGridSize), "Define the number of cells per edge.")
+    ("minInputFrames", po::value<std::size_t>(&settings.minInputFrames)->default_value(settings.minInputFrames), "Minimal number of frames to limit the refinement loop.")
+    ("maxTotalAvgErr", po::value<double>(&settings.maxTotalAvgErr)->default_value(settings.maxTotalAvgErr), "Max Total Average Error.")
+    ("nbStarts", po::value<std::size_t>(&settings.nbStarts)->default_value(settings.nbStarts), "Number of calibrations run concurrently on frame subsets, the best on held-out frames is kept.")
+    ("solver", po::value<std::string>(&solverName)->default_value(solverName), "Calibration solver: OpenCV or Ceres (if built with Ceres).")
+    ("compareSolvers", po::value<bool>(&isComparingSolvers)->default_value(isComparingSolvers), "Also calibrate the detected frames with every other solver and print their timing and errors.")
+    ("nbThreads", po::value<std::size_t>(&settings.nbThreads)->default_value(settings.nbThreads), "Number of threads of the calibration (0: worker pool size).")
+    ("stMap", po::value<std::string>(&stMapFilePath), "Export the ST-map of the calibration in an OpenEXR file.")
+    ("redistortSTMap", po::value<bool>(&isRedistortSTMap)->default_value(isRedistortSTMap), "Export the redistort ST-map instead of the undistort one.")
+    ("halfSTMap", po::value<bool>(&isHalfSTMap)->default_value(isHalfSTMap), "Export the ST-map in 16 bits half floats instead of 32 bits floats.")
+    ("traceFolder", po::value<std::string>(&traceFolder), "Folder of the exported trace-event file.")
+    ("logLevel", po::value<std::string>(&logLevel), "Log level: trace, debug, info, warning, error or none.");
+
+  po::options_description allParams("Calibrate a lens from an image sequence or a video of a calibration pattern.");
+  allParams.add(requiredParams).add(optionalParams);
+
+  po::variables_map vm;
+  try
+  {
+    po::store(po::parse_command_line(argc, argv, allParams), vm);
+    if(vm.count("help") || (argc == 1))
+    {
+      std::cout << allParams << std::endl;
+      return EXIT_SUCCESS;
+    }
+    po::notify(vm);
+  }
+  catch(po::error &e)
+  {
+    std::cerr << "ERROR: " << e.what() << std::endl << std::endl << allParams << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if(patternSize.size() != 2 || frameStep == 0)
+  {
+    std::cerr << "ERROR: invalid patternSize or frameStep" << std::endl << std::endl << allParams << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  Common::Logger &logger = Common::Logger::instance();
+  if(!logLevel.empty())
+    logger.setLevel(Common::Logger::getLevelFromString(logLevel, logger.getLevel()));
+  if(!traceFolder.empty())
+    Common::Tracer::instance().enable(traceFolder);
+
+  std::map<OfxTime, std::vector<cv::Point2f> > checkerPerFrame;
+  double readMs = 0.0;
+  double detectMs = 0.0;
+  double calibrateMs = 0.0;
+  std::size_t nbFrames = 0;
+
+  try
+  {
+    settings.boardSize = cv::Size(patternSize[0], patternSize[1]);
+    bool patternTypeFound = false;
+    for(std::size_t i = 0; i < kStringParamPatternType.size(); ++i)
+    {
+      if(kStringParamPatternType[i].first == patternTypeName)
+      {
+        settings.patternType = EParamPatternType(i);
+        patternTypeFound = true;
+      }
+    }
+    if(!patternTypeFound)
+      throw std::invalid_argument("Unrecognized Pattern Type : " + patternTypeName);
+    bool solverFound = false;
+    for(std::size_t i = 0; i < kStringParamCalibSolver.size(); ++i)
+    {
+      if(kStringParamCalibSolver[i].first == solverName)
+      {
+        settings.solver = EParamCalibSolver(i);
+        solverFound = true;
+      }
+    }
+    if(!solverFound)
+      throw std::invalid_argument("Unrecognized Calibration Solver : " + solverName);
+    detectionSettings.patternType = settings.patternType;
+    detectionSettings.boardSize = settings.boardSize;
+
+    openMVG::dataio::FeedProvider feed(mediaPath);
+    if(!feed.isInit())
+      throw std::runtime_error("Cannot initialize the feed : " + mediaPath);
+
+    openMVG::image::Image<unsigned char> imageGray;
+    openMVG::cameras::Pinhole_Intrinsic_Radial_K3 queryIntrinsics;
+    bool hasIntrinsics = false;
+    std::string currentImagePath;
+    cv::Mat previousGrayImage;
+    std::vector<cv::Point2f> previousPoints;
+    std::size_t nbTrackedFrames = 0;
+    std::vector<std::uint64_t> detectedHashes;
+    std::size_t nbDuplicateFrames = 0;
+    std::size_t nbBlurredFrames = 0;
+
+    for(std::size_t frame = 0; maxFrames == 0 || nbFrames < maxFrames; frame += frameStep)
+    {
+      Clock::time_point start = Clock::now();
+      {
+        OFXMVG_TRACE_SCOPE("read");
+        //The feed is read sequentially, decoding the skipped frames is cheaper than seeking the video
+        bool hasNextFrame = true;
+        for(std::size_t step = 0; frame > 0 && step < frameStep && hasNextFrame; ++step)
+          hasNextFrame = feed.goToNextFrame();
+        if(!hasNextFrame)
+          break;
+        if(!feed.readImage(imageGray, queryIntrinsics, currentImagePath, hasIntrinsics))
+          break;
+      }
+      readMs += getElapsedMs(start);
+      ++nbFrames;
+
+      const cv::Size imageSize(imageGray.Width(), imageGray.Height());
+      if(checkerPerFrame.empty())
+      {
+        settings.imageSize = imageSize;
+      }
+      else if(imageSize != settings.imageSize)
+      {
+        OFXMVG_LOG_ERROR("detect") << "all images don't have the same size" << Common::kv("frame", frame);
+        continue;
+      }
+
+      start = Clock::now();
+      //openMVG images are row-major and contiguous, no copy needed
+      cv::Mat cvImageGray(imageGray.Height(), imageGray.Width(), CV_8UC1, imageGray.data());
+      const std::uint64_t hash = computeImageHash(cvImageGray);
+      const bool isDuplicate = std::any_of(detectedHashes.begin(), detectedHashes.end(), [&](std::uint64_t detectedHash)
+      {
+        return getHashDistance(hash, detectedHash) < filterSettings.minHashDistance;
+      });
+      if(isDuplicate || (filterSettings.minSharpness > 0.0 && computeSharpness(cvImageGray) < filterSettings.minSharpness))
+      {
+        detectMs += getElapsedMs(start);
+        if(isDuplicate)
+          ++nbDuplicateFrames;
+        else
+          ++nbBlurredFrames;
+        OFXMVG_LOG_DEBUG("detect") << (isDuplicate ? "duplicated frame skipped" : "blurred frame skipped")
+          << Common::kv("frame", frame);
+        continue;
+      }
+      std::vector<cv::Point2f> checkerPoints;
+      const bool tracked = isTracking && !previousPoints.empty() &&
+                           trackPattern(previousGrayImage, previousPoints, cvImageGray, detectionSettings, checkerPoints);
+      const bool found = tracked || detectPattern(cvImageGray, detectionSettings, checkerPoints);
+      if(tracked)
+        ++nbTrackedFrames;
+      if(isTracking)
+      {
+        //The feed reuses its image buffer
+        cvImageGray.copyTo(previousGrayImage);
+        previousPoints = found ? checkerPoints : std::vector<cv::Point2f>();
+      }
+      detectMs += getElapsedMs(start);
+      if(found)
+      {
+        checkerPerFrame[frame] = checkerPoints;
+        detectedHashes.push_back(hash);
+      }
+
+      OFXMVG_LOG_DEBUG("detect") << "pattern " << (found ? "found" : "not found")
+        << Common::kv("frame", frame)
+        << Common::kv("nbDetectedFrames", checkerPerFrame.size());
+    }
+
+    OFXMVG_LOG_INFO("detect") << "pattern detection done"
+      << Common::kv("nbFrames", nbFrames)
+      << Common::kv("nbTrackedFrames", nbTrackedFrames)
+      << Common::kv("nbDuplicateFrames", nbDuplicateFrames)
+      << Common::kv("nbBlurredFrames", nbBlurredFrames)
+      << Common::kv("nbDetectedFrames", checkerPerFrame.size());
+
+    Clock::time_point start = Clock::now();
+    CalibrationResult result;
+    calibrateLens(settings, checkerPerFrame, result);
+    calibrateMs = getElapsedMs(start);
+
+    //Same detections and settings, only the solver changes
+    for(std::size_t i = 0; isComparingSolvers && i < kStringParamCalibSolver.size(); ++i)
+    {
+      if(EParamCalibSolver(i) == settings.solver)
+        continue;
+      CalibrationSettings solverSettings = settings;
+      solverSettings.solver = EParamCalibSolver(i);
+      CalibrationResult solverResult;
+      Clock::time_point solverStart = Clock::now();
+      calibrateLens(solverSettings, checkerPerFrame, solverResult);
+      OFXMVG_LOG_INFO("compareSolvers") << kStringParamCalibSolver[i].first
+        << Common::kv("totalMs", getElapsedMs(solverStart))
+        << Common::kv("isCalibrated", solverResult.isCalibrated)
+        << Common::kv("totalAvgErr", solverResult.totalAvgErr)
+        << Common::kv("nbCalibFrames", solverResult.calibInputFrames.size())
+        << Common::kv("holdOutErr", solverResult.holdOutErr);
+    }
+
+    OFXMVG_LOG_INFO("calibrate") << (result.isCalibrated ? "calibrated" : "not calibrated")
+      << Common::kv("totalAvgErr", result.totalAvgErr)
+      << Common::kv("nbCalibFrames", result.calibInputFrames.size())
+      << Common::kv("nbRejectedFrames", result.rejectInputFrames.size())
+      << Common::kv("holdOutErr", result.holdOutErr);
+
+    if(!result.isCalibrated)
+    {
+      logger.flush();
+      return EXIT_FAILURE;
+    }
+    if(!writeCalibrationFile(outputFilePath, settings.imageSize, result.cameraMatrix, result.distCoeffs))
+      throw std::runtime_error("Can't write the calibration file : " + outputFilePath);
+    if(!stMapFilePath.empty())
+    {
+      UndistortMap undistortMap;
+      if(isRedistortSTMap)
+        computeRedistortMap(settings.imageSize, result.cameraMatrix, result.distCoeffs.rowRange(0, 5), undistortMap);
+      else
+        computeUndistortMap(settings.imageSize, result.cameraMatrix, result.distCoeffs.rowRange(0, 5), undistortMap);
+      exportSTMap(undistortMap, stMapFilePath, isHalfSTMap);
+    }
+  }
+  catch(std::exception &e)
+  {
+    OFXMVG_LOG_ERROR("lensCalibration") << e.what();
+    logger.flush();
+    return EXIT_FAILURE;
+  }
+
+  OFXMVG_LOG_INFO("timing") << "read" << Common::kv("totalMs", readMs) << Common::kv("count", nbFrames);
+  OFXMVG_LOG_INFO("timing") << "findPattern" << Common::kv("totalMs", detectMs) << Common::kv("count", nbFrames);
+  OFXMVG_LOG_INFO("timing") << "calibrate" << Common::kv("totalMs", calibrateMs);
+
+  if(Common::Tracer::instance().isEnabled())
+    Common::Tracer::instance().disable();
+  logger.flush();
+  return EXIT_SUCCESS;
+}
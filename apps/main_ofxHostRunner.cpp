@@ -0,0 +1,99 @@
+#include "host/Host.hpp"
+#include "host/ScriptRunner.hpp"
+
+#include <boost/program_options.hpp>
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace po = boost::program_options;
+using namespace openMVG_ofx;
+
+int main(int argc, char **argv)
+{
+  std::string pluginBinary;
+  std::vector<std::string> scripts;
+  std::string timingsFile;
+
+  po::options_description requiredParams("Required parameters");
+  requiredParams.add_options()
+    ("plugin", po::value<std::string>(&pluginBinary)->required(), "OpenFX plugin binary (.ofx file).")
+    ("script", po::value<std::vector<std::string> >(&scripts)->required()->multitoken(), "Host scripts, run in order (see apps/host/ScriptRunner.hpp).");
+
+  po::options_description optionalParams("Optional parameters");
+  optionalParams.add_options()
+    ("help,h", "Print this message.")
+    ("timings", po::value<std::string>(&timingsFile), "Write the action timings of the whole run to this CSV file.");
+
+  po::options_description allParams("Load an OpenFX plugin in a minimal host and run scripted actions on it.");
+  allParams.add(requiredParams).add(optionalParams);
+
+  po::positional_options_description positionalParams;
+  positionalParams.add("script", -1);
+
+  po::variables_map vm;
+  try
+  {
+    po::store(po::command_line_parser(argc, argv).options(allParams).positional(positionalParams).run(), vm);
+    if(vm.count("help") || (argc == 1))
+    {
+      std::cout << allParams << std::endl;
+      return EXIT_SUCCESS;
+    }
+    po::notify(vm);
+  }
+  catch(po::error &e)
+  {
+    std::cerr << "ERROR: " << e.what() << std::endl << std::endl;
+    std::cerr << allParams << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  bool success = true;
+  {
+    Host::ScriptRunner runner(pluginBinary);
+    for(const std::string &script : scripts)
+    {
+      std::ifstream file(script);
+      if(!file)
+      {
+        std::cerr << "ERROR: Can't open the script " << script << std::endl;
+        success = false;
+        break;
+      }
+      if(!runner.run(file, script))
+      {
+        success = false;
+        break;
+      }
+    }
+  }
+
+  Host::Host &host = Host::Host::instance();
+  try
+  {
+    host.destroyInstance();
+  }
+  catch(std::exception &e)
+  {
+    std::cerr << "ERROR: " << e.what() << std::endl;
+    success = false;
+  }
+
+  if(!timingsFile.empty())
+  {
+    std::ofstream file(timingsFile);
+    host.printTimings(file, true);
+  }
+
+  if(host.getNbErrorMessages() > 0)
+  {
+    std::cerr << "ERROR: The plugin posted " << host.getNbErrorMessages() << " error message(s)." << std::endl;
+    success = false;
+  }
+
+  return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
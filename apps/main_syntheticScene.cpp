@@ -0,0 +1,425 @@
+#include "synthetic/SyntheticScene.hpp"
+#include "localizer/CameraLocalizer.hpp"
+#include "lensCalibration/LensCalibration.hpp"
+#include "common/Logger.hpp"
+#include "common/ThreadPool.hpp"
+
+#include <openMVG/sfm/sfm_data.hpp>
+#include <openMVG/sfm/sfm_data_io.hpp>
+#include <openMVG/cameras/Camera_Pinhole_Radial.hpp>
+#include <openMVG/features/features.hpp>
+#include <openMVG/image/image_io.hpp>
+#include <openMVG/voctree/tree_builder.hpp>
+#include <nonFree/sift/SIFT_describer.hpp>
+
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+
+#include <opencv2/core/core.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace po = boost::program_options;
+namespace bfs = boost::filesystem;
+using namespace openMVG_ofx;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+typedef openMVG::features::Descriptor<float, 128> DescriptorFloat;
+
+double getElapsedMs(const Clock::time_point &start)
+{
+  return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+/**
+ * @brief Voxel of the landmarks merge grid
+ */
+struct VoxelKey
+{
+  long long x, y, z;
+
+  bool operator==(const VoxelKey &other) const
+  {
+    return x == other.x && y == other.y && z == other.z;
+  }
+};
+
+struct VoxelKeyHash
+{
+  std::size_t operator()(const VoxelKey &key) const
+  {
+    return std::hash<long long>()(key.x) ^ (std::hash<long long>()(key.y) << 1) ^ (std::hash<long long>()(key.z) << 2);
+  }
+};
+
+/**
+ * @brief Features of a rendered database view, kept until they are merged in landmarks
+ */
+struct ViewFeatures
+{
+  std::vector<openMVG::Vec2> points;
+  std::vector<openMVG::features::Descriptor<unsigned char, 128> > descriptors;
+  double renderMs = 0.0;
+  double extractMs = 0.0;
+};
+
+/**
+ * @brief Keep the most observed landmarks
+ * The voxels of the dropped landmarks stay in the merge grid, marked as dropped:
+ * the features of the next views on these voxels are not merged again.
+ * @param[in] nbKept
+ * @param[in,out] landmarks
+ * @param[in,out] landmarkPerVoxel
+ */
+void dropLeastObservedLandmarks(std::size_t nbKept,
+                                openMVG::sfm::Landmarks &landmarks,
+                                std::unordered_map<VoxelKey, openMVG::IndexT, VoxelKeyHash> &landmarkPerVoxel)
+{
+  if(landmarks.size() <= nbKept)
+    return;
+  std::vector< std::pair<std::size_t, openMVG::IndexT> > landmarksObservations;
+  landmarksObservations.reserve(landmarks.size());
+  for(const auto &landmark : landmarks)
+    landmarksObservations.emplace_back(landmark.second.obs.size(), landmark.first);
+  std::nth_element(landmarksObservations.begin(), landmarksObservations.begin() + nbKept, landmarksObservations.end(),
+    [](const std::pair<std::size_t, openMVG::IndexT> &a, const std::pair<std::size_t, openMVG::IndexT> &b)
+    {
+      return a.first > b.first;
+    });
+  for(auto it = landmarksObservations.begin() + nbKept; it != landmarksObservations.end(); ++it)
+    landmarks.erase(it->second);
+  for(auto &voxel : landmarkPerVoxel)
+  {
+    if(voxel.second != openMVG::UndefinedIndexT && landmarks.count(voxel.second) == 0)
+      voxel.second = openMVG::UndefinedIndexT;
+  }
+}
+
+} //namespace
+
+int main(int argc, char **argv)
+{
+  std::string outputFolder;
+  std::size_t nbViews = 1000;
+  std::size_t nbLandmarks = 0;
+  std::size_t maxMergedLandmarks = 0;
+  std::size_t nbQueryFrames = 100;
+  std::size_t minObservations = 1;
+  double mergeDistance = 0.01;
+  std::string featuresPreset = Localizer::kStringParamFeaturesPreset[Localizer::eParamFeaturesPresetNormal].first;
+  std::size_t voctreeBranching = 10;
+  std::size_t voctreeLevels = 6;
+  std::size_t voctreeMaxDescriptors = 500000;
+  bool writeViewImages = false;
+  std::size_t nbThreads = 0;
+  std::size_t batchSize = 256;
+  std::string logLevel;
+  Synthetic::SceneSettings settings;
+
+  po::options_description requiredParams("Required parameters");
+  requiredParams.add_options()
+    ("output", po::value<std::string>(&outputFolder)->required(), "Output folder.");
+
+  po::options_description optionalParams("Optional parameters");
+  optionalParams.add_options()
+    ("help,h", "Print this message.")
+    ("nbViews", po::value<std::size_t>(&nbViews)->default_value(nbViews), "Number of reconstructed views.")
+    ("nbLandmarks", po::value<std::size_t>(&nbLandmarks)->default_value(nbLandmarks), "Maximal number of landmarks, the most observed are kept (0: all).")
+    ("maxMergedLandmarks", po::value<std::size_t>(&maxMergedLandmarks)->default_value(maxMergedLandmarks), "Maximal number of landmarks in memory while the views are merged, "
+      "the least observed are dropped (0: 8 x nbLandmarks, all if nbLandmarks is 0).")
+    ("nbQueryFrames", po::value<std::size_t>(&nbQueryFrames)->default_value(nbQueryFrames), "Number of rendered frames of the query camera path.")
+    ("minObservations", po::value<std::size_t>(&minObservations)->default_value(minObservations), "Minimal number of observations of a landmark.")
+    ("mergeDistance", po::value<double>(&mergeDistance)->default_value(mergeDistance), "Size of the grid merging the back-projected features in landmarks.")
+    ("preset", po::value<std::string>(&featuresPreset)->default_value(featuresPreset), "SIFT preset: Low, Medium, Normal, High or Ultra.")
+    ("width", po::value<std::size_t>(&settings.width)->default_value(settings.width), "Image width.")
+    ("height", po::value<std::size_t>(&settings.height)->default_value(settings.height), "Image height.")
+    ("focal", po::value<double>(&settings.focal)->default_value(settings.focal), "Focal length in pixels.")
+    ("roomSize", po::value<double>(&settings.roomSize)->default_value(settings.roomSize), "Width and depth of the room.")
+    ("roomHeight", po::value<double>(&settings.roomHeight)->default_value(settings.roomHeight), "Height of the room.")
+    ("textureCellSize", po::value<double>(&settings.textureCellSize)->default_value(settings.textureCellSize), "Size of the coarsest texture detail.")
+    ("supersampling", po::value<int>(&settings.supersampling)->default_value(settings.supersampling), "Render samples per pixel edge.")
+    ("seed", po::value<std::uint32_t>(&settings.seed)->default_value(settings.seed), "Seed of the texture and of the database poses.")
+    ("voctreeBranching", po::value<std::size_t>(&voctreeBranching)->default_value(voctreeBranching), "Vocabulary tree branching factor.")
+    ("voctreeLevels", po::value<std::size_t>(&voctreeLevels)->default_value(voctreeLevels), "Vocabulary tree levels.")
+    ("voctreeMaxDescriptors", po::value<std::size_t>(&voctreeMaxDescriptors)->default_value(voctreeMaxDescriptors), "Maximal number of descriptors to train the vocabulary tree.")
+    ("writeViewImages", po::value<bool>(&writeViewImages)->default_value(writeViewImages), "Write the database view images.")
+    ("nbThreads", po::value<std::size_t>(&nbThreads)->default_value(nbThreads), "Number of render and feature extraction workers (0: one per hardware thread).")
+    ("batchSize", po::value<std::size_t>(&batchSize)->default_value(batchSize), "Number of views extracted before being merged, bounds the memory.")
+    ("logLevel", po::value<std::string>(&logLevel), "Log level: trace, debug, info, warning, error or none.");
+
+  po::options_description allParams("Generate a synthetic reconstruction, its descriptors, a vocabulary tree and a ground truth query sequence.");
+  allParams.add(requiredParams).add(optionalParams);
+
+  po::variables_map vm;
+  try
+  {
+    po::store(po::parse_command_line(argc, argv, allParams), vm);
+    if(vm.count("help") || (argc == 1))
+    {
+      std::cout << allParams << std::endl;
+      return EXIT_SUCCESS;
+    }
+    po::notify(vm);
+  }
+  catch(po::error &e)
+  {
+    std::cerr << "ERROR: " << e.what() << std::endl << std::endl << allParams << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  Common::Logger &logger = Common::Logger::instance();
+  if(!logLevel.empty())
+    logger.setLevel(Common::Logger::getLevelFromString(logLevel, logger.getLevel()));
+
+  batchSize = std::max<std::size_t>(1, batchSize);
+  if(maxMergedLandmarks == 0)
+    maxMergedLandmarks = 8 * nbLandmarks;
+
+  //Render and extraction workers, the process-wide pool by default
+  std::unique_ptr<Common::ThreadPool> threadPool;
+  if(nbThreads > 0)
+    threadPool.reset(new Common::ThreadPool(nbThreads));
+  Common::ThreadPool &pool = threadPool ? *threadPool : Common::ThreadPool::instance();
+
+  openMVG::features::EDESCRIBER_PRESET preset;
+  try
+  {
+    std::size_t presetIndex = 0;
+    while(presetIndex < Localizer::kStringParamFeaturesPreset.size() && Localizer::kStringParamFeaturesPreset[presetIndex].first != featuresPreset)
+      ++presetIndex;
+    preset = Localizer::LocalizerProcessData::getDescriberPreset(static_cast<Localizer::EParamFeaturesPreset>(presetIndex));
+  }
+  catch(std::exception &e)
+  {
+    OFXMVG_LOG_ERROR("setup") << e.what() << Common::kv("preset", featuresPreset);
+    logger.flush();
+    return EXIT_FAILURE;
+  }
+
+  const bfs::path outputPath(outputFolder);
+  const bfs::path descriptorsPath = outputPath / "descriptors";
+  const bfs::path queryPath = outputPath / "query";
+  const bfs::path viewsPath = outputPath / "views";
+  bfs::create_directories(descriptorsPath);
+  bfs::create_directories(queryPath);
+  if(writeViewImages)
+    bfs::create_directories(viewsPath);
+
+  const Synthetic::SyntheticScene scene(settings);
+
+  //Reconstruction with a single distortion free intrinsic
+  openMVG::sfm::SfM_Data sfmData;
+  const double ppx = (settings.width - 1) / 2.0;
+  const double ppy = (settings.height - 1) / 2.0;
+  sfmData.intrinsics[0] = std::make_shared<openMVG::cameras::Pinhole_Intrinsic_Radial_K3>(settings.width, settings.height, settings.focal, ppx, ppy, 0.0, 0.0, 0.0);
+
+  std::unordered_map<VoxelKey, openMVG::IndexT, VoxelKeyHash> landmarkPerVoxel;
+  std::vector<DescriptorFloat> voctreeDescriptors;
+  std::mt19937 samplingGenerator(settings.seed);
+  std::size_t nbSeenDescriptors = 0;
+  std::size_t nbFeatures = 0;
+  openMVG::IndexT nbMergedLandmarks = 0;
+
+  double renderMs = 0.0;
+  double extractMs = 0.0;
+  Clock::time_point start = Clock::now();
+
+  //Database views, extracted in parallel by batch and merged in order
+  for(std::size_t batchBegin = 0; batchBegin < nbViews; batchBegin += batchSize)
+  {
+    const std::size_t batchEnd = std::min(nbViews, batchBegin + batchSize);
+    std::vector<ViewFeatures> batchFeatures(batchEnd - batchBegin);
+
+    pool.parallelFor(batchBegin, batchEnd, [&](std::size_t viewId)
+    {
+      ViewFeatures &viewFeatures = batchFeatures[viewId - batchBegin];
+      Clock::time_point viewStart = Clock::now();
+      openMVG::image::Image<unsigned char> image;
+      scene.render(scene.getDatabasePose(viewId), image);
+      if(writeViewImages)
+        openMVG::image::WriteImage((viewsPath / (std::to_string(viewId) + ".png")).string().c_str(), image);
+      viewFeatures.renderMs = getElapsedMs(viewStart);
+
+      viewStart = Clock::now();
+      openMVG::features::SIFT_Image_describer describer;
+      describer.Set_configuration_preset(preset);
+      std::unique_ptr<openMVG::features::Regions> regions;
+      describer.Describe(image, regions, nullptr);
+      regions->Save((descriptorsPath / (std::to_string(viewId) + ".feat")).string(),
+                    (descriptorsPath / (std::to_string(viewId) + ".desc")).string());
+
+      const openMVG::features::SIFT_Regions *siftRegions = dynamic_cast<const openMVG::features::SIFT_Regions*>(regions.get());
+      for(const auto &feature : siftRegions->Features())
+        viewFeatures.points.emplace_back(feature.x(), feature.y());
+      viewFeatures.descriptors = siftRegions->Descriptors();
+      viewFeatures.extractMs = getElapsedMs(viewStart);
+    });
+
+    for(std::size_t viewId = batchBegin; viewId < batchEnd; ++viewId)
+    {
+      const openMVG::geometry::Pose3 pose = scene.getDatabasePose(viewId);
+      sfmData.views[viewId] = std::make_shared<openMVG::sfm::View>("views/" + std::to_string(viewId) + ".png", viewId, 0, viewId, settings.width, settings.height);
+      sfmData.poses[viewId] = pose;
+
+      const ViewFeatures &viewFeatures = batchFeatures[viewId - batchBegin];
+      renderMs += viewFeatures.renderMs;
+      extractMs += viewFeatures.extractMs;
+      for(std::size_t featureId = 0; featureId < viewFeatures.points.size(); ++featureId)
+      {
+        //Exact 3D point, merged with the features of the other views on the same voxel
+        const openMVG::Vec3 X = scene.backProject(pose, viewFeatures.points[featureId]);
+        const VoxelKey key = {static_cast<long long>(std::floor(X(0) / mergeDistance)),
+                              static_cast<long long>(std::floor(X(1) / mergeDistance)),
+                              static_cast<long long>(std::floor(X(2) / mergeDistance))};
+        auto it = landmarkPerVoxel.find(key);
+        if(it == landmarkPerVoxel.end())
+        {
+          //The identifiers are not reused by the dropped landmarks
+          const openMVG::IndexT landmarkId = nbMergedLandmarks++;
+          it = landmarkPerVoxel.emplace(key, landmarkId).first;
+          sfmData.structure[landmarkId].X = X;
+        }
+        if(it->second != openMVG::UndefinedIndexT)
+        {
+          openMVG::sfm::Landmark &landmark = sfmData.structure[it->second];
+          if(landmark.obs.count(viewId) == 0)
+            landmark.obs[viewId] = openMVG::sfm::Observation(viewFeatures.points[featureId], featureId);
+        }
+
+        //Reservoir sampling of the vocabulary tree training descriptors
+        const auto &descriptor = viewFeatures.descriptors[featureId];
+        std::size_t slot = nbSeenDescriptors++;
+        if(slot >= voctreeMaxDescriptors)
+          slot = std::uniform_int_distribution<std::size_t>(0, slot)(samplingGenerator);
+        if(slot < voctreeMaxDescriptors)
+        {
+          DescriptorFloat descriptorFloat;
+          for(std::size_t i = 0; i < 128; ++i)
+            descriptorFloat[i] = static_cast<float>(descriptor[i]);
+          if(slot < voctreeDescriptors.size())
+            voctreeDescriptors[slot] = descriptorFloat;
+          else
+            voctreeDescriptors.push_back(descriptorFloat);
+        }
+      }
+      nbFeatures += viewFeatures.points.size();
+    }
+
+    //Bound the memory of the merge: half of the landmarks are dropped once the maximum is reached
+    if(maxMergedLandmarks > 0 && sfmData.structure.size() > maxMergedLandmarks)
+    {
+      dropLeastObservedLandmarks(maxMergedLandmarks / 2, sfmData.structure, landmarkPerVoxel);
+      OFXMVG_LOG_DEBUG("views") << "least observed landmarks dropped"
+        << Common::kv("nbViews", batchEnd)
+        << Common::kv("nbMergedLandmarks", nbMergedLandmarks);
+    }
+
+    OFXMVG_LOG_INFO("views") << "views extracted"
+      << Common::kv("nbViews", batchEnd)
+      << Common::kv("nbLandmarks", sfmData.structure.size());
+  }
+  landmarkPerVoxel.clear();
+  const double databaseMs = getElapsedMs(start);
+
+  //Landmarks filtering, the most observed are kept
+  start = Clock::now();
+  {
+    std::vector< std::pair<std::size_t, openMVG::IndexT> > landmarksObservations;
+    for(const auto &landmark : sfmData.structure)
+    {
+      if(landmark.second.obs.size() >= minObservations)
+        landmarksObservations.emplace_back(landmark.second.obs.size(), landmark.first);
+    }
+    if(nbLandmarks > 0 && landmarksObservations.size() > nbLandmarks)
+    {
+      std::partial_sort(landmarksObservations.begin(), landmarksObservations.begin() + nbLandmarks, landmarksObservations.end(),
+                        [](const std::pair<std::size_t, openMVG::IndexT> &a, const std::pair<std::size_t, openMVG::IndexT> &b)
+                        {
+                          return a.first > b.first || (a.first == b.first && a.second < b.second);
+                        });
+      landmarksObservations.resize(nbLandmarks);
+    }
+    openMVG::sfm::Landmarks landmarks;
+    for(const auto &landmarkObservations : landmarksObservations)
+      landmarks[landmarkObservations.second] = sfmData.structure[landmarkObservations.second];
+    sfmData.structure.swap(landmarks);
+  }
+  if(nbLandmarks > 0 && sfmData.structure.size() < nbLandmarks)
+  {
+    OFXMVG_LOG_WARNING("landmarks") << "less landmarks than requested, increase the number of views or the SIFT preset"
+      << Common::kv("nbLandmarks", sfmData.structure.size());
+  }
+
+  if(!openMVG::sfm::Save(sfmData, (outputPath / "sfm_data.json").string(), openMVG::sfm::ESfM_Data(openMVG::sfm::ALL)))
+  {
+    OFXMVG_LOG_ERROR("sfm") << "can't write the reconstruction" << Common::kv("path", (outputPath / "sfm_data.json").string());
+    logger.flush();
+    return EXIT_FAILURE;
+  }
+  const double sfmMs = getElapsedMs(start);
+
+  //Vocabulary tree
+  start = Clock::now();
+  {
+    openMVG::voctree::TreeBuilder<DescriptorFloat> builder(DescriptorFloat(0));
+    builder.kmeans().setRestarts(1);
+    builder.build(voctreeDescriptors, voctreeBranching, voctreeLevels);
+    builder.tree().save((outputPath / "tree.voctree").string());
+  }
+  const double voctreeMs = getElapsedMs(start);
+
+  //Query sequence, with its ground truth poses and lens calibration
+  start = Clock::now();
+  std::vector<Synthetic::GroundTruthPose> groundTruth(nbQueryFrames);
+  pool.parallelFor(0, nbQueryFrames, [&](std::size_t frame)
+  {
+    groundTruth[frame].frame = frame;
+    groundTruth[frame].pose = scene.getQueryPose(frame, nbQueryFrames);
+    openMVG::image::Image<unsigned char> image;
+    scene.render(groundTruth[frame].pose, image);
+    char fileName[64];
+    std::snprintf(fileName, sizeof(fileName), "frame.%05zu.png", frame);
+    openMVG::image::WriteImage((queryPath / fileName).string().c_str(), image);
+  });
+
+  const cv::Mat cameraMatrix = (cv::Mat_<double>(3, 3) << settings.focal, 0.0, ppx, 0.0, settings.focal, ppy, 0.0, 0.0, 1.0);
+  const cv::Mat distCoeffs = cv::Mat::zeros(5, 1, CV_64F);
+  const bool isWritten =
+    Synthetic::writeGroundTruth((outputPath / "groundTruth.txt").string(), groundTruth) &&
+    LensCalibration::writeCalibrationFile((outputPath / "query.cal").string(), cv::Size(settings.width, settings.height), cameraMatrix, distCoeffs);
+  if(!isWritten)
+  {
+    OFXMVG_LOG_ERROR("query") << "can't write the query ground truth" << Common::kv("path", outputFolder);
+    logger.flush();
+    return EXIT_FAILURE;
+  }
+  const double queryMs = getElapsedMs(start);
+
+  OFXMVG_LOG_INFO("summary") << "synthetic scene generated"
+    << Common::kv("nbViews", sfmData.views.size())
+    << Common::kv("nbLandmarks", sfmData.structure.size())
+    << Common::kv("nbFeatures", nbFeatures)
+    << Common::kv("nbVoctreeDescriptors", voctreeDescriptors.size())
+    << Common::kv("nbQueryFrames", nbQueryFrames);
+  OFXMVG_LOG_INFO("timing") << "generation"
+    << Common::kv("databaseMs", databaseMs)
+    << Common::kv("renderThreadMs", renderMs)
+    << Common::kv("extractThreadMs", extractMs)
+    << Common::kv("sfmMs", sfmMs)
+    << Common::kv("voctreeMs", voctreeMs)
+    << Common::kv("queryMs", queryMs);
+
+  logger.flush();
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,233 @@
+#include "SyntheticScene.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <sstream>
+
+namespace openMVG_ofx {
+namespace Synthetic {
+
+namespace {
+
+const double kPi = 3.14159265358979323846;
+
+std::uint32_t hash(std::uint32_t seed, std::int32_t i, std::int32_t j)
+{
+  std::uint32_t h = seed * 0x9E3779B1u;
+  h ^= static_cast<std::uint32_t>(i) * 0x85EBCA77u;
+  h = (h << 13) | (h >> 19);
+  h ^= static_cast<std::uint32_t>(j) * 0xC2B2AE3Du;
+  h ^= h >> 16;
+  h *= 0x7FEB352Du;
+  h ^= h >> 15;
+  h *= 0x846CA68Bu;
+  h ^= h >> 16;
+  return h;
+}
+
+double smoothstep(double t)
+{
+  return t * t * (3.0 - 2.0 * t);
+}
+
+} //namespace
+
+SyntheticScene::SyntheticScene(const SceneSettings &settings)
+  : _settings(settings)
+  , _halfSize(settings.roomSize / 2.0, settings.roomHeight / 2.0, settings.roomSize / 2.0)
+{}
+
+openMVG::geometry::Pose3 SyntheticScene::lookAt(const openMVG::Vec3 &center, double yaw, double pitch)
+{
+  const openMVG::Vec3 z(std::cos(pitch) * std::sin(yaw), std::sin(pitch), std::cos(pitch) * std::cos(yaw));
+  const openMVG::Vec3 down(0.0, -1.0, 0.0);
+  const openMVG::Vec3 x = down.cross(z).normalized();
+  const openMVG::Vec3 y = z.cross(x);
+
+  openMVG::Mat3 R;
+  R.row(0) = x.transpose();
+  R.row(1) = y.transpose();
+  R.row(2) = z.transpose();
+  return openMVG::geometry::Pose3(R, center);
+}
+
+openMVG::geometry::Pose3 SyntheticScene::getDatabasePose(std::size_t index) const
+{
+  //One generator per view, poses don't depend on the generation order
+  std::mt19937 generator(hash(_settings.seed, static_cast<std::int32_t>(index), 1));
+  std::uniform_real_distribution<double> unit(-1.0, 1.0);
+
+  const openMVG::Vec3 center(0.6 * _halfSize(0) * unit(generator),
+                             0.5 * _halfSize(1) * unit(generator),
+                             0.6 * _halfSize(2) * unit(generator));
+  const double yaw = kPi * unit(generator);
+  const double pitch = _settings.maxPitchDeg * kPi / 180.0 * unit(generator);
+  return lookAt(center, yaw, pitch);
+}
+
+openMVG::geometry::Pose3 SyntheticScene::getQueryPose(std::size_t frame, std::size_t nbFrames) const
+{
+  //One turn around the room center, looking outward with a slow yaw and pitch oscillation
+  const double t = 2.0 * kPi * frame / std::max<std::size_t>(nbFrames, 1);
+  const openMVG::Vec3 center(0.4 * _halfSize(0) * std::cos(t),
+                             0.2 * _halfSize(1) * std::sin(2.0 * t),
+                             0.4 * _halfSize(2) * std::sin(t));
+  const double yaw = std::atan2(center(0), center(2)) + 0.3 * std::sin(3.0 * t);
+  const double pitch = 0.1 * std::sin(5.0 * t);
+  return lookAt(center, yaw, pitch);
+}
+
+openMVG::Vec3 SyntheticScene::getRayDirection(const openMVG::geometry::Pose3 &pose, double x, double y) const
+{
+  const double ppx = (_settings.width - 1) / 2.0;
+  const double ppy = (_settings.height - 1) / 2.0;
+  const openMVG::Vec3 cameraDirection((x - ppx) / _settings.focal, (y - ppy) / _settings.focal, 1.0);
+  return pose.rotation().transpose() * cameraDirection;
+}
+
+openMVG::Vec3 SyntheticScene::castRay(const openMVG::Vec3 &center, const openMVG::Vec3 &direction, int &face) const
+{
+  double tMin = std::numeric_limits<double>::max();
+  face = 0;
+  for(int axis = 0; axis < 3; ++axis)
+  {
+    if(direction(axis) == 0.0)
+      continue;
+    const double bound = (direction(axis) > 0.0) ? _halfSize(axis) : -_halfSize(axis);
+    const double t = (bound - center(axis)) / direction(axis);
+    if(t > 0.0 && t < tMin)
+    {
+      tMin = t;
+      face = 2 * axis + ((direction(axis) > 0.0) ? 1 : 0);
+    }
+  }
+  return center + tMin * direction;
+}
+
+double SyntheticScene::valueNoise(std::uint32_t seed, double u, double v) const
+{
+  const double fu = std::floor(u);
+  const double fv = std::floor(v);
+  const std::int32_t i = static_cast<std::int32_t>(fu);
+  const std::int32_t j = static_cast<std::int32_t>(fv);
+  const double su = smoothstep(u - fu);
+  const double sv = smoothstep(v - fv);
+  const double scale = 1.0 / std::numeric_limits<std::uint32_t>::max();
+
+  const double v00 = hash(seed, i, j) * scale;
+  const double v10 = hash(seed, i + 1, j) * scale;
+  const double v01 = hash(seed, i, j + 1) * scale;
+  const double v11 = hash(seed, i + 1, j + 1) * scale;
+  return (v00 * (1.0 - su) + v10 * su) * (1.0 - sv) + (v01 * (1.0 - su) + v11 * su) * sv;
+}
+
+double SyntheticScene::sampleTexture(int face, const openMVG::Vec3 &point) const
+{
+  //Texture coordinates in the face plane
+  const int axis = face / 2;
+  const double u = point((axis + 1) % 3) / _settings.textureCellSize;
+  const double v = point((axis + 2) % 3) / _settings.textureCellSize;
+  const std::uint32_t faceSeed = _settings.seed * 16u + static_cast<std::uint32_t>(face);
+
+  //Octaves of value noise, the coarse ones give distinctive SIFT blobs
+  double value = 0.0;
+  double amplitude = 0.5;
+  double frequency = 1.0;
+  for(std::uint32_t octave = 0; octave < 4; ++octave)
+  {
+    value += amplitude * valueNoise(faceSeed * 8u + octave, u * frequency, v * frequency);
+    amplitude *= 0.5;
+    frequency *= 2.0;
+  }
+  //Contrast stretch, the sum of octaves is concentrated around its mean
+  return std::min(255.0, std::max(0.0, 128.0 + 2.5 * 255.0 * (value - 0.47)));
+}
+
+void SyntheticScene::render(const openMVG::geometry::Pose3 &pose, openMVG::image::Image<unsigned char> &image) const
+{
+  const int samples = std::max(1, _settings.supersampling);
+  const double sampleStep = 1.0 / samples;
+  const double sampleOffset = sampleStep / 2.0 - 0.5;
+  const double normalization = 1.0 / (samples * samples);
+
+  image.resize(_settings.width, _settings.height);
+  for(std::size_t y = 0; y < _settings.height; ++y)
+  {
+    for(std::size_t x = 0; x < _settings.width; ++x)
+    {
+      double value = 0.0;
+      for(int sy = 0; sy < samples; ++sy)
+      {
+        for(int sx = 0; sx < samples; ++sx)
+        {
+          int face = 0;
+          const openMVG::Vec3 direction = getRayDirection(pose, x + sampleOffset + sx * sampleStep, y + sampleOffset + sy * sampleStep);
+          const openMVG::Vec3 point = castRay(pose.center(), direction, face);
+          value += sampleTexture(face, point);
+        }
+      }
+      image(y, x) = static_cast<unsigned char>(value * normalization + 0.5);
+    }
+  }
+}
+
+openMVG::Vec3 SyntheticScene::backProject(const openMVG::geometry::Pose3 &pose, const openMVG::Vec2 &point) const
+{
+  int face = 0;
+  return castRay(pose.center(), getRayDirection(pose, point(0), point(1)), face);
+}
+
+bool writeGroundTruth(const std::string &filePath, const std::vector<GroundTruthPose> &poses)
+{
+  std::ofstream file(filePath);
+  if(!file.is_open())
+    return false;
+
+  file.precision(12);
+  file << "# frame cx cy cz r00 r01 r02 r10 r11 r12 r20 r21 r22" << std::endl;
+  for(const GroundTruthPose &groundTruth : poses)
+  {
+    const openMVG::Vec3 &center = groundTruth.pose.center();
+    const openMVG::Mat3 &rotation = groundTruth.pose.rotation();
+    file << groundTruth.frame << " " << center(0) << " " << center(1) << " " << center(2);
+    for(int i = 0; i < 3; ++i)
+      for(int j = 0; j < 3; ++j)
+        file << " " << rotation(i, j);
+    file << std::endl;
+  }
+  return file.good();
+}
+
+bool readGroundTruth(const std::string &filePath, std::vector<GroundTruthPose> &poses)
+{
+  std::ifstream file(filePath);
+  if(!file.is_open())
+    return false;
+
+  poses.clear();
+  std::string line;
+  while(std::getline(file, line))
+  {
+    if(line.empty() || line[0] == '#')
+      continue;
+    std::istringstream is(line);
+    GroundTruthPose groundTruth;
+    openMVG::Vec3 center;
+    openMVG::Mat3 rotation;
+    is >> groundTruth.frame >> center(0) >> center(1) >> center(2);
+    for(int i = 0; i < 3; ++i)
+      for(int j = 0; j < 3; ++j)
+        is >> rotation(i, j);
+    if(is.fail())
+      return false;
+    groundTruth.pose = openMVG::geometry::Pose3(rotation, center);
+    poses.push_back(groundTruth);
+  }
+  return true;
+}
+
+} //namespace Synthetic
+} //namespace openMVG_ofx
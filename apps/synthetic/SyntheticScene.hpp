@@ -0,0 +1,127 @@
+#pragma once
+
+#include <openMVG/numeric/numeric.h>
+#include <openMVG/geometry/pose3.hpp>
+#include <openMVG/image/image.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace openMVG_ofx {
+namespace Synthetic {
+
+/**
+ * @brief Synthetic scene settings
+ * The scene is a closed box room with procedurally textured faces, seen from inside.
+ */
+struct SceneSettings
+{
+  std::size_t width = 640;
+  std::size_t height = 360;
+  double focal = 500.0;             //in pixels
+  double roomSize = 10.0;           //width and depth of the room
+  double roomHeight = 4.0;
+  double textureCellSize = 0.25;    //size of the coarsest texture detail
+  int supersampling = 2;            //render samples per pixel edge
+  std::uint32_t seed = 42;
+  double maxPitchDeg = 20.0;        //database views pitch range
+};
+
+/**
+ * @brief Procedurally textured box room, rendered by ray casting
+ * Rendering and back-projection are exact: a pixel of a render
+ * back-projects on the textured surface it was rendered from.
+ */
+class SyntheticScene
+{
+public:
+  explicit SyntheticScene(const SceneSettings &settings);
+
+  const SceneSettings& getSettings() const { return _settings; }
+
+  /**
+   * @brief Camera pose looking in a direction, the image y axis pointing down
+   * @param[in] center - camera center
+   * @param[in] yaw - rotation around the vertical axis (radians)
+   * @param[in] pitch - positive looks up (radians)
+   * @return pose
+   */
+  static openMVG::geometry::Pose3 lookAt(const openMVG::Vec3 &center, double yaw, double pitch);
+
+  /**
+   * @brief Random database pose inside the room, deterministic for a given index
+   * @param[in] index - view index
+   * @return pose
+   */
+  openMVG::geometry::Pose3 getDatabasePose(std::size_t index) const;
+
+  /**
+   * @brief Pose on the smooth query camera path
+   * @param[in] frame - frame index
+   * @param[in] nbFrames - number of frames of the path
+   * @return pose
+   */
+  openMVG::geometry::Pose3 getQueryPose(std::size_t frame, std::size_t nbFrames) const;
+
+  /**
+   * @brief Render a gray image of the room
+   * @param[in] pose
+   * @param[out] image
+   */
+  void render(const openMVG::geometry::Pose3 &pose, openMVG::image::Image<unsigned char> &image) const;
+
+  /**
+   * @brief Back-project an image point on the room surface
+   * @param[in] pose
+   * @param[in] point - pixel coordinates, pixel centers on integer coordinates
+   * @return 3D point
+   */
+  openMVG::Vec3 backProject(const openMVG::geometry::Pose3 &pose, const openMVG::Vec2 &point) const;
+
+private:
+  /**
+   * @brief Cast a ray from inside the room
+   * @param[in] center
+   * @param[in] direction
+   * @param[out] face - index of the hit face
+   * @return hit point
+   */
+  openMVG::Vec3 castRay(const openMVG::Vec3 &center, const openMVG::Vec3 &direction, int &face) const;
+
+  openMVG::Vec3 getRayDirection(const openMVG::geometry::Pose3 &pose, double x, double y) const;
+
+  double sampleTexture(int face, const openMVG::Vec3 &point) const;
+  double valueNoise(std::uint32_t seed, double u, double v) const;
+
+  const SceneSettings _settings;
+  const openMVG::Vec3 _halfSize;
+};
+
+/**
+ * @brief Ground truth camera pose of a query frame
+ */
+struct GroundTruthPose
+{
+  std::size_t frame;
+  openMVG::geometry::Pose3 pose;
+};
+
+/**
+ * @brief Write the ground truth poses, one line per frame: frame C(3) R(9 row major)
+ * @param[in] filePath
+ * @param[in] poses
+ * @return true if the file is written
+ */
+bool writeGroundTruth(const std::string &filePath, const std::vector<GroundTruthPose> &poses);
+
+/**
+ * @brief Read a ground truth file written by writeGroundTruth
+ * @param[in] filePath
+ * @param[out] poses
+ * @return true if the file is read
+ */
+bool readGroundTruth(const std::string &filePath, std::vector<GroundTruthPose> &poses);
+
+} //namespace Synthetic
+} //namespace openMVG_ofx
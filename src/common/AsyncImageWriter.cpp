@@ -0,0 +1,95 @@
+#include "AsyncImageWriter.hpp"
+#include "ThreadPool.hpp"
+#include "Trace.hpp"
+#include "Logger.hpp"
+
+#include <opencv2/highgui/highgui.hpp>
+
+#include <algorithm>
+#include <exception>
+
+namespace openMVG_ofx {
+namespace Common {
+
+AsyncImageWriter::AsyncImageWriter(std::size_t maxPendingImages)
+  : _maxPendingImages(std::max<std::size_t>(1, maxPendingImages))
+{}
+
+AsyncImageWriter::~AsyncImageWriter()
+{
+  flush();
+}
+
+void AsyncImageWriter::write(const std::string& filePath, const cv::Mat& image, const Preprocess& preprocess)
+{
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    if(_nbPendingImages >= _maxPendingImages)
+    {
+      OFXMVG_TRACE_SCOPE("asyncImageWriter.wait");
+      _condition.wait(lock, [this]() { return _nbPendingImages < _maxPendingImages; });
+    }
+    ++_nbPendingImages;
+    traceCounter("pendingImageWrites", static_cast<double>(_nbPendingImages));
+  }
+  submit(filePath, image, std::string(), preprocess);
+}
+
+void AsyncImageWriter::convert(const std::string& sourcePath, const std::string& filePath, const Preprocess& preprocess)
+{
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    ++_nbPendingImages;
+    traceCounter("pendingImageWrites", static_cast<double>(_nbPendingImages));
+  }
+  submit(filePath, cv::Mat(), sourcePath, preprocess);
+}
+
+void AsyncImageWriter::submit(const std::string& filePath, const cv::Mat& image, const std::string& sourcePath, const Preprocess& preprocess)
+{
+  //The future is not kept: the pending count tracks the completion
+  ThreadPool::instance().submit([this, filePath, image, sourcePath, preprocess]()
+  {
+    OFXMVG_TRACE_SCOPE("asyncImageWriter.write");
+    bool isWritten = false;
+    try
+    {
+      cv::Mat writtenImage = image;
+      if(writtenImage.empty() && !sourcePath.empty())
+        writtenImage = cv::imread(sourcePath, cv::IMREAD_UNCHANGED);
+      if(writtenImage.empty())
+        OFXMVG_LOG_ERROR("asyncImageWriter") << "cannot read the image" << kv("file", sourcePath);
+      else
+      {
+        if(preprocess)
+          preprocess(writtenImage);
+        isWritten = cv::imwrite(filePath, writtenImage);
+      }
+    }
+    catch(const std::exception& e)
+    {
+      OFXMVG_LOG_ERROR("asyncImageWriter") << e.what() << kv("file", filePath);
+    }
+    if(!isWritten)
+      OFXMVG_LOG_ERROR("asyncImageWriter") << "cannot write the image" << kv("file", filePath);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if(!isWritten)
+      ++_nbFailedWrites;
+    --_nbPendingImages;
+    _condition.notify_all();
+  });
+}
+
+std::size_t AsyncImageWriter::flush()
+{
+  OFXMVG_TRACE_SCOPE("asyncImageWriter.flush");
+  std::unique_lock<std::mutex> lock(_mutex);
+  _condition.wait(lock, [this]() { return _nbPendingImages == 0; });
+  const std::size_t nbFailedWrites = _nbFailedWrites;
+  _nbFailedWrites = 0;
+  return nbFailedWrites;
+}
+
+} //namespace Common
+} //namespace openMVG_ofx
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <opencv2/core/core.hpp>
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <string>
+
+namespace openMVG_ofx {
+namespace Common {
+
+/**
+ * @brief Bounded queue of image writes, encoded and written on the worker pool
+ * The image format is given by the file extension (png, jpg...).
+ * Writes must be queued from host threads: a full queue blocks the caller
+ * until a worker is done, a pool worker could wait for itself.
+ */
+class AsyncImageWriter
+{
+public:
+  /**
+   * @brief Processing of an image on the worker, before the encoding
+   */
+  typedef std::function<void(cv::Mat&)> Preprocess;
+
+  /**
+   * @param[in] maxPendingImages - number of queued images before the writes block
+   */
+  explicit AsyncImageWriter(std::size_t maxPendingImages = 8);
+
+  /**
+   * @brief Wait for the queued writes
+   */
+  ~AsyncImageWriter();
+
+  AsyncImageWriter(const AsyncImageWriter&) = delete;
+  AsyncImageWriter& operator=(const AsyncImageWriter&) = delete;
+
+  /**
+   * @brief Queue an image write, blocks while the queue is full
+   * @param[in] filePath
+   * @param[in] image - shared with the queue, must not be modified afterwards
+   * @param[in] preprocess - optional processing run on the worker, e.g. a conversion to 8 bits
+   */
+  void write(const std::string& filePath, const cv::Mat& image, const Preprocess& preprocess = Preprocess());
+
+  /**
+   * @brief Queue the conversion of an image file, read and written on the worker
+   * The queued conversions hold no image: they don't block, they only delay the next writes.
+   * @param[in] sourcePath
+   * @param[in] filePath
+   * @param[in] preprocess - optional processing of the read image, run on the worker
+   */
+  void convert(const std::string& sourcePath, const std::string& filePath, const Preprocess& preprocess = Preprocess());
+
+  /**
+   * @brief Wait for all the queued writes
+   * @return number of writes that failed since the previous flush
+   */
+  std::size_t flush();
+
+private:
+  /**
+   * @brief Submit a queued write to the worker pool
+   * @param[in] filePath
+   * @param[in] image - written image, read from sourcePath if empty
+   * @param[in] sourcePath
+   * @param[in] preprocess
+   */
+  void submit(const std::string& filePath, const cv::Mat& image, const std::string& sourcePath, const Preprocess& preprocess);
+
+  const std::size_t _maxPendingImages;
+  std::size_t _nbPendingImages = 0;
+  std::size_t _nbFailedWrites = 0;
+  std::mutex _mutex;
+  std::condition_variable _condition;
+};
+
+} //namespace Common
+} //namespace openMVG_ofx
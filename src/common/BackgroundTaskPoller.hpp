@@ -0,0 +1,84 @@
+#pragma once
+
+#include <chrono>
+#include <future>
+#include <memory>
+#include <utility>
+
+namespace openMVG_ofx {
+namespace Common {
+
+/**
+ * @brief Poll of a background task owned by a plugin instance
+ * The host has no timer callback: the task is polled from the actions allowed to set parameters.
+ * Reporting the task sets parameters, and setValue calls back changedParam which polls again:
+ * the nested polls are skipped, so the task can't be released while it's reported.
+ */
+class BackgroundTaskPoller
+{
+public:
+  BackgroundTaskPoller() = default;
+
+  BackgroundTaskPoller(const BackgroundTaskPoller&) = delete;
+  BackgroundTaskPoller& operator=(const BackgroundTaskPoller&) = delete;
+
+  /**
+   * @brief Report the progress of the task and apply its result once done
+   * The task must have a std::future member named future.
+   * @param[in,out] task - released once done
+   * @param[in] reportProgress - called with the running task
+   * @param[in] applyResult - called with the done task, its future is ready
+   * @return true if the task is done
+   */
+  template<typename Task, typename ProgressFunction, typename DoneFunction>
+  bool poll(std::unique_ptr<Task>& task, ProgressFunction&& reportProgress, DoneFunction&& applyResult)
+  {
+    if(_isPolling || !task)
+      return false;
+    PollingScope scope(_isPolling);
+
+    reportProgress(*task);
+    if(task->future.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+      return false;
+
+    //Done: the task is released whatever the outcome
+    std::unique_ptr<Task> doneTask = std::move(task);
+    applyResult(*doneTask);
+    return true;
+  }
+
+  /**
+   * @return true while a task is reported
+   */
+  bool isPolling() const
+  {
+    return _isPolling;
+  }
+
+private:
+  /**
+   * @brief Set the polling flag, reset even if the report throws
+   */
+  class PollingScope
+  {
+  public:
+    explicit PollingScope(bool& isPolling)
+      : _isPolling(isPolling)
+    {
+      _isPolling = true;
+    }
+
+    ~PollingScope()
+    {
+      _isPolling = false;
+    }
+
+  private:
+    bool& _isPolling;
+  };
+
+  bool _isPolling = false;
+};
+
+} //namespace Common
+} //namespace openMVG_ofx
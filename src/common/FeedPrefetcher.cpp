@@ -0,0 +1,120 @@
+#include "FeedPrefetcher.hpp"
+#include "Trace.hpp"
+#include "Logger.hpp"
+
+#include <openMVG/dataio/FeedProvider.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace openMVG_ofx {
+namespace Common {
+
+FeedPrefetcher::FeedPrefetcher(const std::string& mediaPath, std::size_t step, std::size_t maxFrames, std::size_t maxQueuedFrames)
+  : _step(std::max<std::size_t>(1, step))
+  , _maxFrames(maxFrames)
+  , _maxQueuedFrames(std::max<std::size_t>(1, maxQueuedFrames))
+{
+  _thread = std::thread(&FeedPrefetcher::decodeLoop, this, mediaPath);
+
+  //The media is opened by the thread, wait for the first frame or the error
+  std::unique_lock<std::mutex> lock(_mutex);
+  _condition.wait(lock, [this]() { return !_frames.empty() || _isDone; });
+  if(_frames.empty() && _exception)
+  {
+    lock.unlock();
+    _thread.join();
+    std::rethrow_exception(_exception);
+  }
+}
+
+FeedPrefetcher::~FeedPrefetcher()
+{
+  cancel();
+  if(_thread.joinable())
+    _thread.join();
+}
+
+bool FeedPrefetcher::pop(Frame& frame)
+{
+  std::unique_lock<std::mutex> lock(_mutex);
+  if(_frames.empty() && !_isDone)
+  {
+    OFXMVG_TRACE_SCOPE("feedPrefetcher.wait");
+    _condition.wait(lock, [this]() { return !_frames.empty() || _isDone; });
+  }
+  if(_frames.empty())
+  {
+    if(_exception)
+      std::rethrow_exception(_exception);
+    return false;
+  }
+  frame = std::move(_frames.front());
+  _frames.pop_front();
+  traceCounter("queuedFeedFrames", static_cast<double>(_frames.size()));
+  _condition.notify_all();
+  return true;
+}
+
+void FeedPrefetcher::cancel()
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  _isCanceled = true;
+  _frames.clear();
+  _condition.notify_all();
+}
+
+void FeedPrefetcher::decodeLoop(const std::string& mediaPath)
+{
+  try
+  {
+    openMVG::dataio::FeedProvider feed(mediaPath);
+    if(!feed.isInit())
+      throw std::runtime_error("Cannot initialize the feed : " + mediaPath);
+
+    //The feed reuses its image buffer, each frame gets its own copy
+    openMVG::image::Image<unsigned char> imageGray;
+    openMVG::cameras::Pinhole_Intrinsic_Radial_K3 queryIntrinsics;
+    bool hasIntrinsics = false;
+    std::string currentImagePath;
+    std::size_t nbFrames = 0;
+
+    for(std::size_t index = 0; _maxFrames == 0 || nbFrames < _maxFrames; index += _step)
+    {
+      Frame frame;
+      frame.index = index;
+      {
+        OFXMVG_TRACE_SCOPE("feedPrefetcher.decode");
+        //Seeking a video decodes from the previous key frame, the next frame is read sequentially
+        if(index > 0 && !(_step == 1 ? feed.goToNextFrame() : feed.goToFrame(index)))
+          break;
+        if(!feed.readImage(imageGray, queryIntrinsics, currentImagePath, hasIntrinsics))
+          break;
+        cv::Mat(imageGray.Height(), imageGray.Width(), CV_8UC1, imageGray.data()).copyTo(frame.grayImage);
+      }
+      ++nbFrames;
+
+      std::unique_lock<std::mutex> lock(_mutex);
+      _condition.wait(lock, [this]() { return _frames.size() < _maxQueuedFrames || _isCanceled; });
+      if(_isCanceled)
+        break;
+      _frames.push_back(std::move(frame));
+      traceCounter("queuedFeedFrames", static_cast<double>(_frames.size()));
+      _condition.notify_all();
+    }
+    OFXMVG_LOG_DEBUG("feedPrefetcher") << "decoding done"
+      << Common::kv("mediaPath", mediaPath)
+      << Common::kv("nbFrames", nbFrames);
+  }
+  catch(...)
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _exception = std::current_exception();
+  }
+  std::lock_guard<std::mutex> lock(_mutex);
+  _isDone = true;
+  _condition.notify_all();
+}
+
+} //namespace Common
+} //namespace openMVG_ofx
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <opencv2/core/core.hpp>
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace openMVG_ofx {
+namespace Common {
+
+/**
+ * @brief Gray frames of a media file decoded ahead of their use
+ * A folder, an image sequence or a video file is read by an openMVG FeedProvider
+ * on a dedicated thread: it blocks when the queue is full, and so can't take a pool worker.
+ */
+class FeedPrefetcher
+{
+public:
+  /**
+   * @brief Decoded frame
+   */
+  struct Frame
+  {
+    std::size_t index = 0; //frame number in the media
+    cv::Mat grayImage; //CV_8UC1, owned by the frame
+  };
+
+  /**
+   * @brief Start the decoding, throws if the media can't be opened
+   * @param[in] mediaPath - folder, image sequence or video file
+   * @param[in] step - decode one frame every step frames
+   * @param[in] maxFrames - number of decoded frames, 0 for all
+   * @param[in] maxQueuedFrames - number of decoded frames waiting for pop
+   */
+  FeedPrefetcher(const std::string& mediaPath, std::size_t step, std::size_t maxFrames, std::size_t maxQueuedFrames = 8);
+
+  /**
+   * @brief Stop the decoding
+   */
+  ~FeedPrefetcher();
+
+  FeedPrefetcher(const FeedPrefetcher&) = delete;
+  FeedPrefetcher& operator=(const FeedPrefetcher&) = delete;
+
+  /**
+   * @brief Get the next frame, in the media order, blocks until it's decoded
+   * Rethrows the decoding error once the frames decoded before are popped.
+   * @param[out] frame
+   * @return false at the end of the media
+   */
+  bool pop(Frame& frame);
+
+  /**
+   * @brief Stop the decoding, the queued frames are dropped
+   */
+  void cancel();
+
+private:
+  void decodeLoop(const std::string& mediaPath);
+
+  const std::size_t _step;
+  const std::size_t _maxFrames;
+  const std::size_t _maxQueuedFrames;
+  std::deque<Frame> _frames;
+  bool _isDone = false;
+  bool _isCanceled = false;
+  std::exception_ptr _exception;
+  std::mutex _mutex;
+  std::condition_variable _condition;
+  std::thread _thread;
+};
+
+} //namespace Common
+} //namespace openMVG_ofx
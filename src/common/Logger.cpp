@@ -0,0 +1,208 @@
+#include "Logger.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+namespace openMVG_ofx {
+namespace Common {
+
+namespace {
+
+const char* getLevelLabel(ELogLevel level)
+{
+  switch(level)
+  {
+    case eLogLevelTrace : return "trace";
+    case eLogLevelDebug : return "debug";
+    case eLogLevelInfo : return "info";
+    case eLogLevelWarning : return "warning";
+    case eLogLevelError : return "error";
+    default : return "";
+  }
+}
+
+} //namespace
+
+//Definitions of the constants bound to references (std::min)
+const std::size_t Logger::kNbSlots;
+const std::size_t Logger::kMaxMessageSize;
+
+Logger& Logger::instance()
+{
+  static Logger logger;
+  return logger;
+}
+
+ELogLevel Logger::getLevelFromString(const std::string &name, ELogLevel defaultLevel)
+{
+  for(int level = eLogLevelTrace; level < eLogLevelNone; ++level)
+  {
+    if(name == getLevelLabel(static_cast<ELogLevel>(level)))
+      return static_cast<ELogLevel>(level);
+  }
+  if(name == "none")
+    return eLogLevelNone;
+  return defaultLevel;
+}
+
+Logger::Logger()
+  : _level(eLogLevelInfo)
+  , _nbDropped(0)
+  , _running(true)
+  , _enqueuePos(0)
+  , _dequeuePos(0)
+  , _isDrainWaiting(false)
+{
+  for(std::size_t i = 0; i < kNbSlots; ++i)
+    _slots[i].sequence.store(i, std::memory_order_relaxed);
+
+  const char *envLevel = std::getenv("OFXMVG_LOG_LEVEL");
+  if(envLevel)
+    _level.store(getLevelFromString(envLevel, eLogLevelInfo), std::memory_order_relaxed);
+
+  _drainThread = std::thread(&Logger::drainLoop, this);
+}
+
+Logger::~Logger()
+{
+  _running.store(false, std::memory_order_release);
+  {
+    std::lock_guard<std::mutex> guard(_mutex);
+  }
+  _drainCondition.notify_one();
+  if(_drainThread.joinable())
+    _drainThread.join();
+}
+
+void Logger::push(ELogLevel level, const char *tag, const std::string &message)
+{
+  //Bounded MPMC queue from D. Vyukov, used here with a single consumer
+  std::size_t pos = _enqueuePos.load(std::memory_order_relaxed);
+  Slot *slot = nullptr;
+  for(;;)
+  {
+    slot = &_slots[pos & (kNbSlots - 1)];
+    const std::size_t sequence = slot->sequence.load(std::memory_order_acquire);
+    const std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+    if(diff == 0)
+    {
+      if(_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+        break;
+    }
+    else if(diff < 0)
+    {
+      //Ring buffer is full, never block the caller
+      _nbDropped.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    else
+    {
+      pos = _enqueuePos.load(std::memory_order_relaxed);
+    }
+  }
+
+  slot->level = level;
+  slot->tag = tag;
+  slot->size = std::min(message.size(), kMaxMessageSize);
+  std::memcpy(slot->message, message.data(), slot->size);
+  //Sequentially consistent with the wait of drainLoop: either the record or the waiting flag is seen
+  slot->sequence.store(pos + 1, std::memory_order_seq_cst);
+
+  //Wake the drain thread if it sleeps
+  if(_isDrainWaiting.load(std::memory_order_seq_cst))
+  {
+    {
+      std::lock_guard<std::mutex> guard(_mutex);
+    }
+    _drainCondition.notify_one();
+  }
+}
+
+bool Logger::hasRecord() const
+{
+  const std::size_t pos = _dequeuePos.load(std::memory_order_relaxed);
+  return _slots[pos & (kNbSlots - 1)].sequence.load(std::memory_order_seq_cst) == pos + 1;
+}
+
+bool Logger::tryPop(std::string &output)
+{
+  const std::size_t pos = _dequeuePos.load(std::memory_order_relaxed);
+  Slot &slot = _slots[pos & (kNbSlots - 1)];
+  if(slot.sequence.load(std::memory_order_acquire) != pos + 1)
+    return false;
+
+  output += "[ofxMVG][";
+  output += getLevelLabel(slot.level);
+  output += "][";
+  output += slot.tag;
+  output += "] ";
+  output.append(slot.message, slot.size);
+  output += '\n';
+
+  slot.sequence.store(pos + kNbSlots, std::memory_order_release);
+  _dequeuePos.store(pos + 1, std::memory_order_release);
+  return true;
+}
+
+void Logger::drainLoop()
+{
+  std::string batch;
+  std::size_t nbReportedDropped = 0;
+  for(;;)
+  {
+    //Read the flag before draining, to write all the records pushed before the stop
+    const bool running = _running.load(std::memory_order_acquire);
+
+    batch.clear();
+    while(tryPop(batch))
+    {}
+
+    const std::size_t nbDropped = getNbDropped();
+    if(nbDropped != nbReportedDropped)
+    {
+      batch += "[ofxMVG][warning][logger] " + std::to_string(nbDropped - nbReportedDropped) + " records dropped\n";
+      nbReportedDropped = nbDropped;
+    }
+
+    if(!batch.empty())
+    {
+      std::clog.write(batch.data(), batch.size());
+      std::clog.flush();
+      {
+        std::lock_guard<std::mutex> guard(_mutex);
+        _writtenPos = _dequeuePos.load(std::memory_order_relaxed);
+      }
+      _flushCondition.notify_all();
+    }
+    else if(!running)
+    {
+      return;
+    }
+    else
+    {
+      //Sleep until a record is pushed: either push sees the flag, or the wait sees the record
+      std::unique_lock<std::mutex> lock(_mutex);
+      _isDrainWaiting.store(true, std::memory_order_seq_cst);
+      _drainCondition.wait(lock, [this]()
+      {
+        return hasRecord() || !_running.load(std::memory_order_acquire);
+      });
+      _isDrainWaiting.store(false, std::memory_order_relaxed);
+    }
+  }
+}
+
+void Logger::flush()
+{
+  const std::size_t target = _enqueuePos.load(std::memory_order_acquire);
+  std::unique_lock<std::mutex> lock(_mutex);
+  _flushCondition.wait(lock, [this, target]()
+  {
+    return _writtenPos >= target;
+  });
+}
+
+} //namespace Common
+} //namespace openMVG_ofx
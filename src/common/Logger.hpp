@@ -0,0 +1,205 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+
+/**
+ * Minimal level compiled in the plugin.
+ * Logs below this level are removed at compile time.
+ * 0: trace, 1: debug, 2: info, 3: warning, 4: error
+ */
+#ifndef OFXMVG_LOG_COMPILE_LEVEL
+#define OFXMVG_LOG_COMPILE_LEVEL 1
+#endif
+
+namespace openMVG_ofx {
+namespace Common {
+
+enum ELogLevel
+{
+  eLogLevelTrace = 0,
+  eLogLevelDebug,
+  eLogLevelInfo,
+  eLogLevelWarning,
+  eLogLevelError,
+  eLogLevelNone
+};
+
+/**
+ * @brief Process-wide asynchronous logger
+ * Records are pushed in a lock-free bounded ring buffer and written by a background thread.
+ * The background thread sleeps on a condition variable while the buffer is empty,
+ * only the record waking it notifies it: logging doesn't do a syscall on the caller thread otherwise.
+ * The runtime level is read from the OFXMVG_LOG_LEVEL environment variable
+ * (trace, debug, info, warning, error, none), info by default.
+ * If the ring buffer is full, records are dropped and counted.
+ */
+class Logger
+{
+public:
+
+  /**
+   * @brief Get the process-wide logger
+   * @return logger instance
+   */
+  static Logger& instance();
+
+  ~Logger();
+
+  bool isEnabled(ELogLevel level) const
+  {
+    return level >= _level.load(std::memory_order_relaxed);
+  }
+
+  void setLevel(ELogLevel level)
+  {
+    _level.store(level, std::memory_order_relaxed);
+  }
+
+  ELogLevel getLevel() const
+  {
+    return _level.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Push a formatted record in the ring buffer
+   * @param[in] level
+   * @param[in] tag - string literal
+   * @param[in] message
+   */
+  void push(ELogLevel level, const char *tag, const std::string &message);
+
+  /**
+   * @brief Block until all the records pushed before the call are written
+   */
+  void flush();
+
+  /**
+   * @brief Get the number of records dropped because the ring buffer was full
+   * @return dropped records count
+   */
+  std::size_t getNbDropped() const
+  {
+    return _nbDropped.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Parse a level name
+   * @param[in] name - trace, debug, info, warning, error or none
+   * @param[in] defaultLevel - returned if the name is unknown
+   * @return log level
+   */
+  static ELogLevel getLevelFromString(const std::string &name, ELogLevel defaultLevel);
+
+private:
+  static const std::size_t kNbSlots = 4096; //must be a power of 2
+  static const std::size_t kMaxMessageSize = 480;
+
+  struct Slot
+  {
+    std::atomic<std::size_t> sequence;
+    ELogLevel level;
+    const char *tag;
+    std::size_t size;
+    char message[kMaxMessageSize];
+  };
+
+  Logger();
+  Logger(const Logger&) = delete;
+  Logger& operator=(const Logger&) = delete;
+
+  bool hasRecord() const;
+  bool tryPop(std::string &output);
+  void drainLoop();
+
+  std::atomic<ELogLevel> _level;
+  std::atomic<std::size_t> _nbDropped;
+  std::atomic<bool> _running;
+
+  std::array<Slot, kNbSlots> _slots;
+  alignas(64) std::atomic<std::size_t> _enqueuePos;
+  alignas(64) std::atomic<std::size_t> _dequeuePos;
+
+  std::atomic<bool> _isDrainWaiting;
+  std::mutex _mutex; //guards the waits on the conditions and _writtenPos
+  std::condition_variable _drainCondition; //a record is pushed, or the logger stops
+  std::condition_variable _flushCondition; //records are written
+  std::size_t _writtenPos = 0; //number of records written
+
+  std::thread _drainThread;
+};
+
+/**
+ * @brief A log record, pushed to the logger at destruction
+ * Usage: OFXMVG_LOG_DEBUG("render") << "frame computed" << Common::kv("time", args.time);
+ */
+class LogRecord
+{
+public:
+  LogRecord(ELogLevel level, const char *tag)
+    : _level(level)
+    , _tag(tag)
+  {}
+
+  ~LogRecord()
+  {
+    Logger::instance().push(_level, _tag, _stream.str());
+  }
+
+  template<typename T>
+  LogRecord& operator<<(const T &value)
+  {
+    _stream << value;
+    return *this;
+  }
+
+private:
+  ELogLevel _level;
+  const char *_tag;
+  std::ostringstream _stream;
+};
+
+/**
+ * @brief Structured key/value field of a log record, printed as " key=value"
+ */
+template<typename T>
+struct LogField
+{
+  const char *key;
+  const T &value;
+};
+
+template<typename T>
+LogField<T> kv(const char *key, const T &value)
+{
+  return LogField<T>{key, value};
+}
+
+template<typename T>
+std::ostream& operator<<(std::ostream &os, const LogField<T> &field)
+{
+  return os << " " << field.key << "=" << field.value;
+}
+
+} //namespace Common
+} //namespace openMVG_ofx
+
+/**
+ * The record (and its arguments) is only evaluated if the level is enabled,
+ * at compile time and at runtime.
+ */
+#define OFXMVG_LOG(level, tag) \
+  if(((level) < OFXMVG_LOG_COMPILE_LEVEL) || !openMVG_ofx::Common::Logger::instance().isEnabled(level)) {} \
+  else openMVG_ofx::Common::LogRecord(level, tag)
+
+#define OFXMVG_LOG_TRACE(tag) OFXMVG_LOG(openMVG_ofx::Common::eLogLevelTrace, tag)
+#define OFXMVG_LOG_DEBUG(tag) OFXMVG_LOG(openMVG_ofx::Common::eLogLevelDebug, tag)
+#define OFXMVG_LOG_INFO(tag) OFXMVG_LOG(openMVG_ofx::Common::eLogLevelInfo, tag)
+#define OFXMVG_LOG_WARNING(tag) OFXMVG_LOG(openMVG_ofx::Common::eLogLevelWarning, tag)
+#define OFXMVG_LOG_ERROR(tag) OFXMVG_LOG(openMVG_ofx::Common::eLogLevelError, tag)
@@ -0,0 +1,121 @@
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+
+namespace openMVG_ofx {
+namespace Common {
+
+ThreadPool& ThreadPool::instance()
+{
+  static ThreadPool pool;
+  return pool;
+}
+
+ThreadPool::ThreadPool(std::size_t nbThreads)
+{
+  if(nbThreads == 0)
+    nbThreads = std::max(1u, std::thread::hardware_concurrency());
+  for(std::size_t i = 0; i < nbThreads; ++i)
+    _workers.emplace_back(&ThreadPool::workerLoop, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stop = true;
+    _tasks.clear();
+  }
+  _condition.notify_all();
+  for(std::thread &worker : _workers)
+    worker.join();
+}
+
+std::future<void> ThreadPool::submit(std::function<void()> task)
+{
+  std::packaged_task<void()> packagedTask(std::move(task));
+  std::future<void> future = packagedTask.get_future();
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _tasks.push_back(std::move(packagedTask));
+  }
+  _condition.notify_one();
+  return future;
+}
+
+void ThreadPool::parallelFor(std::size_t begin, std::size_t end, const std::function<void(std::size_t)> &function)
+{
+  if(begin >= end)
+    return;
+
+  //Indices are dispatched dynamically to the calling thread and to the workers.
+  //The state outlives the call: a worker may start after all indices are done.
+  struct State
+  {
+    std::function<void(std::size_t)> function;
+    std::atomic<std::size_t> next;
+    std::size_t end;
+    std::size_t nbDone = 0;
+    std::exception_ptr exception;
+    std::mutex mutex;
+    std::condition_variable condition;
+  };
+  std::shared_ptr<State> state = std::make_shared<State>();
+  state->function = function;
+  state->next = begin;
+  state->end = end;
+
+  auto run = [state]()
+  {
+    for(std::size_t index = state->next++; index < state->end; index = state->next++)
+    {
+      std::exception_ptr exception;
+      try
+      {
+        state->function(index);
+      }
+      catch(...)
+      {
+        exception = std::current_exception();
+      }
+      std::lock_guard<std::mutex> lock(state->mutex);
+      if(exception && !state->exception)
+        state->exception = exception;
+      ++state->nbDone;
+      state->condition.notify_all();
+    }
+  };
+
+  const std::size_t nbTasks = std::min(_workers.size(), end - begin - 1);
+  for(std::size_t i = 0; i < nbTasks; ++i)
+    submit(run);
+  run();
+
+  std::unique_lock<std::mutex> lock(state->mutex);
+  state->condition.wait(lock, [&]() { return state->nbDone == end - begin; });
+  if(state->exception)
+    std::rethrow_exception(state->exception);
+}
+
+void ThreadPool::workerLoop()
+{
+  for(;;)
+  {
+    std::packaged_task<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _condition.wait(lock, [this]() { return _stop || !_tasks.empty(); });
+      if(_stop)
+        return;
+      task = std::move(_tasks.front());
+      _tasks.pop_front();
+    }
+    task();
+  }
+}
+
+} //namespace Common
+} //namespace openMVG_ofx
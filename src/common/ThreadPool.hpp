@@ -0,0 +1,73 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace openMVG_ofx {
+namespace Common {
+
+/**
+ * @brief Fixed size pool of worker threads
+ * Tasks are run in submission order, by the first available worker.
+ * Tasks must not call the OFX suites: OFX objects are only used from host threads.
+ */
+class ThreadPool
+{
+public:
+
+  /**
+   * @brief Get the process-wide pool, one worker per hardware thread
+   * @return pool instance
+   */
+  static ThreadPool& instance();
+
+  /**
+   * @param[in] nbThreads - number of workers, 0 for one per hardware thread
+   */
+  explicit ThreadPool(std::size_t nbThreads = 0);
+
+  /**
+   * @brief Wait for the running tasks, the queued ones are dropped
+   */
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  std::size_t getNbThreads() const { return _workers.size(); }
+
+  /**
+   * @brief Queue a task
+   * @param[in] task
+   * @return future of the task, rethrows the task exception
+   */
+  std::future<void> submit(std::function<void()> task);
+
+  /**
+   * @brief Run a function on each index of a range and wait for all of them
+   * The calling thread takes part, it may be a pool worker: the call completes
+   * even if no other worker is available. Rethrows the first function exception.
+   * @param[in] begin
+   * @param[in] end
+   * @param[in] function - called with the index
+   */
+  void parallelFor(std::size_t begin, std::size_t end, const std::function<void(std::size_t)> &function);
+
+private:
+  void workerLoop();
+
+  std::vector<std::thread> _workers;
+  std::deque< std::packaged_task<void()> > _tasks;
+  std::mutex _mutex;
+  std::condition_variable _condition;
+  bool _stop = false;
+};
+
+} //namespace Common
+} //namespace openMVG_ofx
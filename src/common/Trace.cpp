@@ -0,0 +1,180 @@
+#include "Trace.hpp"
+#include "Logger.hpp"
+
+#include <cstdlib>
+#include <fstream>
+
+#ifdef _WIN32
+#include <process.h>
+#define ofxMVGGetPid _getpid
+#else
+#include <unistd.h>
+#define ofxMVGGetPid getpid
+#endif
+
+namespace openMVG_ofx {
+namespace Common {
+
+namespace {
+
+void writeJsonString(std::ostream &os, const char *str)
+{
+  os << '"';
+  for(const char *c = str; c != nullptr && *c != '\0'; ++c)
+  {
+    if(*c == '"' || *c == '\\')
+      os << '\\';
+    os << *c;
+  }
+  os << '"';
+}
+
+} //namespace
+
+Tracer& Tracer::instance()
+{
+  static Tracer tracer;
+  return tracer;
+}
+
+Tracer::Tracer()
+  : _enabled(false)
+  , _epoch(std::chrono::steady_clock::now())
+{
+  //The logger is created first to be destroyed after the last flush
+  Logger::instance();
+
+  const char *envFolder = std::getenv("OFXMVG_TRACE_FOLDER");
+  if(envFolder && *envFolder != '\0')
+  {
+    enable(envFolder);
+    _isEnabledByEnvironment = true;
+  }
+}
+
+Tracer::~Tracer()
+{
+  disable();
+}
+
+void Tracer::enable(const std::string &folder)
+{
+  std::lock_guard<std::mutex> guard(_mutex);
+  for(auto &threadBuffer : _threadBuffers)
+  {
+    std::lock_guard<std::mutex> bufferGuard(threadBuffer->mutex);
+    threadBuffer->events.clear();
+  }
+  _folder = folder;
+  _filePath = folder + "/ofxMVG_trace_" + std::to_string(ofxMVGGetPid()) + ".json";
+  _enabled.store(true, std::memory_order_relaxed);
+}
+
+void Tracer::disable()
+{
+  if(!isEnabled())
+    return;
+  flush();
+  _enabled.store(false, std::memory_order_relaxed);
+}
+
+std::string Tracer::getFolder() const
+{
+  std::lock_guard<std::mutex> guard(_mutex);
+  return _folder;
+}
+
+Tracer::ThreadBuffer& Tracer::getThreadBuffer()
+{
+  thread_local ThreadBuffer *threadBuffer = nullptr;
+  if(threadBuffer == nullptr)
+  {
+    std::shared_ptr<ThreadBuffer> newBuffer = std::make_shared<ThreadBuffer>();
+    std::lock_guard<std::mutex> guard(_mutex);
+    newBuffer->threadId = _threadBuffers.size() + 1;
+    _threadBuffers.push_back(newBuffer);
+    threadBuffer = newBuffer.get(); //owned by the tracer
+  }
+  return *threadBuffer;
+}
+
+void Tracer::addEvent(const TraceEvent &event)
+{
+  ThreadBuffer &threadBuffer = getThreadBuffer();
+  std::lock_guard<std::mutex> guard(threadBuffer.mutex);
+  if(threadBuffer.events.size() < kMaxEventsPerThread)
+    threadBuffer.events.push_back(event);
+}
+
+void Tracer::addSpan(const char *name, const char *category, std::int64_t start, std::int64_t duration)
+{
+  TraceEvent event;
+  event.name = name;
+  event.category = category;
+  event.phase = 'X';
+  event.timestamp = start;
+  event.duration = duration;
+  addEvent(event);
+}
+
+void Tracer::addCounter(const char *name, double value)
+{
+  TraceEvent event;
+  event.name = name;
+  event.category = "counter";
+  event.phase = 'C';
+  event.timestamp = now();
+  event.value = value;
+  addEvent(event);
+}
+
+void Tracer::flush()
+{
+  std::lock_guard<std::mutex> guard(_mutex);
+  if(_filePath.empty())
+    return;
+
+  std::ofstream file(_filePath);
+  if(!file.is_open())
+  {
+    OFXMVG_LOG_ERROR("trace") << "can't write trace file" << kv("path", _filePath);
+    return;
+  }
+
+  const int pid = ofxMVGGetPid();
+  bool first = true;
+
+  file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  for(auto &threadBuffer : _threadBuffers)
+  {
+    std::lock_guard<std::mutex> bufferGuard(threadBuffer->mutex);
+
+    //Thread name metadata
+    file << (first ? "\n" : ",\n");
+    first = false;
+    file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid
+         << ",\"tid\":" << threadBuffer->threadId
+         << ",\"args\":{\"name\":\"thread " << threadBuffer->threadId << "\"}}";
+
+    for(const TraceEvent &event : threadBuffer->events)
+    {
+      file << ",\n{\"name\":";
+      writeJsonString(file, event.name);
+      file << ",\"cat\":";
+      writeJsonString(file, event.category);
+      file << ",\"ph\":\"" << event.phase << "\""
+           << ",\"ts\":" << event.timestamp
+           << ",\"pid\":" << pid
+           << ",\"tid\":" << threadBuffer->threadId;
+      if(event.phase == 'X')
+        file << ",\"dur\":" << event.duration;
+      else
+        file << ",\"args\":{\"value\":" << event.value << "}";
+      file << "}";
+    }
+  }
+  file << "\n]}\n";
+}
+
+} //namespace Common
+} //namespace openMVG_ofx
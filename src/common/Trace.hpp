@@ -0,0 +1,185 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace openMVG_ofx {
+namespace Common {
+
+/**
+ * @brief Trace event, following the Chrome trace-event format
+ * @see https://docs.google.com/document/d/1CvAClvFfyA5R-PhYUmn5OOQtYMH4h6I0nSsKchNAySU
+ */
+struct TraceEvent
+{
+  const char *name = nullptr; //must be a string literal
+  const char *category = nullptr; //must be a string literal
+  char phase = 'X'; //'X' complete span, 'C' counter
+  std::int64_t timestamp = 0; //[us]
+  std::int64_t duration = 0; //[us]
+  double value = 0.0; //counter value
+};
+
+/**
+ * @brief Process-wide trace-event recorder
+ * Events are buffered per thread and written as a JSON file
+ * readable by chrome://tracing or https://ui.perfetto.dev
+ * When disabled, recording an event is a single relaxed atomic load.
+ * Set the OFXMVG_TRACE_FOLDER environment variable to trace all the plugins of the process,
+ * the trace is then written at each flush and at the process exit.
+ */
+class Tracer
+{
+public:
+
+  /**
+   * @brief Get the process-wide tracer
+   * @return tracer instance
+   */
+  static Tracer& instance();
+
+  ~Tracer();
+
+  /**
+   * @brief Start recording events, previous events are dropped
+   * @param[in] folder - output folder of the trace file
+   */
+  void enable(const std::string &folder);
+
+  /**
+   * @brief Write the recorded events and stop recording
+   */
+  void disable();
+
+  /**
+   * @brief Write all the recorded events in the trace file
+   * The file is rewritten at each call.
+   */
+  void flush();
+
+  /**
+   * @return true if the tracing was enabled by the OFXMVG_TRACE_FOLDER environment variable
+   */
+  bool isEnabledByEnvironment() const
+  {
+    return _isEnabledByEnvironment;
+  }
+
+  bool isEnabled() const
+  {
+    return _enabled.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Get the current time in the trace clock
+   * @return microseconds since the tracer creation
+   */
+  std::int64_t now() const
+  {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - _epoch).count();
+  }
+
+  /**
+   * @brief Record a complete span on the calling thread
+   * @param[in] name - string literal
+   * @param[in] category - string literal
+   * @param[in] start - span begin [us]
+   * @param[in] duration - span duration [us]
+   */
+  void addSpan(const char *name, const char *category, std::int64_t start, std::int64_t duration);
+
+  /**
+   * @brief Record a counter value on the calling thread
+   * @param[in] name - string literal
+   * @param[in] value
+   */
+  void addCounter(const char *name, double value);
+
+  /**
+   * @brief Get the output trace folder
+   * @return empty if never enabled
+   */
+  std::string getFolder() const;
+
+private:
+  struct ThreadBuffer
+  {
+    std::mutex mutex; //only contended during a flush
+    std::vector<TraceEvent> events;
+    std::size_t threadId = 0;
+  };
+
+  Tracer();
+
+  ThreadBuffer& getThreadBuffer();
+  void addEvent(const TraceEvent &event);
+
+  //Maximum number of events per thread, to bound memory on long sessions
+  static const std::size_t kMaxEventsPerThread = 1 << 20;
+
+  std::atomic<bool> _enabled;
+  bool _isEnabledByEnvironment = false;
+  const std::chrono::steady_clock::time_point _epoch;
+
+  mutable std::mutex _mutex;
+  std::string _folder;
+  std::string _filePath;
+  std::vector< std::shared_ptr<ThreadBuffer> > _threadBuffers;
+};
+
+/**
+ * @brief RAII span recorder
+ */
+class TraceScope
+{
+public:
+  TraceScope(const char *name, const char *category = "ofxMVG")
+    : _name(name)
+    , _category(category)
+    , _start(Tracer::instance().isEnabled() ? Tracer::instance().now() : -1)
+  {}
+
+  ~TraceScope()
+  {
+    if(_start >= 0)
+    {
+      Tracer &tracer = Tracer::instance();
+      tracer.addSpan(_name, _category, _start, tracer.now() - _start);
+    }
+  }
+
+  TraceScope(const TraceScope&) = delete;
+  TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+  const char *_name;
+  const char *_category;
+  const std::int64_t _start;
+};
+
+/**
+ * @brief Record a counter value if the tracer is enabled
+ * @param[in] name - string literal
+ * @param[in] value
+ */
+inline void traceCounter(const char *name, double value)
+{
+  Tracer &tracer = Tracer::instance();
+  if(tracer.isEnabled())
+    tracer.addCounter(name, value);
+}
+
+} //namespace Common
+} //namespace openMVG_ofx
+
+#define OFXMVG_TRACE_CONCAT_IMPL(a, b) a##b
+#define OFXMVG_TRACE_CONCAT(a, b) OFXMVG_TRACE_CONCAT_IMPL(a, b)
+
+//Record a span from this line to the end of the enclosing scope
+#define OFXMVG_TRACE_SCOPE(name) \
+  openMVG_ofx::Common::TraceScope OFXMVG_TRACE_CONCAT(ofxMVGTraceScope, __LINE__)(name)
@@ -0,0 +1,338 @@
+#include "CeresCalibration.hpp"
+
+#ifdef HAVE_CERES
+
+#include "../common/Trace.hpp"
+#include "../common/Logger.hpp"
+
+#include <ceres/ceres.h>
+
+#include <opencv2/calib3d/calib3d.hpp>
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <memory>
+
+namespace openMVG_ofx {
+namespace LensCalibration {
+
+namespace {
+
+const double kRobustLossScale = 1.0; //pixels, the pattern points are detected with a sub-pixel accuracy
+
+Eigen::Matrix3d skew(const Eigen::Vector3d& v)
+{
+  Eigen::Matrix3d m;
+  m <<    0.0, -v.z(),  v.y(),
+        v.z(),    0.0, -v.x(),
+       -v.y(),  v.x(),    0.0;
+  return m;
+}
+
+/**
+ * @brief Rotation matrix of an angle-axis vector
+ */
+Eigen::Matrix3d getRotation(const Eigen::Vector3d& v)
+{
+  const double theta = v.norm();
+  if(theta < 1e-8)
+    return Eigen::Matrix3d::Identity() + skew(v);
+  return Eigen::AngleAxisd(theta, v / theta).toRotationMatrix();
+}
+
+/**
+ * @brief Derivative of a rotated point R(v) p by the angle-axis vector v
+ * Gallego and Yezzi, "A compact formula for the derivative of a 3-D rotation in exponential coordinates".
+ * @param[in] v - angle-axis vector
+ * @param[in] R - rotation of v
+ * @param[in] Rp - rotated point
+ * @return 3x3 jacobian
+ */
+Eigen::Matrix3d getRotatedPointJacobian(const Eigen::Vector3d& v, const Eigen::Matrix3d& R, const Eigen::Vector3d& Rp)
+{
+  const double theta2 = v.squaredNorm();
+  if(theta2 < 1e-16)
+    return -skew(Rp);
+
+  const Eigen::Matrix3d IminusR = Eigen::Matrix3d::Identity() - R;
+  Eigen::Matrix3d J;
+  for(int i = 0; i < 3; ++i)
+    J.col(i) = (v(i) * v.cross(Rp) + v.cross(IminusR.col(i)).cross(Rp)) / theta2;
+  return J;
+}
+
+/**
+ * @brief Reprojection residual of a pattern point, OpenCV K3 radial and tangential model
+ * Parameter blocks: intrinsics (fx fy cx cy), k1, k2, k3, tangential (p1 p2), pose (angle-axis, translation).
+ * The radial coefficients are separate blocks so that the unused ones can be held constant.
+ */
+class ReprojectionCost : public ceres::SizedCostFunction<2, 4, 1, 1, 1, 2, 6>
+{
+public:
+  ReprojectionCost(const cv::Point3f& objectPoint, const cv::Point2f& imagePoint)
+    : _objectPoint(objectPoint.x, objectPoint.y, objectPoint.z)
+    , _imagePoint(imagePoint.x, imagePoint.y)
+  {}
+
+  bool Evaluate(double const* const* parameters, double* residuals, double** jacobians) const override
+  {
+    const double* intrinsics = parameters[0];
+    const double k1 = parameters[1][0];
+    const double k2 = parameters[2][0];
+    const double k3 = parameters[3][0];
+    const double p1 = parameters[4][0];
+    const double p2 = parameters[4][1];
+    const Eigen::Map<const Eigen::Vector3d> rotation(parameters[5]);
+    const Eigen::Map<const Eigen::Vector3d> translation(parameters[5] + 3);
+
+    const Eigen::Matrix3d R = getRotation(rotation);
+    const Eigen::Vector3d Rp = R * _objectPoint;
+    const Eigen::Vector3d Xc = Rp + translation;
+    //A step moving the pattern behind the camera is rejected
+    if(Xc.z() <= 0.0)
+      return false;
+
+    const double iz = 1.0 / Xc.z();
+    const double x = Xc.x() * iz;
+    const double y = Xc.y() * iz;
+    const double r2 = x * x + y * y;
+    const double r4 = r2 * r2;
+    const double r6 = r4 * r2;
+    const double radial = 1.0 + k1 * r2 + k2 * r4 + k3 * r6;
+    const double xd = x * radial + 2.0 * p1 * x * y + p2 * (r2 + 2.0 * x * x);
+    const double yd = y * radial + p1 * (r2 + 2.0 * y * y) + 2.0 * p2 * x * y;
+    const double fx = intrinsics[0];
+    const double fy = intrinsics[1];
+
+    residuals[0] = fx * xd + intrinsics[2] - _imagePoint.x();
+    residuals[1] = fy * yd + intrinsics[3] - _imagePoint.y();
+    if(jacobians == nullptr)
+      return true;
+
+    //Jacobians are row-major, one row per residual
+    if(jacobians[0])
+    {
+      double* J = jacobians[0];
+      J[0] = xd;  J[1] = 0.0; J[2] = 1.0; J[3] = 0.0;
+      J[4] = 0.0; J[5] = yd;  J[6] = 0.0; J[7] = 1.0;
+    }
+    if(jacobians[1])
+    {
+      jacobians[1][0] = fx * x * r2;
+      jacobians[1][1] = fy * y * r2;
+    }
+    if(jacobians[2])
+    {
+      jacobians[2][0] = fx * x * r4;
+      jacobians[2][1] = fy * y * r4;
+    }
+    if(jacobians[3])
+    {
+      jacobians[3][0] = fx * x * r6;
+      jacobians[3][1] = fy * y * r6;
+    }
+    if(jacobians[4])
+    {
+      double* J = jacobians[4];
+      J[0] = fx * 2.0 * x * y;        J[1] = fx * (r2 + 2.0 * x * x);
+      J[2] = fy * (r2 + 2.0 * y * y); J[3] = fy * 2.0 * x * y;
+    }
+    if(jacobians[5])
+    {
+      //Chain: pixel <- distorted <- normalized <- camera point <- pose
+      const double dRadial = k1 + 2.0 * k2 * r2 + 3.0 * k3 * r4;
+      Eigen::Matrix2d dDistorted;
+      dDistorted << radial + 2.0 * x * x * dRadial + 2.0 * p1 * y + 6.0 * p2 * x,
+                    2.0 * x * y * dRadial + 2.0 * p1 * x + 2.0 * p2 * y,
+                    2.0 * x * y * dRadial + 2.0 * p1 * x + 2.0 * p2 * y,
+                    radial + 2.0 * y * y * dRadial + 6.0 * p1 * y + 2.0 * p2 * x;
+      dDistorted.row(0) *= fx;
+      dDistorted.row(1) *= fy;
+      Eigen::Matrix<double, 2, 3> dNormalized;
+      dNormalized << iz, 0.0, -x * iz,
+                     0.0, iz, -y * iz;
+      const Eigen::Matrix<double, 2, 3> dCamera = dDistorted * dNormalized;
+
+      Eigen::Map<Eigen::Matrix<double, 2, 6, Eigen::RowMajor> > J(jacobians[5]);
+      J.leftCols<3>() = dCamera * getRotatedPointJacobian(rotation, R, Rp);
+      J.rightCols<3>() = dCamera;
+    }
+    return true;
+  }
+
+private:
+  const Eigen::Vector3d _objectPoint;
+  const Eigen::Vector2d _imagePoint;
+};
+
+/**
+ * @brief Report the solver iterations to the calibration callback
+ */
+class ProgressCallback : public ceres::IterationCallback
+{
+public:
+  ProgressCallback(std::size_t start, std::size_t nbFrames, std::size_t nbPoints, const CalibrationCallback& callback)
+    : _nbPoints(nbPoints)
+    , _callback(callback)
+  {
+    _progress.start = start;
+    _progress.nbFrames = nbFrames;
+  }
+
+  ceres::CallbackReturnType operator()(const ceres::IterationSummary& summary) override
+  {
+    //Error of the robustified cost, close to the reprojection error without outliers
+    _progress.iteration = summary.iteration;
+    _progress.totalAvgErr = std::sqrt(2.0 * summary.cost / std::max<std::size_t>(_nbPoints, 1));
+    Common::traceCounter("calibrationError", _progress.totalAvgErr);
+    if(_callback && !_callback(_progress))
+      return ceres::SOLVER_ABORT;
+    return ceres::SOLVER_CONTINUE;
+  }
+
+private:
+  const std::size_t _nbPoints;
+  const CalibrationCallback& _callback;
+  CalibrationProgress _progress;
+};
+
+} //namespace
+
+bool calibrateCeres(const CalibrationSettings& settings,
+                    std::size_t nbThreads,
+                    std::size_t start,
+                    const std::vector<std::vector<cv::Point2f> >& imagePoints,
+                    const std::vector<std::vector<cv::Point3f> >& objectPoints,
+                    const std::vector<std::size_t>& inputFrames,
+                    CalibrationResult& result,
+                    const CalibrationCallback& callback)
+{
+  OFXMVG_TRACE_SCOPE("lensCalibration.calibrateCeres");
+  result.isCalibrated = false;
+  result.totalAvgErr = 0.0;
+  result.holdOutErr = 0.0;
+  result.calibInputFrames = inputFrames;
+  result.rejectInputFrames.clear();
+  if(imagePoints.empty())
+    return false;
+
+  //Initial intrinsics: the warm start, or a closed-form estimate from the pattern homographies
+  cv::Mat cameraMatrix;
+  cv::Mat distCoeffs = cv::Mat::zeros(5, 1, CV_64F);
+  if(!settings.initialCameraMatrix.empty())
+  {
+    settings.initialCameraMatrix.convertTo(cameraMatrix, CV_64F);
+    cv::Mat initialDistCoeffs;
+    settings.initialDistCoeffs.convertTo(initialDistCoeffs, CV_64F);
+    for(int i = 0; i < std::min<int>(5, initialDistCoeffs.total()); ++i)
+      distCoeffs.at<double>(i) = initialDistCoeffs.at<double>(i);
+  }
+  else
+    cameraMatrix = cv::initCameraMatrix2D(objectPoints, imagePoints, settings.imageSize, 1.0);
+
+  double intrinsics[4] = {cameraMatrix.at<double>(0, 0), cameraMatrix.at<double>(1, 1),
+                          cameraMatrix.at<double>(0, 2), cameraMatrix.at<double>(1, 2)};
+  double radialCoefs[3] = {distCoeffs.at<double>(0), distCoeffs.at<double>(1), distCoeffs.at<double>(4)};
+  //The calibration settings of the plugin keep a zero tangential distortion
+  double tangentialCoefs[2] = {0.0, 0.0};
+
+  //Initial poses of the views from the initial intrinsics
+  std::vector<std::array<double, 6> > poses(imagePoints.size());
+  for(std::size_t i = 0; i < imagePoints.size(); ++i)
+  {
+    cv::Mat rvec;
+    cv::Mat tvec;
+    cv::solvePnP(objectPoints[i], imagePoints[i], cameraMatrix, distCoeffs, rvec, tvec);
+    for(int j = 0; j < 3; ++j)
+    {
+      poses[i][j] = rvec.at<double>(j);
+      poses[i][3 + j] = tvec.at<double>(j);
+    }
+  }
+
+  ceres::Problem problem;
+  std::size_t nbPoints = 0;
+  for(std::size_t i = 0; i < imagePoints.size(); ++i)
+  {
+    for(std::size_t j = 0; j < imagePoints[i].size(); ++j)
+    {
+      problem.AddResidualBlock(new ReprojectionCost(objectPoints[i][j], imagePoints[i][j]),
+                               new ceres::CauchyLoss(kRobustLossScale),
+                               intrinsics, &radialCoefs[0], &radialCoefs[1], &radialCoefs[2], tangentialCoefs, poses[i].data());
+    }
+    nbPoints += imagePoints[i].size();
+  }
+  for(int i = std::max(0, settings.nbRadialCoef); i < 3; ++i)
+  {
+    radialCoefs[i] = 0.0;
+    problem.SetParameterBlockConstant(&radialCoefs[i]);
+  }
+  problem.SetParameterBlockConstant(tangentialCoefs);
+
+  //The poses are eliminated first, the reduced system only holds the lens parameters
+  ceres::ParameterBlockOrdering *ordering = new ceres::ParameterBlockOrdering();
+  for(std::array<double, 6>& pose : poses)
+    ordering->AddElementToGroup(pose.data(), 0);
+  ordering->AddElementToGroup(intrinsics, 1);
+  for(double& radialCoef : radialCoefs)
+    ordering->AddElementToGroup(&radialCoef, 1);
+  ordering->AddElementToGroup(tangentialCoefs, 1);
+
+  ceres::Solver::Options options;
+  options.linear_solver_type = ceres::SPARSE_SCHUR;
+  std::string error;
+  if(!options.IsValid(&error))
+    options.linear_solver_type = ceres::DENSE_SCHUR;
+  options.linear_solver_ordering.reset(ordering);
+  options.num_threads = static_cast<int>(std::max<std::size_t>(1, nbThreads));
+  options.max_num_iterations = 100;
+  options.logging_type = ceres::SILENT;
+  ProgressCallback progressCallback(start, imagePoints.size(), nbPoints, callback);
+  options.callbacks.push_back(&progressCallback);
+
+  ceres::Solver::Summary summary;
+  ceres::Solve(options, &problem, &summary);
+  OFXMVG_LOG_DEBUG("calibrateCeres") << "solved"
+    << Common::kv("start", start)
+    << Common::kv("iterations", summary.iterations.size())
+    << Common::kv("initialCost", summary.initial_cost)
+    << Common::kv("finalCost", summary.final_cost)
+    << Common::kv("linearSolver", ceres::LinearSolverTypeToString(summary.linear_solver_type_used))
+    << Common::kv("totalMs", summary.total_time_in_seconds * 1000.0);
+  if(summary.termination_type == ceres::USER_FAILURE || !summary.IsSolutionUsable())
+    return false;
+
+  result.cameraMatrix = (cv::Mat_<double>(3, 3) << intrinsics[0], 0.0, intrinsics[2],
+                                                   0.0, intrinsics[1], intrinsics[3],
+                                                   0.0, 0.0, 1.0);
+  //Same layout as calibrateCamera: k1 k2 p1 p2 k3 k4 k5 k6
+  result.distCoeffs = cv::Mat::zeros(8, 1, CV_64F);
+  result.distCoeffs.at<double>(0) = radialCoefs[0];
+  result.distCoeffs.at<double>(1) = radialCoefs[1];
+  result.distCoeffs.at<double>(2) = tangentialCoefs[0];
+  result.distCoeffs.at<double>(3) = tangentialCoefs[1];
+  result.distCoeffs.at<double>(4) = radialCoefs[2];
+
+  //Reprojection error of all the points, without the robust loss
+  double totalSquaredErr = 0.0;
+  for(std::size_t i = 0; i < imagePoints.size(); ++i)
+  {
+    const cv::Mat rvec(3, 1, CV_64F, poses[i].data());
+    const cv::Mat tvec(3, 1, CV_64F, poses[i].data() + 3);
+    std::vector<cv::Point2f> projectedPoints;
+    cv::projectPoints(objectPoints[i], rvec, tvec, result.cameraMatrix, result.distCoeffs, projectedPoints);
+    totalSquaredErr += std::pow(cv::norm(imagePoints[i], projectedPoints, cv::NORM_L2), 2);
+  }
+  result.totalAvgErr = std::sqrt(totalSquaredErr / std::max<std::size_t>(nbPoints, 1));
+  result.isCalibrated = cv::checkRange(result.cameraMatrix) && cv::checkRange(result.distCoeffs);
+  return result.isCalibrated;
+}
+
+} //namespace LensCalibration
+} //namespace openMVG_ofx
+
+#endif //HAVE_CERES
@@ -0,0 +1,45 @@
+#pragma once
+
+#ifdef HAVE_CERES
+
+#include "LensCalibration.hpp"
+
+#include <opencv2/core/core.hpp>
+
+#include <vector>
+
+namespace openMVG_ofx {
+namespace LensCalibration {
+
+/**
+ * @brief Calibrate the lens as a Ceres problem
+ * The intrinsics, the K3 radial coefficients and the view poses are refined together,
+ * with analytic derivatives. The tangential coefficients of the model are kept at zero,
+ * as with the OpenCV calibration. A robust loss reduces the weight of
+ * the badly detected points instead of rejecting frames. The poses are eliminated
+ * by a multithreaded Schur complement solve.
+ * Starts from the settings initial guess, or from a closed-form estimate.
+ * Doesn't use the OFX suites, it can run on a worker thread.
+ * @param[in] settings
+ * @param[in] nbThreads - threads of the solver
+ * @param[in] start - multi-start index, reported in the progress
+ * @param[in] imagePoints - pattern points per frame
+ * @param[in] objectPoints - pattern model points per frame
+ * @param[in] inputFrames - frame of each view
+ * @param[out] result
+ * @param[in] callback - progress callback, may cancel the calibration
+ * @return true if the calibration succeed, false if it fails or is canceled
+ */
+bool calibrateCeres(const CalibrationSettings& settings,
+                    std::size_t nbThreads,
+                    std::size_t start,
+                    const std::vector<std::vector<cv::Point2f> >& imagePoints,
+                    const std::vector<std::vector<cv::Point3f> >& objectPoints,
+                    const std::vector<std::size_t>& inputFrames,
+                    CalibrationResult& result,
+                    const CalibrationCallback& callback);
+
+} //namespace LensCalibration
+} //namespace openMVG_ofx
+
+#endif //HAVE_CERES
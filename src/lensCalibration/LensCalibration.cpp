@@ -1,12 +1,65 @@
 #include "LensCalibration.hpp"
+#include "CeresCalibration.hpp"
+
+#include "../common/Trace.hpp"
+#include "../common/Logger.hpp"
+#include "../common/ThreadPool.hpp"
 
 #include <openMVG/image/image_converter.hpp>
+#include <openMVG/calibration/calibration.hpp>
 
 #include <opencv2/opencv.hpp>
 
+#include <cereal/archives/portable_binary.hpp>
+#include <cereal/external/base64.hpp>
+#include <cereal/types/map.hpp>
+#include <cereal/types/tuple.hpp>
+#include <cereal/types/utility.hpp>
+#include <cereal/types/vector.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bitset>
+#include <cfloat>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <numeric>
+#include <queue>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+
 namespace openMVG_ofx {
 namespace LensCalibration {
 
+std::size_t getMaxNbExtraInputs()
+{
+  static const std::size_t maxNbExtraInputs = []()
+  {
+    std::size_t nbExtraInputs = OFXMVG_LENSCALIBRATION_MAX_EXTRA_INPUTS;
+    const char *envNbExtraInputs = std::getenv("OFXMVG_LENSCALIBRATION_MAX_EXTRA_INPUTS");
+    if(envNbExtraInputs)
+    {
+      char *end = nullptr;
+      const long value = std::strtol(envNbExtraInputs, &end, 10);
+      if(end != envNbExtraInputs && *end == '\0' && value >= 0 && value <= 63)
+      {
+        nbExtraInputs = static_cast<std::size_t>(value);
+      }
+      else
+      {
+        OFXMVG_LOG_WARNING("getMaxNbExtraInputs") << "invalid OFXMVG_LENSCALIBRATION_MAX_EXTRA_INPUTS, the default is used"
+          << Common::kv("value", envNbExtraInputs)
+          << Common::kv("default", nbExtraInputs);
+      }
+    }
+    return nbExtraInputs;
+  }();
+  return maxNbExtraInputs;
+}
 
 void convertRGBImage(const Common::Image<float>& inputImageOFX, openMVG::image::Image<openMVG::image::RGBfColor>& outputImageMVG)
 {
@@ -84,6 +137,1006 @@ openMVG::calibration::Pattern getPatternType(EParamPatternType pattern)
   }
 }
 
+namespace {
+
+/**
+ * @brief Smallest distance between two neighbour points of the same grid row
+ */
+float getMinPointSpacing(const std::vector<cv::Point2f>& points, const cv::Size& boardSize)
+{
+  float minSpacing = std::numeric_limits<float>::max();
+  for(std::size_t i = 0; i + 1 < points.size(); ++i)
+  {
+    if((i + 1) % boardSize.width == 0)
+      continue;
+    minSpacing = std::min(minSpacing, static_cast<float>(cv::norm(points[i + 1] - points[i])));
+  }
+  return minSpacing;
+}
+
+/**
+ * @brief Refine dark circle centers as the darkness-weighted centroid of a local window
+ */
+void refineCircleCenters(const cv::Mat& grayImage, float radius, float maxShift, std::vector<cv::Point2f>& points)
+{
+  const cv::Rect imageRect(0, 0, grayImage.cols, grayImage.rows);
+  for(cv::Point2f& point : points)
+  {
+    const int r = std::max(2, static_cast<int>(radius));
+    const cv::Rect window = cv::Rect(static_cast<int>(point.x) - r, static_cast<int>(point.y) - r, 2 * r + 1, 2 * r + 1) & imageRect;
+    if(window.area() == 0)
+      continue;
+    const cv::Mat roi = grayImage(window);
+    double minValue = 0.0;
+    double maxValue = 0.0;
+    cv::minMaxLoc(roi, &minValue, &maxValue);
+    const double threshold = (minValue + maxValue) / 2.0;
+
+    double sumWeight = 0.0;
+    double sumX = 0.0;
+    double sumY = 0.0;
+    for(int y = 0; y < roi.rows; ++y)
+    {
+      const unsigned char* row = roi.ptr<unsigned char>(y);
+      for(int x = 0; x < roi.cols; ++x)
+      {
+        const double weight = threshold - row[x];
+        if(weight <= 0.0)
+          continue;
+        sumWeight += weight;
+        sumX += weight * x;
+        sumY += weight * y;
+      }
+    }
+    if(sumWeight <= 0.0)
+      continue;
+    const cv::Point2f center(static_cast<float>(window.x + sumX / sumWeight), static_cast<float>(window.y + sumY / sumWeight));
+    if(cv::norm(center - point) <= maxShift)
+      point = center;
+  }
+}
+
+/**
+ * @brief Refine approximate pattern points in local windows of the full resolution image
+ * @param[in] grayImage
+ * @param[in] settings
+ * @param[in] maxShift - maximal displacement of a circle center
+ * @param[in,out] points
+ */
+void refinePatternPoints(const cv::Mat& grayImage, const DetectionSettings& settings, float maxShift, std::vector<cv::Point2f>& points)
+{
+  const float spacing = getMinPointSpacing(points, settings.boardSize);
+  if(settings.patternType == eParamPatternTypeChessboard)
+  {
+    //Same window as the full resolution detection, smaller on tight grids
+    const int halfWindow = std::max(2, std::min(11, static_cast<int>(spacing / 2.0f) - 1));
+    cv::cornerSubPix(grayImage, points, cv::Size(halfWindow, halfWindow), cv::Size(-1, -1),
+                     cv::TermCriteria(cv::TermCriteria::EPS + cv::TermCriteria::COUNT, 30, 0.1));
+  }
+  else
+  {
+    refineCircleCenters(grayImage, 0.45f * spacing, maxShift, points);
+  }
+}
+
+/**
+ * @brief Pattern points position in grid units, in the findPattern order
+ */
+std::vector<cv::Point2f> getGridPoints(const DetectionSettings& settings)
+{
+  std::vector<cv::Point2f> gridPoints;
+  for(int y = 0; y < settings.boardSize.height; ++y)
+  {
+    for(int x = 0; x < settings.boardSize.width; ++x)
+    {
+      if(settings.patternType == eParamPatternTypeAsymmetricCirclesGrid)
+        gridPoints.emplace_back(static_cast<float>(2 * x + y % 2), static_cast<float>(y));
+      else
+        gridPoints.emplace_back(static_cast<float>(x), static_cast<float>(y));
+    }
+  }
+  return gridPoints;
+}
+
+/**
+ * @brief Serialized detections layout: per pattern, per frame, the image hash and the points coordinates
+ */
+typedef std::map<PatternKey, std::map<OfxTime, std::pair<std::uint64_t, std::vector<float> > > > SerializedDetections;
+
+const std::uint32_t kDetectionsVersion = 1;
+
+/**
+ * @brief OpenCV calibration flags of the settings
+ */
+int getCalibrationFlags(const CalibrationSettings& settings)
+{
+  int cvCalibFlags = 0;
+  cvCalibFlags |= CV_CALIB_ZERO_TANGENT_DIST;
+  const std::array<int, 6> fixDistortionCoefs = {CV_CALIB_FIX_K1, CV_CALIB_FIX_K2, CV_CALIB_FIX_K3, CV_CALIB_FIX_K4, CV_CALIB_FIX_K5, CV_CALIB_FIX_K6};
+  for (int i = settings.nbRadialCoef; i < 6; ++i)
+      cvCalibFlags |= fixDistortionCoefs[i];
+  return cvCalibFlags;
+}
+
+/**
+ * @brief Copy the initial guess of the settings in the matrices given to calibrateCamera
+ */
+void getInitialGuess(const CalibrationSettings& settings, cv::Mat& cameraMatrix, cv::Mat& distCoeffs)
+{
+  settings.initialCameraMatrix.convertTo(cameraMatrix, CV_64F);
+  distCoeffs = cv::Mat::zeros(8, 1, CV_64F);
+  cv::Mat initialDistCoeffs;
+  settings.initialDistCoeffs.convertTo(initialDistCoeffs, CV_64F);
+  for(int i = 0; i < std::min<int>(8, initialDistCoeffs.total()); ++i)
+    distCoeffs.at<double>(i) = initialDistCoeffs.at<double>(i);
+}
+
+/**
+ * @brief Gather the points and the input frame of the selected frames
+ */
+void gatherFrames(const std::vector<std::size_t>& selectedFrames,
+                  const std::vector<std::vector<cv::Point2f> >& imagePoints,
+                  const std::vector<std::vector<cv::Point3f> >& objectPoints,
+                  const std::vector<std::size_t>& inputFrames,
+                  std::vector<std::vector<cv::Point2f> >& calibImagePoints,
+                  std::vector<std::vector<cv::Point3f> >& calibObjectPoints,
+                  std::vector<std::size_t>& calibInputFrames)
+{
+  calibImagePoints.clear();
+  calibObjectPoints.clear();
+  calibInputFrames.clear();
+  for(std::size_t i : selectedFrames)
+  {
+    calibImagePoints.push_back(imagePoints[i]);
+    calibObjectPoints.push_back(objectPoints[i]);
+    calibInputFrames.push_back(inputFrames[i]);
+  }
+}
+
+/**
+ * @brief Iterative calibration of the frames selected among the given ones
+ * Same loop as openMVG calibrationIterativeOptimization, with a progress report between the iterations.
+ * The selection shrinks by half the rejected frames, the other half is replaced by the
+ * unselected frames covering the freed cells best.
+ */
+bool runIterativeCalibration(const CalibrationSettings& settings,
+                             int cvCalibFlags,
+                             std::size_t start,
+                             const std::vector<std::vector<cv::Point2f> >& imagePoints,
+                             const std::vector<std::vector<cv::Point3f> >& objectPoints,
+                             const std::vector<std::size_t>& inputFrames,
+                             CalibrationResult& result,
+                             const CalibrationCallback& callback)
+{
+  result.isCalibrated = false;
+  result.totalAvgErr = 0.0;
+  result.holdOutErr = 0.0;
+  result.rejectInputFrames.clear();
+
+  CalibrationFrameSelector selector(imagePoints, settings.imageSize, settings.calibGridSize);
+  selector.select(settings.maxCalibFrames);
+  std::vector<std::vector<cv::Point2f> > calibImagePoints;
+  std::vector<std::vector<cv::Point3f> > calibObjectPoints;
+
+  //With an initial guess, each iteration also warm-starts from the previous one
+  const bool isWarmStart = !settings.initialCameraMatrix.empty();
+  if(isWarmStart)
+    getInitialGuess(settings, result.cameraMatrix, result.distCoeffs);
+
+  CalibrationProgress progress;
+  progress.start = start;
+  for(;; ++progress.iteration)
+  {
+    OFXMVG_TRACE_SCOPE("lensCalibration.calibrationIteration");
+    const std::vector<std::size_t> selectedFrames = selector.getSelectedFrames();
+    gatherFrames(selectedFrames, imagePoints, objectPoints, inputFrames, calibImagePoints, calibObjectPoints, result.calibInputFrames);
+    std::vector<cv::Mat> rvecs;
+    std::vector<cv::Mat> tvecs;
+    if(!isWarmStart)
+    {
+      result.cameraMatrix = cv::Mat::eye(3, 3, CV_64F);
+      result.distCoeffs = cv::Mat::zeros(8, 1, CV_64F);
+    }
+    cv::calibrateCamera(calibObjectPoints, calibImagePoints, settings.imageSize,
+                        result.cameraMatrix, result.distCoeffs, rvecs, tvecs,
+                        cvCalibFlags | (isWarmStart ? CV_CALIB_USE_INTRINSIC_GUESS : 0));
+    result.isCalibrated = cv::checkRange(result.cameraMatrix) && cv::checkRange(result.distCoeffs);
+
+    //Reprojection error per frame and over all points
+    std::vector<float> reprojErrs(calibImagePoints.size());
+    double totalSquaredErr = 0.0;
+    std::size_t totalPoints = 0;
+    for(std::size_t i = 0; i < calibImagePoints.size(); ++i)
+    {
+      std::vector<cv::Point2f> projectedPoints;
+      cv::projectPoints(calibObjectPoints[i], rvecs[i], tvecs[i], result.cameraMatrix, result.distCoeffs, projectedPoints);
+      const double squaredErr = std::pow(cv::norm(calibImagePoints[i], projectedPoints, cv::NORM_L2), 2);
+      reprojErrs[i] = static_cast<float>(std::sqrt(squaredErr / calibImagePoints[i].size()));
+      totalSquaredErr += squaredErr;
+      totalPoints += calibImagePoints[i].size();
+    }
+    result.totalAvgErr = std::sqrt(totalSquaredErr / std::max<std::size_t>(totalPoints, 1));
+
+    progress.nbFrames = calibImagePoints.size();
+    progress.totalAvgErr = result.totalAvgErr;
+    Common::traceCounter("calibrationError", result.totalAvgErr);
+    if(callback && !callback(progress))
+    {
+      result.isCalibrated = false;
+      return false;
+    }
+    if(!result.isCalibrated ||
+       result.totalAvgErr <= settings.maxTotalAvgErr ||
+       calibImagePoints.size() <= settings.minInputFrames)
+      break;
+
+    //Reject the worst tenth of the frames, at least one, keeping minInputFrames
+    std::vector<float> sortedErrs = reprojErrs;
+    std::sort(sortedErrs.begin(), sortedErrs.end());
+    const float limitErr = sortedErrs[(sortedErrs.size() * 9) / 10];
+    std::size_t nbRemovable = calibImagePoints.size() - settings.minInputFrames;
+    std::size_t nbRejected = 0;
+    for(std::size_t i = calibImagePoints.size(); i-- > 0 && nbRemovable > 0;)
+    {
+      if(reprojErrs[i] < limitErr)
+        continue;
+      result.rejectInputFrames.push_back(result.calibInputFrames[i]);
+      selector.reject(selectedFrames[i]);
+      --nbRemovable;
+      ++nbRejected;
+    }
+    selector.select(calibImagePoints.size() - (nbRejected + 1) / 2);
+  }
+  return result.isCalibrated;
+}
+
+/**
+ * @brief Calibrate the frames selected among the given ones with the solver of the settings
+ * @param[in] nbThreads - threads of the solver, the OpenCV solver is single-threaded
+ */
+bool runCalibration(const CalibrationSettings& settings,
+                    int cvCalibFlags,
+                    std::size_t nbThreads,
+                    std::size_t start,
+                    const std::vector<std::vector<cv::Point2f> >& imagePoints,
+                    const std::vector<std::vector<cv::Point3f> >& objectPoints,
+                    const std::vector<std::size_t>& inputFrames,
+                    CalibrationResult& result,
+                    const CalibrationCallback& callback)
+{
+#ifdef HAVE_CERES
+  if(settings.solver == eParamCalibSolverCeres)
+  {
+    //The robust loss weights the bad frames down, they are not rejected
+    CalibrationFrameSelector selector(imagePoints, settings.imageSize, settings.calibGridSize);
+    selector.select(settings.maxCalibFrames);
+    std::vector<std::vector<cv::Point2f> > calibImagePoints;
+    std::vector<std::vector<cv::Point3f> > calibObjectPoints;
+    std::vector<std::size_t> calibInputFrames;
+    gatherFrames(selector.getSelectedFrames(), imagePoints, objectPoints, inputFrames, calibImagePoints, calibObjectPoints, calibInputFrames);
+    return calibrateCeres(settings, nbThreads, start, calibImagePoints, calibObjectPoints, calibInputFrames, result, callback);
+  }
+#endif
+  return runIterativeCalibration(settings, cvCalibFlags, start, imagePoints, objectPoints, inputFrames, result, callback);
+}
+
+/**
+ * @brief Reprojection error of frames unseen by a calibration
+ * The pose of each frame is estimated with the calibrated intrinsics.
+ */
+double computeHoldOutError(const std::vector<std::vector<cv::Point2f> >& imagePoints,
+                           const std::vector<std::vector<cv::Point3f> >& objectPoints,
+                           const cv::Mat& cameraMatrix,
+                           const cv::Mat& distCoeffs)
+{
+  double totalSquaredErr = 0.0;
+  std::size_t totalPoints = 0;
+  for(std::size_t i = 0; i < imagePoints.size(); ++i)
+  {
+    cv::Mat rvec;
+    cv::Mat tvec;
+    if(!cv::solvePnP(objectPoints[i], imagePoints[i], cameraMatrix, distCoeffs, rvec, tvec))
+      return std::numeric_limits<double>::max();
+    std::vector<cv::Point2f> projectedPoints;
+    cv::projectPoints(objectPoints[i], rvec, tvec, cameraMatrix, distCoeffs, projectedPoints);
+    totalSquaredErr += std::pow(cv::norm(imagePoints[i], projectedPoints, cv::NORM_L2), 2);
+    totalPoints += imagePoints[i].size();
+  }
+  return std::sqrt(totalSquaredErr / std::max<std::size_t>(totalPoints, 1));
+}
+
+} //namespace
+
+void convertToGRAY8(const Common::Image<float>& inputImage, bool isGray, cv::Mat& outputImage)
+{
+  outputImage.create(inputImage.getHeight(), inputImage.getWidth(), cv::DataType<unsigned char>::type);
+  if(isGray)
+    convertGGG32ToGRAY8(inputImage, outputImage);
+  else
+    convertRGB32ToGRAY8(inputImage, outputImage);
+}
+
+bool UndistortMap::isComputedFor(const cv::Size& size, const cv::Mat& K, const cv::Mat& D, bool redistort) const
+{
+  return !positions.empty() && imageSize == size && isRedistort == redistort &&
+         cameraMatrix.size() == K.size() && distCoeffs.size() == D.size() &&
+         cv::norm(cameraMatrix, K, cv::NORM_INF) == 0.0 &&
+         cv::norm(distCoeffs, D, cv::NORM_INF) == 0.0;
+}
+
+void computeUndistortMap(const cv::Size& imageSize, const cv::Mat& cameraMatrix, const cv::Mat& distCoeffs, UndistortMap& map)
+{
+  OFXMVG_TRACE_SCOPE("lensCalibration.computeUndistortMap");
+  map.imageSize = imageSize;
+  cameraMatrix.convertTo(map.cameraMatrix, CV_64F);
+  distCoeffs.convertTo(map.distCoeffs, CV_64F);
+  map.isRedistort = false;
+  cv::Mat unusedMap;
+  cv::initUndistortRectifyMap(map.cameraMatrix, map.distCoeffs, cv::noArray(), map.cameraMatrix,
+                              imageSize, CV_32FC2, map.positions, unusedMap);
+}
+
+void computeRedistortMap(const cv::Size& imageSize, const cv::Mat& cameraMatrix, const cv::Mat& distCoeffs, UndistortMap& map)
+{
+  OFXMVG_TRACE_SCOPE("lensCalibration.computeRedistortMap");
+  map.imageSize = imageSize;
+  cameraMatrix.convertTo(map.cameraMatrix, CV_64F);
+  distCoeffs.convertTo(map.distCoeffs, CV_64F);
+  map.isRedistort = true;
+  map.positions.create(imageSize, CV_32FC2);
+  Common::ThreadPool::instance().parallelFor(0, imageSize.height, [&](std::size_t y)
+  {
+    cv::Mat distortedPositions(1, imageSize.width, CV_32FC2);
+    cv::Vec2f* distortedPtr = distortedPositions.ptr<cv::Vec2f>();
+    for(int x = 0; x < imageSize.width; ++x)
+      distortedPtr[x] = cv::Vec2f(static_cast<float>(x), static_cast<float>(y));
+    //Written in the map row, the projection keeps the camera matrix
+    cv::Mat rowPositions = map.positions.row(static_cast<int>(y));
+    cv::undistortPoints(distortedPositions, rowPositions, map.cameraMatrix, map.distCoeffs, cv::noArray(), map.cameraMatrix);
+  });
+}
+
+void undistortImage(const Common::Image<float>& inputImage, const UndistortMap& map, Common::Image<float>& outputImage)
+{
+  OFXMVG_TRACE_SCOPE("lensCalibration.undistortImage");
+  assert(map.imageSize.width == static_cast<int>(outputImage.getWidth()));
+  assert(map.imageSize.height == static_cast<int>(outputImage.getHeight()));
+  assert(inputImage.getData() != outputImage.getData());
+
+  const int inputWidth = static_cast<int>(inputImage.getWidth());
+  const int inputHeight = static_cast<int>(inputImage.getHeight());
+  const bool hasAlpha = outputImage.getNbChannels() > 3;
+
+  Common::ThreadPool::instance().parallelFor(0, outputImage.getHeight(), [&](std::size_t y)
+  {
+    const cv::Vec2f* positionPtr = map.positions.ptr<cv::Vec2f>(static_cast<int>(y));
+    for(std::size_t x = 0; x < outputImage.getWidth(); ++x)
+    {
+      float* outputPtr = outputImage.getPixel(x, y);
+      const float sx = positionPtr[x][0];
+      const float sy = positionPtr[x][1];
+      if(!(sx >= 0.f && sy >= 0.f && sx <= inputWidth - 1 && sy <= inputHeight - 1))
+      {
+        outputPtr[0] = outputPtr[1] = outputPtr[2] = 0.f;
+      }
+      else
+      {
+        const int x0 = static_cast<int>(sx);
+        const int y0 = static_cast<int>(sy);
+        const int x1 = std::min(x0 + 1, inputWidth - 1);
+        const int y1 = std::min(y0 + 1, inputHeight - 1);
+        const float wx = sx - x0;
+        const float wy = sy - y0;
+        const float* p00 = inputImage.getPixel(x0, y0);
+        const float* p10 = inputImage.getPixel(x1, y0);
+        const float* p01 = inputImage.getPixel(x0, y1);
+        const float* p11 = inputImage.getPixel(x1, y1);
+        for(int c = 0; c < 3; ++c)
+        {
+          const float top = p00[c] + wx * (p10[c] - p00[c]);
+          const float bottom = p01[c] + wx * (p11[c] - p01[c]);
+          outputPtr[c] = top + wy * (bottom - top);
+        }
+      }
+      if(hasAlpha)
+        outputPtr[3] = 1.f;
+    }
+  });
+}
+
+bool trackPattern(const cv::Mat& previousGrayImage,
+                  const std::vector<cv::Point2f>& previousPoints,
+                  const cv::Mat& grayImage,
+                  const DetectionSettings& settings,
+                  std::vector<cv::Point2f>& points)
+{
+  const std::size_t nbPoints = static_cast<std::size_t>(settings.boardSize.area());
+  const bool isTrackable = (settings.patternType == eParamPatternTypeChessboard ||
+                            settings.patternType == eParamPatternTypeCirclesGrid ||
+                            settings.patternType == eParamPatternTypeAsymmetricCirclesGrid);
+  if(!isTrackable || previousPoints.size() != nbPoints || previousGrayImage.size() != grayImage.size())
+    return false;
+
+  OFXMVG_TRACE_SCOPE("lensCalibration.trackPattern");
+  std::vector<unsigned char> status;
+  std::vector<float> errors;
+  cv::calcOpticalFlowPyrLK(previousGrayImage, grayImage, previousPoints, points, status, errors, cv::Size(21, 21), 3);
+
+  const cv::Rect_<float> imageRect(0.f, 0.f, static_cast<float>(grayImage.cols), static_cast<float>(grayImage.rows));
+  for(std::size_t i = 0; i < nbPoints; ++i)
+  {
+    if(!status[i] || !imageRect.contains(points[i]))
+      return false;
+  }
+  const float spacing = getMinPointSpacing(points, settings.boardSize);
+  if(spacing < 4.0f)
+    return false;
+
+  refinePatternPoints(grayImage, settings, 0.25f * spacing, points);
+
+  //The grid ordering is valid if a homography maps the grid on the tracked points,
+  //a swapped or lost point is at least one spacing away from its prediction
+  const std::vector<cv::Point2f> gridPoints = getGridPoints(settings);
+  const cv::Mat H = cv::findHomography(gridPoints, points, 0);
+  if(H.empty())
+    return false;
+  std::vector<cv::Point2f> predictedPoints;
+  cv::perspectiveTransform(gridPoints, predictedPoints, H);
+  for(std::size_t i = 0; i < nbPoints; ++i)
+  {
+    if(cv::norm(predictedPoints[i] - points[i]) > 0.25 * spacing)
+      return false;
+  }
+  return true;
+}
+
+void writeSTMap(const UndistortMap& map, Common::Image<float>& outputImage)
+{
+  OFXMVG_TRACE_SCOPE("lensCalibration.writeSTMap");
+  assert(map.imageSize.width == static_cast<int>(outputImage.getWidth()));
+  assert(map.imageSize.height == static_cast<int>(outputImage.getHeight()));
+
+  const float scaleX = 1.f / map.imageSize.width;
+  const float scaleY = 1.f / map.imageSize.height;
+  const bool hasAlpha = outputImage.getNbChannels() > 3;
+  Common::ThreadPool::instance().parallelFor(0, outputImage.getHeight(), [&](std::size_t y)
+  {
+    const cv::Vec2f* positionPtr = map.positions.ptr<cv::Vec2f>(static_cast<int>(y));
+    for(std::size_t x = 0; x < outputImage.getWidth(); ++x)
+    {
+      float* outputPtr = outputImage.getPixel(x, y);
+      outputPtr[0] = (positionPtr[x][0] + 0.5f) * scaleX;
+      outputPtr[1] = 1.f - (positionPtr[x][1] + 0.5f) * scaleY;
+      outputPtr[2] = 0.f;
+      if(hasAlpha)
+        outputPtr[3] = 1.f;
+    }
+  });
+}
+
+void exportSTMap(const UndistortMap& map, const std::string& filePath, bool isHalf)
+{
+  OFXMVG_TRACE_SCOPE("lensCalibration.exportSTMap");
+  //OpenCV stores the channels as BGR
+  cv::Mat stMap(map.imageSize, CV_32FC3);
+  const float scaleX = 1.f / map.imageSize.width;
+  const float scaleY = 1.f / map.imageSize.height;
+  for(int y = 0; y < map.imageSize.height; ++y)
+  {
+    const cv::Vec2f* positionPtr = map.positions.ptr<cv::Vec2f>(y);
+    cv::Vec3f* stMapPtr = stMap.ptr<cv::Vec3f>(y);
+    for(int x = 0; x < map.imageSize.width; ++x)
+      stMapPtr[x] = cv::Vec3f(0.f, 1.f - (positionPtr[x][1] + 0.5f) * scaleY, (positionPtr[x][0] + 0.5f) * scaleX);
+  }
+  std::vector<int> writeParams;
+#if CV_VERSION_MAJOR >= 4
+  writeParams = {cv::IMWRITE_EXR_TYPE, isHalf ? cv::IMWRITE_EXR_TYPE_HALF : cv::IMWRITE_EXR_TYPE_FLOAT};
+#else
+  if(isHalf)
+    OFXMVG_LOG_WARNING("exportSTMap") << "half floats not supported by this OpenCV version, written in floats";
+#endif
+  bool isWritten = false;
+  try
+  {
+    isWritten = cv::imwrite(filePath, stMap, writeParams);
+  }
+  catch(const cv::Exception& e)
+  {
+    throw std::runtime_error("Cannot write the ST-map " + filePath + " : " + e.what());
+  }
+  if(!isWritten)
+    throw std::runtime_error("Cannot write the ST-map " + filePath);
+  OFXMVG_LOG_INFO("exportSTMap") << "ST-map exported"
+    << Common::kv("file", filePath)
+    << Common::kv("width", map.imageSize.width)
+    << Common::kv("height", map.imageSize.height)
+    << Common::kv("redistort", map.isRedistort)
+    << Common::kv("half", isHalf);
+}
+
+std::uint64_t computeImageHash(const cv::Mat& grayImage)
+{
+  //Area interpolation averages the whole image, the hash ignores the noise
+  cv::Mat thumbnail;
+  cv::resize(grayImage, thumbnail, cv::Size(9, 8), 0.0, 0.0, cv::INTER_AREA);
+
+  std::uint64_t hash = 0;
+  for(int y = 0; y < thumbnail.rows; ++y)
+  {
+    const unsigned char* row = thumbnail.ptr<unsigned char>(y);
+    for(int x = 0; x < 8; ++x)
+      hash = (hash << 1) | (row[x] < row[x + 1] ? 1u : 0u);
+  }
+  return hash;
+}
+
+int getHashDistance(std::uint64_t hashA, std::uint64_t hashB)
+{
+  return static_cast<int>(std::bitset<64>(hashA ^ hashB).count());
+}
+
+double computeSharpness(const cv::Mat& grayImage)
+{
+  OFXMVG_TRACE_SCOPE("lensCalibration.computeSharpness");
+  cv::Mat laplacian;
+  cv::Laplacian(grayImage, laplacian, CV_16S);
+  cv::Scalar mean;
+  cv::Scalar stdDev;
+  cv::meanStdDev(laplacian, mean, stdDev);
+  return stdDev[0] * stdDev[0];
+}
+
+bool detectPattern(const cv::Mat& grayImage,
+                   const DetectionSettings& settings,
+                   std::vector<cv::Point2f>& points)
+{
+  OFXMVG_TRACE_SCOPE("lensCalibration.findPattern");
+  const openMVG::calibration::Pattern patternType = getPatternType(settings.patternType);
+
+  //Pyramid level of the detection pass
+  int level = 0;
+  cv::Mat detectionImage = grayImage;
+  const bool isScalable = (settings.patternType == eParamPatternTypeChessboard ||
+                           settings.patternType == eParamPatternTypeCirclesGrid ||
+                           settings.patternType == eParamPatternTypeAsymmetricCirclesGrid);
+  if(isScalable && settings.maxDetectionSize > 0)
+  {
+    while(level < 5 && std::max(detectionImage.cols, detectionImage.rows) > settings.maxDetectionSize)
+    {
+      cv::Mat downsampled;
+      cv::pyrDown(detectionImage, downsampled);
+      detectionImage = downsampled;
+      ++level;
+    }
+  }
+
+  if(!openMVG::calibration::findPattern(patternType, detectionImage, settings.boardSize, points))
+    return false;
+  if(level == 0)
+    return true;
+
+  //Back to full resolution, pixel centers are on integer coordinates
+  OFXMVG_TRACE_SCOPE("lensCalibration.refinePattern");
+  const float scale = static_cast<float>(1 << level);
+  for(cv::Point2f& point : points)
+    point = (point + cv::Point2f(0.5f, 0.5f)) * scale - cv::Point2f(0.5f, 0.5f);
+
+  refinePatternPoints(grayImage, settings, scale, points);
+  return true;
+}
+
+bool detectPattern(const Common::Image<float>& inputImage,
+                   const DetectionSettings& settings,
+                   std::vector<cv::Point2f>& points)
+{
+  cv::Mat grayImage;
+  convertToGRAY8(inputImage, settings.isGray, grayImage);
+  return detectPattern(grayImage, settings, points);
+}
+
+PatternKey getPatternKey(const DetectionSettings& settings)
+{
+  return PatternKey(int(settings.patternType), settings.boardSize.width, settings.boardSize.height);
+}
+
+std::string serializeDetections(const std::map<PatternKey, PatternDetections>& detectionsPerPattern)
+{
+  OFXMVG_TRACE_SCOPE("lensCalibration.serializeDetections");
+  SerializedDetections serialized;
+  for(const auto& detections : detectionsPerPattern)
+  {
+    for(const auto& checker : detections.second.checkerPerFrame)
+    {
+      const auto hashIt = detections.second.hashPerFrame.find(checker.first);
+      auto& frame = serialized[detections.first][checker.first];
+      frame.first = (hashIt != detections.second.hashPerFrame.end()) ? hashIt->second : 0;
+      frame.second.reserve(2 * checker.second.size());
+      for(const cv::Point2f& point : checker.second)
+      {
+        frame.second.push_back(point.x);
+        frame.second.push_back(point.y);
+      }
+    }
+  }
+
+  std::ostringstream binaryData;
+  {
+    cereal::PortableBinaryOutputArchive archive(binaryData);
+    archive(kDetectionsVersion, serialized);
+  }
+  const std::string binary = binaryData.str();
+  return cereal::base64::encode(reinterpret_cast<const unsigned char*>(binary.data()), binary.size());
+}
+
+void deserializeDetections(const std::string& serializedDetections,
+                           std::map<PatternKey, PatternDetections>& detectionsPerPattern)
+{
+  OFXMVG_TRACE_SCOPE("lensCalibration.deserializeDetections");
+  std::istringstream binaryData(cereal::base64::decode(serializedDetections));
+  std::uint32_t version = 0;
+  SerializedDetections serialized;
+  {
+    cereal::PortableBinaryInputArchive archive(binaryData);
+    archive(version);
+    if(version != kDetectionsVersion)
+      throw std::runtime_error("Unsupported detections version " + std::to_string(version));
+    archive(serialized);
+  }
+
+  detectionsPerPattern.clear();
+  for(const auto& pattern : serialized)
+  {
+    PatternDetections& detections = detectionsPerPattern[pattern.first];
+    for(const auto& frame : pattern.second)
+    {
+      std::vector<cv::Point2f>& points = detections.checkerPerFrame[frame.first];
+      points.reserve(frame.second.second.size() / 2);
+      for(std::size_t i = 0; i + 1 < frame.second.second.size(); i += 2)
+        points.emplace_back(frame.second.second[i], frame.second.second[i + 1]);
+      detections.hashPerFrame[frame.first] = frame.second.first;
+    }
+  }
+}
+
+CalibrationFrameSelector::CalibrationFrameSelector(const std::vector<std::vector<cv::Point2f> >& imagePoints,
+                                                   const cv::Size& imageSize,
+                                                   std::size_t gridSize)
+  : _cellsPerFrame(imagePoints.size())
+  , _isRejectedFrame(imagePoints.size(), false)
+{
+  gridSize = std::max<std::size_t>(gridSize, 1);
+  _nbSelectedPerCell.assign(gridSize * gridSize, 0);
+
+  //Cells covered by each frame
+  for(std::size_t i = 0; i < imagePoints.size(); ++i)
+  {
+    std::vector<std::uint32_t>& cells = _cellsPerFrame[i];
+    cells.reserve(imagePoints[i].size());
+    for(const cv::Point2f& point : imagePoints[i])
+    {
+      if(!(point.x >= 0.f && point.y >= 0.f && point.x < imageSize.width && point.y < imageSize.height))
+        continue;
+      const std::size_t cellX = std::min(gridSize - 1, static_cast<std::size_t>(point.x * gridSize / imageSize.width));
+      const std::size_t cellY = std::min(gridSize - 1, static_cast<std::size_t>(point.y * gridSize / imageSize.height));
+      cells.push_back(static_cast<std::uint32_t>(cellY * gridSize + cellX));
+    }
+    std::sort(cells.begin(), cells.end());
+    cells.erase(std::unique(cells.begin(), cells.end()), cells.end());
+  }
+  resetCandidates();
+}
+
+float CalibrationFrameSelector::getGain(std::size_t frame) const
+{
+  float gain = 0.f;
+  for(std::uint32_t cell : _cellsPerFrame[frame])
+    gain += 1.f / (1 + _nbSelectedPerCell[cell]);
+  return gain;
+}
+
+void CalibrationFrameSelector::resetCandidates()
+{
+  std::vector<Candidate> candidates;
+  candidates.reserve(_cellsPerFrame.size());
+  for(std::size_t i = 0; i < _cellsPerFrame.size(); ++i)
+  {
+    if(!_cellsPerFrame[i].empty() && !_isRejectedFrame[i] && _gainPerSelectedFrame.count(i) == 0)
+      candidates.push_back({getGain(i), i, _nbUpdates});
+  }
+  _candidates = std::priority_queue<Candidate, std::vector<Candidate>, IsLowerCandidate>(IsLowerCandidate(), std::move(candidates));
+}
+
+std::size_t CalibrationFrameSelector::select(std::size_t maxFrames)
+{
+  OFXMVG_TRACE_SCOPE("lensCalibration.selectCalibrationFrames");
+  std::size_t nbSelected = 0;
+  while(_gainPerSelectedFrame.size() < maxFrames && !_candidates.empty())
+  {
+    Candidate candidate = _candidates.top();
+    _candidates.pop();
+    if(candidate.nbUpdates != _nbUpdates)
+    {
+      candidate.gain = getGain(candidate.frame);
+      candidate.nbUpdates = _nbUpdates;
+      _candidates.push(candidate);
+      ++_nbEvaluations;
+      continue;
+    }
+    _gainPerSelectedFrame[candidate.frame] = candidate.gain;
+    for(std::uint32_t cell : _cellsPerFrame[candidate.frame])
+      ++_nbSelectedPerCell[cell];
+    ++_nbUpdates;
+    ++nbSelected;
+  }
+
+  OFXMVG_LOG_DEBUG("selectCalibrationFrames") << "frames selected"
+    << Common::kv("nbCandidates", _cellsPerFrame.size())
+    << Common::kv("nbNewSelected", nbSelected)
+    << Common::kv("nbSelected", _gainPerSelectedFrame.size())
+    << Common::kv("nbEvaluations", _nbEvaluations);
+  return nbSelected;
+}
+
+void CalibrationFrameSelector::reject(std::size_t frame)
+{
+  if(_gainPerSelectedFrame.erase(frame) == 0)
+    throw std::logic_error("Can't reject the unselected calibration frame " + std::to_string(frame));
+  for(std::uint32_t cell : _cellsPerFrame[frame])
+    --_nbSelectedPerCell[cell];
+  _isRejectedFrame[frame] = true;
+  ++_nbUpdates;
+  //The queued gains are no longer upper bounds
+  resetCandidates();
+}
+
+std::vector<std::size_t> CalibrationFrameSelector::getSelectedFrames(std::vector<float>* scores) const
+{
+  std::vector<std::size_t> selectedIndexes;
+  selectedIndexes.reserve(_gainPerSelectedFrame.size());
+  if(scores)
+    scores->clear();
+  for(const auto& selectedFrame : _gainPerSelectedFrame)
+  {
+    selectedIndexes.push_back(selectedFrame.first);
+    if(scores)
+      scores->push_back(selectedFrame.second);
+  }
+  return selectedIndexes;
+}
+
+std::vector<std::size_t> selectCalibrationFrames(const std::vector<std::vector<cv::Point2f> >& imagePoints,
+                                                 const cv::Size& imageSize,
+                                                 std::size_t gridSize,
+                                                 std::size_t maxFrames,
+                                                 std::vector<float>* scores)
+{
+  CalibrationFrameSelector selector(imagePoints, imageSize, gridSize);
+  selector.select(maxFrames);
+  return selector.getSelectedFrames(scores);
+}
+
+bool calibrateLens(const CalibrationSettings& settings,
+                   const std::map<OfxTime, std::vector<cv::Point2f> >& checkerPerFrame,
+                   CalibrationResult& result,
+                   const CalibrationCallback& callback)
+{
+  if(checkerPerFrame.empty())
+    throw std::logic_error("No checkerboard detected.");
+
+  const openMVG::calibration::Pattern patternType = getPatternType(settings.patternType);
+
+  const int cvCalibFlags = getCalibrationFlags(settings);
+
+  //Multi-start: every fifth frame is held out to compare the starts
+  const std::size_t holdOutStep = 5;
+  const std::size_t nbHoldOutFrames = checkerPerFrame.size() / holdOutStep;
+  std::size_t nbStarts = std::max<std::size_t>(1, settings.nbStarts);
+  if(nbStarts > 1 && (nbHoldOutFrames < 3 || checkerPerFrame.size() - nbHoldOutFrames <= settings.minInputFrames))
+  {
+    OFXMVG_LOG_WARNING("calibrateLens") << "not enough frames for a multi-start calibration"
+      << Common::kv("nbFrames", checkerPerFrame.size());
+    nbStarts = 1;
+  }
+
+  std::vector<std::size_t> inputFrames;
+  std::vector<std::vector<cv::Point2f> > imagePoints;
+  std::vector<std::vector<cv::Point2f> > holdOutImagePoints;
+  std::size_t frameIndex = 0;
+  for(const auto& checker : checkerPerFrame)
+  {
+    if(nbStarts > 1 && (frameIndex++ % holdOutStep) == holdOutStep / 2)
+    {
+      holdOutImagePoints.push_back(checker.second);
+      continue;
+    }
+    inputFrames.push_back(static_cast<std::size_t>(checker.first));
+    imagePoints.push_back(checker.second);
+  }
+
+  Common::traceCounter("calibrationFrames", imagePoints.size());
+  std::vector<std::vector<cv::Point3f> > objectPoints;
+  openMVG::calibration::computeObjectPoints(settings.boardSize, patternType, settings.squareSize, imagePoints, objectPoints);
+
+  //The starts share the thread budget
+  const std::size_t nbThreads = settings.nbThreads > 0 ? settings.nbThreads : Common::ThreadPool::instance().getNbThreads();
+  if(nbStarts == 1)
+    return runCalibration(settings, cvCalibFlags, nbThreads, 0, imagePoints, objectPoints, inputFrames, result, callback);
+
+  std::vector<std::vector<cv::Point3f> > holdOutObjectPoints;
+  openMVG::calibration::computeObjectPoints(settings.boardSize, patternType, settings.squareSize, holdOutImagePoints, holdOutObjectPoints);
+
+  //The first start selects among all the frames, the others among a random subset of them
+  std::vector<CalibrationResult> results(nbStarts);
+  std::vector<double> holdOutErrs(nbStarts, std::numeric_limits<double>::max());
+  std::atomic<bool> isCanceled(false);
+  const std::size_t nbThreadsPerStart = std::max<std::size_t>(1, nbThreads / nbStarts);
+  Common::ThreadPool::instance().parallelFor(0, nbStarts, [&](std::size_t start)
+  {
+    OFXMVG_TRACE_SCOPE("lensCalibration.calibrationStart");
+    std::vector<std::size_t> subset(imagePoints.size());
+    std::iota(subset.begin(), subset.end(), 0);
+    if(start > 0)
+    {
+      std::mt19937 generator(static_cast<std::uint32_t>(start));
+      std::shuffle(subset.begin(), subset.end(), generator);
+      subset.resize(std::min(subset.size(), std::max(settings.minInputFrames, (subset.size() * 4) / 5)));
+      std::sort(subset.begin(), subset.end());
+    }
+    std::vector<std::vector<cv::Point2f> > startImagePoints;
+    std::vector<std::vector<cv::Point3f> > startObjectPoints;
+    std::vector<std::size_t> startInputFrames;
+    for(std::size_t i : subset)
+    {
+      startImagePoints.push_back(imagePoints[i]);
+      startObjectPoints.push_back(objectPoints[i]);
+      startInputFrames.push_back(inputFrames[i]);
+    }
+
+    const bool isCalibrated = runCalibration(settings, cvCalibFlags, nbThreadsPerStart, start, startImagePoints, startObjectPoints, startInputFrames, results[start],
+      [&](const CalibrationProgress& progress)
+      {
+        if(isCanceled || (callback && !callback(progress)))
+          isCanceled = true;
+        return !isCanceled;
+      });
+    if(isCalibrated)
+      holdOutErrs[start] = computeHoldOutError(holdOutImagePoints, holdOutObjectPoints, results[start].cameraMatrix, results[start].distCoeffs);
+    OFXMVG_LOG_DEBUG("calibrateLens") << "start done"
+      << Common::kv("start", start)
+      << Common::kv("isCalibrated", isCalibrated)
+      << Common::kv("totalAvgErr", results[start].totalAvgErr)
+      << Common::kv("holdOutErr", holdOutErrs[start]);
+  });
+  if(isCanceled)
+  {
+    result.isCalibrated = false;
+    return false;
+  }
+
+  const std::size_t bestStart = std::min_element(holdOutErrs.begin(), holdOutErrs.end()) - holdOutErrs.begin();
+  result = results[bestStart];
+  result.holdOutErr = holdOutErrs[bestStart];
+  OFXMVG_LOG_INFO("calibrateLens") << "best start"
+    << Common::kv("start", bestStart)
+    << Common::kv("nbStarts", nbStarts)
+    << Common::kv("totalAvgErr", result.totalAvgErr)
+    << Common::kv("holdOutErr", result.holdOutErr)
+    << Common::kv("nbHoldOutFrames", holdOutImagePoints.size());
+  return result.isCalibrated;
+}
+
+void getCalibrationMatrices(double focalLength,
+                            const cv::Point2d& principalPoint,
+                            const cv::Vec3d& radialCoefs,
+                            const cv::Vec2d& tangentialCoefs,
+                            cv::Mat& cameraMatrix,
+                            cv::Mat& distCoeffs)
+{
+  cameraMatrix = (cv::Mat_<double>(3, 3) << focalLength, 0.0, principalPoint.x,
+                                            0.0, focalLength, principalPoint.y,
+                                            0.0, 0.0, 1.0);
+  //Same layout as setOutputParams: k1 k2 p1 p2 k3
+  distCoeffs = (cv::Mat_<double>(5, 1) << radialCoefs[0], radialCoefs[1], tangentialCoefs[0], tangentialCoefs[1], radialCoefs[2]);
+}
+
+IncrementalCalibration::IncrementalCalibration(const CalibrationSettings& settings)
+  : _settings(settings)
+{}
+
+void IncrementalCalibration::addFrame(OfxTime time, const std::vector<cv::Point2f>& points)
+{
+  _checkerPerFrame[time] = points;
+  ++_nbNewFrames;
+}
+
+bool IncrementalCalibration::update()
+{
+  //Three views constrain the intrinsics without initial guess
+  const bool hasGuess = _result.isCalibrated || !_settings.initialCameraMatrix.empty();
+  if(_checkerPerFrame.size() < (hasGuess ? 1 : 3))
+    return false;
+
+  OFXMVG_TRACE_SCOPE("lensCalibration.incrementalUpdate");
+  //The cost is bounded: frames spread over the image
+  std::vector<std::vector<cv::Point2f> > allImagePoints;
+  std::vector<std::size_t> allInputFrames;
+  for(const auto& checker : _checkerPerFrame)
+  {
+    allImagePoints.push_back(checker.second);
+    allInputFrames.push_back(static_cast<std::size_t>(checker.first));
+  }
+  std::vector<std::vector<cv::Point2f> > imagePoints;
+  std::vector<std::size_t> inputFrames;
+  for(std::size_t i : selectCalibrationFrames(allImagePoints, _settings.imageSize, _settings.calibGridSize, std::max<std::size_t>(_settings.maxCalibFrames, 1)))
+  {
+    imagePoints.push_back(allImagePoints[i]);
+    inputFrames.push_back(allInputFrames[i]);
+  }
+  if(imagePoints.size() < (hasGuess ? 1 : 3))
+    return false;
+  std::vector<std::vector<cv::Point3f> > objectPoints;
+  openMVG::calibration::computeObjectPoints(_settings.boardSize, getPatternType(_settings.patternType), _settings.squareSize, imagePoints, objectPoints);
+
+  cv::Mat cameraMatrix;
+  cv::Mat distCoeffs;
+  int cvCalibFlags = getCalibrationFlags(_settings);
+  cv::TermCriteria criteria(cv::TermCriteria::COUNT + cv::TermCriteria::EPS, 30, DBL_EPSILON);
+  if(_result.isCalibrated)
+  {
+    _result.cameraMatrix.copyTo(cameraMatrix);
+    _result.distCoeffs.copyTo(distCoeffs);
+  }
+  else if(hasGuess)
+    getInitialGuess(_settings, cameraMatrix, distCoeffs);
+  if(hasGuess)
+  {
+    //Close to the solution: a few iterations refine it
+    cvCalibFlags |= CV_CALIB_USE_INTRINSIC_GUESS;
+    criteria.maxCount = 5;
+  }
+  else
+  {
+    cameraMatrix = cv::Mat::eye(3, 3, CV_64F);
+    distCoeffs = cv::Mat::zeros(8, 1, CV_64F);
+  }
+
+  std::vector<cv::Mat> rvecs;
+  std::vector<cv::Mat> tvecs;
+  const double rms = cv::calibrateCamera(objectPoints, imagePoints, _settings.imageSize,
+                                         cameraMatrix, distCoeffs, rvecs, tvecs, cvCalibFlags, criteria);
+  _nbNewFrames = 0;
+  if(!cv::checkRange(cameraMatrix) || !cv::checkRange(distCoeffs))
+    return _result.isCalibrated;
+
+  _result.isCalibrated = true;
+  _result.totalAvgErr = rms;
+  _result.cameraMatrix = cameraMatrix;
+  _result.distCoeffs = distCoeffs;
+  _result.calibInputFrames = std::move(inputFrames);
+  return true;
+}
+
+bool writeCalibrationFile(const std::string& filePath,
+                          const cv::Size& imageSize,
+                          const cv::Mat& cameraMatrix,
+                          const cv::Mat& distCoeffs)
+{
+  std::ofstream file(filePath);
+  if(!file.is_open())
+    return false;
+
+  file.precision(12);
+  file << imageSize.width << std::endl
+       << imageSize.height << std::endl
+       << cameraMatrix.at<double>(0,0) << std::endl
+       << cameraMatrix.at<double>(0,2) << std::endl
+       << cameraMatrix.at<double>(1,2) << std::endl
+       << distCoeffs.at<double>(0) << std::endl
+       << distCoeffs.at<double>(1) << std::endl
+       << distCoeffs.at<double>(4) << std::endl;
+  return file.good();
+}
+
 void setOutputParams(OFX::DoubleParam *_outputCameraFocalLenght,
                      OFX::Double2DParam *_outputCameraPrincipalPointOffset,
                      OFX::DoubleParam *_outputLensDistortionRadialCoef1,
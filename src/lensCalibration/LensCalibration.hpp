@@ -8,9 +8,112 @@
 
 #include <opencv2/core/mat.hpp>
 
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <queue>
+#include <string>
+#include <tuple>
+#include <vector>
+
 namespace openMVG_ofx {
 namespace LensCalibration {
 
+/**
+ * @brief Lens calibration settings, independent from the OFX parameters
+ */
+struct CalibrationSettings
+{
+  cv::Size imageSize;
+  cv::Size boardSize = cv::Size(10, 7);
+  EParamPatternType patternType = eParamPatternTypeChessboard;
+  double squareSize = 1.0;
+  int nbRadialCoef = 3;
+  std::size_t maxCalibFrames = 100;
+  std::size_t calibGridSize = 10;
+  std::size_t minInputFrames = 10;
+  double maxTotalAvgErr = 0.1;
+  std::size_t nbStarts = 1; //concurrent calibrations on frame subsets, the best one on held-out frames wins
+  EParamCalibSolver solver = eParamCalibSolverOpenCV;
+  std::size_t nbThreads = 0; //threads of the calibration, shared by the starts, 0 for the worker pool size
+  cv::Mat initialCameraMatrix; //warm start of the optimization, empty to start from nothing
+  cv::Mat initialDistCoeffs;
+};
+
+/**
+ * @brief Pattern detection settings
+ */
+struct DetectionSettings
+{
+  bool isGray = false; //the input image is a gray image stored as RGB
+  EParamPatternType patternType = eParamPatternTypeChessboard;
+  cv::Size boardSize = cv::Size(10, 7);
+  int maxDetectionSize = 1920; //largest image side of the detection pass, 0 to detect at full resolution
+};
+
+/**
+ * @brief Pre-filter of the frames, before the pattern detection
+ */
+struct FrameFilterSettings
+{
+  int minHashDistance = 3; //frames whose hash is closer to a detected frame hash are skipped, 0 to disable
+  double minSharpness = 0.0; //frames with a lower sharpness are skipped, 0 to disable
+};
+
+/**
+ * @brief Pattern points detected per frame, for one pattern type and size
+ */
+struct PatternDetections
+{
+  std::map<OfxTime, std::vector<cv::Point2f> > checkerPerFrame;
+  std::map<OfxTime, std::uint64_t> hashPerFrame; //image hash of the checkerPerFrame frames
+};
+
+/**
+ * @brief Pattern type, width and height: the detections are only valid for one pattern
+ */
+typedef std::tuple<int, int, int> PatternKey;
+
+/**
+ * @brief Lens calibration result
+ */
+struct CalibrationResult
+{
+  bool isCalibrated = false;
+  double totalAvgErr = 0.0;
+  cv::Mat cameraMatrix;
+  cv::Mat distCoeffs;
+  std::vector<std::size_t> calibInputFrames; //selected frames
+  std::vector<std::size_t> rejectInputFrames; //frames rejected by the optimization
+  double holdOutErr = 0.0; //reprojection error of the held-out frames, multi-start only
+};
+
+/**
+ * @brief Lens calibration progress, reported after each optimization iteration
+ */
+struct CalibrationProgress
+{
+  std::size_t start = 0; //multi-start index
+  std::size_t iteration = 0;
+  std::size_t nbFrames = 0; //frames used by the iteration
+  double totalAvgErr = 0.0; //reprojection error of the iteration (pixels)
+};
+
+/**
+ * @brief Calibration progress callback
+ * Called on the calibration threads, concurrently with several starts.
+ * Returns false to cancel the calibration.
+ */
+typedef std::function<bool(const CalibrationProgress&)> CalibrationCallback;
+
+/**
+ * @brief Get the number of rig source clips of the plugin
+ * The OFXMVG_LENSCALIBRATION_MAX_EXTRA_INPUTS environment variable (0 to 63) overrides the build default.
+ * The value is read once: the described and the fetched clips must match.
+ * @return number of rig source clips
+ */
+std::size_t getMaxNbExtraInputs();
+
 /**
  * @brief convert a rgb OFX image to a rgb MVG image
  * @param[in] inputImageOFX
@@ -46,6 +149,369 @@ void convertGGG32ToGRAY8(const Common::Image<float>& inputImage, cv::Mat& output
  */
 openMVG::calibration::Pattern getPatternType(EParamPatternType pattern);
 
+/**
+ * @brief Convert an OFX image to a gray (unsigned char) 8 bits image
+ * @param[in] inputImage
+ * @param[in] isGray - the input image is a gray image stored as RGB
+ * @param[out] outputImage - allocated to the input size
+ */
+void convertToGRAY8(const Common::Image<float>& inputImage, bool isGray, cv::Mat& outputImage);
+
+/**
+ * @brief Distortion map: source position of each pixel of an image
+ * Undistort map: position in the distorted image of each undistorted pixel.
+ * Redistort map: position in the undistorted image of each distorted pixel.
+ * Depends only on the image size and the calibration, it's reused by the renders.
+ */
+struct UndistortMap
+{
+  cv::Size imageSize;
+  cv::Mat cameraMatrix;
+  cv::Mat distCoeffs;
+  bool isRedistort = false;
+  cv::Mat positions; //CV_32FC2, one source position per pixel
+
+  /**
+   * @brief Check if the map was computed for an image size and a calibration
+   * @param[in] size
+   * @param[in] K - camera matrix
+   * @param[in] D - distortion coefficients, k1 k2 p1 p2 k3
+   * @param[in] redistort - map direction
+   */
+  bool isComputedFor(const cv::Size& size, const cv::Mat& K, const cv::Mat& D, bool redistort) const;
+};
+
+/**
+ * @brief Compute the distortion map of an image size and a calibration
+ * The undistorted image keeps the camera matrix.
+ * @param[in] imageSize
+ * @param[in] cameraMatrix
+ * @param[in] distCoeffs - k1 k2 p1 p2 k3
+ * @param[out] map
+ */
+void computeUndistortMap(const cv::Size& imageSize, const cv::Mat& cameraMatrix, const cv::Mat& distCoeffs, UndistortMap& map);
+
+/**
+ * @brief Compute the inverse distortion map of an image size and a calibration
+ * The lens model is inverted iteratively, the rows are processed on the worker pool.
+ * @param[in] imageSize
+ * @param[in] cameraMatrix
+ * @param[in] distCoeffs - k1 k2 p1 p2 k3
+ * @param[out] map
+ */
+void computeRedistortMap(const cv::Size& imageSize, const cv::Mat& cameraMatrix, const cv::Mat& distCoeffs, UndistortMap& map);
+
+/**
+ * @brief Undistort an RGB(A) image into another, with a bilinear interpolation
+ * Rows are processed on the worker pool. The pixels mapped outside the input are black,
+ * the output alpha is opaque.
+ * @param[in] inputImage
+ * @param[in] map - computed for the output size
+ * @param[out] outputImage - may not be the input image
+ */
+void undistortImage(const Common::Image<float>& inputImage, const UndistortMap& map, Common::Image<float>& outputImage);
+
+/**
+ * @brief Write a distortion map as an ST-map
+ * Normalized source position of each pixel: red is s = (x + 0.5) / width, green is
+ * t = 1 - (y + 0.5) / height, with a bottom-left origin as the compositing STMap nodes.
+ * Blue is zero and alpha is opaque.
+ * @param[in] map
+ * @param[out] outputImage - RGBA, with the map size
+ */
+void writeSTMap(const UndistortMap& map, Common::Image<float>& outputImage);
+
+/**
+ * @brief Export a distortion map as an OpenEXR ST-map, in 32 bits floats
+ * @param[in] map
+ * @param[in] filePath - .exr file
+ * @param[in] isHalf - write 16 bits half floats instead, if supported by OpenCV
+ * @throw std::runtime_error if the file can't be written
+ */
+void exportSTMap(const UndistortMap& map, const std::string& filePath, bool isHalf = false);
+
+/**
+ * @brief Track the pattern points of the previous frame
+ * Points are moved by pyramidal optical flow and refined locally. The result is
+ * rejected if a point is lost or if the grid ordering is not consistent.
+ * @param[in] previousGrayImage
+ * @param[in] previousPoints - pattern points detected on the previous image
+ * @param[in] grayImage
+ * @param[in] settings
+ * @param[out] points - tracked pattern points
+ * @return true if the whole pattern is tracked
+ */
+bool trackPattern(const cv::Mat& previousGrayImage,
+                  const std::vector<cv::Point2f>& previousPoints,
+                  const cv::Mat& grayImage,
+                  const DetectionSettings& settings,
+                  std::vector<cv::Point2f>& points);
+
+/**
+ * @brief Compute the 64 bits difference hash (dHash) of an image
+ * The image is reduced to 9x8 pixels, each bit compares two horizontal neighbours.
+ * Near identical images have hashes with a small Hamming distance.
+ * @param[in] grayImage - 8 bits gray image
+ * @return hash
+ */
+std::uint64_t computeImageHash(const cv::Mat& grayImage);
+
+/**
+ * @brief Number of different bits between two image hashes
+ * @param[in] hashA
+ * @param[in] hashB
+ * @return Hamming distance, in [0, 64]
+ */
+int getHashDistance(std::uint64_t hashA, std::uint64_t hashB);
+
+/**
+ * @brief Compute the sharpness of an image: the variance of its Laplacian
+ * Low values mean a blurred image, the scale depends on the image content.
+ * @param[in] grayImage - 8 bits gray image
+ * @return sharpness
+ */
+double computeSharpness(const cv::Mat& grayImage);
+
+/**
+ * @brief Detect the calibration pattern, coarse to fine
+ * The pattern is searched on a pyramid level smaller than maxDetectionSize,
+ * frames without pattern are rejected at this level. Found points are then
+ * refined in local windows of the full resolution image.
+ * Doesn't use the OFX suites, it can run on a worker thread.
+ * @param[in] grayImage - full resolution 8 bits gray image
+ * @param[in] settings
+ * @param[out] points - detected pattern points, in full resolution pixels
+ * @return true if the pattern is found
+ */
+bool detectPattern(const cv::Mat& grayImage,
+                   const DetectionSettings& settings,
+                   std::vector<cv::Point2f>& points);
+
+/**
+ * @brief Convert an OFX image to gray and detect the calibration pattern
+ * @param[in] inputImage
+ * @param[in] settings
+ * @param[out] points - detected pattern points
+ * @return true if the pattern is found
+ */
+bool detectPattern(const Common::Image<float>& inputImage,
+                   const DetectionSettings& settings,
+                   std::vector<cv::Point2f>& points);
+
+/**
+ * @brief Get the key of the detected pattern
+ * @param[in] settings
+ * @return key
+ */
+PatternKey getPatternKey(const DetectionSettings& settings);
+
+/**
+ * @brief Serialize the detections in a compact string: base64 of a portable binary archive
+ * @param[in] detectionsPerPattern
+ * @return serialized detections
+ */
+std::string serializeDetections(const std::map<PatternKey, PatternDetections>& detectionsPerPattern);
+
+/**
+ * @brief Read detections serialized by serializeDetections
+ * @param[in] serializedDetections
+ * @param[out] detectionsPerPattern
+ * @throw std::exception if the data is invalid
+ */
+void deserializeDetections(const std::string& serializedDetections,
+                           std::map<PatternKey, PatternDetections>& detectionsPerPattern);
+
+/**
+ * @brief Selection of the frames covering the image best, with a lazy greedy coverage maximization
+ * The image is split in gridSize x gridSize cells. The gain of a frame is the sum over
+ * the cells holding its points of 1 / (1 + number of selected frames in the cell).
+ * The frame with the highest gain is selected and the counts of its cells are updated.
+ * Selections only decrease the gains: a queued gain is an upper bound, only the top frame is re-evaluated.
+ * A rejection raises the gains of the frames sharing its cells, all the gains are re-evaluated.
+ * Frames without point in the image are never selected.
+ * Not thread-safe.
+ */
+class CalibrationFrameSelector
+{
+public:
+  /**
+   * @param[in] imagePoints - pattern points per frame
+   * @param[in] imageSize
+   * @param[in] gridSize - number of cells per image side
+   */
+  CalibrationFrameSelector(const std::vector<std::vector<cv::Point2f> >& imagePoints,
+                           const cv::Size& imageSize,
+                           std::size_t gridSize);
+
+  /**
+   * @brief Select frames until maxFrames frames are selected or no frame is left
+   * @param[in] maxFrames - maximal number of selected frames, including the already selected ones
+   * @return number of frames selected by this call
+   */
+  std::size_t select(std::size_t maxFrames);
+
+  /**
+   * @brief Remove a selected frame from the selection, it won't be selected again
+   * @param[in] frame - index of a selected frame
+   * @throw std::logic_error if the frame isn't selected
+   */
+  void reject(std::size_t frame);
+
+  /**
+   * @param[out] scores - if not null, gain of each selected frame when it was selected
+   * @return indexes of the selected frames, in increasing order
+   */
+  std::vector<std::size_t> getSelectedFrames(std::vector<float>* scores = nullptr) const;
+
+  std::size_t getNbSelectedFrames() const { return _gainPerSelectedFrame.size(); }
+
+private:
+  /**
+   * @brief The gain is up to date if it was computed after the last selection.
+   *        Ties are broken by the frame order, the selection is deterministic.
+   */
+  struct Candidate
+  {
+    float gain;
+    std::size_t frame;
+    std::size_t nbUpdates; //number of selection updates when the gain was computed
+  };
+
+  struct IsLowerCandidate
+  {
+    bool operator()(const Candidate& a, const Candidate& b) const
+    {
+      return a.gain < b.gain || (a.gain == b.gain && a.frame > b.frame);
+    }
+  };
+
+  float getGain(std::size_t frame) const;
+
+  /**
+   * @brief Queue the frames neither selected nor rejected, with their current gain
+   */
+  void resetCandidates();
+
+  std::vector<std::vector<std::uint32_t> > _cellsPerFrame; //sorted cells covered by each frame
+  std::vector<std::uint32_t> _nbSelectedPerCell;
+  std::vector<bool> _isRejectedFrame;
+  std::map<std::size_t, float> _gainPerSelectedFrame;
+  std::priority_queue<Candidate, std::vector<Candidate>, IsLowerCandidate> _candidates;
+  std::size_t _nbUpdates = 0;
+  std::size_t _nbEvaluations = 0;
+};
+
+/**
+ * @brief Select the frames covering the image best, see CalibrationFrameSelector
+ * @param[in] imagePoints - pattern points per frame
+ * @param[in] imageSize
+ * @param[in] gridSize - number of cells per image side
+ * @param[in] maxFrames - maximal number of selected frames
+ * @param[out] scores - if not null, gain of each selected frame when it was selected
+ * @return indexes of the selected frames, in increasing order
+ */
+std::vector<std::size_t> selectCalibrationFrames(const std::vector<std::vector<cv::Point2f> >& imagePoints,
+                                                 const cv::Size& imageSize,
+                                                 std::size_t gridSize,
+                                                 std::size_t maxFrames,
+                                                 std::vector<float>* scores = nullptr);
+
+/**
+ * @brief Calibrate the lens from the pattern points detected per frame
+ * The best frames are selected, then the calibration is refined iteratively:
+ * the frames with the highest reprojection errors are rejected until the error
+ * is below maxTotalAvgErr or only minInputFrames remain. Half of the rejected
+ * frames are replaced by the unselected frames covering their cells best.
+ * With several starts, a fifth of the frames is held out. The starts run on the
+ * worker pool from different subsets of the frames, the one with the
+ * lowest held-out reprojection error is kept.
+ * Doesn't use the OFX suites, it can run on a worker thread.
+ * @param[in] settings
+ * @param[in] checkerPerFrame - detected pattern points per frame
+ * @param[out] result
+ * @param[in] callback - progress callback, may cancel the calibration
+ * @return true if the calibration succeed, false if it fails or is canceled
+ */
+bool calibrateLens(const CalibrationSettings& settings,
+                   const std::map<OfxTime, std::vector<cv::Point2f> >& checkerPerFrame,
+                   CalibrationResult& result,
+                   const CalibrationCallback& callback = CalibrationCallback());
+
+/**
+ * @brief Build the camera matrix and the distortion coefficients from the output values
+ * @param[in] focalLength
+ * @param[in] principalPoint
+ * @param[in] radialCoefs - k1 k2 k3
+ * @param[in] tangentialCoefs - p1 p2
+ * @param[out] cameraMatrix
+ * @param[out] distCoeffs
+ */
+void getCalibrationMatrices(double focalLength,
+                            const cv::Point2d& principalPoint,
+                            const cv::Vec3d& radialCoefs,
+                            const cv::Vec2d& tangentialCoefs,
+                            cv::Mat& cameraMatrix,
+                            cv::Mat& distCoeffs);
+
+/**
+ * @brief Calibration estimate updated as the pattern detections accumulate
+ * Each update warm-starts from the previous solution: the intrinsics are the
+ * initial guess, the solver fits the poses of the views and refines them in a
+ * few iterations. Frames are not rejected, use calibrateLens for the final result.
+ * Not thread-safe, doesn't use the OFX suites.
+ */
+class IncrementalCalibration
+{
+public:
+  explicit IncrementalCalibration(const CalibrationSettings& settings);
+
+  const CalibrationSettings& getSettings() const { return _settings; }
+
+  /**
+   * @brief Add the pattern points of a frame, used by the next update
+   * @param[in] time
+   * @param[in] points
+   */
+  void addFrame(OfxTime time, const std::vector<cv::Point2f>& points);
+
+  /**
+   * @brief Number of frames added since the last update
+   */
+  std::size_t getNbNewFrames() const { return _nbNewFrames; }
+
+  /**
+   * @brief Update the estimate with all the frames, at most maxCalibFrames spread over the time
+   * @return true if the estimate is valid
+   */
+  bool update();
+
+  /**
+   * @brief Last estimate, calibInputFrames are the frames of the last update
+   */
+  const CalibrationResult& getResult() const { return _result; }
+
+private:
+  const CalibrationSettings _settings;
+  std::map<OfxTime, std::vector<cv::Point2f> > _checkerPerFrame;
+  std::size_t _nbNewFrames = 0;
+  CalibrationResult _result;
+};
+
+/**
+ * @brief Write the calibration in the openMVG calibration file format,
+ *        readable by the CameraLocalizer lens calibration file parameter
+ *        (width height focal ppx ppy k1 k2 k3)
+ * @param[in] filePath
+ * @param[in] imageSize
+ * @param[in] cameraMatrix
+ * @param[in] distCoeffs
+ * @return true if the file is written
+ */
+bool writeCalibrationFile(const std::string& filePath,
+                          const cv::Size& imageSize,
+                          const cv::Mat& cameraMatrix,
+                          const cv::Mat& distCoeffs);
+
 /**
  * @brief Set intrinsic values and distortion coefficients into OFX parameters
  * @param[in] _outputFlags
@@ -1,27 +1,68 @@
 #include "LensCalibrationInteract.hpp"
 
+#include "../common/stb_easy_font.h"
+
 namespace openMVG_ofx {
 namespace LensCalibration {
 
 bool LensCalibrationInteract::draw(const OFX::DrawArgs &args)
 {
+  //The draw can't set the parameters: the background calibration state is drawn until it's applied
+  const std::string status = _plugin->getCalibrationTaskStatus();
+  if(status.empty())
+    return false;
+
+  //Above the bottom left corner of the image, with a constant size on screen
+  glPushMatrix();
+  glTranslated(10.0 * args.pixelScale.x, 30.0 * args.pixelScale.y, 0.0);
+  glScaled(2.0 * args.pixelScale.x, 2.0 * args.pixelScale.y, 1.0);
+  glColor3f(1.f, 1.f, 1.f);
+  stb_print_string(0.f, 0.f, status);
+  glPopMatrix();
   return true;
 }
 
+//The interactions are the actions allowed to set parameters: each one refreshes the background calibration status
+
 bool LensCalibrationInteract::penMotion(const OFX::PenArgs &args)
 {
+  _plugin->updateBackgroundStatus();
   return false;
 }
 
 bool LensCalibrationInteract::penDown(const OFX::PenArgs &args)
 {
+  _plugin->updateBackgroundStatus();
   return false;
 }
 
 bool LensCalibrationInteract::penUp(const OFX::PenArgs &args)
 {
+  _plugin->updateBackgroundStatus();
   return false;
 }
 
+bool LensCalibrationInteract::keyDown(const OFX::KeyArgs &args)
+{
+  _plugin->updateBackgroundStatus();
+  return false;
+}
+
+bool LensCalibrationInteract::keyUp(const OFX::KeyArgs &args)
+{
+  _plugin->updateBackgroundStatus();
+  return false;
+}
+
+void LensCalibrationInteract::gainFocus(const OFX::FocusArgs &args)
+{
+  _plugin->updateBackgroundStatus();
+}
+
+void LensCalibrationInteract::loseFocus(const OFX::FocusArgs &args)
+{
+  _plugin->updateBackgroundStatus();
+}
+
 } //namespace LensCalibration
-} //namespace openMVG_ofx
\ No newline at end of file
+} //namespace openMVG_ofx
@@ -32,6 +32,10 @@ public:
   bool penMotion(const OFX::PenArgs &args);
   bool penDown(const OFX::PenArgs &args);
   bool penUp(const OFX::PenArgs &args);
+  bool keyDown(const OFX::KeyArgs &args);
+  bool keyUp(const OFX::KeyArgs &args);
+  void gainFocus(const OFX::FocusArgs &args);
+  void loseFocus(const OFX::FocusArgs &args);
 };
 
 class LensCalibrationOverlayDescriptor : public OFX::DefaultEffectOverlayDescriptor<LensCalibrationOverlayDescriptor, LensCalibrationInteract>
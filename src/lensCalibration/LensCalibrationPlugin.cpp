@@ -1,22 +1,35 @@
 #include "LensCalibrationPlugin.hpp"
 #include "LensCalibration.hpp"
 #include "../common/Image.hpp"
+#include "../common/Trace.hpp"
+#include "../common/Logger.hpp"
+#include "../common/ThreadPool.hpp"
+#include "../common/FeedPrefetcher.hpp"
 
 #include <openMVG/calibration/patternDetect.hpp>
 #include <openMVG/calibration/bestImages.hpp>
 #include <openMVG/calibration/calibration.hpp>
 #include <openMVG/calibration/exportData.hpp>
-#include <openMVG/cameras/Camera_undistort_image.hpp>
 #include <openMVG/image/pixel_types.hpp>
 
 #include <opencv2/opencv.hpp>
 #include <opencv2/calib3d/calib3d.hpp>
 
+#include <boost/filesystem/path.hpp>
+#include <boost/filesystem/operations.hpp>
+
 #include <map>
 #include <array>
+#include <cmath>
+#include <deque>
+#include <future>
+#include <memory>
 #include <vector>
 #include <stdio.h>
 #include <cassert>
+#include <chrono>
+#include <sstream>
+#include <iomanip>
 #include <iostream>
 #include <algorithm>
 #include <stdexcept>
@@ -24,6 +37,19 @@
 namespace openMVG_ofx {
 namespace LensCalibration {
 
+namespace bfs = boost::filesystem;
+
+namespace {
+
+/**
+ * @brief Time of a File Source frame among the main lens frames, after any main source time
+ */
+OfxTime getFileFrameTime(OfxTime fileFrame)
+{
+  return 1e7 + fileFrame;
+}
+
+} //namespace
 
 LensCalibrationPlugin::LensCalibrationPlugin(OfxImageEffectHandle handle)
   : OFX::ImageEffect(handle)
@@ -37,11 +63,79 @@ LensCalibrationPlugin::LensCalibrationPlugin(OfxImageEffectHandle handle)
   _outputParams.push_back(_outputLensDistortionRadialCoef3);
   _outputParams.push_back(_outputLensDistortionTangentialCoef1);
   _outputParams.push_back(_outputLensDistortionTangentialCoef2);
+
+  const std::size_t nbExtraInputs = getMaxNbExtraInputs();
+  _inputs.resize(2 + nbExtraInputs);
+  _extraOutputParams.resize(nbExtraInputs);
+  _inputs[0].clip = _srcClip;
+  _inputs[0].cache = _detectionsCache;
+  _inputs[getFileInput()].cache = _fileDetectionsCache;
+  for(std::size_t input = 0; input < nbExtraInputs; ++input)
+  {
+    //The rig sources are only defined in the general context
+    if(getContext() == OFX::eContextGeneral)
+      _inputs[1 + input].clip = fetchClip(kClipExtraSource(input));
+    _inputs[1 + input].cache = fetchStringParam(kParamExtraDetectionsCache(input));
+
+    ExtraOutputParams &outputParams = _extraOutputParams[input];
+    outputParams.isCalibrated = fetchBooleanParam(kParamExtraOutputIsCalibrated(input));
+    outputParams.avgReprojErr = fetchDoubleParam(kParamExtraOutputAvgReprojErr(input));
+    outputParams.focalLength = fetchDoubleParam(kParamExtraOutputFocalLength(input));
+    outputParams.principalPoint = fetchDouble2DParam(kParamExtraOutputPrincipalPoint(input));
+    outputParams.radialCoef1 = fetchDoubleParam(kParamExtraOutputRadialCoef1(input));
+    outputParams.radialCoef2 = fetchDoubleParam(kParamExtraOutputRadialCoef2(input));
+    outputParams.radialCoef3 = fetchDoubleParam(kParamExtraOutputRadialCoef3(input));
+    outputParams.tangentialCoef1 = fetchDoubleParam(kParamExtraOutputTangentialCoef1(input));
+    outputParams.tangentialCoef2 = fetchDoubleParam(kParamExtraOutputTangentialCoef2(input));
+    _outputParams.push_back(outputParams.isCalibrated);
+    _outputParams.push_back(outputParams.avgReprojErr);
+    _outputParams.push_back(outputParams.focalLength);
+    _outputParams.push_back(outputParams.principalPoint);
+    _outputParams.push_back(outputParams.radialCoef1);
+    _outputParams.push_back(outputParams.radialCoef2);
+    _outputParams.push_back(outputParams.radialCoef3);
+    _outputParams.push_back(outputParams.tangentialCoef1);
+    _outputParams.push_back(outputParams.tangentialCoef2);
+  }
+
+  _patternKey = getPatternKey(getDetectionSettings());
+  for(std::size_t input = 0; input < _inputs.size(); ++input)
+    loadDetections(input);
+  const OfxPointI imageSize(_inputImageSize->getValue());
+  _inputs[0].imageSize = cv::Size(imageSize.x, imageSize.y);
+
+  //One folder per instance, the frames of the instances don't mix
+  boost::system::error_code error;
+  const bfs::path tempFolder = bfs::temp_directory_path(error);
+  if(!error)
+    _debugSourceFolder = (tempFolder / bfs::unique_path("ofxMVG_lensCalibration_%%%%-%%%%-%%%%-%%%%")).string();
+}
+
+LensCalibrationPlugin::~LensCalibrationPlugin()
+{
+  //The tasks use the instance data
+  if(_calibrationTask)
+  {
+    _calibrationTask->isCanceled = true;
+    _calibrationTask->future.wait();
+  }
+  for(const std::unique_ptr<CalibrationTask>& task : _canceledCalibrationTasks)
+    task->future.wait();
+  resetLiveCalibration();
+  //The debug writes read the kept frames
+  _debugImageWriter.flush();
+  if(!_debugSourceFolder.empty())
+  {
+    boost::system::error_code error;
+    bfs::remove_all(_debugSourceFolder, error);
+  }
 }
 
 void LensCalibrationPlugin::syncPrivateData()
 {
-  std::cout << "LensCalibrationPlugin::syncPrivateData" << std::endl;
+  OFXMVG_LOG_DEBUG("syncPrivateData") << "LensCalibrationPlugin::syncPrivateData";
+  updateBackgroundStatus();
+  saveDetections();
 }
 
 void LensCalibrationPlugin::beginSequenceRender(const OFX::BeginSequenceRenderArguments &args)
@@ -51,184 +145,734 @@ void LensCalibrationPlugin::beginSequenceRender(const OFX::BeginSequenceRenderAr
 
 void LensCalibrationPlugin::endSequenceRender(const OFX::EndSequenceRenderArguments &args)
 {
+  flushDebugImages();
 
+  //Write the sequence timeline
+  if(Common::Tracer::instance().isEnabled())
+    Common::Tracer::instance().flush();
 }
 
 void LensCalibrationPlugin::render(const OFX::RenderArguments &args)
 {
-  std::cout << "render : time: " << args.time << std::endl;
-  std::cout << "render : fieldToRender: " << args.fieldToRender << std::endl;
-  std::cout << "render : renderQualityDraft: " << args.renderQualityDraft << std::endl;
-  std::cout << "render : renderScale: " << args.renderScale.x << ", " << args.renderScale.y << std::endl;
-  std::cout << "render : interactiveRenderStatus: " << args.interactiveRenderStatus << std::endl;
-  std::cout << "render : args.renderWindow: (" << args.renderWindow.x1 << ", " << args.renderWindow.y1 << "), (" << args.renderWindow.x2 << ", "  << args.renderWindow.y2 << ")" << std::endl;
+  OFXMVG_TRACE_SCOPE("lensCalibration.render");
+  OFXMVG_LOG_DEBUG("render") << "begin"
+    << Common::kv("time", args.time)
+    << Common::kv("fieldToRender", args.fieldToRender)
+    << Common::kv("renderQualityDraft", args.renderQualityDraft)
+    << Common::kv("renderScale.x", args.renderScale.x)
+    << Common::kv("renderScale.y", args.renderScale.y)
+    << Common::kv("interactiveRenderStatus", args.interactiveRenderStatus)
+    << Common::kv("renderWindow.x1", args.renderWindow.x1)
+    << Common::kv("renderWindow.y1", args.renderWindow.y1)
+    << Common::kv("renderWindow.x2", args.renderWindow.x2)
+    << Common::kv("renderWindow.y2", args.renderWindow.y2);
 
   if(abort())
   {
-    std::cout << "render : abort" << std::endl;
+    OFXMVG_LOG_DEBUG("render") << "abort" << Common::kv("time", args.time);
     return;
   }
-  OFX::Image *inputPtr = _srcClip->fetchImage(args.time);
-  if(inputPtr == NULL)
+  //Common::Image doesn't own the fetched images
+  std::unique_ptr<OFX::Image> inputPtr(_srcClip->fetchImage(args.time));
+  if(!inputPtr)
   {
-    std::cout << "Input image is NULL" << std::endl;
+    OFXMVG_LOG_ERROR("render") << "input image is NULL" << Common::kv("time", args.time);
     return;
   }
-  const Common::Image<float> inputImageOFX(inputPtr, Common::eOrientationTopDown);
+  const Common::Image<float> inputImageOFX(inputPtr.get(), Common::eOrientationTopDown);
 
   if(_outputIsCalibrated->getValue())
   {
-    OfxPointD principalPoint = _outputCameraPrincipalPointOffset->getValue();
-    // Lens already calibrated, directly undistort the input image
-    openMVG::cameras::Pinhole_Intrinsic_Radial_K3 camera(inputImageOFX.getWidth(),
-                                                         inputImageOFX.getHeight(),
-                                                         _outputCameraFocalLenght->getValue(),
-                                                         principalPoint.x,
-                                                         principalPoint.y,
-                                                         _outputLensDistortionRadialCoef1->getValue(),
-                                                         _outputLensDistortionRadialCoef2->getValue(),
-                                                         _outputLensDistortionRadialCoef3->getValue());
-
-    openMVG::image::Image<openMVG::image::RGBfColor> inputImageMVG;
-    convertRGBImage(inputImageOFX, inputImageMVG);
-    openMVG::image::Image<openMVG::image::RGBfColor> outputImageMVG;
-    openMVG::cameras::UndistortImage(inputImageMVG, &camera, outputImageMVG);
-    
-    OFX::Image *outputPtr = _dstClip->fetchImage(args.time);
-    if(outputPtr == NULL)
+    // Lens already calibrated, directly undistort the input image or output the ST-map
+    std::unique_ptr<OFX::Image> outputPtr(_dstClip->fetchImage(args.time));
+    if(!outputPtr)
     {
-      std::cout << "Output image is NULL" << std::endl;
+      OFXMVG_LOG_ERROR("render") << "output image is NULL" << Common::kv("time", args.time);
       return;
     }
-    Common::Image<float> outputImageOFX(outputPtr, Common::eOrientationTopDown);
-    convertRGBImage(inputImageMVG, outputImageOFX);
+    Common::Image<float> outputImageOFX(outputPtr.get(), Common::eOrientationTopDown);
+    if(outputImageOFX.getWidth() != inputImageOFX.getWidth() || outputImageOFX.getHeight() != inputImageOFX.getHeight())
+    {
+      OFXMVG_LOG_ERROR("render") << "input and output images don't have the same size" << Common::kv("time", args.time);
+      return;
+    }
+
+    const EParamOutputMode outputMode = EParamOutputMode(_outputMode->getValue());
+    const cv::Size imageSize(static_cast<int>(outputImageOFX.getWidth()), static_cast<int>(outputImageOFX.getHeight()));
+    const std::shared_ptr<const UndistortMap> undistortMap = getUndistortMap(imageSize, args.renderScale, outputMode == eParamOutputModeRedistortSTMap);
+    if(outputMode == eParamOutputModeUndistort)
+      undistortImage(inputImageOFX, *undistortMap, outputImageOFX);
+    else
+      writeSTMap(*undistortMap, outputImageOFX);
   }
   else
   {
     bool found = false;
+    bool isDetected = false;
+    bool isFirstFrame = false;
+    std::size_t nbDetectedFrames = 0;
+    {
+      std::lock_guard<std::mutex> lock(_checkerMutex);
+      isDetected = (_inputs[0].checkerPerFrame.count(args.time) != 0);
+      isFirstFrame = isMainLensEmpty();
+      nbDetectedFrames = _inputs[0].checkerPerFrame.size();
+    }
     // Detect checkerboard for calibration
-    if(checkerPerFrame.count(args.time) == 0) // if not already extracted
+    if(!isDetected) // if not already extracted
     {
-      std::cout << "Detect checkerboard for calibration at frame " << args.time << std::endl;
-      std::cout << "checkerPerFrame.size(): " << checkerPerFrame.size() << std::endl;
-      OfxPointI imageSizeParamValue(_inputImageSize->getValue());
-      OfxPointI imageSizeMVG{static_cast<int>(inputImageOFX.getWidth()), static_cast<int>(inputImageOFX.getHeight())};
-      if(checkerPerFrame.empty())
-        // If no checkerboard collected, initialize with the current image size
-        _inputImageSize->setValue(inputImageOFX.getWidth(), inputImageOFX.getHeight());
-      else if(imageSizeParamValue.x != imageSizeMVG.x || imageSizeParamValue.y != imageSizeMVG.y)
+      OFXMVG_LOG_DEBUG("render") << "detect pattern"
+        << Common::kv("time", args.time)
+        << Common::kv("nbDetectedFrames", nbDetectedFrames);
+      // If no checkerboard collected, initialize with the current image size
+      const cv::Size frameSize(static_cast<int>(inputImageOFX.getWidth()), static_cast<int>(inputImageOFX.getHeight()));
+      if(!checkImageSize(frameSize, isFirstFrame))
       {
-        std::cerr << "All images don't have the same size." << std::endl;
+        OFXMVG_LOG_ERROR("render") << "all images don't have the same size" << Common::kv("time", args.time);
 //        throw std::logic_error("All images don't have the same size.");
         return;
       }
 
-      cv::Mat cvInputGrayImage(inputImageOFX.getHeight(), inputImageOFX.getWidth(), cv::DataType<unsigned char>::type);
-      if(_inputImageIsGray->getValue())
+      const DetectionSettings detectionSettings = getDetectionSettings();
+      initLiveCalibration();
+      OFXMVG_LOG_TRACE("render") << "pattern"
+        << Common::kv("width", detectionSettings.boardSize.width)
+        << Common::kv("height", detectionSettings.boardSize.height)
+        << Common::kv("inputPatternType", int(detectionSettings.patternType))
+        << Common::kv("maxDetectionSize", detectionSettings.maxDetectionSize);
+      cv::Mat grayImage;
+      convertToGRAY8(inputImageOFX, detectionSettings.isGray, grayImage);
+      std::uint64_t hash = 0;
+      const bool isAccepted = filterFrame(0, args.time, grayImage, getFrameFilterSettings(), hash);
+      std::vector<cv::Point2f> checkerPoints;
+      const bool isTracking = isAccepted && _inputTrackPattern->getValue();
+      bool tracked = false;
+      if(isTracking)
       {
-        convertGGG32ToGRAY8(inputImageOFX, cvInputGrayImage);
+        std::lock_guard<std::mutex> lock(_trackingMutex);
+        if(_trackingFrame.isValid && std::abs(args.time - _trackingFrame.time) <= 1.0)
+          tracked = trackPattern(_trackingFrame.grayImage, _trackingFrame.points, grayImage, detectionSettings, checkerPoints);
       }
-      else
+      found = isAccepted && (tracked || detectPattern(grayImage, detectionSettings, checkerPoints));
+      if(isTracking)
       {
-        convertRGB32ToGRAY8(inputImageOFX, cvInputGrayImage);
+        std::lock_guard<std::mutex> lock(_trackingMutex);
+        _trackingFrame.isValid = found;
+        _trackingFrame.time = args.time;
+        _trackingFrame.grayImage = grayImage;
+        _trackingFrame.points = checkerPoints;
+        if(tracked)
+          ++_nbTrackedFrames;
+        OFXMVG_LOG_DEBUG("render") << (tracked ? "pattern tracked" : "pattern searched")
+          << Common::kv("time", args.time)
+          << Common::kv("nbTrackedFrames", _nbTrackedFrames);
       }
-
-      OfxPointI p(_inputPatternSize->getValue());
-      cv::Size boardSize(p.x, p.y);
-      std::cout << "inputPatternSize: " << boardSize.width << ", " << boardSize.height << std::endl;
-      EParamPatternType inputPatternType = EParamPatternType(_inputPatternType->getValue());
-      std::cout << "inputPatternType: " << int(inputPatternType) << std::endl;
-      openMVG::calibration::Pattern patternType = getPatternType(inputPatternType);
-      std::cout << "patternType openMVG: " << int(patternType) << std::endl;
-      std::vector<cv::Point2f> checkerPoints;
-      found = openMVG::calibration::findPattern(patternType, cvInputGrayImage, boardSize, checkerPoints);
       if(found)
-        checkerPerFrame[args.time] = checkerPoints;
+      {
+        nbDetectedFrames = addDetectedFrame(0, args.time, checkerPoints, hash, getPatternKey(detectionSettings));
+        if(_debugEnable->getValue())
+          saveDebugSource(args.time, grayImage);
+      }
     }
-    OFX::Image *outputPtr = _dstClip->fetchImage(args.time);
-    if(outputPtr == NULL)
+    std::unique_ptr<OFX::Image> outputPtr(_dstClip->fetchImage(args.time));
+    if(!outputPtr)
     {
-      std::cout << "Output image is NULL" << std::endl;
+      OFXMVG_LOG_ERROR("render") << "output image is NULL" << Common::kv("time", args.time);
       return;
     }
-    Common::Image<float> outputImage(outputPtr, Common::eOrientationTopDown);
+    Common::Image<float> outputImage(outputPtr.get(), Common::eOrientationTopDown);
     outputImage.copyFrom(inputImageOFX);
 
-    if(found)
-      std::cout << "Checker found at time " << args.time << "." << std::endl;
-    else
-      std::cout << "Checker NOT found at time " << args.time << "." << std::endl;
-
-    std::cout << "checkerPerFrame.size(): " << checkerPerFrame.size() << std::endl;
-    std::cout << "checkerPerFrame.at(time).size(): " << checkerPerFrame.at(args.time).size() << std::endl;
+    OFXMVG_LOG_DEBUG("render") << "pattern " << (found ? "found" : "not found")
+      << Common::kv("time", args.time)
+      << Common::kv("nbDetectedFrames", nbDetectedFrames);
     // TODO: export number of images for calibration to a user parameter
   }
 }
 
-void LensCalibrationPlugin::calibrateLens()
+DetectionSettings LensCalibrationPlugin::getDetectionSettings() const
 {
-  if(checkerPerFrame.empty())
-    throw std::logic_error("No checkerboard detected.");
-  
+  DetectionSettings settings;
+  settings.isGray = _inputImageIsGray->getValue();
   OfxPointI p(_inputPatternSize->getValue());
-  cv::Size boardSize(p.x, p.y);
-  EParamPatternType inputPatternType = EParamPatternType(_inputPatternType->getValue());
-  openMVG::calibration::Pattern patternType = getPatternType(inputPatternType);
-  
-  std::vector<std::size_t> remainingImagesIndexes(checkerPerFrame.size());
-  std::vector<float> calibImageScore;
-  std::vector<std::size_t> calibInputFrames;
-  std::vector<std::vector<cv::Point2f> > calibImagePoints;
-  std::vector<long unsigned int> validFrames;
-  std::vector<std::vector<cv::Point2f> > imagePoints;
-  
-  OfxPointI imageSizeValue(_inputImageSize->getValue());
-  cv::Size imageSize(imageSizeValue.x, imageSizeValue.y);
+  settings.boardSize = cv::Size(p.x, p.y);
+  settings.patternType = EParamPatternType(_inputPatternType->getValue());
+  settings.maxDetectionSize = _inputDetectionMaxSize->getValue();
+  return settings;
+}
 
-  for (std::map<OfxTime, std::vector<cv::Point2f> >::iterator it = checkerPerFrame.begin(); it != checkerPerFrame.end(); ++it)
+FrameFilterSettings LensCalibrationPlugin::getFrameFilterSettings() const
+{
+  FrameFilterSettings settings;
+  settings.minHashDistance = _inputMinHashDistance->getValue();
+  settings.minSharpness = _inputMinSharpness->getValue();
+  return settings;
+}
+
+bool LensCalibrationPlugin::filterFrame(std::size_t input, OfxTime time, const cv::Mat& grayImage, const FrameFilterSettings& settings, std::uint64_t& hash)
+{
+  OFXMVG_TRACE_SCOPE("lensCalibration.filterFrame");
+  InputDetections &detections = _inputs[input];
+  hash = computeImageHash(grayImage);
+  if(settings.minHashDistance > 0)
   {
-    validFrames.push_back(it->first);
-    imagePoints.push_back(it->second);
+    std::lock_guard<std::mutex> lock(_checkerMutex);
+    for(const auto& detectedHash : detections.hashPerFrame)
+    {
+      if(getHashDistance(hash, detectedHash.second) < settings.minHashDistance)
+      {
+        detections.duplicateFrames.insert(time);
+        OFXMVG_LOG_DEBUG("filterFrame") << "duplicated frame skipped"
+          << Common::kv("input", input)
+          << Common::kv("time", time)
+          << Common::kv("detectedTime", detectedHash.first)
+          << Common::kv("nbDuplicateFrames", detections.duplicateFrames.size());
+        return false;
+      }
+    }
   }
-  
-  openMVG::calibration::selectBestImages(imagePoints, imageSize, remainingImagesIndexes, _inputMaxCalibFrames->getValue(),
-                                        validFrames, calibImageScore, calibInputFrames, calibImagePoints, _inputCalibGridSize->getValue());
-  
-  std::vector<std::vector<cv::Point3f> > calibObjectPoints;
-  openMVG::calibration::computeObjectPoints(boardSize, patternType, _inputSquareSize->getValue(), calibImagePoints, calibObjectPoints);
-
-  int cvCalibFlags = 0;
-  double totalAvgErr = 0;
-  std::vector<cv::Mat> rvecs;
-  float aspectRatio = 1.f;
-  std::vector<cv::Mat> tvecs;
-  std::vector<float> reprojErrs;
-  std::vector<std::size_t> rejectInputFrames;
-  
-  cvCalibFlags |= CV_CALIB_ZERO_TANGENT_DIST;
-  const std::array<int, 6> fixDistortionCoefs = {CV_CALIB_FIX_K1, CV_CALIB_FIX_K2, CV_CALIB_FIX_K3, CV_CALIB_FIX_K4, CV_CALIB_FIX_K5, CV_CALIB_FIX_K6};
-  for (int i = _inputNbRadialCoef->getValue(); i < 6; ++i)
-      cvCalibFlags |= fixDistortionCoefs[i];
-  
-  cv::Mat distCoeffs;
-  cv::Mat cameraMatrix;
-  bool isCalibrated = openMVG::calibration::calibrationIterativeOptimization(calibImagePoints,
-                                                                             calibObjectPoints,
-                                                                             imageSize,
-                                                                             aspectRatio,
-                                                                             cvCalibFlags,
-                                                                             cameraMatrix,
-                                                                             distCoeffs,
-                                                                             rvecs,
-                                                                             tvecs,
-                                                                             reprojErrs,
-                                                                             totalAvgErr, 
-                                                                             _inputMaxTotalAvgErr->getValue(),
-                                                                             _inputMinInputFrames->getValue(),
-                                                                             calibInputFrames,
-                                                                             calibImageScore,
-                                                                             rejectInputFrames);
-  
+  //The sharpness filter costs a pass on the full image, after the cheap hash test
+  if(settings.minSharpness > 0.0)
+  {
+    const double sharpness = computeSharpness(grayImage);
+    if(sharpness < settings.minSharpness)
+    {
+      std::lock_guard<std::mutex> lock(_checkerMutex);
+      detections.blurredFrames.insert(time);
+      OFXMVG_LOG_DEBUG("filterFrame") << "blurred frame skipped"
+        << Common::kv("input", input)
+        << Common::kv("time", time)
+        << Common::kv("sharpness", sharpness)
+        << Common::kv("nbBlurredFrames", detections.blurredFrames.size());
+      return false;
+    }
+  }
+  std::lock_guard<std::mutex> lock(_checkerMutex);
+  detections.duplicateFrames.erase(time);
+  detections.blurredFrames.erase(time);
+  return true;
+}
+
+std::size_t LensCalibrationPlugin::addDetectedFrame(std::size_t input, OfxTime time, const std::vector<cv::Point2f>& points, std::uint64_t hash, const PatternKey& patternKey)
+{
+  InputDetections &detections = _inputs[input];
+  std::size_t nbDetectedFrames = 0;
+  {
+    std::lock_guard<std::mutex> lock(_checkerMutex);
+    if(patternKey != _patternKey)
+      return detections.checkerPerFrame.size();
+    detections.checkerPerFrame[time] = points;
+    detections.hashPerFrame[time] = hash;
+    detections.isDetectionsModified = true;
+    nbDetectedFrames = detections.checkerPerFrame.size();
+  }
+  if(input == 0)
+    addLiveFrame(time, points);
+  else if(input == getFileInput())
+    addLiveFrame(getFileFrameTime(time), points);
+  return nbDetectedFrames;
+}
+
+void LensCalibrationPlugin::loadDetections(std::size_t input)
+{
+  InputDetections &detections = _inputs[input];
+  const std::string serializedDetections = detections.cache->getValue();
+  if(serializedDetections.empty())
+    return;
+
+  OFXMVG_TRACE_SCOPE("lensCalibration.loadDetections");
+  std::map<PatternKey, PatternDetections> detectionsPerPattern;
+  try
+  {
+    deserializeDetections(serializedDetections, detectionsPerPattern);
+  }
+  catch(std::exception &e)
+  {
+    sendMessage(OFX::Message::eMessageWarning, "lenscalibration.loaddetections", "Can't load the pattern detections cache : " + std::string(e.what()));
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(_checkerMutex);
+  detections.detectionsPerPattern = std::move(detectionsPerPattern);
+  PatternDetections &patternDetections = detections.detectionsPerPattern[_patternKey];
+  detections.checkerPerFrame = std::move(patternDetections.checkerPerFrame);
+  detections.hashPerFrame = std::move(patternDetections.hashPerFrame);
+  detections.detectionsPerPattern.erase(_patternKey);
+  detections.isDetectionsModified = false;
+  OFXMVG_LOG_INFO("loadDetections") << "pattern detections loaded from the cache"
+    << Common::kv("input", input)
+    << Common::kv("nbPatterns", detections.detectionsPerPattern.size() + (detections.checkerPerFrame.empty() ? 0 : 1))
+    << Common::kv("nbDetectedFrames", detections.checkerPerFrame.size());
+}
+
+void LensCalibrationPlugin::saveDetections()
+{
+  for(InputDetections &detections : _inputs)
+  {
+    std::string serializedDetections;
+    {
+      std::lock_guard<std::mutex> lock(_checkerMutex);
+      if(!detections.isDetectionsModified)
+        continue;
+      OFXMVG_TRACE_SCOPE("lensCalibration.saveDetections");
+      std::map<PatternKey, PatternDetections> detectionsPerPattern = detections.detectionsPerPattern;
+      if(!detections.checkerPerFrame.empty())
+      {
+        PatternDetections &patternDetections = detectionsPerPattern[_patternKey];
+        patternDetections.checkerPerFrame = detections.checkerPerFrame;
+        patternDetections.hashPerFrame = detections.hashPerFrame;
+      }
+      serializedDetections = serializeDetections(detectionsPerPattern);
+      detections.isDetectionsModified = false;
+    }
+    detections.cache->setValue(serializedDetections);
+    Common::traceCounter("detectionsCacheBytes", serializedDetections.size());
+  }
+}
+
+void LensCalibrationPlugin::updatePattern()
+{
+  const PatternKey patternKey = getPatternKey(getDetectionSettings());
+  std::lock_guard<std::mutex> lock(_checkerMutex);
+  if(patternKey == _patternKey)
+    return;
+
+  //Keep the current detections, restore the ones of the new pattern
+  for(InputDetections &detections : _inputs)
+  {
+    if(!detections.checkerPerFrame.empty())
+    {
+      PatternDetections &previousDetections = detections.detectionsPerPattern[_patternKey];
+      previousDetections.checkerPerFrame = std::move(detections.checkerPerFrame);
+      previousDetections.hashPerFrame = std::move(detections.hashPerFrame);
+    }
+    PatternDetections &patternDetections = detections.detectionsPerPattern[patternKey];
+    detections.checkerPerFrame = std::move(patternDetections.checkerPerFrame);
+    detections.hashPerFrame = std::move(patternDetections.hashPerFrame);
+    detections.detectionsPerPattern.erase(patternKey);
+    detections.duplicateFrames.clear();
+    detections.blurredFrames.clear();
+  }
+  _patternKey = patternKey;
+  {
+    std::lock_guard<std::mutex> trackingLock(_trackingMutex);
+    _trackingFrame.isValid = false;
+  }
+  OFXMVG_LOG_DEBUG("updatePattern") << "pattern changed"
+    << Common::kv("nbDetectedFrames", _inputs[0].checkerPerFrame.size());
+}
+
+CalibrationSettings LensCalibrationPlugin::getCalibrationSettings() const
+{
+  CalibrationSettings settings;
+  {
+    std::lock_guard<std::mutex> lock(_checkerMutex);
+    settings.imageSize = _inputs[0].imageSize;
+  }
+  OfxPointI p(_inputPatternSize->getValue());
+  settings.boardSize = cv::Size(p.x, p.y);
+  settings.patternType = EParamPatternType(_inputPatternType->getValue());
+  settings.squareSize = _inputSquareSize->getValue();
+  settings.nbRadialCoef = _inputNbRadialCoef->getValue();
+  settings.maxCalibFrames = _inputMaxCalibFrames->getValue();
+  settings.calibGridSize = _inputCalibGridSize->getValue();
+  settings.minInputFrames = _inputMinInputFrames->getValue();
+  settings.maxTotalAvgErr = _inputMaxTotalAvgErr->getValue();
+  settings.nbStarts = std::max(1, _inputCalibNbStarts->getValue());
+  settings.solver = EParamCalibSolver(_inputCalibSolver->getValue());
+  return settings;
+}
+
+bool LensCalibrationPlugin::checkImageSize(const cv::Size& frameSize, bool isFirstFrame)
+{
+  {
+    std::lock_guard<std::mutex> lock(_checkerMutex);
+    if(!isFirstFrame || _inputs[0].imageSize == frameSize)
+      return _inputs[0].imageSize == frameSize;
+    _inputs[0].imageSize = frameSize;
+  }
+  //The live solver is created with the image size, it has no frame yet
+  resetLiveCalibration();
+  return true;
+}
+
+std::map<OfxTime, std::vector<cv::Point2f> > LensCalibrationPlugin::getMainLensCheckers() const
+{
+  std::lock_guard<std::mutex> lock(_checkerMutex);
+  std::map<OfxTime, std::vector<cv::Point2f> > checkers = _inputs[0].checkerPerFrame;
+  for(const auto& checker : _inputs[getFileInput()].checkerPerFrame)
+    checkers[getFileFrameTime(checker.first)] = checker.second;
+  return checkers;
+}
+
+bool LensCalibrationPlugin::isMainLensEmpty() const
+{
+  return _inputs[0].checkerPerFrame.empty() && _inputs[getFileInput()].checkerPerFrame.empty();
+}
+
+void LensCalibrationPlugin::updateImageSizeParam()
+{
+  cv::Size imageSize;
+  {
+    std::lock_guard<std::mutex> lock(_checkerMutex);
+    imageSize = _inputs[0].imageSize;
+  }
+  const OfxPointI imageSizeValue(_inputImageSize->getValue());
+  if(imageSizeValue.x != imageSize.width || imageSizeValue.y != imageSize.height)
+    _inputImageSize->setValue(imageSize.width, imageSize.height);
+}
+
+void LensCalibrationPlugin::startCalibration()
+{
+  OFXMVG_TRACE_SCOPE("lensCalibration.startCalibration");
+  CalibrationSettings settings = getCalibrationSettings();
+
+  //Warm start from the live estimate, or from a previous calibration
+  {
+    std::lock_guard<std::mutex> lock(_liveCalibration.mutex);
+    if(_liveCalibration.result.isCalibrated)
+    {
+      settings.initialCameraMatrix = _liveCalibration.result.cameraMatrix.clone();
+      settings.initialDistCoeffs = _liveCalibration.result.distCoeffs.clone();
+    }
+  }
+  if(settings.initialCameraMatrix.empty() && _outputCameraFocalLenght->getValue() > 0.0)
+  {
+    const OfxPointD principalPoint = _outputCameraPrincipalPointOffset->getValue();
+    const OfxPointD tangentialCoefs{_outputLensDistortionTangentialCoef1->getValue(), _outputLensDistortionTangentialCoef2->getValue()};
+    getCalibrationMatrices(_outputCameraFocalLenght->getValue(),
+                           cv::Point2d(principalPoint.x, principalPoint.y),
+                           cv::Vec3d(_outputLensDistortionRadialCoef1->getValue(),
+                                     _outputLensDistortionRadialCoef2->getValue(),
+                                     _outputLensDistortionRadialCoef3->getValue()),
+                           cv::Vec2d(tangentialCoefs.x, tangentialCoefs.y),
+                           settings.initialCameraMatrix,
+                           settings.initialDistCoeffs);
+  }
+
+  //One lens per source: the rig sources share the pattern and the calibration settings
+  //The File Source frames are main lens frames
+  std::vector<std::map<OfxTime, std::vector<cv::Point2f> > > checkersPerInput(getFileInput());
+  std::vector<CalibrationSettings> settingsPerInput(getFileInput());
+  checkersPerInput[0] = getMainLensCheckers();
+  {
+    std::lock_guard<std::mutex> lock(_checkerMutex);
+    for(std::size_t input = 1; input < getFileInput(); ++input)
+      checkersPerInput[input] = _inputs[input].checkerPerFrame;
+  }
+  const std::map<OfxTime, std::vector<cv::Point2f> > &checkers = checkersPerInput[0];
+  if(checkers.empty())
+  {
+    sendMessage(OFX::Message::eMessageError, "nocheckerboard", "No checkerboard detected.");
+    return;
+  }
+  settingsPerInput[0] = settings;
+  std::size_t nbExtraInputs = 0;
+  for(std::size_t input = 1; input < getFileInput(); ++input)
+  {
+    const InputDetections &detections = _inputs[input];
+    if(checkersPerInput[input].empty() || !detections.clip || !detections.clip->isConnected())
+    {
+      checkersPerInput[input].clear();
+      continue;
+    }
+    //The warm start only applies to the main lens
+    CalibrationSettings &extraSettings = settingsPerInput[input];
+    extraSettings = settings;
+    extraSettings.initialCameraMatrix = cv::Mat();
+    extraSettings.initialDistCoeffs = cv::Mat();
+    extraSettings.imageSize = detections.imageSize;
+    if(extraSettings.imageSize.area() == 0)
+    {
+      const OfxRectD rod = detections.clip->getRegionOfDefinition(checkersPerInput[input].begin()->first);
+      extraSettings.imageSize = cv::Size(static_cast<int>(rod.x2 - rod.x1), static_cast<int>(rod.y2 - rod.y1));
+    }
+    ++nbExtraInputs;
+  }
+
+  //The lenses share the worker pool: each calibration gets its part of the threads
+  const std::size_t nbThreadsPerInput = std::max<std::size_t>(1, Common::ThreadPool::instance().getNbThreads() / (1 + nbExtraInputs));
+  for(CalibrationSettings &inputSettings : settingsPerInput)
+    inputSettings.nbThreads = nbThreadsPerInput;
+
+  _calibrationTask.reset(new CalibrationTask());
+  CalibrationTask *task = _calibrationTask.get();
+  task->nbInputFrames = std::min(checkers.size(), settings.maxCalibFrames);
+  task->minInputFrames = settings.minInputFrames;
+  task->nbStarts = settings.nbStarts;
+  task->extraResults.resize(_extraOutputParams.size());
+  task->future = Common::ThreadPool::instance().submit([task, settingsPerInput, checkersPerInput]()
+  {
+    //The main lens reports the progress, the rig lenses are calibrated alongside
+    Common::ThreadPool::instance().parallelFor(0, checkersPerInput.size(), [&](std::size_t input)
+    {
+      if(input == 0)
+      {
+        LensCalibration::calibrateLens(settingsPerInput[0], checkersPerInput[0], task->result, [task](const CalibrationProgress& progress)
+        {
+          OFXMVG_LOG_DEBUG("calibrateLens") << "iteration"
+            << Common::kv("iteration", progress.iteration)
+            << Common::kv("nbFrames", progress.nbFrames)
+            << Common::kv("totalAvgErr", progress.totalAvgErr);
+          std::lock_guard<std::mutex> lock(task->mutex);
+          task->progress = progress;
+          task->isProgressUpdated = true;
+          return !task->isCanceled;
+        });
+        return;
+      }
+      if(checkersPerInput[input].empty())
+        return;
+      //A rig lens failure doesn't invalidate the other lenses
+      CalibrationResult &extraResult = task->extraResults[input - 1];
+      try
+      {
+        LensCalibration::calibrateLens(settingsPerInput[input], checkersPerInput[input], extraResult, [task](const CalibrationProgress&)
+        {
+          return !task->isCanceled;
+        });
+      }
+      catch(std::exception &e)
+      {
+        OFXMVG_LOG_ERROR("calibrateLens") << e.what() << Common::kv("input", input);
+        extraResult = CalibrationResult();
+      }
+    });
+  });
+
+  _outputCalibrate->setEnabled(false);
+  _cancelCalibration->setEnabled(true);
+  _calibrationProgress->setValue(0.0);
+  _calibrationStatus->setValue("Selecting " + std::to_string(task->nbInputFrames) + " frames among " + std::to_string(checkers.size()));
+  OFXMVG_LOG_INFO("calibrateLens") << "calibration started"
+    << Common::kv("nbDetectedFrames", checkers.size())
+    << Common::kv("nbExtraInputs", nbExtraInputs);
+}
+
+void LensCalibrationPlugin::initLiveCalibration()
+{
+  if(!_inputLiveCalibration->getValue())
+    return;
+  {
+    std::lock_guard<std::mutex> lock(_liveCalibration.mutex);
+    if(_liveCalibration.solver)
+      return;
+    _liveCalibration.solver.reset(new IncrementalCalibration(getCalibrationSettings()));
+  }
+  //The frames detected before are used by the first update
+  for(const auto& checker : getMainLensCheckers())
+    addLiveFrame(checker.first, checker.second);
+}
+
+void LensCalibrationPlugin::addLiveFrame(OfxTime time, const std::vector<cv::Point2f>& points)
+{
+  const std::size_t kUpdateStep = 5; //new frames between two updates
+
+  std::lock_guard<std::mutex> lock(_liveCalibration.mutex);
+  if(!_liveCalibration.solver)
+    return;
+  _liveCalibration.newFrames[time] = points;
+  if(_liveCalibration.isUpdating || _liveCalibration.newFrames.size() < kUpdateStep)
+    return;
+
+  //A single update runs at a time, it takes the frames added meanwhile
+  _liveCalibration.isUpdating = true;
+  IncrementalCalibration *solver = _liveCalibration.solver.get();
+  _liveCalibration.future = Common::ThreadPool::instance().submit([this, solver, kUpdateStep]()
+  {
+    LiveCalibration &live = _liveCalibration;
+    for(;;)
+    {
+      std::map<OfxTime, std::vector<cv::Point2f> > newFrames;
+      {
+        std::lock_guard<std::mutex> lock(live.mutex);
+        std::swap(newFrames, live.newFrames);
+      }
+      for(const auto& frame : newFrames)
+        solver->addFrame(frame.first, frame.second);
+      try
+      {
+        solver->update();
+      }
+      catch(std::exception &e)
+      {
+        OFXMVG_LOG_ERROR("liveCalibration") << e.what();
+      }
+
+      std::lock_guard<std::mutex> lock(live.mutex);
+      if(live.solver.get() == solver)
+      {
+        live.result = solver->getResult();
+        live.isResultUpdated = true;
+      }
+      if(live.solver.get() != solver || live.newFrames.size() < kUpdateStep)
+      {
+        live.isUpdating = false;
+        return;
+      }
+    }
+  });
+}
+
+void LensCalibrationPlugin::updateLiveCalibration()
+{
+  CalibrationResult result;
+  {
+    std::lock_guard<std::mutex> lock(_liveCalibration.mutex);
+    if(!_liveCalibration.isResultUpdated)
+      return;
+    result = _liveCalibration.result;
+    _liveCalibration.isResultUpdated = false;
+  }
+  if(!result.isCalibrated)
+    return;
+  _liveFocalLength->setValue(result.cameraMatrix.at<double>(0, 0));
+  _livePrincipalPoint->setValue(result.cameraMatrix.at<double>(0, 2), result.cameraMatrix.at<double>(1, 2));
+  _liveAvgReprojErr->setValue(result.totalAvgErr);
+  OFXMVG_LOG_DEBUG("liveCalibration") << "estimate updated"
+    << Common::kv("nbFrames", result.calibInputFrames.size())
+    << Common::kv("focal", result.cameraMatrix.at<double>(0, 0))
+    << Common::kv("totalAvgErr", result.totalAvgErr);
+}
+
+void LensCalibrationPlugin::resetLiveCalibration()
+{
+  //The running update owns the solver until it ends
+  std::unique_ptr<IncrementalCalibration> solver;
+  std::future<void> future;
+  {
+    std::lock_guard<std::mutex> lock(_liveCalibration.mutex);
+    solver = std::move(_liveCalibration.solver);
+    future = std::move(_liveCalibration.future);
+    _liveCalibration.newFrames.clear();
+    _liveCalibration.result = CalibrationResult();
+    _liveCalibration.isResultUpdated = false;
+  }
+  if(future.valid())
+    future.wait();
+}
+
+void LensCalibrationPlugin::updateBackgroundStatus()
+{
+  updateCalibrationTask();
+  updateLiveCalibration();
+
+  //Release the canceled tasks once stopped
+  _canceledCalibrationTasks.erase(std::remove_if(_canceledCalibrationTasks.begin(), _canceledCalibrationTasks.end(),
+    [](const std::unique_ptr<CalibrationTask>& task)
+    {
+      return task->future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }), _canceledCalibrationTasks.end());
+}
+
+std::string LensCalibrationPlugin::getCalibrationTaskStatus() const
+{
+  if(!_calibrationTask)
+    return std::string();
+  CalibrationTask &task = *_calibrationTask;
+  std::ostringstream status;
+  if(task.future.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+  {
+    std::lock_guard<std::mutex> lock(task.mutex);
+    status << "Calibrating: iteration " << task.progress.iteration
+           << ", " << task.progress.nbFrames << " frames"
+           << ", error " << task.progress.totalAvgErr << " px";
+    return status.str();
+  }
+  //The result is complete once the future is ready
+  if(task.result.isCalibrated)
+  {
+    status << "Calibrated: focal " << task.result.cameraMatrix.at<double>(0, 0) << " px"
+           << ", error " << task.result.totalAvgErr << " px";
+  }
+  else
+  {
+    status << "Not calibrated";
+  }
+  status << ", applied at the next interaction";
+  return status.str();
+}
+
+void LensCalibrationPlugin::cancelCalibration()
+{
+  if(!_calibrationTask)
+    return;
+  _calibrationTask->isCanceled = true;
+  _canceledCalibrationTasks.push_back(std::move(_calibrationTask));
+  _outputCalibrate->setEnabled(true);
+  _cancelCalibration->setEnabled(false);
+  _calibrationStatus->setValue("Canceled");
+  OFXMVG_LOG_INFO("calibrateLens") << "calibration canceled";
+}
+
+void LensCalibrationPlugin::updateCalibrationTask()
+{
+  //Parameters are set out of the lock: setValue calls back changedParam, the nested polls are skipped
+  _calibrationTaskPoller.poll(_calibrationTask,
+    [this](CalibrationTask &task)
+    {
+      bool isProgressUpdated = false;
+      CalibrationProgress progress;
+      {
+        std::lock_guard<std::mutex> lock(task.mutex);
+        std::swap(isProgressUpdated, task.isProgressUpdated);
+        progress = task.progress;
+      }
+      if(!isProgressUpdated)
+        return;
+      //The progress is the part of the frames rejected, the loop stops at minInputFrames
+      const std::size_t nbRemovableFrames = (task.nbInputFrames > task.minInputFrames) ? task.nbInputFrames - task.minInputFrames : 0;
+      const std::size_t nbRemovedFrames = (task.nbInputFrames > progress.nbFrames) ? task.nbInputFrames - progress.nbFrames : 0;
+      const double fraction = nbRemovableFrames ? std::min(1.0, double(nbRemovedFrames) / nbRemovableFrames) : 0.0;
+      std::ostringstream status;
+      if(task.nbStarts > 1)
+        status << "Start " << progress.start + 1 << "/" << task.nbStarts << ", ";
+      status << "Iteration " << progress.iteration
+             << ", " << progress.nbFrames << " frames"
+             << ", error " << progress.totalAvgErr << " px";
+      //Starts report concurrently, keep the progress monotonic
+      _calibrationProgress->setValue(std::max(fraction, _calibrationProgress->getValue()));
+      _calibrationStatus->setValue(status.str());
+    },
+    [this](CalibrationTask &doneTask)
+    {
+      _outputCalibrate->setEnabled(true);
+      _cancelCalibration->setEnabled(false);
+      try
+      {
+        doneTask.future.get();
+      }
+      catch(std::exception &e)
+      {
+        _calibrationStatus->setValue("Failed");
+        sendMessage(OFX::Message::eMessageError, "calibrationfailed", "The calibration failed : " + std::string(e.what()));
+        return;
+      }
+      _calibrationProgress->setValue(1.0);
+      _calibrationStatus->setValue(doneTask.result.isCalibrated ? "Calibrated" : "Not calibrated");
+      setCalibrationResult(doneTask.result, doneTask.extraResults);
+      if(_debugEnable->getValue() && doneTask.result.isCalibrated)
+        exportDebugImages(doneTask.result);
+      OFXMVG_LOG_INFO("calibrateLens") << (doneTask.result.isCalibrated ? "calibrated" : "not calibrated")
+        << Common::kv("totalAvgErr", doneTask.result.totalAvgErr)
+        << Common::kv("nbCalibFrames", doneTask.result.calibInputFrames.size())
+        << Common::kv("nbRejectedFrames", doneTask.result.rejectInputFrames.size())
+        << Common::kv("holdOutErr", doneTask.result.holdOutErr);
+      for(std::size_t input = 0; input < doneTask.extraResults.size(); ++input)
+      {
+        const CalibrationResult &extraResult = doneTask.extraResults[input];
+        if(extraResult.cameraMatrix.empty())
+          continue;
+        OFXMVG_LOG_INFO("calibrateLens") << (extraResult.isCalibrated ? "rig lens calibrated" : "rig lens not calibrated")
+          << Common::kv("input", input + 1)
+          << Common::kv("totalAvgErr", extraResult.totalAvgErr)
+          << Common::kv("nbCalibFrames", extraResult.calibInputFrames.size());
+      }
+    });
+}
+
+void LensCalibrationPlugin::setCalibrationResult(const CalibrationResult& result, const std::vector<CalibrationResult>& extraResults)
+{
+  beginEditBlock("calibrateLens");
   setOutputParams(_outputCameraFocalLenght,
                   _outputCameraPrincipalPointOffset,
                   _outputLensDistortionRadialCoef1,
@@ -236,11 +880,486 @@ void LensCalibrationPlugin::calibrateLens()
                   _outputLensDistortionRadialCoef3,
                   _outputLensDistortionTangentialCoef1,
                   _outputLensDistortionTangentialCoef2,
-                  cameraMatrix, distCoeffs);
+                  result.cameraMatrix, result.distCoeffs);
   
-  _outputIsCalibrated->setValue(isCalibrated);
+  _outputAvgReprojErr->setValue(result.totalAvgErr);
+  _outputIsCalibrated->setValue(result.isCalibrated);
+
+  for(std::size_t input = 0; input < extraResults.size(); ++input)
+  {
+    const CalibrationResult &extraResult = extraResults[input];
+    ExtraOutputParams &outputParams = _extraOutputParams[input];
+    if(extraResult.cameraMatrix.empty())
+    {
+      //Not calibrated this time: unconnected source or no detection
+      outputParams.isCalibrated->setValue(false);
+      continue;
+    }
+    setOutputParams(outputParams.focalLength,
+                    outputParams.principalPoint,
+                    outputParams.radialCoef1,
+                    outputParams.radialCoef2,
+                    outputParams.radialCoef3,
+                    outputParams.tangentialCoef1,
+                    outputParams.tangentialCoef2,
+                    extraResult.cameraMatrix, extraResult.distCoeffs);
+    outputParams.avgReprojErr->setValue(extraResult.totalAvgErr);
+    outputParams.isCalibrated->setValue(extraResult.isCalibrated);
+  }
+  endEditBlock();
+}
+
+std::string LensCalibrationPlugin::getDebugSourcePath(OfxTime time) const
+{
+  std::ostringstream sourcePath;
+  sourcePath << _debugSourceFolder << "/frame_" << std::setfill('0') << std::setw(5) << static_cast<std::size_t>(time) << ".png";
+  return sourcePath.str();
+}
+
+void LensCalibrationPlugin::saveDebugSource(OfxTime time, const cv::Mat& grayImage) const
+{
+  if(_debugSourceFolder.empty())
+    return;
+  OFXMVG_TRACE_SCOPE("lensCalibration.saveDebugSource");
+  boost::system::error_code error;
+  bfs::create_directories(_debugSourceFolder, error);
+  const std::string sourcePath = getDebugSourcePath(time);
+  if(error || !cv::imwrite(sourcePath, grayImage))
+    OFXMVG_LOG_ERROR("saveDebugSource") << "cannot keep the frame for the debug images" << Common::kv("file", sourcePath);
+}
+
+void LensCalibrationPlugin::exportDebugImages(const CalibrationResult& result)
+{
+  OFXMVG_TRACE_SCOPE("lensCalibration.exportDebugImages");
+  const cv::Mat cameraMatrix = result.cameraMatrix.clone();
+  const cv::Mat distCoeffs = result.distCoeffs.clone();
+  std::size_t nbImages = 0;
+  std::size_t nbMissingSources = 0;
+
+  auto exportFrames = [&](const std::string& folder, const std::vector<std::size_t>& frames)
+  {
+    if(folder.empty())
+      return;
+    for(std::size_t frame : frames)
+    {
+      //Frames detected with debug disabled, or restored from the detections cache, are not kept
+      const std::string sourcePath = getDebugSourcePath(static_cast<OfxTime>(frame));
+      boost::system::error_code error;
+      if(_debugSourceFolder.empty() || !bfs::exists(sourcePath, error))
+      {
+        ++nbMissingSources;
+        continue;
+      }
+      std::ostringstream filePath;
+      filePath << folder << "/frame_" << std::setfill('0') << std::setw(5) << frame << ".png";
+      _debugImageWriter.convert(sourcePath, filePath.str(), [cameraMatrix, distCoeffs](cv::Mat& writtenImage)
+      {
+        cv::Mat undistortedImage;
+        cv::undistort(writtenImage, undistortedImage, cameraMatrix, distCoeffs);
+        writtenImage = undistortedImage;
+      });
+      ++nbImages;
+    }
+  };
+  exportFrames(_debugSelectedImgFolder->getValue(), result.calibInputFrames);
+  exportFrames(_debugRejectedImgFolder->getValue(), result.rejectInputFrames);
+
+  OFXMVG_LOG_INFO("exportDebugImages") << "debug images queued"
+    << Common::kv("nbImages", nbImages)
+    << Common::kv("nbMissingSources", nbMissingSources);
+  if(nbMissingSources > 0)
+    OFXMVG_LOG_WARNING("exportDebugImages") << "frames not detected with debug enabled are not exported"
+      << Common::kv("nbMissingSources", nbMissingSources);
 }
 
+void LensCalibrationPlugin::flushDebugImages()
+{
+  const std::size_t nbFailedWrites = _debugImageWriter.flush();
+  if(nbFailedWrites == 0)
+    return;
+  OFXMVG_LOG_WARNING("exportDebugImages") << "debug images not written" << Common::kv("nbFailedWrites", nbFailedWrites);
+  sendMessage(OFX::Message::eMessageWarning, "debugexport", "Some debug images can't be written, check the debug folders.");
+}
+
+void LensCalibrationPlugin::analyzeClip()
+{
+  OFXMVG_TRACE_SCOPE("lensCalibration.analyzeClip");
+  if(!_srcClip->isConnected())
+    return;
+
+  const OfxRangeD range = _srcClip->getFrameRange();
+  const std::size_t nbRangeFrames = static_cast<std::size_t>(std::floor(range.max - range.min)) + 1;
+  std::size_t step = std::max(1, _inputAnalyzeStep->getValue());
+  const std::size_t maxFrames = std::max(0, _inputMaxFrames->getValue());
+  if(maxFrames > 0)
+    step = std::max(step, (nbRangeFrames + maxFrames - 1) / maxFrames);
+  const std::size_t nbFrames = (nbRangeFrames + step - 1) / step;
+
+  //Parameters are read on the host thread, workers only get values
+  initLiveCalibration();
+  const DetectionSettings detectionSettings = getDetectionSettings();
+  const FrameFilterSettings filterSettings = getFrameFilterSettings();
+  const bool isDebugEnabled = _debugEnable->getValue();
+
+  Common::ThreadPool &pool = Common::ThreadPool::instance();
+  const std::size_t maxPendingFrames = 2 * pool.getNbThreads(); //bounds the fetched images memory
+
+  //Images are released on the host thread, once analyzed
+  struct PendingFrame
+  {
+    std::unique_ptr<OFX::Image> imageOFX;
+    std::unique_ptr< Common::Image<float> > image;
+    std::future<void> future;
+  };
+  std::deque<PendingFrame> pendingFrames;
+  std::size_t nbFound = 0;
+  std::size_t nbAnalyzed = 0;
+  std::size_t nbErrors = 0;
+  std::mutex countersMutex;
+
+  auto waitFirstPendingFrame = [&]()
+  {
+    try
+    {
+      pendingFrames.front().future.get();
+    }
+    catch(std::exception &e)
+    {
+      OFXMVG_LOG_ERROR("analyzeClip") << e.what();
+      ++nbErrors;
+    }
+    pendingFrames.pop_front();
+  };
+
+  OFXMVG_LOG_INFO("analyzeClip") << "begin"
+    << Common::kv("first", range.min)
+    << Common::kv("last", range.max)
+    << Common::kv("step", step)
+    << Common::kv("nbThreads", pool.getNbThreads());
+
+  progressStart("Analyze clip", "analyzeclip");
+  bool isAborted = false;
+  try
+  {
+    for(std::size_t frame = 0; frame < nbFrames; ++frame)
+    {
+      if(!progressUpdate(static_cast<double>(frame) / nbFrames))
+      {
+        isAborted = true;
+        break;
+      }
+      updateLiveCalibration();
+      const OfxTime time = range.min + frame * step;
+      //The rig sources are analyzed at the times of the main source
+      for(std::size_t input = 0; input < _inputs.size(); ++input)
+      {
+        InputDetections &detections = _inputs[input];
+        if(!detections.clip || !detections.clip->isConnected())
+          continue;
+        {
+          std::lock_guard<std::mutex> lock(_checkerMutex);
+          if(detections.checkerPerFrame.count(time) != 0)
+            continue;
+        }
+
+        std::unique_ptr<OFX::Image> imageOFX(detections.clip->fetchImage(time));
+        if(!imageOFX)
+        {
+          OFXMVG_LOG_ERROR("analyzeClip") << "input image is NULL" << Common::kv("input", input) << Common::kv("time", time);
+          continue;
+        }
+        std::unique_ptr< Common::Image<float> > image(new Common::Image<float>(imageOFX.get(), Common::eOrientationTopDown));
+        const cv::Size frameSize(static_cast<int>(image->getWidth()), static_cast<int>(image->getHeight()));
+
+        if(input == 0)
+        {
+          bool isFirstFrame = false;
+          {
+            std::lock_guard<std::mutex> lock(_checkerMutex);
+            isFirstFrame = isMainLensEmpty() && (nbAnalyzed == 0);
+          }
+          // If no checkerboard collected, initialize with the current image size
+          if(!checkImageSize(frameSize, isFirstFrame))
+          {
+            OFXMVG_LOG_ERROR("analyzeClip") << "all images don't have the same size" << Common::kv("time", time);
+            continue;
+          }
+          if(isFirstFrame)
+            initLiveCalibration();
+          ++nbAnalyzed;
+        }
+        else if(detections.imageSize.area() == 0)
+        {
+          detections.imageSize = frameSize;
+        }
+        else if(detections.imageSize != frameSize)
+        {
+          OFXMVG_LOG_ERROR("analyzeClip") << "all images don't have the same size" << Common::kv("input", input) << Common::kv("time", time);
+          continue;
+        }
+
+        while(pendingFrames.size() >= maxPendingFrames)
+          waitFirstPendingFrame();
+
+        const Common::Image<float> *imagePtr = image.get();
+        std::future<void> future = pool.submit([=, &nbFound, &countersMutex]()
+        {
+          cv::Mat grayImage;
+          convertToGRAY8(*imagePtr, detectionSettings.isGray, grayImage);
+          std::uint64_t hash = 0;
+          if(!filterFrame(input, time, grayImage, filterSettings, hash))
+            return;
+          std::vector<cv::Point2f> checkerPoints;
+          if(!detectPattern(grayImage, detectionSettings, checkerPoints))
+            return;
+          addDetectedFrame(input, time, checkerPoints, hash, getPatternKey(detectionSettings));
+          if(input == 0 && isDebugEnabled)
+            saveDebugSource(time, grayImage);
+          std::lock_guard<std::mutex> lock(countersMutex);
+          ++nbFound;
+        });
+        pendingFrames.push_back(PendingFrame{std::move(imageOFX), std::move(image), std::move(future)});
+      }
+    }
+  }
+  catch(...)
+  {
+    //The workers use the pending images
+    while(!pendingFrames.empty())
+      waitFirstPendingFrame();
+    progressEnd();
+    throw;
+  }
+  while(!pendingFrames.empty())
+    waitFirstPendingFrame();
+  progressEnd();
+
+  std::size_t nbDetectedFrames = 0;
+  std::size_t nbDuplicateFrames = 0;
+  std::size_t nbBlurredFrames = 0;
+  {
+    std::lock_guard<std::mutex> lock(_checkerMutex);
+    for(const InputDetections &detections : _inputs)
+    {
+      nbDetectedFrames += detections.checkerPerFrame.size();
+      nbDuplicateFrames += detections.duplicateFrames.size();
+      nbBlurredFrames += detections.blurredFrames.size();
+    }
+  }
+  saveDetections();
+  updateImageSizeParam();
+  updateLiveCalibration();
+  OFXMVG_LOG_INFO("analyzeClip") << (isAborted ? "aborted" : "done")
+    << Common::kv("nbAnalyzed", nbAnalyzed)
+    << Common::kv("nbFound", nbFound)
+    << Common::kv("nbErrors", nbErrors)
+    << Common::kv("nbDuplicateFrames", nbDuplicateFrames)
+    << Common::kv("nbBlurredFrames", nbBlurredFrames)
+    << Common::kv("nbDetectedFrames", nbDetectedFrames);
+}
+
+void LensCalibrationPlugin::analyzeFile()
+{
+  OFXMVG_TRACE_SCOPE("lensCalibration.analyzeFile");
+  const std::string mediaPath = _inputFileSource->getValue();
+  if(mediaPath.empty())
+  {
+    sendMessage(OFX::Message::eMessageError, "nofilesource", "No file source to analyze.");
+    return;
+  }
+  const std::size_t step = std::max(1, _inputAnalyzeStep->getValue());
+  const std::size_t maxFrames = std::max(0, _inputMaxFrames->getValue());
+  //The file frames are main lens frames, kept apart from the main source ones
+  const std::size_t fileInput = getFileInput();
+
+  //Parameters are read on the host thread, workers only get values
+  initLiveCalibration();
+  const DetectionSettings detectionSettings = getDetectionSettings();
+  const FrameFilterSettings filterSettings = getFrameFilterSettings();
+  const bool isDebugEnabled = _debugEnable->getValue();
+
+  Common::ThreadPool &pool = Common::ThreadPool::instance();
+  const std::size_t maxPendingFrames = 2 * pool.getNbThreads(); //bounds the decoded images memory
+
+  std::unique_ptr<Common::FeedPrefetcher> prefetcher;
+  try
+  {
+    prefetcher.reset(new Common::FeedPrefetcher(mediaPath, step, maxFrames, maxPendingFrames));
+  }
+  catch(std::exception &e)
+  {
+    sendMessage(OFX::Message::eMessageError, "filesource", "Cannot read the file source : " + std::string(e.what()));
+    return;
+  }
+
+  //The frames are owned by the detection tasks
+  std::deque< std::future<void> > pendingFrames;
+  std::size_t nbFound = 0;
+  std::size_t nbAnalyzed = 0;
+  std::size_t nbErrors = 0;
+  std::mutex countersMutex;
+
+  auto waitFirstPendingFrame = [&]()
+  {
+    try
+    {
+      pendingFrames.front().get();
+    }
+    catch(std::exception &e)
+    {
+      OFXMVG_LOG_ERROR("analyzeFile") << e.what();
+      ++nbErrors;
+    }
+    pendingFrames.pop_front();
+  };
+
+  OFXMVG_LOG_INFO("analyzeFile") << "begin"
+    << Common::kv("mediaPath", mediaPath)
+    << Common::kv("step", step)
+    << Common::kv("maxFrames", maxFrames)
+    << Common::kv("nbThreads", pool.getNbThreads());
+
+  progressStart("Analyze file", "analyzefile");
+  bool isAborted = false;
+  try
+  {
+    Common::FeedPrefetcher::Frame frame;
+    while(prefetcher->pop(frame))
+    {
+      //The media length is unknown, the progress is only exact with Max Frames
+      if(!progressUpdate(maxFrames ? static_cast<double>(nbAnalyzed) / maxFrames : 0.0))
+      {
+        isAborted = true;
+        break;
+      }
+      updateLiveCalibration();
+      const OfxTime time = static_cast<OfxTime>(frame.index);
+      bool isFirstFrame = false;
+      {
+        std::lock_guard<std::mutex> lock(_checkerMutex);
+        if(_inputs[fileInput].checkerPerFrame.count(time) != 0)
+          continue;
+        isFirstFrame = isMainLensEmpty() && (nbAnalyzed == 0);
+      }
+      // If no checkerboard collected, initialize with the current image size
+      if(!checkImageSize(cv::Size(frame.grayImage.cols, frame.grayImage.rows), isFirstFrame))
+      {
+        OFXMVG_LOG_ERROR("analyzeFile") << "all images don't have the same size" << Common::kv("frame", frame.index);
+        continue;
+      }
+      if(isFirstFrame)
+        initLiveCalibration();
+      ++nbAnalyzed;
+
+      while(pendingFrames.size() >= maxPendingFrames)
+        waitFirstPendingFrame();
+
+      const cv::Mat grayImage = frame.grayImage;
+      pendingFrames.push_back(pool.submit([=, &nbFound, &countersMutex]()
+      {
+        std::uint64_t hash = 0;
+        if(!filterFrame(fileInput, time, grayImage, filterSettings, hash))
+          return;
+        std::vector<cv::Point2f> checkerPoints;
+        if(!detectPattern(grayImage, detectionSettings, checkerPoints))
+          return;
+        addDetectedFrame(fileInput, time, checkerPoints, hash, getPatternKey(detectionSettings));
+        if(isDebugEnabled)
+          saveDebugSource(getFileFrameTime(time), grayImage);
+        std::lock_guard<std::mutex> lock(countersMutex);
+        ++nbFound;
+      }));
+    }
+  }
+  catch(std::exception &e)
+  {
+    //Decoding error: the frames decoded before are kept
+    OFXMVG_LOG_ERROR("analyzeFile") << e.what();
+    ++nbErrors;
+  }
+  catch(...)
+  {
+    //The workers use the plugin
+    prefetcher.reset();
+    while(!pendingFrames.empty())
+      waitFirstPendingFrame();
+    progressEnd();
+    throw;
+  }
+  prefetcher.reset();
+  while(!pendingFrames.empty())
+    waitFirstPendingFrame();
+  progressEnd();
+
+  std::size_t nbDetectedFrames = 0;
+  {
+    std::lock_guard<std::mutex> lock(_checkerMutex);
+    nbDetectedFrames = _inputs[fileInput].checkerPerFrame.size();
+  }
+  saveDetections();
+  updateImageSizeParam();
+  updateLiveCalibration();
+  OFXMVG_LOG_INFO("analyzeFile") << (isAborted ? "aborted" : "done")
+    << Common::kv("nbAnalyzed", nbAnalyzed)
+    << Common::kv("nbFound", nbFound)
+    << Common::kv("nbErrors", nbErrors)
+    << Common::kv("nbDetectedFrames", nbDetectedFrames);
+}
+
+std::shared_ptr<const UndistortMap> LensCalibrationPlugin::getUndistortMap(const cv::Size& imageSize, const OfxPointD& renderScale, bool isRedistort)
+{
+  const OfxPointD principalPoint = _outputCameraPrincipalPointOffset->getValue();
+  const OfxPointD tangentialCoefs{_outputLensDistortionTangentialCoef1->getValue(), _outputLensDistortionTangentialCoef2->getValue()};
+  cv::Mat cameraMatrix;
+  cv::Mat distCoeffs;
+  getCalibrationMatrices(_outputCameraFocalLenght->getValue(),
+                         cv::Point2d(principalPoint.x, principalPoint.y),
+                         cv::Vec3d(_outputLensDistortionRadialCoef1->getValue(),
+                                   _outputLensDistortionRadialCoef2->getValue(),
+                                   _outputLensDistortionRadialCoef3->getValue()),
+                         cv::Vec2d(tangentialCoefs.x, tangentialCoefs.y),
+                         cameraMatrix,
+                         distCoeffs);
+  cameraMatrix.at<double>(0, 0) *= renderScale.x;
+  cameraMatrix.at<double>(0, 2) *= renderScale.x;
+  cameraMatrix.at<double>(1, 1) *= renderScale.y;
+  cameraMatrix.at<double>(1, 2) *= renderScale.y;
+
+  std::lock_guard<std::mutex> lock(_undistortMapMutex);
+  if(!_undistortMap || !_undistortMap->isComputedFor(imageSize, cameraMatrix, distCoeffs, isRedistort))
+  {
+    std::shared_ptr<UndistortMap> map = std::make_shared<UndistortMap>();
+    if(isRedistort)
+      computeRedistortMap(imageSize, cameraMatrix, distCoeffs, *map);
+    else
+      computeUndistortMap(imageSize, cameraMatrix, distCoeffs, *map);
+    _undistortMap = map;
+  }
+  return _undistortMap;
+}
+
+void LensCalibrationPlugin::exportSTMap()
+{
+  OFXMVG_TRACE_SCOPE("lensCalibration.exportSTMap");
+  const std::string filePath = _outputSTMapFile->getValue();
+  const OfxPointI imageSize(_inputImageSize->getValue());
+  if(!_outputIsCalibrated->getValue() || filePath.empty() || imageSize.x <= 0 || imageSize.y <= 0)
+  {
+    sendMessage(OFX::Message::eMessageError, "stmapexport", "The lens must be calibrated and the ST-map file set to export the ST-map.");
+    return;
+  }
+  try
+  {
+    const bool isRedistort = (EParamOutputMode(_outputMode->getValue()) == eParamOutputModeRedistortSTMap);
+    const std::shared_ptr<const UndistortMap> undistortMap = getUndistortMap(cv::Size(imageSize.x, imageSize.y), OfxPointD{1.0, 1.0}, isRedistort);
+    LensCalibration::exportSTMap(*undistortMap, filePath, _outputSTMapHalf->getValue());
+  }
+  catch(const std::exception& e)
+  {
+    OFXMVG_LOG_ERROR("exportSTMap") << e.what();
+    sendMessage(OFX::Message::eMessageError, "stmapexport", e.what());
+  }
+}
 
 bool LensCalibrationPlugin::isIdentity(const OFX::IsIdentityArguments &args, OFX::Clip * &identityClip, double &identityTime)
 {
@@ -254,18 +1373,83 @@ void LensCalibrationPlugin::changedClip(const OFX::InstanceChangedArgs &args, co
 
 void LensCalibrationPlugin::changedParam(const OFX::InstanceChangedArgs &args, const std::string &paramName)
 {
+  OFXMVG_TRACE_SCOPE("lensCalibration.changedParam");
+  updateBackgroundStatus();
+  updateImageSizeParam();
+  
   //Calibrate
   if(paramName == kParamCalibrate)
   {
+    if(_calibrationTask)
+    {
+      sendMessage(OFX::Message::eMessageWarning, "calibrationrunning", "The calibration is already running.");
+      return;
+    }
     if(_outputIsCalibrated->getValue())
     {
       sendMessage(OFX::Message::eMessageError, "alreadycalibrated", "The lens is already calibrated. Change the isCalibrated status to add new image in order to recalibrate.");
       return;
     }
-    calibrateLens();
+    saveDetections();
+    startCalibration();
+    return;
+  }
+
+  //Cancel the background calibration
+  if(paramName == kParamCancelCalibration)
+  {
+    cancelCalibration();
     return;
   }
   
+  //Analyze the source clip
+  if(paramName == kParamAnalyzeClip)
+  {
+    if(_outputIsCalibrated->getValue())
+    {
+      sendMessage(OFX::Message::eMessageError, "alreadycalibrated", "The lens is already calibrated. Change the isCalibrated status to add new image in order to recalibrate.");
+      return;
+    }
+    analyzeClip();
+    return;
+  }
+
+  //Analyze the file source
+  if(paramName == kParamAnalyzeFile)
+  {
+    if(_outputIsCalibrated->getValue())
+    {
+      sendMessage(OFX::Message::eMessageError, "alreadycalibrated", "The lens is already calibrated. Change the isCalibrated status to add new image in order to recalibrate.");
+      return;
+    }
+    analyzeFile();
+    return;
+  }
+
+  //Detections are kept per pattern
+  if(paramName == kParamPatternType || paramName == kParamPatternSize)
+  {
+    resetLiveCalibration();
+    updatePattern();
+    return;
+  }
+
+  //The live estimate depends on the calibration model
+  if(paramName == kParamLiveCalibration || paramName == kParamSquareSize ||
+     paramName == kParamNbRadialCoef || paramName == kParamMaxCalibFrames)
+  {
+    resetLiveCalibration();
+    initLiveCalibration();
+    return;
+  }
+
+  //Export the ST-map file
+  if(paramName == kParamOutputExportSTMap)
+  {
+    exportSTMap();
+    return;
+  }
+
   //Clear All
   if(paramName == kParamOutputClear)
   {
@@ -2,11 +2,22 @@
 #include "ofxsImageEffect.h"
 #include "LensCalibrationPluginFactory.hpp"
 #include "LensCalibrationPluginDefinition.hpp"
+#include "LensCalibration.hpp"
+#include "../common/AsyncImageWriter.hpp"
+#include "../common/BackgroundTaskPoller.hpp"
 
 #include <opencv2/opencv.hpp>
 #include <opencv2/core/core.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
 
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <set>
+
 namespace openMVG_ofx {
 namespace LensCalibration {
 
@@ -27,14 +38,31 @@ private:
   OFX::BooleanParam *_inputImageIsGray = fetchBooleanParam(kParamInputImageIsGray);
   OFX::ChoiceParam *_inputPatternType = fetchChoiceParam(kParamPatternType);
   OFX::Int2DParam *_inputPatternSize = fetchInt2DParam(kParamPatternSize);
+  OFX::IntParam *_inputDetectionMaxSize = fetchIntParam(kParamDetectionMaxSize);
+  OFX::BooleanParam *_inputTrackPattern = fetchBooleanParam(kParamTrackPattern);
+  OFX::IntParam *_inputMinHashDistance = fetchIntParam(kParamMinHashDistance);
+  OFX::DoubleParam *_inputMinSharpness = fetchDoubleParam(kParamMinSharpness);
   OFX::DoubleParam *_inputSquareSize = fetchDoubleParam(kParamSquareSize);
   OFX::IntParam *_inputNbRadialCoef = fetchIntParam(kParamNbRadialCoef);
   OFX::IntParam *_inputMaxFrames = fetchIntParam(kParamMaxFrames);
+  OFX::IntParam *_inputAnalyzeStep = fetchIntParam(kParamAnalyzeStep);
+  OFX::StringParam *_inputFileSource = fetchStringParam(kParamFileSource);
   OFX::IntParam *_inputMaxCalibFrames = fetchIntParam(kParamMaxCalibFrames);
   OFX::IntParam *_inputCalibGridSize = fetchIntParam(kParamCalibGridSize);
   OFX::IntParam *_inputMinInputFrames = fetchIntParam(kParamMinInputFrames);
   OFX::DoubleParam *_inputMaxTotalAvgErr = fetchDoubleParam(kParamMaxTotalAvgErr);
+  OFX::IntParam *_inputCalibNbStarts = fetchIntParam(kParamCalibNbStarts);
+  OFX::ChoiceParam *_inputCalibSolver = fetchChoiceParam(kParamCalibSolver);
+  OFX::BooleanParam *_inputLiveCalibration = fetchBooleanParam(kParamLiveCalibration);
+  OFX::DoubleParam *_liveFocalLength = fetchDoubleParam(kParamLiveFocalLength);
+  OFX::Double2DParam *_livePrincipalPoint = fetchDouble2DParam(kParamLivePrincipalPoint);
+  OFX::DoubleParam *_liveAvgReprojErr = fetchDoubleParam(kParamLiveAvgReprojErr);
   OFX::PushButtonParam *_outputCalibrate = fetchPushButtonParam(kParamCalibrate);
+  OFX::PushButtonParam *_cancelCalibration = fetchPushButtonParam(kParamCancelCalibration);
+  OFX::DoubleParam *_calibrationProgress = fetchDoubleParam(kParamCalibrationProgress);
+  OFX::StringParam *_calibrationStatus = fetchStringParam(kParamCalibrationStatus);
+  OFX::StringParam *_detectionsCache = fetchStringParam(kParamDetectionsCache);
+  OFX::StringParam *_fileDetectionsCache = fetchStringParam(kParamFileDetectionsCache);
 
   //Output parameters
   OFX::BooleanParam *_outputIsCalibrated = fetchBooleanParam(kParamOutputIsCalibrated);
@@ -48,6 +76,9 @@ private:
   OFX::DoubleParam *_outputLensDistortionTangentialCoef1 = fetchDoubleParam(kParamOutputTangentialCoef1);
   OFX::DoubleParam *_outputLensDistortionTangentialCoef2 = fetchDoubleParam(kParamOutputTangentialCoef2);
   OFX::PushButtonParam *_outputClear = fetchPushButtonParam(kParamOutputClear);
+  OFX::ChoiceParam *_outputMode = fetchChoiceParam(kParamOutputMode);
+  OFX::StringParam *_outputSTMapFile = fetchStringParam(kParamOutputSTMapFile);
+  OFX::BooleanParam *_outputSTMapHalf = fetchBooleanParam(kParamOutputSTMapHalf);
 
   //Debug parameters
   OFX::BooleanParam *_debugEnable = fetchBooleanParam(kParamDebugEnable);
@@ -57,8 +88,91 @@ private:
   //Output Parameters List
   std::vector<OFX::ValueParam*> _outputParams;
   
+  //Output parameters of the rig source clips
+  struct ExtraOutputParams
+  {
+    OFX::BooleanParam *isCalibrated = nullptr;
+    OFX::DoubleParam *avgReprojErr = nullptr;
+    OFX::DoubleParam *focalLength = nullptr;
+    OFX::Double2DParam *principalPoint = nullptr;
+    OFX::DoubleParam *radialCoef1 = nullptr;
+    OFX::DoubleParam *radialCoef2 = nullptr;
+    OFX::DoubleParam *radialCoef3 = nullptr;
+    OFX::DoubleParam *tangentialCoef1 = nullptr;
+    OFX::DoubleParam *tangentialCoef2 = nullptr;
+  };
+  std::vector<ExtraOutputParams> _extraOutputParams; //sized at load, see getMaxNbExtraInputs
+
   // Cache
-  std::map<OfxTime, std::vector<cv::Point2f> > checkerPerFrame;
+  //Pattern detections of a source: the main source first, then the rig sources, last the File Source.
+  //The File Source frames are keyed by their index in the file, they don't match the main source times.
+  struct InputDetections
+  {
+    OFX::Clip *clip = nullptr; //null for the File Source, or if the rig source isn't defined in the context
+    OFX::StringParam *cache = nullptr; //persisted detections
+    cv::Size imageSize; //size of the analyzed images, mirrored by the image size parameter for the main source
+    std::map<OfxTime, std::vector<cv::Point2f> > checkerPerFrame;
+    std::map<OfxTime, std::uint64_t> hashPerFrame; //image hash of the checkerPerFrame frames
+    std::set<OfxTime> duplicateFrames; //frames skipped by the pre-filter
+    std::set<OfxTime> blurredFrames;
+    std::map<PatternKey, PatternDetections> detectionsPerPattern; //detections of the other patterns
+    bool isDetectionsModified = false; //the cache parameter is not up to date
+  };
+  std::vector<InputDetections> _inputs; //sized at load, not resized while the workers run
+  std::size_t getFileInput() const { return _inputs.size() - 1; }
+  mutable std::mutex _checkerMutex; //protects the detections, filled by render and by the analyze workers
+  PatternKey _patternKey; //pattern of the checkerPerFrame of all the sources
+
+  //Last pattern found by render, tracked on the next rendered frame
+  struct TrackingFrame
+  {
+    bool isValid = false;
+    OfxTime time = 0.0;
+    cv::Mat grayImage;
+    std::vector<cv::Point2f> points;
+  };
+  TrackingFrame _trackingFrame;
+  std::size_t _nbTrackedFrames = 0;
+  std::mutex _trackingMutex;
+
+  //Calibration running on the worker pool, its result is applied on a host thread
+  struct CalibrationTask
+  {
+    std::future<void> future;
+    std::atomic<bool> isCanceled{false};
+    std::mutex mutex; //protects progress and isProgressUpdated
+    CalibrationProgress progress;
+    bool isProgressUpdated = false;
+    std::size_t nbInputFrames = 0;
+    std::size_t minInputFrames = 0;
+    std::size_t nbStarts = 1;
+    CalibrationResult result;
+    std::vector<CalibrationResult> extraResults; //rig sources, calibrated concurrently
+  };
+  std::unique_ptr<CalibrationTask> _calibrationTask;
+  Common::BackgroundTaskPoller _calibrationTaskPoller;
+  std::vector< std::unique_ptr<CalibrationTask> > _canceledCalibrationTasks; //released once stopped
+
+  //Live calibration estimate, updated on the worker pool as the detections accumulate
+  struct LiveCalibration
+  {
+    std::mutex mutex; //protects all but the solver
+    std::unique_ptr<IncrementalCalibration> solver; //only used by the running update
+    std::map<OfxTime, std::vector<cv::Point2f> > newFrames;
+    bool isUpdating = false;
+    std::future<void> future;
+    CalibrationResult result;
+    bool isResultUpdated = false;
+  };
+  LiveCalibration _liveCalibration;
+
+  //Distortion map of the last undistorted render
+  std::shared_ptr<const UndistortMap> _undistortMap;
+  std::mutex _undistortMapMutex;
+
+  //Debug images, encoded on the worker pool
+  Common::AsyncImageWriter _debugImageWriter;
+  std::string _debugSourceFolder; //detected frames of the main source, kept for the debug images
 
 public:
   
@@ -68,6 +182,11 @@ public:
    */
   LensCalibrationPlugin(OfxImageEffectHandle handle);
 
+  /**
+   * @brief Cancel and wait for the running and canceled calibrations
+   */
+  ~LensCalibrationPlugin();
+
   /** @brief The sync private data action, called when the effect needs to sync any private data to persistant parameters */
   void syncPrivateData();
 
@@ -111,9 +230,209 @@ public:
    * @param[in] paramName
    */
   virtual void changedParam(const OFX::InstanceChangedArgs &args, const std::string &paramName);
+
+  /**
+   * @brief Report the background calibrations in the parameters
+   * The host has no timer callback: called from the actions allowed to set parameters.
+   */
+  void updateBackgroundStatus();
+
+  /**
+   * @brief Get the state of the background calibration, drawn by the overlay
+   * The overlay draw can't set parameters: the state is drawn until the next poll applies it.
+   * @return empty if no calibration is running or waiting to be applied
+   */
+  std::string getCalibrationTaskStatus() const;
   
 private:
-  void calibrateLens();
+  /**
+   * @brief Report the progress of the background calibration and apply its result once done
+   */
+  void updateCalibrationTask();
+
+  /**
+   * @brief Get the calibration settings from the parameters values, and the main source image size
+   * @return settings
+   */
+  CalibrationSettings getCalibrationSettings() const;
+
+  /**
+   * @brief Check the size of a main source frame, the first one sets the image size
+   * Called from render and the analysis: the image size parameter is only set by updateImageSizeParam.
+   * @param[in] frameSize
+   * @param[in] isFirstFrame - no frame detected before
+   * @return false if the frame size differs from the image size
+   */
+  bool checkImageSize(const cv::Size& frameSize, bool isFirstFrame);
+
+  /**
+   * @brief Get the frames of the main lens: the main source detections, then the File Source ones
+   * The File Source frames are moved after the main source times, see getFileFrameTime.
+   * @return pattern points per frame
+   */
+  std::map<OfxTime, std::vector<cv::Point2f> > getMainLensCheckers() const;
+
+  /**
+   * @return true if neither the main source nor the File Source has a detected frame, _checkerMutex must be locked
+   */
+  bool isMainLensEmpty() const;
+
+  /**
+   * @brief Set the image size parameter if it differs from the main source image size
+   * Must be called from changedParam.
+   */
+  void updateImageSizeParam();
+
+  /**
+   * @brief Create the live calibration solver if enabled, with the frames already detected
+   * Uses the parameters, must be called from a host thread.
+   */
+  void initLiveCalibration();
+
+  /**
+   * @brief Add a detected frame to the live calibration, update it in background every few frames
+   * Thread-safe, doesn't use the OFX suites.
+   * @param[in] time
+   * @param[in] points
+   */
+  void addLiveFrame(OfxTime time, const std::vector<cv::Point2f>& points);
+
+  /**
+   * @brief Set the live estimate parameters if the estimate changed
+   */
+  void updateLiveCalibration();
+
+  /**
+   * @brief Wait for the running update and drop the live calibration
+   */
+  void resetLiveCalibration();
+
+  /**
+   * @brief Start the lens calibration on the worker pool
+   */
+  void startCalibration();
+
+  /**
+   * @brief Cancel the background calibration without waiting for it
+   * The canceled task stops at its next progress report, it's released by the next polls.
+   */
+  void cancelCalibration();
+
+  /**
+   * @brief Set the output parameters, in one edit block
+   * @param[in] result - main source calibration
+   * @param[in] extraResults - rig sources calibrations
+   */
+  void setCalibrationResult(const CalibrationResult& result, const std::vector<CalibrationResult>& extraResults);
+
+  /**
+   * @brief Get the path of a detected frame kept for the debug images
+   * @param[in] time
+   * @return path in the debug source folder
+   */
+  std::string getDebugSourcePath(OfxTime time) const;
+
+  /**
+   * @brief Keep a detected frame of the main source for the debug images
+   * Thread-safe, doesn't use the OFX suites.
+   * @param[in] time
+   * @param[in] grayImage - image given to the detection
+   */
+  void saveDebugSource(OfxTime time, const cv::Mat& grayImage) const;
+
+  /**
+   * @brief Queue the undistortion of the selected and rejected frames of a calibration to the debug folders
+   * The frames kept at their detection are read, undistorted and written on the worker pool:
+   * the sources are not fetched, so it's called as soon as the calibration is collected.
+   * Returns without waiting for the writes.
+   * @param[in] result
+   */
+  void exportDebugImages(const CalibrationResult& result);
+
+  /**
+   * @brief Wait for the debug images writes and report the failed ones
+   */
+  void flushDebugImages();
+
+  /**
+   * @brief Load the detections of all patterns from the cache parameter of a source
+   * @param[in] input - source index, 0 for the main source
+   */
+  void loadDetections(std::size_t input);
+
+  /**
+   * @brief Write the detections of all patterns in the cache parameters of the sources, if modified
+   * Must be called from an action allowed to set parameters values.
+   */
+  void saveDetections();
+
+  /**
+   * @brief Switch the checkerPerFrame of the sources to the detections of the current pattern parameters
+   */
+  void updatePattern();
+
+  /**
+   * @brief Get the pattern detection settings from the parameters values
+   * @return settings
+   */
+  DetectionSettings getDetectionSettings() const;
+
+  /**
+   * @brief Get the frame pre-filter settings from the parameters values
+   * @return settings
+   */
+  FrameFilterSettings getFrameFilterSettings() const;
+
+  /**
+   * @brief Skip the duplicated and blurred frames before the pattern detection
+   * Thread-safe, doesn't use the OFX suites.
+   * @param[in] input - source index, 0 for the main source
+   * @param[in] time
+   * @param[in] grayImage
+   * @param[in] settings
+   * @param[out] hash - image hash, to register with the detected points
+   * @return true if the pattern should be searched on the frame
+   */
+  bool filterFrame(std::size_t input, OfxTime time, const cv::Mat& grayImage, const FrameFilterSettings& settings, std::uint64_t& hash);
+
+  /**
+   * @brief Register the pattern points detected on a frame
+   * The main source frames also feed the live calibration.
+   * @param[in] input - source index, 0 for the main source
+   * @param[in] time
+   * @param[in] points
+   * @param[in] hash - image hash
+   * @param[in] patternKey - detected pattern, the points are dropped if the pattern changed meanwhile
+   * @return number of frames with a detected pattern
+   */
+  std::size_t addDetectedFrame(std::size_t input, OfxTime time, const std::vector<cv::Point2f>& points, std::uint64_t hash, const PatternKey& patternKey);
+
+  /**
+   * @brief Detect the pattern on the frames of the connected source clips, on the worker pool
+   * Frames are fetched on the calling thread, converted and analyzed concurrently.
+   * The rig sources are analyzed at the main source times.
+   */
+  void analyzeClip();
+
+  /**
+   * @brief Detect the pattern on the frames of the file source, as the main source
+   * Frames are decoded ahead on a dedicated thread and analyzed on the worker pool.
+   */
+  void analyzeFile();
+
+  /**
+   * @brief Get the distortion map of the output calibration, computed once per size and calibration
+   * @param[in] imageSize
+   * @param[in] renderScale - the calibration is in full resolution pixels
+   * @param[in] isRedistort - map direction
+   * @return map
+   */
+  std::shared_ptr<const UndistortMap> getUndistortMap(const cv::Size& imageSize, const OfxPointD& renderScale, bool isRedistort);
+
+  /**
+   * @brief Export the ST-map of the output calibration at the input image size
+   */
+  void exportSTMap();
   
   void clearOutputParamValues()
   {
@@ -7,6 +7,17 @@
  * Plugin Parameters definition
  */
 
+//Optional source clips of a rig, calibrated with the main source
+#define kClipExtraSource(I) "Source" + std::to_string(I + 2)
+
+/**
+ * Default number of rig source clips
+ * Overridden at runtime by the OFXMVG_LENSCALIBRATION_MAX_EXTRA_INPUTS environment variable.
+ */
+#ifndef OFXMVG_LENSCALIBRATION_MAX_EXTRA_INPUTS
+#define OFXMVG_LENSCALIBRATION_MAX_EXTRA_INPUTS 3
+#endif
+
 //Calibration parameters
 #define kParamGroupCalibration "groupCalibration"
 
@@ -14,14 +25,34 @@
 #define kParamImageSize "imageSize"
 #define kParamPatternType "patternType"
 #define kParamPatternSize "patternSize"
+#define kParamDetectionMaxSize "detectionMaxSize"
+#define kParamTrackPattern "trackPattern"
+#define kParamMinHashDistance "minHashDistance"
+#define kParamMinSharpness "minSharpness"
 #define kParamSquareSize "SquareSize"
 #define kParamNbRadialCoef "nbRadialCoef"
 #define kParamMaxFrames "maxFrames"
+#define kParamAnalyzeStep "analyzeStep"
+#define kParamAnalyzeClip "analyzeClip"
+#define kParamFileSource "fileSource"
+#define kParamAnalyzeFile "analyzeFile"
 #define kParamMaxCalibFrames "maxCalibFrames"
 #define kParamCalibGridSize "calibGridSize"
 #define kParamMinInputFrames "minInputFrames"
 #define kParamMaxTotalAvgErr "maxTotalAvgErr"
+#define kParamCalibNbStarts "calibNbStarts"
+#define kParamCalibSolver "calibSolver"
+#define kParamLiveCalibration "liveCalibration"
+#define kParamLiveFocalLength "liveFocalLength"
+#define kParamLivePrincipalPoint "livePrincipalPoint"
+#define kParamLiveAvgReprojErr "liveAvgReprojErr"
 #define kParamCalibrate "outputCalibrate"
+#define kParamCancelCalibration "cancelCalibration"
+#define kParamCalibrationProgress "calibrationProgress"
+#define kParamCalibrationStatus "calibrationStatus"
+#define kParamDetectionsCache "detectionsCache"
+#define kParamExtraDetectionsCache(I) "extraDetectionsCache_" + std::to_string(I)
+#define kParamFileDetectionsCache "fileDetectionsCache"
 
 //Debug parameters
 #define kParamGroupDebug "groupDebug"
@@ -36,6 +67,10 @@
 #define kParamOutputAvgReprojErr "outputAvgReprojErr"
 #define kParamOutputIsCalibrated "outputIsCalibrated"
 #define kParamOutputClear "outputClear"
+#define kParamOutputMode "outputMode"
+#define kParamOutputSTMapFile "outputSTMapFile"
+#define kParamOutputSTMapHalf "outputSTMapHalf"
+#define kParamOutputExportSTMap "outputExportSTMap"
 
 #define kParamOutputCameraGroup "groupCamera"
 
@@ -50,6 +85,18 @@
 #define kParamOutputTangentialCoef1 "outputTangentialCoef1"
 #define kParamOutputTangentialCoef2 "outputTangentialCoef2"
 
+//Output parameters of the extra sources
+#define kParamGroupExtraOutput(I) "groupExtraOutput_" + std::to_string(I)
+#define kParamExtraOutputIsCalibrated(I) "extraOutputIsCalibrated_" + std::to_string(I)
+#define kParamExtraOutputAvgReprojErr(I) "extraOutputAvgReprojErr_" + std::to_string(I)
+#define kParamExtraOutputFocalLength(I) "extraOutputFocalLength_" + std::to_string(I)
+#define kParamExtraOutputPrincipalPoint(I) "extraOutputPrincipalPoint_" + std::to_string(I)
+#define kParamExtraOutputRadialCoef1(I) "extraOutputRadialCoef1_" + std::to_string(I)
+#define kParamExtraOutputRadialCoef2(I) "extraOutputRadialCoef2_" + std::to_string(I)
+#define kParamExtraOutputRadialCoef3(I) "extraOutputRadialCoef3_" + std::to_string(I)
+#define kParamExtraOutputTangentialCoef1(I) "extraOutputTangentialCoef1_" + std::to_string(I)
+#define kParamExtraOutputTangentialCoef2(I) "extraOutputTangentialCoef2_" + std::to_string(I)
+
 /**
  * Choice Parameter option definition
  */
@@ -75,5 +122,35 @@ static const std::vector< std::pair<std::string, std::string> > kStringParamPatt
   {"CCTag", ""}
 };
 
+//kParamOutputMode options
+enum EParamOutputMode
+{
+  eParamOutputModeUndistort = 0,
+  eParamOutputModeUndistortSTMap,
+  eParamOutputModeRedistortSTMap
+};
+
+static const std::vector< std::pair<std::string, std::string> > kStringParamOutputMode = {
+  {"Undistorted image", "Undistort the source clip."},
+  {"Undistort ST-map", "Position in the source image of each undistorted pixel."},
+  {"Redistort ST-map", "Position in the undistorted image of each source pixel, to apply the lens distortion."}
+};
+
+//kParamCalibSolver options
+enum EParamCalibSolver
+{
+  eParamCalibSolverOpenCV = 0
+#ifdef HAVE_CERES
+  , eParamCalibSolverCeres
+#endif
+};
+
+static const std::vector< std::pair<std::string, std::string> > kStringParamCalibSolver = {
+  {"OpenCV", "Iterative OpenCV calibration, rejects the worst frames between the iterations."}
+#ifdef HAVE_CERES
+  , {"Ceres", "Ceres bundle adjustment with a robust loss, the badly detected points get a low weight."}
+#endif
+};
+
 } //namespace LensCalibration
 } //namespace openMVG_ofx
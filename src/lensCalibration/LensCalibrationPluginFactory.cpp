@@ -1,7 +1,11 @@
 #include "LensCalibrationPluginFactory.hpp"
 #include "LensCalibrationPluginDefinition.hpp"
+#include "LensCalibration.hpp"
 #include "LensCalibrationInteract.hpp"
 
+#include <array>
+#include <string>
+
 namespace openMVG_ofx {
 namespace LensCalibration {
 
@@ -56,6 +60,20 @@ void LensCalibrationPluginFactory::describeInContext(OFX::ImageEffectDescriptor&
   srcClip->setSupportsTiles(false);
   srcClip->setIsMask(false);
   srcClip->setOptional(false);
+
+  //Rig source clips, only allowed in the general context
+  if(context == OFX::eContextGeneral)
+  {
+    for(std::size_t input = 0; input < getMaxNbExtraInputs(); ++input)
+    {
+      OFX::ClipDescriptor *extraClip = desc.defineClip(kClipExtraSource(input));
+      extraClip->addSupportedComponent(OFX::ePixelComponentRGBA);
+      extraClip->setTemporalClipAccess(false);
+      extraClip->setSupportsTiles(false);
+      extraClip->setIsMask(false);
+      extraClip->setOptional(true);
+    }
+  }
   
   //Output clip
   OFX::ClipDescriptor *dstClip = desc.defineClip(kOfxImageEffectOutputClipName);
@@ -106,6 +124,51 @@ void LensCalibrationPluginFactory::describeInContext(OFX::ImageEffectDescriptor&
       param->setAnimates(false);
       param->setParent(*groupCalibration);
     }
+
+    {
+      OFX::IntParamDescriptor *param = desc.defineIntParam(kParamDetectionMaxSize);
+      param->setLabel("Detection Max Size");
+      param->setHint("The pattern is searched on a downsampled image whose largest side is below this size, "
+                     "then refined at full resolution. 0 to search at full resolution.");
+      param->setRange(0, kOfxFlagInfiniteMax);
+      param->setDisplayRange(0, 4096);
+      param->setDefault(1920);
+      param->setAnimates(false);
+      param->setParent(*groupCalibration);
+    }
+
+    {
+      OFX::BooleanParamDescriptor *param = desc.defineBooleanParam(kParamTrackPattern);
+      param->setLabel("Track Pattern");
+      param->setHint("Track the pattern found on the previous rendered frame instead of searching the whole image. "
+                     "Falls back to the full search when the tracking fails.");
+      param->setDefault(false);
+      param->setAnimates(false);
+      param->setParent(*groupCalibration);
+    }
+
+    {
+      OFX::IntParamDescriptor *param = desc.defineIntParam(kParamMinHashDistance);
+      param->setLabel("Min Hash Distance");
+      param->setHint("Frames nearly identical to a frame where the pattern is already detected are skipped. "
+                     "Number of different bits of the 64 bits image hashes below which a frame is a duplicate, 0 to disable.");
+      param->setRange(0, 64);
+      param->setDisplayRange(0, 16);
+      param->setDefault(3);
+      param->setAnimates(false);
+      param->setParent(*groupCalibration);
+    }
+
+    {
+      OFX::DoubleParamDescriptor *param = desc.defineDoubleParam(kParamMinSharpness);
+      param->setLabel("Min Sharpness");
+      param->setHint("Blurred frames are skipped. Minimal variance of the image Laplacian (8 bits gray levels), 0 to disable.");
+      param->setRange(0, kOfxFlagInfiniteMax);
+      param->setDisplayRange(0, 500);
+      param->setDefault(0);
+      param->setAnimates(false);
+      param->setParent(*groupCalibration);
+    }
     
     {
       OFX::DoubleParamDescriptor *param = desc.defineDoubleParam(kParamSquareSize);
@@ -140,6 +203,43 @@ void LensCalibrationPluginFactory::describeInContext(OFX::ImageEffectDescriptor&
       param->setParent(*groupCalibration);
     }
 
+    {
+      OFX::IntParamDescriptor *param = desc.defineIntParam(kParamAnalyzeStep);
+      param->setLabel("Analyze Step");
+      param->setHint("Analyze one frame every N frames of the source clip or of the file source. Increased to respect Max Frames on the source clip.");
+      param->setRange(1, kOfxFlagInfiniteMax);
+      param->setDisplayRange(1, 100);
+      param->setDefault(1);
+      param->setAnimates(false);
+      param->setParent(*groupCalibration);
+    }
+
+    {
+      OFX::PushButtonParamDescriptor *param = desc.definePushButtonParam(kParamAnalyzeClip);
+      param->setLabel("Analyze Clip");
+      param->setHint("Detect the calibration pattern on the source clip range, without playing it.");
+      param->setParent(*groupCalibration);
+    }
+
+    {
+      OFX::StringParamDescriptor *param = desc.defineStringParam(kParamFileSource);
+      param->setLabel("File Source");
+      param->setHint("Folder, image sequence or video file analyzed by Analyze File, without loading it in the host. "
+                     "Its detections are kept apart from the source clip ones, and calibrated with them.");
+      param->setStringType(OFX::eStringTypeFilePath);
+      param->setFilePathExists(true);
+      param->setAnimates(false);
+      param->setEvaluateOnChange(false);
+      param->setParent(*groupCalibration);
+    }
+
+    {
+      OFX::PushButtonParamDescriptor *param = desc.definePushButtonParam(kParamAnalyzeFile);
+      param->setLabel("Analyze File");
+      param->setHint("Detect the calibration pattern on the File Source frames, decoded ahead of the detection.");
+      param->setParent(*groupCalibration);
+    }
+
     {
       OFX::IntParamDescriptor *param = desc.defineIntParam(kParamMaxCalibFrames);
       param->setLabel("Max Calibration Frames");
@@ -183,11 +283,114 @@ void LensCalibrationPluginFactory::describeInContext(OFX::ImageEffectDescriptor&
       param->setAnimates(false);
       param->setParent(*groupCalibration);
     }
+
+    {
+      OFX::IntParamDescriptor *param = desc.defineIntParam(kParamCalibNbStarts);
+      param->setLabel("Calibration Starts");
+      param->setHint("Number of calibrations run concurrently from different subsets of the selected frames. "
+                     "With more than one start, a fifth of the frames is held out and the calibration with "
+                     "the lowest reprojection error on these frames is kept.");
+      param->setRange(1, 64);
+      param->setDisplayRange(1, 16);
+      param->setDefault(1);
+      param->setAnimates(false);
+      param->setParent(*groupCalibration);
+    }
+
+    {
+      OFX::ChoiceParamDescriptor *param = desc.defineChoiceParam(kParamCalibSolver);
+      param->setLabel("Calibration Solver");
+      param->setHint("Solver of the lens calibration. Ceres is only available if the plugin is built with Ceres.");
+      param->appendOptions(kStringParamCalibSolver);
+      param->setDefault(eParamCalibSolverOpenCV);
+      param->setAnimates(false);
+      param->setParent(*groupCalibration);
+    }
+
+    {
+      OFX::BooleanParamDescriptor *param = desc.defineBooleanParam(kParamLiveCalibration);
+      param->setLabel("Live Calibration");
+      param->setHint("Update a calibration estimate in background as the patterns are detected. "
+                     "Each update starts from the previous estimate, and the final calibration starts from the last one.");
+      param->setDefault(false);
+      param->setAnimates(false);
+      param->setParent(*groupCalibration);
+    }
+
+    {
+      OFX::DoubleParamDescriptor *param = desc.defineDoubleParam(kParamLiveFocalLength);
+      param->setLabel("Live Focal Length");
+      param->setHint("Focal length of the live calibration estimate (pixels).");
+      param->setDisplayRange(1, 5000);
+      param->setEvaluateOnChange(false);
+      param->setEnabled(false);
+      param->setAnimates(false);
+      param->setCanUndo(false);
+      param->setParent(*groupCalibration);
+    }
+
+    {
+      OFX::Double2DParamDescriptor *param = desc.defineDouble2DParam(kParamLivePrincipalPoint);
+      param->setLabel("Live Principal Point");
+      param->setHint("Principal point of the live calibration estimate (pixels).");
+      param->setEvaluateOnChange(false);
+      param->setEnabled(false);
+      param->setAnimates(false);
+      param->setCanUndo(false);
+      param->setParent(*groupCalibration);
+    }
+
+    {
+      OFX::DoubleParamDescriptor *param = desc.defineDoubleParam(kParamLiveAvgReprojErr);
+      param->setLabel("Live Reprojection Error");
+      param->setHint("Reprojection error of the live calibration estimate (pixels).");
+      param->setDisplayRange(0, 10);
+      param->setEvaluateOnChange(false);
+      param->setEnabled(false);
+      param->setAnimates(false);
+      param->setCanUndo(false);
+      param->setParent(*groupCalibration);
+      param->setLayoutHint(OFX::eLayoutHintDivider);
+    }
     
     {
       OFX::PushButtonParamDescriptor *param = desc.definePushButtonParam(kParamCalibrate);
       param->setLabel("Calibrate");
-      param->setHint("calibrate");
+      param->setHint("Calibrate the lens in background from the detected patterns.");
+      param->setParent(*groupCalibration);
+    }
+
+    {
+      OFX::PushButtonParamDescriptor *param = desc.definePushButtonParam(kParamCancelCalibration);
+      param->setLabel("Cancel Calibration");
+      param->setHint("Stop the running calibration, the output parameters are not modified.");
+      param->setEnabled(false);
+      param->setParent(*groupCalibration);
+    }
+
+    {
+      OFX::DoubleParamDescriptor *param = desc.defineDoubleParam(kParamCalibrationProgress);
+      param->setLabel("Calibration Progress");
+      param->setHint("Progress of the running calibration.");
+      param->setRange(0, 1);
+      param->setDisplayRange(0, 1);
+      param->setDefault(0);
+      param->setEvaluateOnChange(false);
+      param->setEnabled(false);
+      param->setAnimates(false);
+      param->setCanUndo(false);
+      param->setParent(*groupCalibration);
+    }
+
+    {
+      OFX::StringParamDescriptor *param = desc.defineStringParam(kParamCalibrationStatus);
+      param->setLabel("Calibration Status");
+      param->setHint("Current iteration, number of frames and reprojection error of the running calibration.");
+      param->setStringType(OFX::eStringTypeSingleLine);
+      param->setEvaluateOnChange(false);
+      param->setEnabled(false);
+      param->setAnimates(false);
+      param->setCanUndo(false);
       param->setParent(*groupCalibration);
     }
 
@@ -308,6 +511,111 @@ void LensCalibrationPluginFactory::describeInContext(OFX::ImageEffectDescriptor&
       }
     }
     
+    //Output parameters of the rig source clips
+    for(std::size_t input = 0; input < getMaxNbExtraInputs(); ++input)
+    {
+      OFX::GroupParamDescriptor *groupExtraOutput = desc.defineGroupParam(kParamGroupExtraOutput(input));
+      groupExtraOutput->setLabel(kClipExtraSource(input));
+      groupExtraOutput->setParent(*groupOutput);
+      groupExtraOutput->setOpen(false);
+
+      {
+        OFX::BooleanParamDescriptor *param = desc.defineBooleanParam(kParamExtraOutputIsCalibrated(input));
+        param->setLabel("Is calibrated");
+        param->setHint("Is calibrated");
+        param->setEvaluateOnChange(false);
+        param->setEnabled(false);
+        param->setParent(*groupExtraOutput);
+      }
+
+      {
+        OFX::DoubleParamDescriptor *param = desc.defineDoubleParam(kParamExtraOutputAvgReprojErr(input));
+        param->setLabel("Average Reprojection Error");
+        param->setDisplayRange(0, 10);
+        param->setEvaluateOnChange(false);
+        param->setEnabled(false);
+        param->setAnimates(false);
+        param->setParent(*groupExtraOutput);
+      }
+
+      {
+        OFX::DoubleParamDescriptor *param = desc.defineDoubleParam(kParamExtraOutputFocalLength(input));
+        param->setLabel("Focal Length");
+        param->setDisplayRange(1, 100);
+        param->setEvaluateOnChange(false);
+        param->setEnabled(false);
+        param->setAnimates(false);
+        param->setParent(*groupExtraOutput);
+      }
+
+      {
+        OFX::Double2DParamDescriptor *param = desc.defineDouble2DParam(kParamExtraOutputPrincipalPoint(input));
+        param->setLabel("Principal Point");
+        param->setEvaluateOnChange(false);
+        param->setEnabled(false);
+        param->setAnimates(false);
+        param->setParent(*groupExtraOutput);
+      }
+
+      const std::array<std::pair<std::string, std::string>, 5> distortionParams = {{
+        {kParamExtraOutputRadialCoef1(input), "Radial Coef1"},
+        {kParamExtraOutputRadialCoef2(input), "Radial Coef2"},
+        {kParamExtraOutputRadialCoef3(input), "Radial Coef3"},
+        {kParamExtraOutputTangentialCoef1(input), "Tangential Coef1"},
+        {kParamExtraOutputTangentialCoef2(input), "Tangential Coef2"}
+      }};
+      for(const auto& distortionParam : distortionParams)
+      {
+        OFX::DoubleParamDescriptor *param = desc.defineDoubleParam(distortionParam.first);
+        param->setLabel(distortionParam.second);
+        param->setDisplayRange(0, 10);
+        param->setEvaluateOnChange(false);
+        param->setEnabled(false);
+        param->setAnimates(false);
+        param->setParent(*groupExtraOutput);
+      }
+    }
+
+    {
+      OFX::ChoiceParamDescriptor *param = desc.defineChoiceParam(kParamOutputMode);
+      param->setLabel("Output Mode");
+      param->setHint("Output of the calibrated lens: the undistorted source clip, or an ST-map of the lens distortion "
+                     "(red: normalized x, green: normalized y from the bottom) to distort or undistort with a texture lookup.");
+      param->appendOptions(kStringParamOutputMode);
+      param->setDefault(eParamOutputModeUndistort);
+      param->setAnimates(false);
+      param->setParent(*groupOutput);
+    }
+
+    {
+      OFX::StringParamDescriptor *param = desc.defineStringParam(kParamOutputSTMapFile);
+      param->setLabel("ST-map File");
+      param->setHint("OpenEXR file of the exported ST-map, at the calibrated image size. "
+                     "Exports the redistort ST-map in the Redistort ST-map output mode, the undistort ST-map otherwise.");
+      param->setStringType(OFX::eStringTypeFilePath);
+      param->setFilePathExists(false);
+      param->setAnimates(false);
+      param->setParent(*groupOutput);
+    }
+
+    {
+      OFX::BooleanParamDescriptor *param = desc.defineBooleanParam(kParamOutputSTMapHalf);
+      param->setLabel("Half Float ST-map");
+      param->setHint("Write the ST-map file in 16 bits half floats instead of 32 bits floats. "
+                     "Half floats lose sub-pixel precision on large images.");
+      param->setDefault(false);
+      param->setAnimates(false);
+      param->setParent(*groupOutput);
+    }
+
+    {
+      OFX::PushButtonParamDescriptor *param = desc.definePushButtonParam(kParamOutputExportSTMap);
+      param->setLabel("Export ST-map");
+      param->setHint("Write the ST-map file.");
+      param->setParent(*groupOutput);
+      param->setLayoutHint(OFX::eLayoutHintDivider);
+    }
+
     {
       OFX::PushButtonParamDescriptor *param = desc.definePushButtonParam(kParamOutputClear);
       param->setLabel("Clear");
@@ -348,6 +656,43 @@ void LensCalibrationPluginFactory::describeInContext(OFX::ImageEffectDescriptor&
       param->setParent(*groupDebug);
     }
   }
+
+  {
+    OFX::StringParamDescriptor *param = desc.defineStringParam(kParamDetectionsCache);
+    param->setLabel("Pattern Detections Cache");
+    param->setHint("Allow the plugin to store the detected pattern points");
+    param->setIsSecret(true);
+    param->setEnabled(false);
+    param->setAnimates(false);
+    param->setStringType(OFX::eStringTypeSingleLine);
+    param->setEvaluateOnChange(false);
+    param->setCanUndo(false);
+  }
+
+  {
+    OFX::StringParamDescriptor *param = desc.defineStringParam(kParamFileDetectionsCache);
+    param->setLabel("Pattern Detections Cache File Source");
+    param->setHint("Allow the plugin to store the detected pattern points of the File Source, per frame of the file");
+    param->setIsSecret(true);
+    param->setEnabled(false);
+    param->setAnimates(false);
+    param->setStringType(OFX::eStringTypeSingleLine);
+    param->setEvaluateOnChange(false);
+    param->setCanUndo(false);
+  }
+
+  for(std::size_t input = 0; input < getMaxNbExtraInputs(); ++input)
+  {
+    OFX::StringParamDescriptor *param = desc.defineStringParam(kParamExtraDetectionsCache(input));
+    param->setLabel(std::string("Pattern Detections Cache ") + kClipExtraSource(input));
+    param->setHint("Allow the plugin to store the detected pattern points of a rig source clip");
+    param->setIsSecret(true);
+    param->setEnabled(false);
+    param->setAnimates(false);
+    param->setStringType(OFX::eStringTypeSingleLine);
+    param->setEvaluateOnChange(false);
+    param->setCanUndo(false);
+  }
 }
 
 OFX::ImageEffect* LensCalibrationPluginFactory::createInstance(OfxImageEffectHandle handle, OFX::ContextEnum context)
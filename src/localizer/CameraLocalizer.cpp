@@ -1,8 +1,14 @@
 #include "CameraLocalizer.hpp"
+#include "../common/Trace.hpp"
+#include "../common/Logger.hpp"
+#include "../common/ThreadPool.hpp"
 
 #include <nonFree/sift/SIFT_describer.hpp>
 
+#include <cassert>
 #include <cmath>
+#include <cstdlib>
+#include <limits>
 #include <chrono>
 
 namespace openMVG_ofx {
@@ -12,24 +18,31 @@ void LocalizerProcessData::extractFeatures(
       const std::map< std::size_t, openMVG::image::Image<unsigned char> > &mapImageGray,
       std::vector< std::unique_ptr<openMVG::features::Regions> > &vecQueryRegions) const
 {
+  //The describer only reads its configuration, one instance is shared by the inputs
   openMVG::features::SIFT_Image_describer imageDescriber;
   imageDescriber.Set_configuration_preset(param->_featurePreset);
   
-  auto inputImageGrey = mapImageGray.begin();
+  std::vector<const openMVG::image::Image<unsigned char>*> inputImagesGray;
+  inputImagesGray.reserve(mapImageGray.size());
+  for(const auto &inputImageGray : mapImageGray)
+    inputImagesGray.push_back(&inputImageGray.second);
     
-  for(unsigned int i = 0; i < mapImageGray.size(); ++i)
+  //One input per task, the rig cameras are described concurrently
+  Common::ThreadPool::instance().parallelFor(0, inputImagesGray.size(), [&](std::size_t i)
   {
-    std::cout << "[features]\tExtract SIFT : input " << i << std::endl;
     // outQueryRegions.reset(new openMVG::features::SIFT_Regions());
     
+    OFXMVG_TRACE_SCOPE("extractFeatures");
     auto detect_start = std::chrono::steady_clock::now();
-    imageDescriber.Describe( inputImageGrey->second, vecQueryRegions[i], nullptr);
-    ++inputImageGrey;
+    imageDescriber.Describe(*inputImagesGray[i], vecQueryRegions[i], nullptr);
     
     auto detect_end = std::chrono::steady_clock::now();
     auto detect_elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(detect_end - detect_start);
-    std::cout << "[features]\tExtract SIFT done: found " << vecQueryRegions[i]->RegionCount() << " features in " << detect_elapsed.count() << " [ms]" << std::endl;
-  }
+    OFXMVG_LOG_DEBUG("features") << "extract SIFT done"
+      << Common::kv("input", i)
+      << Common::kv("nbFeatures", vecQueryRegions[i]->RegionCount())
+      << Common::kv("durationMs", detect_elapsed.count());
+  });
 }
 
 bool LocalizerProcessData::localize(std::unique_ptr<openMVG::features::Regions> &queryRegions,
@@ -127,6 +140,32 @@ EParamLensDistortionMode LocalizerProcessData::getLensDistortionModelFromEnum(op
   }
 }
 
+std::size_t getMaxNbInputs()
+{
+  static const std::size_t maxNbInputs = []()
+  {
+    std::size_t nbInputs = OFXMVG_LOCALIZER_MAX_INPUTS;
+    const char *envNbInputs = std::getenv("OFXMVG_LOCALIZER_MAX_INPUTS");
+    if(envNbInputs)
+    {
+      char *end = nullptr;
+      const long value = std::strtol(envNbInputs, &end, 10);
+      if(end != envNbInputs && *end == '\0' && value >= 1 && value <= 64)
+      {
+        nbInputs = static_cast<std::size_t>(value);
+      }
+      else
+      {
+        OFXMVG_LOG_WARNING("getMaxNbInputs") << "invalid OFXMVG_LOCALIZER_MAX_INPUTS, the default is used"
+          << Common::kv("value", envNbInputs)
+          << Common::kv("default", nbInputs);
+      }
+    }
+    return nbInputs;
+  }();
+  return maxNbInputs;
+}
+
 std::size_t getParamInputId(const std::string& paramName)
 {
   std::size_t last_index = paramName.find_last_not_of("0123456789");
@@ -135,81 +174,132 @@ std::size_t getParamInputId(const std::string& paramName)
   return std::stoi(paramName.substr(last_index + 1));
 }
 
-void setPoseToParamsAtTime(
-    const openMVG::geometry::Pose3 &pose,
-    const double time,
-    OFX::Double3DParam *cameraOutputTranslate,
-    OFX::Double3DParam *cameraOutputRotate,
-    OFX::Double3DParam *cameraOutputScale)
+void getOutputParamValues(
+    const openMVG::localization::LocalizationResult &localizationResult,
+    const std::vector<openMVG::features::SIOPointFeature> &features,
+    const double sensorWidth,
+    OutputParamValues &values)
 {
+  const openMVG::geometry::Pose3 &pose = localizationResult.getPose();
+
   // Convert camera orientation
   openMVG::Mat3 fixOrientation;
   fixOrientation << 1.,  0., 0.,
                     0., -1., 0.,
                     0.,  0., -1.;
 
-  openMVG::Vec3 translation = pose.center();
-  cameraOutputTranslate->setValueAtTime(time, translation(0), translation(1), translation(2));
+  values.translate = pose.center();
 
   // ZYX: 0 1 2
   // Decompose the rotation in ZXY angles
-  //  std::ifstream f("/tmp/fixRotation.txt");
   int a=0, b=1, c=2;
-  //  f >> a;
-  //  f >> b;
-  //  f >> c;
-  openMVG::Vec3 rotationAngles = (fixOrientation * pose.rotation()).transpose().eulerAngles(a, b, c);
-  
-  double convDeg = 180.0 / M_PI;
-  cameraOutputRotate->setValueAtTime(time, rotationAngles(0) * convDeg, rotationAngles(1) * convDeg, rotationAngles(2) * convDeg);
-  
-  cameraOutputScale->setValueAtTime(time, 1, 1, 1);
-}
+  const double convDeg = 180.0 / M_PI;
+  values.rotate = (fixOrientation * pose.rotation()).transpose().eulerAngles(a, b, c) * convDeg;
 
-void setIntrinsicsToParamsAtTime(
-    const openMVG::cameras::Pinhole_Intrinsic &intrinsics,
-    const double time,
-    const double sensorWidth,
-    OFX::DoubleParam *cameraOutputFocalLength,
-    OFX::Double2DParam *cameraOutputOpticalCenter)
-{
+  const openMVG::cameras::Pinhole_Intrinsic &intrinsics = localizationResult.getIntrinsics();
   const std::vector<double> params = intrinsics.getParams();
-  cameraOutputFocalLength->setValueAtTime(time, params[0] * sensorWidth / double(intrinsics.w()) );
-  cameraOutputOpticalCenter->setValueAtTime(time, params[1], params[2]);
-  //  for(std::size_t i = 3; params.size(); ++i)
-  //  {
-  //    
-  //  }
-}
+  values.focalLength = params[0] * sensorWidth / double(intrinsics.w());
+  values.opticalCenter = openMVG::Vec2(params[1], params[2]);
 
-void setStatToParamsAtTime(
-    const openMVG::localization::LocalizationResult &localizationResult,
-    const std::vector<openMVG::features::SIOPointFeature> &features,
-    const double time,
-    OFX::DoubleParam *outputStatErrorMean,
-    OFX::DoubleParam *outputStatErrorMin,
-    OFX::DoubleParam *outputStatErrorMax,
-    OFX::DoubleParam *outputStatNbMatchedImages,
-    OFX::DoubleParam *outputStatNbDetectedFeatures,
-    OFX::DoubleParam *outputStatNbMatchedFeatures,
-    OFX::DoubleParam *outputStatNbInlierFeatures)
-{
   //Error statistics only available if the localizationResult has inliers
-  if(localizationResult.getInliers().size() > 0)
+  values.hasErrorStats = (localizationResult.getInliers().size() > 0);
+  if(values.hasErrorStats)
   {
     const openMVG::Mat2X residuals = localizationResult.computeInliersResiduals();
 
     const auto sqrErrors = (residuals.cwiseProduct(residuals)).colwise().sum();
 
-    outputStatErrorMean->setValueAtTime(time, std::sqrt(sqrErrors.mean()));
-    outputStatErrorMin->setValueAtTime(time, std::sqrt(sqrErrors.minCoeff()));
-    outputStatErrorMax->setValueAtTime(time, std::sqrt(sqrErrors.maxCoeff()));
+    values.errorMean = std::sqrt(sqrErrors.mean());
+    values.errorMin = std::sqrt(sqrErrors.minCoeff());
+    values.errorMax = std::sqrt(sqrErrors.maxCoeff());
+  }
+
+  values.nbMatchedImages = localizationResult.getMatchedImages().size();
+  values.nbDetectedFeatures = features.size();
+  values.nbMatchedFeatures = localizationResult.getIndMatch3D2D().size();
+  values.nbInlierFeatures = localizationResult.getInliers().size();
+}
+
+void unwrapEulerAngles(std::vector<openMVG::Vec3> &rotations)
+{
+  for(std::size_t i = 1; i < rotations.size(); ++i)
+  {
+    const openMVG::Vec3 &previous = rotations[i - 1];
+    //XYZ angles (a, b, c) and (a + 180, 180 - b, c + 180) are the same rotation
+    const openMVG::Vec3 candidates[2] = {
+      rotations[i],
+      openMVG::Vec3(rotations[i](0) + 180.0, 180.0 - rotations[i](1), rotations[i](2) + 180.0)
+    };
+    double bestDistance = std::numeric_limits<double>::max();
+    for(const openMVG::Vec3 &candidate : candidates)
+    {
+      openMVG::Vec3 unwrapped;
+      for(int axis = 0; axis < 3; ++axis)
+        unwrapped(axis) = candidate(axis) - 360.0 * std::round((candidate(axis) - previous(axis)) / 360.0);
+      const double distance = (unwrapped - previous).squaredNorm();
+      if(distance < bestDistance)
+      {
+        bestDistance = distance;
+        rotations[i] = unwrapped;
+      }
+    }
   }
+}
 
-  outputStatNbMatchedImages->setValueAtTime(time, localizationResult.getMatchedImages().size());
-  outputStatNbDetectedFeatures->setValueAtTime(time, features.size());
-  outputStatNbMatchedFeatures->setValueAtTime(time, localizationResult.getIndMatch3D2D().size());
-  outputStatNbInlierFeatures->setValueAtTime(time, localizationResult.getInliers().size());
+std::vector<std::size_t> reduceKeys(const std::vector<double> &times, const std::vector<openMVG::Vec> &values, double tolerance)
+{
+  assert(times.size() == values.size());
+  std::vector<std::size_t> keys;
+  if(values.empty())
+    return keys;
+
+  //Constant curve
+  bool isConstant = true;
+  for(std::size_t i = 1; i < values.size() && isConstant; ++i)
+    isConstant = ((values[i] - values[0]).cwiseAbs().maxCoeff() <= tolerance);
+  if(isConstant)
+  {
+    keys.push_back(0);
+    return keys;
+  }
+
+  //The segments are split at their farthest sample until all the samples are within the tolerance
+  std::vector<bool> isKept(values.size(), false);
+  isKept.front() = true;
+  isKept.back() = true;
+  std::vector< std::pair<std::size_t, std::size_t> > segments;
+  segments.emplace_back(0, values.size() - 1);
+  while(!segments.empty())
+  {
+    const std::size_t first = segments.back().first;
+    const std::size_t last = segments.back().second;
+    segments.pop_back();
+
+    double maxError = tolerance;
+    std::size_t farthest = first;
+    for(std::size_t i = first + 1; i < last; ++i)
+    {
+      const double t = (times[i] - times[first]) / (times[last] - times[first]);
+      const double error = (values[first] + t * (values[last] - values[first]) - values[i]).cwiseAbs().maxCoeff();
+      if(error > maxError)
+      {
+        maxError = error;
+        farthest = i;
+      }
+    }
+    if(farthest == first)
+      continue;
+    isKept[farthest] = true;
+    segments.emplace_back(first, farthest);
+    segments.emplace_back(farthest, last);
+  }
+
+  for(std::size_t i = 0; i < isKept.size(); ++i)
+  {
+    if(isKept[i])
+      keys.push_back(i);
+  }
+  return keys;
 }
 
 void convertRGB32ToGRAY8(const Common::Image<float> &inputImage, openMVG::image::Image<unsigned char> &outputImage)
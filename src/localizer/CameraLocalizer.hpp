@@ -133,6 +133,14 @@ struct LocalizerProcessData
   static EParamLensDistortionMode getLensDistortionModelFromEnum(openMVG::cameras::EINTRINSIC model);
 };
 
+/**
+ * @brief Get the number of input clips of the plugin
+ * The OFXMVG_LOCALIZER_MAX_INPUTS environment variable (1 to 64) overrides the build default.
+ * The value is read once: the described and the fetched inputs must match.
+ * @return number of input clips
+ */
+std::size_t getMaxNbInputs();
+
 /**
  * @brief get the digit id of a param name given
  * @param paramName
@@ -141,54 +149,54 @@ struct LocalizerProcessData
 std::size_t getParamInputId(const std::string& paramName);
 
 /**
- * @brief Set openMVG pose values into OFX parameters
- * @param pose
- * @param time
- * @param cameraOutputTranslate
- * @param cameraOutputRotate
- * @param cameraOutputScale
+ * @brief Output parameter values of a localized camera, computed before the host calls
  */
-void setPoseToParamsAtTime(
-    const openMVG::geometry::Pose3 & pose,
-    const double time,
-    OFX::Double3DParam *cameraOutputTranslate,
-    OFX::Double3DParam *cameraOutputRotate,
-    OFX::Double3DParam *cameraOutputScale);
+struct OutputParamValues
+{
+  openMVG::Vec3 translate = openMVG::Vec3::Zero();
+  openMVG::Vec3 rotate = openMVG::Vec3::Zero(); //degrees, ZXY angles
+  double focalLength = 0.0; //sensor unit
+  openMVG::Vec2 opticalCenter = openMVG::Vec2::Zero();
+  bool hasErrorStats = false; //error statistics only available with inliers
+  double errorMean = 0.0;
+  double errorMin = 0.0;
+  double errorMax = 0.0;
+  std::size_t nbMatchedImages = 0;
+  std::size_t nbDetectedFeatures = 0;
+  std::size_t nbMatchedFeatures = 0;
+  std::size_t nbInlierFeatures = 0;
+};
 
 /**
- * @brief Set openMVG intrinsics values into OFX parameters
- * @param intrinsics
- * @param time
- * @param sensorWidth
- * @param cameraOutputFocalLength
- * @param cameraOutputOpticalCenter
+ * @brief Compute the output parameter values of a localization result
+ * @param[in] localizationResult
+ * @param[in] features
+ * @param[in] sensorWidth
+ * @param[out] values
  */
-void setIntrinsicsToParamsAtTime(
-    const openMVG::cameras::Pinhole_Intrinsic& intrinsics,
-    const double time,
+void getOutputParamValues(
+    const openMVG::localization::LocalizationResult &localizationResult,
+    const std::vector<openMVG::features::SIOPointFeature>& features,
     const double sensorWidth,
-    OFX::DoubleParam *cameraOutputFocalLength,
-    OFX::Double2DParam *cameraOutputOpticalCenter);
+    OutputParamValues &values);
 
 /**
- * @brief Set openMVG errors values into OFX parameters
- * @param localizationResult
- * @param time
- * @param outputErrorMean
- * @param outputErrorMin
- * @param outputErrorMax
+ * @brief Make a sequence of Euler angles continuous
+ * Each rotation takes the equivalent angles closest to the previous rotation,
+ * so the animation curves don't jump of 360 degrees or flip to the alternate decomposition.
+ * @param[in,out] rotations - XYZ Euler angles in degrees, as given by Eigen eulerAngles(0, 1, 2)
  */
-void setStatToParamsAtTime(
-    const openMVG::localization::LocalizationResult &localizationResult,
-    const std::vector<openMVG::features::SIOPointFeature>& features,
-    const double time,
-    OFX::DoubleParam *outputStatErrorMean,
-    OFX::DoubleParam *outputStatErrorMin,
-    OFX::DoubleParam *outputStatErrorMax,
-    OFX::DoubleParam *outputStatNbMatchedImages,
-    OFX::DoubleParam *outputStatNbDetectedFeatures,
-    OFX::DoubleParam *outputStatNbMatchedFeatures,
-    OFX::DoubleParam *outputStatNbInlierFeatures);
+void unwrapEulerAngles(std::vector<openMVG::Vec3> &rotations);
+
+/**
+ * @brief Select the keys of a linearly interpolated curve within a tolerance of the samples
+ * Ramer-Douglas-Peucker simplification, a curve within the tolerance of its first value is reduced to a single key.
+ * @param[in] times - increasing
+ * @param[in] values - one value per time, of the same dimension
+ * @param[in] tolerance - maximal absolute error on each dimension
+ * @return indexes of the kept keys, increasing
+ */
+std::vector<std::size_t> reduceKeys(const std::vector<double> &times, const std::vector<openMVG::Vec> &values, double tolerance);
 
 /**
  * @brief convert a 32 bits float image to a gray (unsigned char) 8 bits image
@@ -3,6 +3,7 @@
 #include "CameraLocalizerPlugin.hpp"
 
 #include "../common/stb_easy_font.h"
+#include "../common/Trace.hpp"
 
 #include <cmath>
 #include <array>
@@ -38,6 +39,8 @@ void drawCircle(GLfloat x, GLfloat y, GLfloat radius)
 
 bool CameraLocalizerInteract::draw(const OFX::DrawArgs &args)
 {
+  OFXMVG_TRACE_SCOPE("overlay.draw");
+  
   //Check if current frame has cache
   if(!_plugin->hasFrameDataCache(args.time))
   {
@@ -432,5 +435,12 @@ bool CameraLocalizerInteract::draw(const OFX::DrawArgs &args)
   return true;
 }
 
+bool CameraLocalizerInteract::penMotion(const OFX::PenArgs &args)
+{
+  //Pen motions over the viewer refresh the background rig calibration status
+  _plugin->updateBackgroundStatus();
+  return false;
+}
+
 }
 }
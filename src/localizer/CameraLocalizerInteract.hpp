@@ -20,7 +20,7 @@ class CameraLocalizerPlugin;
 class CameraLocalizerInteract : public OFX::OverlayInteract
 {
 private:
-  const CameraLocalizerPlugin* _plugin;
+  CameraLocalizerPlugin* _plugin;
   
 public:
   CameraLocalizerInteract(OfxInteractHandle handle, OFX::ImageEffect* effect)
@@ -30,6 +30,7 @@ public:
 
   // overridden function from OFX::Interact to do things
   virtual bool draw(const OFX::DrawArgs &args);
+  virtual bool penMotion(const OFX::PenArgs &args);
 };
 
 class CameraLocalizerOverlayDescriptor : public OFX::DefaultEffectOverlayDescriptor<CameraLocalizerOverlayDescriptor, CameraLocalizerInteract>
@@ -1,5 +1,8 @@
 #include "CameraLocalizerPlugin.hpp"
 #include "../common/Image.hpp"
+#include "../common/Trace.hpp"
+#include "../common/Logger.hpp"
+#include "../common/ThreadPool.hpp"
 
 #include <boost/filesystem/path.hpp>
 #include <boost/filesystem/operations.hpp>
@@ -14,6 +17,10 @@
 #include <cassert>
 #include <iostream>
 #include <algorithm>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <sstream>
 
 namespace openMVG_ofx {
 namespace Localizer {
@@ -23,70 +30,90 @@ namespace bfs = boost::filesystem;
 CameraLocalizerPlugin::CameraLocalizerPlugin(OfxImageEffectHandle handle)
   : OFX::ImageEffect(handle)
 {
-  for(std::size_t input = 0; input < K_MAX_INPUTS; ++input)
+  _inputs.resize(getMaxNbInputs());
+
+  for(std::size_t input = 0; input < _inputs.size(); ++input)
   {
+    InputParams &inputParams = _inputs[input];
+
     //Source clips
-    _srcClip[input] = fetchClip(kClip(input)); 
+    inputParams.clip = fetchClip(kClip(input));
     
     //Input Parameters
-    _inputIsGrayscale[input] = fetchBooleanParam(kParamInputIsGrayscale(input));
-    _inputLensCalibrationFile[input] = fetchStringParam(kParamInputLensCalibrationFile(input));
-    _inputLensDistortion[input] = fetchChoiceParam(kParamInputDistortion(input));
-    _inputLensDistortionMode[input] = fetchChoiceParam(kParamInputDistortionMode(input));
-    _inputLensDistortionCoef1[input] = fetchDoubleParam(kParamInputDistortionCoef1(input));
-    _inputLensDistortionCoef2[input] = fetchDoubleParam(kParamInputDistortionCoef2(input));
-    _inputLensDistortionCoef3[input] = fetchDoubleParam(kParamInputDistortionCoef3(input));
-    _inputLensDistortionCoef4[input] = fetchDoubleParam(kParamInputDistortionCoef4(input));
-    _inputOpticalCenter[input] = fetchDouble2DParam(kParamInputOpticalCenter(input));
-    _inputFocalLengthMode[input] = fetchChoiceParam(kParamInputFocalLengthMode(input));
-    _inputFocalLength[input] = fetchDoubleParam(kParamInputFocalLength(input));
-    _inputFocalLengthVarying[input] = fetchBooleanParam(kParamInputFocalLengthVarying(input));
-    _inputSensorWidth[input] = fetchDoubleParam(kParamInputSensorWidth(input));
-    _inputRelativePoseRotateM1[input] = fetchDouble3DParam(kParamInputRelativePoseRotateM1(input));
-    _inputRelativePoseRotateM2[input] = fetchDouble3DParam(kParamInputRelativePoseRotateM2(input));
-    _inputRelativePoseRotateM3[input] = fetchDouble3DParam(kParamInputRelativePoseRotateM3(input));
-    _inputRelativePoseCenter[input] = fetchDouble3DParam(kParamInputRelativePoseCenter(input));
-    _inputGroupRelativePose[input] = fetchGroupParam(kParamInputGroupRelativePose(input));
+    inputParams.isGrayscale = fetchBooleanParam(kParamInputIsGrayscale(input));
+    inputParams.lensCalibrationFile = fetchStringParam(kParamInputLensCalibrationFile(input));
+    inputParams.lensDistortion = fetchChoiceParam(kParamInputDistortion(input));
+    inputParams.lensDistortionMode = fetchChoiceParam(kParamInputDistortionMode(input));
+    inputParams.lensDistortionCoef1 = fetchDoubleParam(kParamInputDistortionCoef1(input));
+    inputParams.lensDistortionCoef2 = fetchDoubleParam(kParamInputDistortionCoef2(input));
+    inputParams.lensDistortionCoef3 = fetchDoubleParam(kParamInputDistortionCoef3(input));
+    inputParams.lensDistortionCoef4 = fetchDoubleParam(kParamInputDistortionCoef4(input));
+    inputParams.opticalCenter = fetchDouble2DParam(kParamInputOpticalCenter(input));
+    inputParams.focalLengthMode = fetchChoiceParam(kParamInputFocalLengthMode(input));
+    inputParams.focalLength = fetchDoubleParam(kParamInputFocalLength(input));
+    inputParams.focalLengthVarying = fetchBooleanParam(kParamInputFocalLengthVarying(input));
+    inputParams.sensorWidth = fetchDoubleParam(kParamInputSensorWidth(input));
+    inputParams.relativePoseRotateM1 = fetchDouble3DParam(kParamInputRelativePoseRotateM1(input));
+    inputParams.relativePoseRotateM2 = fetchDouble3DParam(kParamInputRelativePoseRotateM2(input));
+    inputParams.relativePoseRotateM3 = fetchDouble3DParam(kParamInputRelativePoseRotateM3(input));
+    inputParams.relativePoseCenter = fetchDouble3DParam(kParamInputRelativePoseCenter(input));
+    inputParams.groupRelativePose = fetchGroupParam(kParamInputGroupRelativePose(input));
     
     //Output Parameters
-    _cameraOutputTranslate[input] = fetchDouble3DParam(kParamOutputTranslate(input));
-    _cameraOutputRotate[input] = fetchDouble3DParam(kParamOutputRotate(input));
-    _cameraOutputScale[input] = fetchDouble3DParam(kParamOutputScale(input));
-    _cameraOutputOpticalCenter[input] = fetchDouble2DParam(kParamOutputOpticalCenter(input));
-    _cameraOutputFocalLength[input] = fetchDoubleParam(kParamOutputFocalLength(input));
-    _cameraOutputNear[input] = fetchDoubleParam(kParamOutputNear(input));
-    _cameraOutputFar[input] = fetchDoubleParam(kParamOutputFar(input));
-    _cameraOutputLensDistortionCoef1[input] = fetchDoubleParam(kParamOutputDistortionCoef1(input));
-    _cameraOutputLensDistortionCoef2[input] = fetchDoubleParam(kParamOutputDistortionCoef2(input));
-    _cameraOutputLensDistortionCoef3[input] = fetchDoubleParam(kParamOutputDistortionCoef3(input));
-    _cameraOutputLensDistortionCoef4[input] = fetchDoubleParam(kParamOutputDistortionCoef4(input));
-    _outputStatErrorMean[input] = fetchDoubleParam(kParamOutputStatErrorMean(input));
-    _outputStatErrorMin[input] = fetchDoubleParam(kParamOutputStatErrorMin(input));
-    _outputStatErrorMax[input] = fetchDoubleParam(kParamOutputStatErrorMax(input));
-    _outputStatNbMatchedImages[input] = fetchDoubleParam(kParamOutputStatNbMatchedImages(input));
-    _outputStatNbDetectedFeatures[input] = fetchDoubleParam(kParamOutputStatNbDetectedFeatures(input));
-    _outputStatNbMatchedFeatures[input] = fetchDoubleParam(kParamOutputStatNbMatchedFeatures(input));
-    _outputStatNbInlierFeatures[input] = fetchDoubleParam(kParamOutputStatNbInlierFeatures(input));
+    inputParams.outputTranslate = fetchDouble3DParam(kParamOutputTranslate(input));
+    inputParams.outputRotate = fetchDouble3DParam(kParamOutputRotate(input));
+    inputParams.outputScale = fetchDouble3DParam(kParamOutputScale(input));
+    inputParams.outputOpticalCenter = fetchDouble2DParam(kParamOutputOpticalCenter(input));
+    inputParams.outputFocalLength = fetchDoubleParam(kParamOutputFocalLength(input));
+    inputParams.outputNear = fetchDoubleParam(kParamOutputNear(input));
+    inputParams.outputFar = fetchDoubleParam(kParamOutputFar(input));
+    inputParams.outputLensDistortionCoef1 = fetchDoubleParam(kParamOutputDistortionCoef1(input));
+    inputParams.outputLensDistortionCoef2 = fetchDoubleParam(kParamOutputDistortionCoef2(input));
+    inputParams.outputLensDistortionCoef3 = fetchDoubleParam(kParamOutputDistortionCoef3(input));
+    inputParams.outputLensDistortionCoef4 = fetchDoubleParam(kParamOutputDistortionCoef4(input));
+    inputParams.outputStatErrorMean = fetchDoubleParam(kParamOutputStatErrorMean(input));
+    inputParams.outputStatErrorMin = fetchDoubleParam(kParamOutputStatErrorMin(input));
+    inputParams.outputStatErrorMax = fetchDoubleParam(kParamOutputStatErrorMax(input));
+    inputParams.outputStatNbMatchedImages = fetchDoubleParam(kParamOutputStatNbMatchedImages(input));
+    inputParams.outputStatNbDetectedFeatures = fetchDoubleParam(kParamOutputStatNbDetectedFeatures(input));
+    inputParams.outputStatNbMatchedFeatures = fetchDoubleParam(kParamOutputStatNbMatchedFeatures(input));
+    inputParams.outputStatNbInlierFeatures = fetchDoubleParam(kParamOutputStatNbInlierFeatures(input));
     
-    _outputParams.push_back(_cameraOutputTranslate[input]);
-    _outputParams.push_back(_cameraOutputRotate[input]);
-    _outputParams.push_back(_cameraOutputScale[input]);
-    _outputParams.push_back(_cameraOutputFocalLength[input]);
-    _outputParams.push_back(_cameraOutputOpticalCenter[input]);
-    _outputParams.push_back(_outputStatErrorMean[input]);
-    _outputParams.push_back(_outputStatErrorMin[input]);
-    _outputParams.push_back(_outputStatErrorMax[input]);
-    _outputParams.push_back(_outputStatNbMatchedImages[input]);
-    _outputParams.push_back(_outputStatNbDetectedFeatures[input]);
-    _outputParams.push_back(_outputStatNbMatchedFeatures[input]);
-    _outputParams.push_back(_outputStatNbInlierFeatures[input]);
+    _outputParams.push_back(inputParams.outputTranslate);
+    _outputParams.push_back(inputParams.outputRotate);
+    _outputParams.push_back(inputParams.outputScale);
+    _outputParams.push_back(inputParams.outputFocalLength);
+    _outputParams.push_back(inputParams.outputOpticalCenter);
+    _outputParams.push_back(inputParams.outputStatErrorMean);
+    _outputParams.push_back(inputParams.outputStatErrorMin);
+    _outputParams.push_back(inputParams.outputStatErrorMax);
+    _outputParams.push_back(inputParams.outputStatNbMatchedImages);
+    _outputParams.push_back(inputParams.outputStatNbDetectedFeatures);
+    _outputParams.push_back(inputParams.outputStatNbMatchedFeatures);
+    _outputParams.push_back(inputParams.outputStatNbInlierFeatures);
   }
   //reset all plugins options
   reset();
 }
 
+CameraLocalizerPlugin::~CameraLocalizerPlugin()
+{
+  //The task uses the instance data
+  if(_rigCalibrationTask)
+  {
+    _rigCalibrationTask->isCanceled = true;
+    _rigCalibrationTask->future.wait();
+  }
+}
+
+void CameraLocalizerPlugin::syncPrivateData()
+{
+  updateBackgroundStatus();
+}
+
 void CameraLocalizerPlugin::parametersSetup()
 {
+  OFXMVG_TRACE_SCOPE("parametersSetup");
   //Get Features type enum
   EParamFeaturesType describer = static_cast<EParamFeaturesType>(_featureType->getValue());
 
@@ -171,42 +198,85 @@ void CameraLocalizerPlugin::parametersSetup()
 bool CameraLocalizerPlugin::getRegionOfDefinition(const OFX::RegionOfDefinitionArguments &args, OfxRectD &rod)
 {
   if((getNbConnectedInput() <= 0) || 
-          (!_srcClip[_cameraOutputIndex->getValue()-1]->isConnected()))
+          (!_inputs[_cameraOutputIndex->getValue()-1].clip->isConnected()))
   {
     // rod = OfxRectD{0,0,-1,-1};
     throw OFX::Exception::Suite(kOfxStatFailed);
   }
-  rod = _srcClip[_cameraOutputIndex->getValue()-1]->getRegionOfDefinition(args.time);
+  rod = _inputs[_cameraOutputIndex->getValue()-1].clip->getRegionOfDefinition(args.time);
   
   return true;
 }
 
 void CameraLocalizerPlugin::beginSequenceRender(const OFX::BeginSequenceRenderArguments &args)
 {
-  std::cout << "sequence render : begin : " << timeLineGetTime() << std::endl;
+  OFXMVG_TRACE_SCOPE("beginSequenceRender");
+  OFXMVG_LOG_DEBUG("beginSequenceRender") << "begin" << Common::kv("time", timeLineGetTime());
   if(!_uptodateParam || !_uptodateDescriptor)
   {
    parametersSetup();
    _uptodateParam = true;
    _uptodateDescriptor = true;
   }
+  {
+    std::lock_guard<std::mutex> lock(_pendingOutputMutex);
+    _isSequenceRendering = true;
+  }
+
+  //The solved frames are appended as they come
+  const std::string trackFilePath = _outputTrackFile->getValue();
+  if(_outputStreamTrack->getValue() && !trackFilePath.empty())
+  {
+    try
+    {
+      _trackFileWriter.reset(new TrackFileWriter(trackFilePath, true));
+    }
+    catch(std::exception &e)
+    {
+      OFXMVG_LOG_ERROR("beginSequenceRender") << e.what();
+      sendMessage(OFX::Message::eMessageWarning, "cameralocalization.trackfile", e.what());
+    }
+  }
 }
 
 void CameraLocalizerPlugin::endSequenceRender(const OFX::EndSequenceRenderArguments &args)
 {
   // TODO:
   // Bundle if needed and multiple images collected.
+  
+  {
+    std::lock_guard<std::mutex> lock(_pendingOutputMutex);
+    _isSequenceRendering = false;
+  }
+  commitOutputParamValues();
+
+  if(_trackFileWriter)
+  {
+    _trackFileWriter->flush();
+    OFXMVG_LOG_INFO("endSequenceRender") << "track file streamed" << Common::kv("nbRecords", _trackFileWriter->getNbRecords());
+    _trackFileWriter.reset();
+  }
+
+  //Write the sequence timeline
+  if(Common::Tracer::instance().isEnabled())
+    Common::Tracer::instance().flush();
 }
 
 void CameraLocalizerPlugin::render(const OFX::RenderArguments &args)
 {
-  std::cout << "render : [info] time: " << args.time << std::endl;
-  std::cout << "render : [info] fieldToRender: " << args.fieldToRender << std::endl;
-  std::cout << "render : [info] renderQualityDraft: " << args.renderQualityDraft << std::endl;
-  std::cout << "render : [info] renderScale: " << args.renderScale.x << ", " << args.renderScale.y << std::endl;
-  std::cout << "render : [info] interactiveRenderStatus: " << args.interactiveRenderStatus << std::endl;
-  std::cout << "render : [info] args.renderWindow: (" << args.renderWindow.x1 << ", " << args.renderWindow.y1 << "), (" << args.renderWindow.x2 << ", "  << args.renderWindow.y2 << ")" << std::endl;
-  std::cout << "render : [info] output clip index : " << _cameraOutputIndex->getValue() - 1 << std::endl;
+  OFXMVG_TRACE_SCOPE("render");
+  OFXMVG_LOG_DEBUG("render") << "begin"
+    << Common::kv("time", args.time)
+    << Common::kv("fieldToRender", args.fieldToRender)
+    << Common::kv("renderQualityDraft", args.renderQualityDraft)
+    << Common::kv("renderScale.x", args.renderScale.x)
+    << Common::kv("renderScale.y", args.renderScale.y)
+    << Common::kv("interactiveRenderStatus", args.interactiveRenderStatus)
+    << Common::kv("renderWindow.x1", args.renderWindow.x1)
+    << Common::kv("renderWindow.y1", args.renderWindow.y1)
+    << Common::kv("renderWindow.x2", args.renderWindow.x2)
+    << Common::kv("renderWindow.y2", args.renderWindow.y2)
+    << Common::kv("outputClipIndex", _cameraOutputIndex->getValue() - 1);
   
   if(abort())
   {
@@ -216,15 +286,15 @@ void CameraLocalizerPlugin::render(const OFX::RenderArguments &args)
   //Check if no connected input
   if(getNbConnectedInput() <= 0)
   {
-    std::cout << "render : [quit] no input" << std::endl;
+    OFXMVG_LOG_DEBUG("render") << "quit: no input";
     return;
   }
   
   //Get output index
   int outputClipIndex = _cameraOutputIndex->getValue() - 1;
-  if(!_srcClip[outputClipIndex]->isConnected())
+  if(!_inputs[outputClipIndex].clip->isConnected())
   {
-    std::cerr << "render : [error] invalid output index" << std::endl;
+    OFXMVG_LOG_ERROR("render") << "invalid output index" << Common::kv("outputClipIndex", outputClipIndex);
     return;
   }
  
@@ -234,10 +304,13 @@ void CameraLocalizerPlugin::render(const OFX::RenderArguments &args)
   std::map<std::size_t, openMVG::image::Image<unsigned char> > mapImageGray;
   
   //Collect Images in input
-  if(!getInputsInGrayScale(args.time, mapImageGray))
   {
-    std::cerr << "render : [error] can't collect images in input" << std::endl;
-    return;
+    OFXMVG_TRACE_SCOPE("render.fetchInputs");
+    if(!getInputsInGrayScale(args.time, mapImageGray))
+    {
+      OFXMVG_LOG_ERROR("render") << "can't collect images in input" << Common::kv("time", args.time);
+      return;
+    }
   }
   
   try
@@ -248,21 +321,21 @@ void CameraLocalizerPlugin::render(const OFX::RenderArguments &args)
     {
       //Don't launch the tracker if we already have a keyFrame at current time.
       //We only need to provide the output image to the host.
-      std::cout << "render : [stopped] frame already computed at frame : " << args.time << std::endl;
+      OFXMVG_LOG_DEBUG("render") << "frame already computed" << Common::kv("time", args.time);
       
       for(auto &inputFrameData : getFrameDataCache(args.time))
       {
         mapLocResults[inputFrameData.first] = inputFrameData.second.localizationResult;
         mapIntrinsics[inputFrameData.first] = inputFrameData.second.localizationResult.getIntrinsics(); //TODO: remove and read intrinsics from output parameters
       }
-      std::cout << "render : [stopped] cache loaded at time : " << args.time << std::endl;
+      OFXMVG_LOG_DEBUG("render") << "cache loaded" << Common::kv("time", args.time);
     }
     else
     {
       //Ensure Localizer is correctly initialized
       if(!_processData.localizer->isInit())
       {
-        std::cerr << "render : [error] Cannot initialize the camera localizer at frame " << args.time << "." << std::endl;
+        OFXMVG_LOG_ERROR("render") << "cannot initialize the camera localizer" << Common::kv("time", args.time);
         return;
       }
       
@@ -302,7 +375,8 @@ void CameraLocalizerPlugin::render(const OFX::RenderArguments &args)
       //Localization Process
       if(isRigInInput() && !isRigModeUnknown())
       {
-        std::cout << "render : [localization] Known RIG" << std::endl;
+        OFXMVG_TRACE_SCOPE("render.localizeRig");
+        OFXMVG_LOG_DEBUG("render") << "localization: known rig";
         openMVG::geometry::Pose3 mainCameraPose;
         std::vector<openMVG::localization::LocalizationResult> vecLocResults;
 
@@ -321,13 +395,11 @@ void CameraLocalizerPlugin::render(const OFX::RenderArguments &args)
       }
       else
       {
-        if(isRigInInput())
-          std::cout << "render : [localization] Simple mode : unknown RIG" << std::endl;
-        else
-          std::cout << "render : [localization] Simple mode : one camera" << std::endl;
+        OFXMVG_LOG_DEBUG("render") << "localization: simple mode, " << (isRigInInput() ? "unknown rig" : "one camera");
                 
         for(std::size_t input = 0; input < getNbConnectedInput(); ++input)
         {
+          OFXMVG_TRACE_SCOPE("render.localize");
           std::size_t clipIndex = _connectedClipIdx[input];
           _processData.localize(vecQueryRegions[input],
                                 vecQueryImageSize[input],
@@ -347,28 +419,35 @@ void CameraLocalizerPlugin::render(const OFX::RenderArguments &args)
       
       for(std::size_t output = 0; output < getNbConnectedInput(); ++output)
       {
-        std::cout << "render : [write] output  : " << output << std::endl;
         std::size_t clipIndex = _connectedClipIdx[output];
         
         //Update frame temp cache
         frameDataCache[clipIndex].extractedFeatures = dynamic_cast<const openMVG::features::SIFT_Regions*>(vecQueryRegions[output].get())->Features();
         frameDataCache[clipIndex].localizationResult = mapLocResults[clipIndex];
         frameDataCache[clipIndex].undistortedPt2D = mapLocResults[clipIndex].retrieveUndistortedPt2D();
+        
+        Common::traceCounter("features", frameDataCache[clipIndex].extractedFeatures.size());
+        Common::traceCounter("inliers", mapLocResults[clipIndex].getInliers().size());
          
         if(mapLocResults[clipIndex].isValid())
         {
-          std::cout << "render : [write] update output UI parameters " << std::endl;
+          OFXMVG_LOG_DEBUG("render") << "update output parameters" << Common::kv("time", args.time) << Common::kv("clipIndex", clipIndex);
           updateOutputParamAtTime(args.time, 
                                   clipIndex, 
                                   mapLocResults[clipIndex], 
                                   frameDataCache[clipIndex].extractedFeatures);
           
-          std::cout << "render : [write] update intrinsics " << std::endl;
           mapIntrinsics[clipIndex] = mapLocResults[clipIndex].getIntrinsics();
+
+          if(_trackFileWriter)
+          {
+            TrackRecord record;
+            getTrackRecord(args.time, clipIndex, frameDataCache[clipIndex], record);
+            _trackFileWriter->write(record);
+          }
         }
       }
       
-      std::cout << "render : [cache] update with frame temp cache " << std::endl;
       //Update cache with frame temp cache
       {
         if(hasFrameDataCache(args.time))
@@ -387,9 +466,16 @@ void CameraLocalizerPlugin::render(const OFX::RenderArguments &args)
         }
       }
       
-      std::cout << "render : [write] update serialized data  " << std::endl;
-      //Update serialized data
-      serializeCacheData();
+      //Update serialized data, once at the end of a sequence render
+      bool isSequenceRendering = false;
+      {
+        std::lock_guard<std::mutex> lock(_pendingOutputMutex);
+        isSequenceRendering = _isSequenceRendering;
+      }
+      //The reduced keys of the frame are written now that the cache holds it
+      if(!isSequenceRendering && !commitOutputParamValues())
+        serializeCacheData();
+      Common::traceCounter("cacheFrames", _framesData.size());
     }
   }
   catch(std::exception &e)
@@ -398,31 +484,28 @@ void CameraLocalizerPlugin::render(const OFX::RenderArguments &args)
   }
   
   //Update Overlay
-  std::cout << "render : [overlay] redraw"  << std::endl;
   this->redrawOverlays();
 
   //Fetch Output image
-  std::cout << "render : [output clip] fetch"  << std::endl;
   OFX::Image *outputPtr = _dstClip->fetchImage(args.time);
   if(outputPtr == NULL)
   {
-    std::cout << "render : [output clip] is NULL" << std::endl;
+    OFXMVG_LOG_ERROR("render") << "output image is NULL" << Common::kv("time", args.time);
     return;
   }
   Common::Image<float> outputImage(outputPtr, Common::eOrientationTopDown);
+  OFXMVG_TRACE_SCOPE("render.output");
   
   // TODO: always undistort (fill vecIntrinsics from params)
   if(mapLocResults[outputClipIndex].isValid())
   {
     openMVG::image::Image<unsigned char> undistortedImage;
-    std::cout << "render : [output clip] compute undistorted "  << std::endl;
     openMVG::cameras::UndistortImage(mapImageGray[outputClipIndex], &mapIntrinsics[outputClipIndex], undistortedImage);
-    std::cout << "render : [output clip] convert and copy "  << std::endl;
     convertGRAY8ToRGB32(undistortedImage, outputImage);
   }
   else
   {
-    std::cout << "render : [output clip] no calibration "  << std::endl;
+    OFXMVG_LOG_DEBUG("render") << "output without undistortion: no calibration" << Common::kv("time", args.time);
     convertGRAY8ToRGB32(mapImageGray[outputClipIndex], outputImage);
   }
 
@@ -440,11 +523,9 @@ bool CameraLocalizerPlugin::isIdentity(const OFX::IsIdentityArguments &args, OFX
 
 void CameraLocalizerPlugin::changedClip(const OFX::InstanceChangedArgs &args, const std::string &clipName)
 {
-  std::cout << "----------" << std::endl;
-  std::cout << "changedClip: " << clipName << std::endl;
-  std::cout << "  args.reason: " << int(args.reason) << std::endl;
-  std::cout << "  args.time: " << args.time << std::endl;
-  std::cout << "----------" << std::endl;
+  OFXMVG_LOG_DEBUG("changedClip") << clipName
+    << Common::kv("reason", int(args.reason))
+    << Common::kv("time", args.time);
   
   //a clip have been changed by the user or the plugin
   if(args.reason != OFX::InstanceChangeReason::eChangeTime)
@@ -460,6 +541,15 @@ void CameraLocalizerPlugin::changedClip(const OFX::InstanceChangedArgs &args, co
 
 void CameraLocalizerPlugin::changedParam(const OFX::InstanceChangedArgs &args, const std::string &paramName)
 {
+  OFXMVG_TRACE_SCOPE("changedParam");
+  updateBackgroundStatus();
+  
+  //Trace export
+  if((paramName == kParamAdvancedDebugTrace) || (paramName == kParamAdvancedDebugFolder))
+  {
+    updateTracing();
+  }
+  
   //A parameter change
   _uptodateParam = false;
   
@@ -468,7 +558,7 @@ void CameraLocalizerPlugin::changedParam(const OFX::InstanceChangedArgs &args, c
   {
     OFX::ImageEffectHostDescription* desc = OFX::getImageEffectHostDescription();
    
-    if(!_srcClip[_cameraOutputIndex->getValue() - 1]->isConnected())
+    if(!_inputs[_cameraOutputIndex->getValue() - 1].clip->isConnected())
     {
       int min;
       int max;
@@ -510,6 +600,13 @@ void CameraLocalizerPlugin::changedParam(const OFX::InstanceChangedArgs &args, c
     calibrateRig();
     return;
   }
+
+  //Cancel Rig calibration
+  if(paramName == kParamRigCalibrationCancel)
+  {
+    cancelRigCalibration();
+    return;
+  }
   
   //Load Rig calibration
   if(paramName == kParamRigCalibrationLoad)
@@ -539,6 +636,23 @@ void CameraLocalizerPlugin::changedParam(const OFX::InstanceChangedArgs &args, c
     return;
   }
   
+  //Rewrite the output keys with the new reduction
+  if(paramName == kParamOutputReduceKeys ||
+     (_outputReduceKeys->getValue() && (paramName == kParamOutputTranslateTolerance ||
+                                        paramName == kParamOutputRotateTolerance ||
+                                        paramName == kParamOutputIntrinsicsTolerance)))
+  {
+    writeOutputParamKeys();
+    return;
+  }
+
+  //Track file export
+  if(paramName == kParamOutputExportTrack)
+  {
+    exportTrackFile();
+    return;
+  }
+
   //Clear Current Frame
   if(paramName == kParamCacheClearCurrentFrame)
   {
@@ -560,7 +674,7 @@ void CameraLocalizerPlugin::changedParam(const OFX::InstanceChangedArgs &args, c
   //Input Parameter
   std::size_t input = getParamInputId(paramName);
   
-  if(input < K_MAX_INPUTS)
+  if(input < _inputs.size())
   {
     if(paramName == kParamInputDistortion(input))
     {
@@ -583,24 +697,24 @@ void CameraLocalizerPlugin::changedParam(const OFX::InstanceChangedArgs &args, c
     if(paramName == kParamInputLensCalibrationFile(input))
     {
       openMVG::cameras::Pinhole_Intrinsic_Radial_K3 intrinsic; //TODO : multiple camera type
-      openMVG::dataio::readCalibrationFromFile(_inputLensCalibrationFile[input]->getValue(), intrinsic);
+      openMVG::dataio::readCalibrationFromFile(_inputs[input].lensCalibrationFile->getValue(), intrinsic);
 
-      _inputFocalLength[input]->setValue(intrinsic.focal());
-      _inputOpticalCenter[input]->setValue(intrinsic.principal_point()(0), intrinsic.principal_point()(1));
-      _inputLensDistortionMode[input]->setValue(LocalizerProcessData::getLensDistortionModelFromEnum(intrinsic.getType()));
+      _inputs[input].focalLength->setValue(intrinsic.focal());
+      _inputs[input].opticalCenter->setValue(intrinsic.principal_point()(0), intrinsic.principal_point()(1));
+      _inputs[input].lensDistortionMode->setValue(LocalizerProcessData::getLensDistortionModelFromEnum(intrinsic.getType()));
 
       const std::vector<double>& parameters = intrinsic.getDistortionParams();
 
       if(parameters.size() > 0)
-        _inputLensDistortionCoef1[input]->setValue(parameters[0]);
+        _inputs[input].lensDistortionCoef1->setValue(parameters[0]);
       if(parameters.size() > 1)
-        _inputLensDistortionCoef2[input]->setValue(parameters[1]);
+        _inputs[input].lensDistortionCoef2->setValue(parameters[1]);
       if(parameters.size() > 2)
-        _inputLensDistortionCoef3[input]->setValue(parameters[2]);
+        _inputs[input].lensDistortionCoef3->setValue(parameters[2]);
       if(parameters.size() > 3)
-        _inputLensDistortionCoef4[input]->setValue(parameters[3]);
+        _inputs[input].lensDistortionCoef4->setValue(parameters[3]);
       if(parameters.size() > 4)
-        std::cerr << "[CameraLocalizer] Warning: There is some ignored distortion parameters." << std::endl;
+        OFXMVG_LOG_WARNING("changedParam") << "some distortion parameters are ignored" << Common::kv("input", input);
 
       return;
     }
@@ -610,73 +724,206 @@ void CameraLocalizerPlugin::changedParam(const OFX::InstanceChangedArgs &args, c
 
 void CameraLocalizerPlugin::calibrateRig()
 {
-  openMVG::rig::Rig rigCalibration;
-  std::vector< std::vector<openMVG::localization::LocalizationResult> > dataPerCamera(getNbConnectedInput());
+  OFXMVG_TRACE_SCOPE("calibrateRig");
+  if(_rigCalibrationTask)
+  {
+    sendMessage(OFX::Message::eMessageWarning, "rig.calibration.process", "The Rig calibration is already running.");
+    return;
+  }
+  if(!isRigInInput())
+  {
+    sendMessage(OFX::Message::eMessageError, "rig.calibration.process", "The Rig calibration needs at least 2 connected input clips.");
+    return;
+  }
 
-  //Collect cache data per camera
+  //Collect cache data per camera, on the frames localized by all the cameras
+  std::vector< std::vector<openMVG::localization::LocalizationResult> > dataPerCamera(getNbConnectedInput());
   for(auto &framesDataAtTime : _framesData)
   {
-    assert(getNbConnectedInput() == framesDataAtTime.second.size());
-    for(std::size_t cameraIndex = 0; cameraIndex < framesDataAtTime.second.size(); ++cameraIndex)
+    bool isLocalizedByAll = true;
+    for(std::size_t clipIndex : _connectedClipIdx)
     {
-      auto &cameraFrameDataAtTime = framesDataAtTime.second[cameraIndex];
-      if(cameraFrameDataAtTime.isLocalized())
+      const auto cameraFrameDataAtTime = framesDataAtTime.second.find(clipIndex);
+      if(cameraFrameDataAtTime == framesDataAtTime.second.end())
+      {
+        isLocalizedByAll = false;
+        break;
+      }
+      std::lock_guard<std::mutex> guard(cameraFrameDataAtTime->second.mutex);
+      if(!cameraFrameDataAtTime->second.isLocalized())
       {
-        dataPerCamera[cameraIndex].push_back(framesDataAtTime.second[cameraIndex].localizationResult);
+        isLocalizedByAll = false;
+        break;
       }
     }
-  }
+    if(!isLocalizedByAll)
+      continue;
 
-  //Set tracking result per camera
-  for(std::size_t cameraIndex = 0; cameraIndex < dataPerCamera.size(); ++cameraIndex)
-  {
-    rigCalibration.setTrackingResult(dataPerCamera[cameraIndex], cameraIndex);
+    for(std::size_t cameraIndex = 0; cameraIndex < getNbConnectedInput(); ++cameraIndex)
+    {
+      const FrameData &cameraFrameDataAtTime = framesDataAtTime.second.at(_connectedClipIdx[cameraIndex]);
+      std::lock_guard<std::mutex> guard(cameraFrameDataAtTime.mutex);
+      dataPerCamera[cameraIndex].push_back(cameraFrameDataAtTime.localizationResult);
+    }
   }
-
-  if(!rigCalibration.initializeCalibration())
+  const std::size_t nbFrames = dataPerCamera.front().size();
+  if(nbFrames == 0)
   {
     sendMessage(OFX::Message::eMessageError, "rig.calibration.process",
-        "Unable to find a proper initialization for the relative poses for Rig calibration  ! Aborting...");
+        "No frame is localized by all the cameras, track the Rig before its calibration.");
     return;
   }
 
-  if(!rigCalibration.optimizeCalibration())
-  {
-    sendMessage(OFX::Message::eMessageWarning, "rig.calibration.process",
-        "Unable to optimize the relative poses for Rig calibration ! Aborting...");
-    return;
-  }
-  else
+  RigCalibrationSettings settings;
+  settings.nbInitFrames = static_cast<std::size_t>(_rigCalibrationNbFrames->getValue());
+  settings.nbHypotheses = static_cast<std::size_t>(_rigCalibrationNbHypotheses->getValue());
+  settings.maxResidualError = _reprojectionError->getValue();
+
+  //The results are moved to the task, not copied
+  const std::size_t nbCameras = dataPerCamera.size();
+  std::shared_ptr< const std::vector< std::vector<openMVG::localization::LocalizationResult> > > taskData =
+    std::make_shared< std::vector< std::vector<openMVG::localization::LocalizationResult> > >(std::move(dataPerCamera));
+
+  _rigCalibrationTask.reset(new RigCalibrationTask());
+  RigCalibrationTask *task = _rigCalibrationTask.get();
+  task->clipIndices = _connectedClipIdx;
+  task->future = Common::ThreadPool::instance().submit([task, settings, taskData]()
   {
-    std::cout << "rig calibration : [write] clear cache" << std::endl;
+    Localizer::calibrateRig(*taskData, settings, task->result, [task](const RigCalibrationProgress& progress)
+    {
+      std::lock_guard<std::mutex> lock(task->mutex);
+      //The progress is reported concurrently, keep the most advanced one
+      if(progress.step > task->progress.step ||
+         (progress.step == task->progress.step && progress.nbDone >= task->progress.nbDone))
+      {
+        task->progress = progress;
+        task->isProgressUpdated = true;
+      }
+      return !task->isCanceled;
+    });
+  });
 
-    // Clear all keys, as they contain localization of each camera independently without RIG constraint (which is the input of the rig calibration).
-    clearOutputParamValues();
-    invalidRender();
+  _rigCalibration->setEnabled(false);
+  _rigCalibrationCancel->setEnabled(true);
+  _rigCalibrationProgress->setValue(0.0);
+  _rigCalibrationStatus->setValue("Initializing from " + std::to_string(std::min(settings.nbInitFrames, nbFrames)) + " frames among " + std::to_string(nbFrames));
+  OFXMVG_LOG_INFO("calibrateRig") << "rig calibration started"
+    << Common::kv("nbFrames", nbFrames)
+    << Common::kv("nbCameras", nbCameras)
+    << Common::kv("nbHypotheses", settings.nbHypotheses);
+}
 
-    // Update cameras subposes with RIG calibration results
-    const std::vector<openMVG::geometry::Pose3>& subposes = rigCalibration.getRelativePoses();
+void CameraLocalizerPlugin::cancelRigCalibration()
+{
+  if(!_rigCalibrationTask)
+    return;
+  _rigCalibrationTask->isCanceled = true;
+  _rigCalibrationTask->future.wait();
+  updateRigCalibrationTask();
+}
+
+void CameraLocalizerPlugin::updateBackgroundStatus()
+{
+  updateRigCalibrationTask();
+}
 
-    for(std::size_t pose = 0; pose < subposes.size(); ++pose)
+void CameraLocalizerPlugin::updateRigCalibrationTask()
+{
+  //Parameters are set out of the lock: setValue calls back changedParam, the nested polls are skipped
+  _rigCalibrationTaskPoller.poll(_rigCalibrationTask,
+    [this](RigCalibrationTask &task)
     {
-      std::size_t input = pose + 1; //don't have main camera
+      bool isProgressUpdated = false;
+      RigCalibrationProgress progress;
+      {
+        std::lock_guard<std::mutex> lock(task.mutex);
+        std::swap(isProgressUpdated, task.isProgressUpdated);
+        progress = task.progress;
+      }
+      if(!isProgressUpdated)
+        return;
+      //The initialization is the first half, the refinement the second one
+      const double stepFraction = progress.nbTotal ? std::min(1.0, double(progress.nbDone) / progress.nbTotal) : 0.0;
+      const double fraction = 0.5 * (progress.step + stepFraction);
+      std::ostringstream status;
+      if(progress.step == eRigCalibrationStepInitialization)
+        status << "Hypothesis " << progress.nbDone << "/" << progress.nbTotal;
+      else
+        status << "Refinement, error " << progress.error << " px";
+      _rigCalibrationProgress->setValue(std::max(fraction, _rigCalibrationProgress->getValue()));
+      _rigCalibrationStatus->setValue(status.str());
+    },
+    [this](RigCalibrationTask &doneTask)
+    {
+      _rigCalibration->setEnabled(true);
+      _rigCalibrationCancel->setEnabled(false);
+      try
+      {
+        doneTask.future.get();
+      }
+      catch(std::exception &e)
+      {
+        _rigCalibrationStatus->setValue("Failed");
+        sendMessage(OFX::Message::eMessageError, "rig.calibration.process", "The Rig calibration failed : " + std::string(e.what()));
+        return;
+      }
+      if(doneTask.isCanceled)
+      {
+        _rigCalibrationStatus->setValue("Canceled");
+        OFXMVG_LOG_INFO("calibrateRig") << "rig calibration canceled";
+        return;
+      }
 
-      std::cout << "rig calibration : [write] update relative pose : " << pose << " for input : " << input << std::endl; 
+      const RigCalibrationResult &result = doneTask.result;
+      if(!result.isCalibrated)
+      {
+        _rigCalibrationStatus->setValue("Not calibrated");
+        sendMessage(OFX::Message::eMessageError, "rig.calibration.process",
+            "Unable to find a proper initialization for the relative poses for Rig calibration  ! Aborting...");
+        return;
+      }
 
-      const auto rotate = subposes[pose].rotation();
-      const auto center = subposes[pose].center();
+      OFXMVG_LOG_INFO("calibrateRig") << "clear cache";
 
-      _inputRelativePoseRotateM1[input]->setValue(rotate(0,0), rotate(0,1), rotate(0,2));
-      _inputRelativePoseRotateM2[input]->setValue(rotate(1,0), rotate(1,1), rotate(1,2));
-      _inputRelativePoseRotateM3[input]->setValue(rotate(2,0), rotate(2,1), rotate(2,2));
-      _inputRelativePoseCenter[input]->setValue(center(0), center(1), center(2));
-    }
-    
-    sendMessage(OFX::Message::eMessageMessage, "rig.calibration.process",
-        "Rig calibration succeed ! Relative Poses have been update.");
+      // Clear all keys, as they contain localization of each camera independently without RIG constraint (which is the input of the rig calibration).
+      clearOutputParamValues();
+      invalidRender();
 
-    _rigMode->setValue((int)EParamRigMode::eParamRigModeKnown);
-  }
+      // Update cameras subposes with RIG calibration results
+      beginEditBlock("calibrateRig");
+      double maxError = 0.0;
+      for(std::size_t pose = 0; pose < result.relativePoses.size(); ++pose)
+      {
+        std::size_t input = doneTask.clipIndices[pose + 1]; //don't have main camera
+
+        OFXMVG_LOG_INFO("calibrateRig") << "update relative pose"
+          << Common::kv("pose", pose)
+          << Common::kv("input", input)
+          << Common::kv("meanInlierError", result.errors[pose]);
+
+        const auto rotate = result.relativePoses[pose].rotation();
+        const auto center = result.relativePoses[pose].center();
+
+        _inputs[input].relativePoseRotateM1->setValue(rotate(0,0), rotate(0,1), rotate(0,2));
+        _inputs[input].relativePoseRotateM2->setValue(rotate(1,0), rotate(1,1), rotate(1,2));
+        _inputs[input].relativePoseRotateM3->setValue(rotate(2,0), rotate(2,1), rotate(2,2));
+        _inputs[input].relativePoseCenter->setValue(center(0), center(1), center(2));
+        maxError = std::max(maxError, result.errors[pose]);
+      }
+      _rigCalibrationProgress->setValue(1.0);
+      std::ostringstream status;
+      status << "Calibrated on " << result.nbFrames << " frames, error " << maxError << " px";
+      _rigCalibrationStatus->setValue(status.str());
+      _rigMode->setValue((int)EParamRigMode::eParamRigModeKnown);
+      endEditBlock();
+
+      sendMessage(OFX::Message::eMessageMessage, "rig.calibration.process",
+          "Rig calibration succeed ! Relative Poses have been update.");
+      OFXMVG_LOG_INFO("calibrateRig") << "rig calibrated"
+        << Common::kv("nbFrames", result.nbFrames)
+        << Common::kv("nbValidHypotheses", result.nbValidHypotheses)
+        << Common::kv("maxMeanInlierError", maxError);
+    });
 }
 
 void CameraLocalizerPlugin::loadRigCalibration(const std::string &filePath)
@@ -684,10 +931,11 @@ void CameraLocalizerPlugin::loadRigCalibration(const std::string &filePath)
   std::vector<openMVG::geometry::Pose3> subposes;
   openMVG::rig::loadRigCalibration(filePath, subposes);
 
-  if(subposes.size() >= K_MAX_INPUTS)
+  if(subposes.size() >= _inputs.size())
   {
     sendMessage(OFX::Message::eMessageWarning, "rig.subpose.file",
-            "The number of cameras in the RIG file contains more cameras than the plugin supports.");
+            "The RIG file contains more cameras than the plugin supports (" + std::to_string(_inputs.size()) + " inputs), "
+            "set OFXMVG_LOCALIZER_MAX_INPUTS to describe more inputs.");
   }
   else if(subposes.size() != (getNbConnectedInput() - 1))
   {
@@ -698,7 +946,7 @@ void CameraLocalizerPlugin::loadRigCalibration(const std::string &filePath)
   //Reset all relative poses to 0
   clearAllRelativePoses();
 
-  const std::size_t nbSubPoses = std::min(subposes.size(), std::size_t(K_MAX_INPUTS - 1));
+  const std::size_t nbSubPoses = std::min(subposes.size(), _inputs.size() - 1);
 
   for(std::size_t input = 0; input < nbSubPoses; ++input)
   {
@@ -712,10 +960,10 @@ void CameraLocalizerPlugin::loadRigCalibration(const std::string &filePath)
     const auto rotate = subposes[input].rotation();
     const auto center = subposes[input].center();
 
-    _inputRelativePoseRotateM1[clipIndex]->setValue(rotate(0,0), rotate(0,1), rotate(0,2));
-    _inputRelativePoseRotateM2[clipIndex]->setValue(rotate(1,0), rotate(1,1), rotate(1,2));
-    _inputRelativePoseRotateM3[clipIndex]->setValue(rotate(2,0), rotate(2,1), rotate(2,2));
-    _inputRelativePoseCenter[clipIndex]->setValue(center(0), center(1), center(2));
+    _inputs[clipIndex].relativePoseRotateM1->setValue(rotate(0,0), rotate(0,1), rotate(0,2));
+    _inputs[clipIndex].relativePoseRotateM2->setValue(rotate(1,0), rotate(1,1), rotate(1,2));
+    _inputs[clipIndex].relativePoseRotateM3->setValue(rotate(2,0), rotate(2,1), rotate(2,2));
+    _inputs[clipIndex].relativePoseCenter->setValue(center(0), center(1), center(2));
   }
 }
 
@@ -728,10 +976,10 @@ void CameraLocalizerPlugin::saveRigCalibration(const std::string &filePath)
     auto &rotate = subposes[input - 1].rotation();
     auto &center = subposes[input - 1].center();
 
-    _inputRelativePoseRotateM1[input]->getValue(rotate(0,0), rotate(0,1), rotate(0,2));
-    _inputRelativePoseRotateM2[input]->getValue(rotate(1,0), rotate(1,1), rotate(1,2));
-    _inputRelativePoseRotateM3[input]->getValue(rotate(2,0), rotate(2,1), rotate(2,2));
-    _inputRelativePoseCenter[input]->getValue(center(0), center(1), center(2));
+    _inputs[input].relativePoseRotateM1->getValue(rotate(0,0), rotate(0,1), rotate(0,2));
+    _inputs[input].relativePoseRotateM2->getValue(rotate(1,0), rotate(1,1), rotate(1,2));
+    _inputs[input].relativePoseRotateM3->getValue(rotate(2,0), rotate(2,1), rotate(2,2));
+    _inputs[input].relativePoseCenter->getValue(center(0), center(1), center(2));
   }
   if(openMVG::rig::saveRigCalibration(filePath, subposes))
   {
@@ -747,14 +995,14 @@ void CameraLocalizerPlugin::saveRigCalibration(const std::string &filePath)
 
 void CameraLocalizerPlugin::reset()
 {
-  std::cout << "reset : [parameters] update" << std::endl;
+  OFXMVG_LOG_DEBUG("reset") << "update parameters";
   //Reset plugin parameters
   _uptodateParam = false;
   _uptodateDescriptor = false;
   
   updateConnectedClipIndexCollection();
   
-  for(std::size_t input = 0; input < K_MAX_INPUTS; ++input)
+  for(std::size_t input = 0; input < _inputs.size(); ++input)
   {
     updateLensDistortion(input);
     updateLensDistortionMode(input);
@@ -765,13 +1013,17 @@ void CameraLocalizerPlugin::reset()
   updateTrackingRangeMode();
   updateCameraOutputIndexRange();
   
+  //The tracer is process-wide, don't stop another instance session
+  if(_debugTrace->getValue())
+    updateTracing();
+  
   _trackingButton->setEnabled(hasInput());
   
   //Reset plugin cache
   if(!_serializedResults->getValue().empty())
   {
     std::size_t nbFrameInCache = 0; //Only for prints
-    std::cout << "reset : [cache] load serialized data" << std::endl;
+    OFXMVG_LOG_DEBUG("reset") << "load serialized data";
     try
     {
       std::istringstream serializedData(_serializedResults->getValue());
@@ -785,7 +1037,7 @@ void CameraLocalizerPlugin::reset()
           cameraframeDataAtTime.second.undistortedPt2D = cameraframeDataAtTime.second.localizationResult.retrieveUndistortedPt2D();
         }
       }
-      std::cout << "reset : [cache] " << nbFrameInCache << " frames loaded in cache from serialized data" << std::endl;
+      OFXMVG_LOG_INFO("reset") << "frames loaded in cache from serialized data" << Common::kv("nbFrames", nbFrameInCache);
     }
     catch(std::exception &e)
     {
@@ -797,31 +1049,55 @@ void CameraLocalizerPlugin::reset()
 
  void CameraLocalizerPlugin::clearAllRelativePoses()
  {
-  for(std::size_t i = 0; i < K_MAX_INPUTS; ++i)
+  for(std::size_t i = 0; i < _inputs.size(); ++i)
   {
-    _inputRelativePoseRotateM1[i]->setValue(0, 0, 0);
-    _inputRelativePoseRotateM2[i]->setValue(0, 0, 0);
-    _inputRelativePoseRotateM3[i]->setValue(0, 0, 0);
-    _inputRelativePoseCenter[i]->setValue(0, 0, 0);
+    _inputs[i].relativePoseRotateM1->setValue(0, 0, 0);
+    _inputs[i].relativePoseRotateM2->setValue(0, 0, 0);
+    _inputs[i].relativePoseRotateM3->setValue(0, 0, 0);
+    _inputs[i].relativePoseCenter->setValue(0, 0, 0);
   }
  }
 
 void CameraLocalizerPlugin::serializeCacheData()
 {
+  OFXMVG_TRACE_SCOPE("serializeCacheData");
   std::stringstream serializedData;
   {
     cereal::XMLOutputArchive archive( serializedData );
     archive( CEREAL_NVP(_framesData) );
   }
   _serializedResults->setValue( serializedData.str() );
+  Common::traceCounter("cacheBytes", serializedData.str().size());
+}
+
+void CameraLocalizerPlugin::updateTracing()
+{
+  Common::Tracer &tracer = Common::Tracer::instance();
+  //The process-level tracing has priority
+  if(tracer.isEnabledByEnvironment())
+    return;
+  const std::string folder = _debugFolder->getValue();
+  
+  if(_debugTrace->getValue() && !folder.empty())
+  {
+    if(tracer.isEnabled() && (tracer.getFolder() == folder))
+      return;
+    //Write the previous session before switching folder
+    tracer.disable();
+    tracer.enable(folder);
+  }
+  else
+  {
+    tracer.disable();
+  }
 }
 
 void CameraLocalizerPlugin::updateConnectedClipIndexCollection()
 {
   _connectedClipIdx.clear();
-  for(std::size_t input = 0; input < K_MAX_INPUTS; ++input)
+  for(std::size_t input = 0; input < _inputs.size(); ++input)
   {
-      if(_srcClip[input]->isConnected())
+      if(_inputs[input].clip->isConnected())
       {
         _connectedClipIdx.push_back(input);
       }
@@ -846,7 +1122,7 @@ void CameraLocalizerPlugin::updateCameraOutputIndexRange()
     max = _connectedClipIdx.back() + 1;
     
     std::size_t value = _cameraOutputIndex->getValue();
-    if((value < min) || (value > max) || (!_srcClip[value - 1]->isConnected()))
+    if((value < min) || (value > max) || (!_inputs[value - 1].clip->isConnected()))
     {
       _cameraOutputIndex->setValue(min);
     }
@@ -873,30 +1149,35 @@ void CameraLocalizerPlugin::updateRigOptions()
   _rigCalibrationSave->setIsSecret(unknown);
   _rigCalibrationFile->setIsSecret(unknown);
   _rigCalibration->setIsSecret(!unknown);
+  _rigCalibrationNbFrames->setIsSecret(!unknown);
+  _rigCalibrationNbHypotheses->setIsSecret(!unknown);
+  _rigCalibrationCancel->setIsSecret(!unknown);
+  _rigCalibrationProgress->setIsSecret(!unknown);
+  _rigCalibrationStatus->setIsSecret(!unknown);
   
-  for (std::size_t input = 0; input < K_MAX_INPUTS; ++input)
+  for (std::size_t input = 0; input < _inputs.size(); ++input)
   {
-    _inputRelativePoseRotateM1[input]->setIsSecret(unknown);
-    _inputRelativePoseRotateM2[input]->setIsSecret(unknown);
-    _inputRelativePoseRotateM3[input]->setIsSecret(unknown);
-    _inputRelativePoseCenter[input]->setIsSecret(unknown);
-    _inputGroupRelativePose[input]->setIsSecret(unknown);
+    _inputs[input].relativePoseRotateM1->setIsSecret(unknown);
+    _inputs[input].relativePoseRotateM2->setIsSecret(unknown);
+    _inputs[input].relativePoseRotateM3->setIsSecret(unknown);
+    _inputs[input].relativePoseCenter->setIsSecret(unknown);
+    _inputs[input].groupRelativePose->setIsSecret(unknown);
   }
 }
 
 void CameraLocalizerPlugin::updateLensDistortion(std::size_t input)
 {
-  bool unknown = (static_cast<EParamLensDistortion>(_inputLensDistortion[input]->getValue()) == eParamLensDistortionUnKnown);
-  _inputLensDistortionMode[input]->setIsSecret(unknown);
-  _inputLensDistortionCoef1[input]->setIsSecret(unknown);
-  _inputLensDistortionCoef2[input]->setIsSecret(unknown);
-  _inputLensDistortionCoef3[input]->setIsSecret(unknown);
-  _inputLensDistortionCoef4[input]->setIsSecret(unknown);
+  bool unknown = (static_cast<EParamLensDistortion>(_inputs[input].lensDistortion->getValue()) == eParamLensDistortionUnKnown);
+  _inputs[input].lensDistortionMode->setIsSecret(unknown);
+  _inputs[input].lensDistortionCoef1->setIsSecret(unknown);
+  _inputs[input].lensDistortionCoef2->setIsSecret(unknown);
+  _inputs[input].lensDistortionCoef3->setIsSecret(unknown);
+  _inputs[input].lensDistortionCoef4->setIsSecret(unknown);
 }
 
 void CameraLocalizerPlugin::updateLensDistortionMode(std::size_t input)
 {
-  EParamLensDistortionMode distortionMode = static_cast<EParamLensDistortionMode>(_inputLensDistortionMode[input]->getValue());
+  EParamLensDistortionMode distortionMode = static_cast<EParamLensDistortionMode>(_inputs[input].lensDistortionMode->getValue());
   //TODO : display the good number of coefficient per distortion mode
 }
 
@@ -909,9 +1190,9 @@ void CameraLocalizerPlugin::updateTrackingRangeMode()
 
 void CameraLocalizerPlugin::updateFocalLength(std::size_t input)
 {
-  bool unknown = (static_cast<EParamFocalLengthMode>(_inputFocalLengthMode[input]->getValue()) == eParamFocalLengthModeUnKnown);
-  _inputFocalLength[input]->setIsSecret(unknown);
-  _inputFocalLengthVarying[input]->setIsSecret(unknown);
+  bool unknown = (static_cast<EParamFocalLengthMode>(_inputs[input].focalLengthMode->getValue()) == eParamFocalLengthModeUnKnown);
+  _inputs[input].focalLength->setIsSecret(unknown);
+  _inputs[input].focalLengthVarying->setIsSecret(unknown);
 }
 
 void CameraLocalizerPlugin::updateOutputParamAtTime(double time, 
@@ -919,33 +1200,324 @@ void CameraLocalizerPlugin::updateOutputParamAtTime(double time,
                                                     const openMVG::localization::LocalizationResult& locResults, 
                                                     const std::vector<openMVG::features::SIOPointFeature>& extractedFeatures) 
 {
-  setPoseToParamsAtTime(
-          locResults.getPose(),
-          time,
-          _cameraOutputTranslate[clipIndex],
-          _cameraOutputRotate[clipIndex],
-          _cameraOutputScale[clipIndex]);
+  OutputParamValues values;
+  getOutputParamValues(locResults, extractedFeatures, _inputs[clipIndex].sensorWidth->getValue(), values);
 
+  //Each key is a host round-trip with its own notifications: keep them for the end of the sequence.
+  //The reduced keys need the neighbour frames, they are written from the cache.
+  const bool isReduced = _outputReduceKeys->getValue();
+  {
+    std::lock_guard<std::mutex> lock(_pendingOutputMutex);
+    if(_isSequenceRendering || isReduced)
+    {
+      _pendingOutputValues[time][clipIndex] = values;
+      Common::traceCounter("pendingOutputFrames", _pendingOutputValues.size());
+      return;
+    }
+  }
+  setOutputParamValuesAtTime(time, clipIndex, values);
+}
 
-  setIntrinsicsToParamsAtTime(
-          locResults.getIntrinsics(),
-          time,
-          _inputSensorWidth[clipIndex]->getValue(),
-          _cameraOutputFocalLength[clipIndex],
-          _cameraOutputOpticalCenter[clipIndex]);
+void CameraLocalizerPlugin::setOutputParamValuesAtTime(double time, std::size_t clipIndex, const OutputParamValues& values)
+{
+  _inputs[clipIndex].outputTranslate->setValueAtTime(time, values.translate(0), values.translate(1), values.translate(2));
+  _inputs[clipIndex].outputRotate->setValueAtTime(time, values.rotate(0), values.rotate(1), values.rotate(2));
+  _inputs[clipIndex].outputScale->setValueAtTime(time, 1, 1, 1);
 
+  _inputs[clipIndex].outputFocalLength->setValueAtTime(time, values.focalLength);
+  _inputs[clipIndex].outputOpticalCenter->setValueAtTime(time, values.opticalCenter(0), values.opticalCenter(1));
 
-  setStatToParamsAtTime(
-          locResults,
-          extractedFeatures, //read only
-          time,
-          _outputStatErrorMean[clipIndex],
-          _outputStatErrorMin[clipIndex],
-          _outputStatErrorMax[clipIndex],
-          _outputStatNbMatchedImages[clipIndex],
-          _outputStatNbDetectedFeatures[clipIndex],
-          _outputStatNbMatchedFeatures[clipIndex],
-          _outputStatNbInlierFeatures[clipIndex]);
+  if(values.hasErrorStats)
+  {
+    _inputs[clipIndex].outputStatErrorMean->setValueAtTime(time, values.errorMean);
+    _inputs[clipIndex].outputStatErrorMin->setValueAtTime(time, values.errorMin);
+    _inputs[clipIndex].outputStatErrorMax->setValueAtTime(time, values.errorMax);
+  }
+  _inputs[clipIndex].outputStatNbMatchedImages->setValueAtTime(time, values.nbMatchedImages);
+  _inputs[clipIndex].outputStatNbDetectedFeatures->setValueAtTime(time, values.nbDetectedFeatures);
+  _inputs[clipIndex].outputStatNbMatchedFeatures->setValueAtTime(time, values.nbMatchedFeatures);
+  _inputs[clipIndex].outputStatNbInlierFeatures->setValueAtTime(time, values.nbInlierFeatures);
+}
+
+bool CameraLocalizerPlugin::commitOutputParamValues()
+{
+  std::map<OfxTime, std::map<std::size_t, OutputParamValues> > pendingOutputValues;
+  {
+    std::lock_guard<std::mutex> lock(_pendingOutputMutex);
+    std::swap(pendingOutputValues, _pendingOutputValues);
+  }
+  if(pendingOutputValues.empty())
+    return false;
+
+  OFXMVG_TRACE_SCOPE("commitOutputParamValues");
+  //The reduction needs the neighbour frames: the keys of the rendered range are rewritten from the cache
+  if(_outputReduceKeys->getValue())
+  {
+    writeOutputParamKeys(pendingOutputValues.begin()->first, pendingOutputValues.rbegin()->first);
+    serializeCacheData();
+    return true;
+  }
+
+  //A single undo entry and change notification for the whole sequence
+  beginEditBlock("localizeSequence");
+  for(const auto& timeValues : pendingOutputValues)
+  {
+    for(const auto& clipValues : timeValues.second)
+      setOutputParamValuesAtTime(timeValues.first, clipValues.first, clipValues.second);
+  }
+  serializeCacheData();
+  endEditBlock();
+  OFXMVG_LOG_DEBUG("commitOutputParamValues") << "output keys set" << Common::kv("nbFrames", pendingOutputValues.size());
+  return true;
+}
+
+void CameraLocalizerPlugin::writeOutputParamKeys(OfxTime firstTime, OfxTime lastTime)
+{
+  OFXMVG_TRACE_SCOPE("writeOutputParamKeys");
+  const bool isReduced = _outputReduceKeys->getValue();
+  const bool isAllKeys = (firstTime == -std::numeric_limits<OfxTime>::infinity() && lastTime == std::numeric_limits<OfxTime>::infinity());
+  const double translateTolerance = _outputTranslateTolerance->getValue();
+  const double rotateTolerance = _outputRotateTolerance->getValue();
+  const double intrinsicsTolerance = _outputIntrinsicsTolerance->getValue();
+  const double kHostTolerance = 1e-6; //rounding of the values read back from the host
+  std::size_t nbFrames = 0;
+  std::size_t nbKeys = 0;
+  std::size_t nbHostKeys = 0;
+
+  beginEditBlock("writeOutputParamKeys");
+  if(isAllKeys)
+  {
+    for(OFX::ValueParam* outputParam: _outputParams)
+      outputParam->deleteAllKeys();
+  }
+
+  for(std::size_t clipIndex = 0; clipIndex < _inputs.size(); ++clipIndex)
+  {
+    //Values of the localized frames of the camera, in time order
+    std::vector<double> times;
+    std::vector<OutputParamValues> values;
+    const double sensorWidth = _inputs[clipIndex].sensorWidth->getValue();
+    for(const auto& frameData : _framesData)
+    {
+      const auto inputFrameData = frameData.second.find(clipIndex);
+      if(inputFrameData == frameData.second.end())
+        continue;
+      std::lock_guard<std::mutex> guard(inputFrameData->second.mutex);
+      if(!inputFrameData->second.localizationResult.isValid())
+        continue;
+      times.push_back(frameData.first);
+      values.emplace_back();
+      getOutputParamValues(inputFrameData->second.localizationResult, inputFrameData->second.extractedFeatures, sensorWidth, values.back());
+    }
+
+    if(!isReduced)
+    {
+      for(std::size_t i = 0; i < times.size(); ++i)
+      {
+        if(times[i] < firstTime || times[i] > lastTime)
+          continue;
+        setOutputParamValuesAtTime(times[i], clipIndex, values[i]);
+        nbKeys += _outputParams.size() / _inputs.size();
+        ++nbFrames;
+      }
+      continue;
+    }
+
+    if(times.empty())
+      continue;
+    std::vector<openMVG::Vec3> rotations(values.size());
+    for(std::size_t i = 0; i < values.size(); ++i)
+      rotations[i] = values[i].rotate;
+    unwrapEulerAngles(rotations);
+
+    //One curve per parameter, the error statistics only exist on the frames with inliers
+    struct Curve
+    {
+      OFX::ValueParam *param;
+      double tolerance;
+      std::function<void(double, const openMVG::Vec&)> setKey;
+      std::function<openMVG::Vec(double)> getValue; //host interpolated value
+      std::vector<double> times;
+      std::vector<openMVG::Vec> values;
+
+      void add(double time, const openMVG::Vec& value)
+      {
+        times.push_back(time);
+        values.push_back(value);
+      }
+    };
+    OFX::Double3DParam *outputTranslate = _inputs[clipIndex].outputTranslate;
+    OFX::Double3DParam *outputRotate = _inputs[clipIndex].outputRotate;
+    OFX::Double2DParam *outputOpticalCenter = _inputs[clipIndex].outputOpticalCenter;
+    auto getDouble3DCurve = [](OFX::Double3DParam *param, double tolerance)
+    {
+      return Curve{param, tolerance,
+        [param](double time, const openMVG::Vec& value) { param->setValueAtTime(time, value(0), value(1), value(2)); },
+        [param](double time) { openMVG::Vec value(3); param->getValueAtTime(time, value(0), value(1), value(2)); return value; },
+        {}, {}};
+    };
+    auto getDoubleCurve = [](OFX::DoubleParam *param, double tolerance)
+    {
+      return Curve{param, tolerance,
+        [param](double time, const openMVG::Vec& value) { param->setValueAtTime(time, value(0)); },
+        [param](double time) { return openMVG::Vec::Constant(1, param->getValueAtTime(time)); },
+        {}, {}};
+    };
+    Curve translate = getDouble3DCurve(outputTranslate, translateTolerance);
+    Curve rotate = getDouble3DCurve(outputRotate, rotateTolerance);
+    Curve focalLength = getDoubleCurve(_inputs[clipIndex].outputFocalLength, intrinsicsTolerance);
+    Curve opticalCenter{outputOpticalCenter, intrinsicsTolerance,
+      [outputOpticalCenter](double time, const openMVG::Vec& value) { outputOpticalCenter->setValueAtTime(time, value(0), value(1)); },
+      [outputOpticalCenter](double time) { openMVG::Vec value(2); outputOpticalCenter->getValueAtTime(time, value(0), value(1)); return value; },
+      {}, {}};
+    //The statistics are kept exact: only the keys aligned with their neighbours are removed
+    Curve errorMean = getDoubleCurve(_inputs[clipIndex].outputStatErrorMean, 0.0);
+    Curve errorMin = getDoubleCurve(_inputs[clipIndex].outputStatErrorMin, 0.0);
+    Curve errorMax = getDoubleCurve(_inputs[clipIndex].outputStatErrorMax, 0.0);
+    Curve nbMatchedImages = getDoubleCurve(_inputs[clipIndex].outputStatNbMatchedImages, 0.0);
+    Curve nbDetectedFeatures = getDoubleCurve(_inputs[clipIndex].outputStatNbDetectedFeatures, 0.0);
+    Curve nbMatchedFeatures = getDoubleCurve(_inputs[clipIndex].outputStatNbMatchedFeatures, 0.0);
+    Curve nbInlierFeatures = getDoubleCurve(_inputs[clipIndex].outputStatNbInlierFeatures, 0.0);
+    for(std::size_t i = 0; i < values.size(); ++i)
+    {
+      const OutputParamValues &v = values[i];
+      translate.add(times[i], v.translate);
+      rotate.add(times[i], rotations[i]);
+      focalLength.add(times[i], openMVG::Vec::Constant(1, v.focalLength));
+      opticalCenter.add(times[i], v.opticalCenter);
+      if(v.hasErrorStats)
+      {
+        errorMean.add(times[i], openMVG::Vec::Constant(1, v.errorMean));
+        errorMin.add(times[i], openMVG::Vec::Constant(1, v.errorMin));
+        errorMax.add(times[i], openMVG::Vec::Constant(1, v.errorMax));
+      }
+      nbMatchedImages.add(times[i], openMVG::Vec::Constant(1, v.nbMatchedImages));
+      nbDetectedFeatures.add(times[i], openMVG::Vec::Constant(1, v.nbDetectedFeatures));
+      nbMatchedFeatures.add(times[i], openMVG::Vec::Constant(1, v.nbMatchedFeatures));
+      nbInlierFeatures.add(times[i], openMVG::Vec::Constant(1, v.nbInlierFeatures));
+      if(times[i] >= firstTime && times[i] <= lastTime)
+        ++nbFrames;
+    }
+
+    auto writeKeys = [&](const Curve& curve)
+    {
+      if(curve.times.empty())
+        return;
+      //The window of the rewritten frames ends on the neighbour keys, the keys outside are kept
+      std::size_t first = 0;
+      std::size_t last = curve.times.size() - 1;
+      if(!isAllKeys)
+      {
+        const int previousKey = curve.param->getKeyIndex(firstTime, OFX::eKeySearchBackwards);
+        if(previousKey >= 0)
+        {
+          const std::size_t next = std::upper_bound(curve.times.begin(), curve.times.end(), curve.param->getKeyTime(previousKey)) - curve.times.begin();
+          first = (next > 0) ? next - 1 : 0;
+        }
+        const int nextKey = curve.param->getKeyIndex(lastTime, OFX::eKeySearchForwards);
+        if(nextKey >= 0)
+        {
+          const std::size_t index = std::lower_bound(curve.times.begin(), curve.times.end(), curve.param->getKeyTime(nextKey)) - curve.times.begin();
+          last = std::min(index, last);
+        }
+        last = std::max(first, last);
+        for(int key = curve.param->getKeyIndex(curve.times[first], OFX::eKeySearchForwards); key >= 0;
+            key = curve.param->getKeyIndex(curve.times[first], OFX::eKeySearchForwards))
+        {
+          const double keyTime = curve.param->getKeyTime(key);
+          if(keyTime >= curve.times[last])
+            break;
+          curve.param->deleteKeyAtTime(keyTime);
+        }
+      }
+
+      const std::vector<double> windowTimes(curve.times.begin() + first, curve.times.begin() + last + 1);
+      const std::vector<openMVG::Vec> windowValues(curve.values.begin() + first, curve.values.begin() + last + 1);
+      std::vector<bool> isKey(windowTimes.size(), false);
+      for(std::size_t key : reduceKeys(windowTimes, windowValues, curve.tolerance))
+      {
+        curve.setKey(windowTimes[key], windowValues[key]);
+        isKey[key] = true;
+        ++nbKeys;
+      }
+
+      //The reduction assumes a linear interpolation, the host may use another one:
+      //a key is added on the dropped frames the host curve doesn't follow within the tolerance
+      for(bool isFollowed = false; !isFollowed;)
+      {
+        isFollowed = true;
+        std::vector<std::size_t> strayFrames;
+        for(std::size_t i = 0; i < windowTimes.size(); ++i)
+        {
+          if(!isKey[i] && (curve.getValue(windowTimes[i]) - windowValues[i]).cwiseAbs().maxCoeff() > curve.tolerance + kHostTolerance)
+            strayFrames.push_back(i);
+        }
+        for(std::size_t i : strayFrames)
+        {
+          curve.setKey(windowTimes[i], windowValues[i]);
+          isKey[i] = true;
+          ++nbKeys;
+          ++nbHostKeys;
+          isFollowed = false;
+        }
+      }
+    };
+    writeKeys(translate);
+    writeKeys(rotate);
+    _inputs[clipIndex].outputScale->setValueAtTime(times.front(), 1, 1, 1);
+    ++nbKeys;
+    writeKeys(focalLength);
+    writeKeys(opticalCenter);
+    writeKeys(errorMean);
+    writeKeys(errorMin);
+    writeKeys(errorMax);
+    writeKeys(nbMatchedImages);
+    writeKeys(nbDetectedFeatures);
+    writeKeys(nbMatchedFeatures);
+    writeKeys(nbInlierFeatures);
+  }
+  endEditBlock();
+  OFXMVG_LOG_INFO("writeOutputParamKeys") << (isReduced ? "reduced keys written" : "keys written")
+    << Common::kv("firstTime", firstTime)
+    << Common::kv("lastTime", lastTime)
+    << Common::kv("nbFrames", nbFrames)
+    << Common::kv("nbKeys", nbKeys)
+    << Common::kv("nbHostKeys", nbHostKeys);
+}
+
+void CameraLocalizerPlugin::exportTrackFile()
+{
+  OFXMVG_TRACE_SCOPE("exportTrackFile");
+  const std::string trackFilePath = _outputTrackFile->getValue();
+  if(trackFilePath.empty())
+  {
+    sendMessage(OFX::Message::eMessageError, "cameralocalization.trackfile", "No track file.");
+    return;
+  }
+  try
+  {
+    TrackFileWriter writer(trackFilePath, false);
+    for(const auto& frameData : _framesData)
+    {
+      for(const auto& inputFrameData : frameData.second)
+      {
+        std::lock_guard<std::mutex> guard(inputFrameData.second.mutex);
+        if(!inputFrameData.second.localizationResult.isValid())
+          continue;
+        TrackRecord record;
+        getTrackRecord(frameData.first, inputFrameData.first, inputFrameData.second, record);
+        writer.write(record);
+      }
+    }
+    writer.flush();
+    OFXMVG_LOG_INFO("exportTrackFile") << "track file written"
+      << Common::kv("path", trackFilePath)
+      << Common::kv("nbRecords", writer.getNbRecords());
+  }
+  catch(std::exception &e)
+  {
+    sendMessage(OFX::Message::eMessageError, "cameralocalization.trackfile", e.what());
+  }
 }
 
 void CameraLocalizerPlugin::getInputSubPose(std::size_t clipIndex, openMVG::geometry::Pose3& subPose)
@@ -953,15 +1525,15 @@ void CameraLocalizerPlugin::getInputSubPose(std::size_t clipIndex, openMVG::geom
   auto &rotate = subPose.rotation();
   auto &center = subPose.center();
 
-  _inputRelativePoseRotateM1[clipIndex]->getValue(rotate(0,0), rotate(0,1), rotate(0,2));
-  _inputRelativePoseRotateM2[clipIndex]->getValue(rotate(1,0), rotate(1,1), rotate(1,2));
-  _inputRelativePoseRotateM3[clipIndex]->getValue(rotate(2,0), rotate(2,1), rotate(2,2));
-  _inputRelativePoseCenter[clipIndex]->getValue(center(0), center(1), center(2));
+  _inputs[clipIndex].relativePoseRotateM1->getValue(rotate(0,0), rotate(0,1), rotate(0,2));
+  _inputs[clipIndex].relativePoseRotateM2->getValue(rotate(1,0), rotate(1,1), rotate(1,2));
+  _inputs[clipIndex].relativePoseRotateM3->getValue(rotate(2,0), rotate(2,1), rotate(2,2));
+  _inputs[clipIndex].relativePoseCenter->getValue(center(0), center(1), center(2));
 }
 
 bool CameraLocalizerPlugin::getInputIntrinsics(double time, std::size_t clipIndex, openMVG::cameras::Pinhole_Intrinsic &queryIntrinsics)
 {
-  EParamLensDistortion lensDistortionType = static_cast<EParamLensDistortion>(_inputLensDistortion[clipIndex]->getValue());
+  EParamLensDistortion lensDistortionType = static_cast<EParamLensDistortion>(_inputs[clipIndex].lensDistortion->getValue());
   
   const bool hasIntrinsics = lensDistortionType == eParamLensDistortionKnown || lensDistortionType == eParamLensDistortionApproximate;
   
@@ -973,16 +1545,16 @@ bool CameraLocalizerPlugin::getInputIntrinsics(double time, std::size_t clipInde
   double ppx;
   double ppy;
 
-  _inputOpticalCenter[clipIndex]->getValue(ppx, ppy);
+  _inputs[clipIndex].opticalCenter->getValue(ppx, ppy);
 
   //TODO : Change for different camera type
   queryIntrinsics.updateFromParams({
-    _inputFocalLength[clipIndex]->getValueAtTime(time),
+    _inputs[clipIndex].focalLength->getValueAtTime(time),
     ppx,
     ppy,
-    _inputLensDistortionCoef1[clipIndex]->getValue(),
-    _inputLensDistortionCoef2[clipIndex]->getValue(),
-    _inputLensDistortionCoef3[clipIndex]->getValue()
+    _inputs[clipIndex].lensDistortionCoef1->getValue(),
+    _inputs[clipIndex].lensDistortionCoef2->getValue(),
+    _inputs[clipIndex].lensDistortionCoef3->getValue()
   });
 
   return true;
@@ -990,28 +1562,38 @@ bool CameraLocalizerPlugin::getInputIntrinsics(double time, std::size_t clipInde
 
 bool CameraLocalizerPlugin::getInputsInGrayScale(double time, std::map< std::size_t, openMVG::image::Image<unsigned char> > &mapInputImage)
 {
+  //The images and params are fetched from the host first, then converted concurrently
+  std::vector< std::unique_ptr<OFX::Image> > inputImagesOFX(getNbConnectedInput());
+  std::vector<char> inputIsGrayscale(getNbConnectedInput());
   for(std::size_t input = 0; input < getNbConnectedInput(); ++input)
   {
     std::size_t clipIndex = _connectedClipIdx[input];
-    OFX::Image *inputPtr = _srcClip[clipIndex]->fetchImage(time);
+    inputImagesOFX[input].reset(_inputs[clipIndex].clip->fetchImage(time));
 
-    if(inputPtr == NULL)
+    if(!inputImagesOFX[input])
     {
       return false;
     }
+    inputIsGrayscale[input] = _inputs[clipIndex].isGrayscale->getValue();
+    mapInputImage[clipIndex]; //the map isn't modified by the tasks
+  }
 
-    Common::Image<float> inputImage(inputPtr, Common::eOrientationTopDown);
-    mapInputImage[clipIndex] = openMVG::image::Image<unsigned char>(inputImage.getWidth(), inputImage.getHeight());
+  Common::ThreadPool::instance().parallelFor(0, getNbConnectedInput(), [&](std::size_t input)
+  {
+    std::size_t clipIndex = _connectedClipIdx[input];
+    Common::Image<float> inputImage(inputImagesOFX[input].get(), Common::eOrientationTopDown);
+    openMVG::image::Image<unsigned char> &imageGray = mapInputImage.at(clipIndex);
+    imageGray = openMVG::image::Image<unsigned char>(inputImage.getWidth(), inputImage.getHeight());
     
-    if(_inputIsGrayscale[clipIndex]->getValue())
+    if(inputIsGrayscale[input])
     {
-      convertGGG32ToGRAY8(inputImage, mapInputImage[clipIndex]);
+      convertGGG32ToGRAY8(inputImage, imageGray);
     }
     else
     {
-      convertRGB32ToGRAY8(inputImage, mapInputImage[clipIndex]);
+      convertRGB32ToGRAY8(inputImage, imageGray);
     }
-  }
+  });
   return true;
 }
 
@@ -1,11 +1,15 @@
 #pragma once
 #include "ofxsImageEffect.h"
 #include "CameraLocalizer.hpp"
+#include "TrackFile.hpp"
+#include "RigCalibration.hpp"
 #include "CameraLocalizerPluginFactory.hpp"
 #include "CameraLocalizerPluginDefinition.hpp"
+#include "../common/BackgroundTaskPoller.hpp"
 
-//Maximum number of input clip 
-#define K_MAX_INPUTS 5
+#include <atomic>
+#include <future>
+#include <limits>
 
 
 namespace openMVG_ofx {
@@ -17,32 +21,63 @@ namespace Localizer {
 class CameraLocalizerPlugin : public OFX::ImageEffect 
 {
 private:
+  /**
+   * @brief Clip and parameters of an input camera
+   */
+  struct InputParams
+  {
+    //Source clip
+    OFX::Clip *clip;
+
+    //Input Parameters
+    OFX::BooleanParam *isGrayscale;
+    OFX::StringParam *lensCalibrationFile;
+    OFX::DoubleParam *sensorWidth;
+    OFX::Double2DParam *opticalCenter;
+    OFX::ChoiceParam *focalLengthMode;
+    OFX::DoubleParam *focalLength;
+    OFX::BooleanParam *focalLengthVarying;
+    OFX::ChoiceParam *lensDistortion;
+    OFX::ChoiceParam *lensDistortionMode;
+    OFX::DoubleParam *lensDistortionCoef1;
+    OFX::DoubleParam *lensDistortionCoef2;
+    OFX::DoubleParam *lensDistortionCoef3;
+    OFX::DoubleParam *lensDistortionCoef4;
+    OFX::Double3DParam *relativePoseRotateM1;
+    OFX::Double3DParam *relativePoseRotateM2;
+    OFX::Double3DParam *relativePoseRotateM3;
+    OFX::Double3DParam *relativePoseCenter;
+    OFX::GroupParam *groupRelativePose;
+
+    //Output Parameters
+    OFX::Double3DParam *outputTranslate;
+    OFX::Double3DParam *outputRotate;
+    OFX::Double3DParam *outputScale;
+    OFX::Double2DParam *outputOpticalCenter;
+    OFX::DoubleParam *outputFocalLength;
+    OFX::DoubleParam *outputNear;
+    OFX::DoubleParam *outputFar;
+    OFX::DoubleParam *outputLensDistortionCoef1;
+    OFX::DoubleParam *outputLensDistortionCoef2;
+    OFX::DoubleParam *outputLensDistortionCoef3;
+    OFX::DoubleParam *outputLensDistortionCoef4;
+    OFX::DoubleParam *outputStatErrorMean;
+    OFX::DoubleParam *outputStatErrorMin;
+    OFX::DoubleParam *outputStatErrorMax;
+    OFX::DoubleParam *outputStatNbMatchedImages;
+    OFX::DoubleParam *outputStatNbDetectedFeatures;
+    OFX::DoubleParam *outputStatNbMatchedFeatures;
+    OFX::DoubleParam *outputStatNbInlierFeatures;
+  };
+
   //(!) Don't delete these, OFX::ImageEffect is managing them
   
+  //Inputs, one per described input clip
+  std::vector<InputParams> _inputs;
+
   //Clips
-  OFX::Clip *_srcClip[K_MAX_INPUTS]; //Source clip
   OFX::Clip *_dstClip = fetchClip(kOfxImageEffectOutputClipName); //Destination clip
   
-  //Input Parameters
-  OFX::BooleanParam *_inputIsGrayscale[K_MAX_INPUTS];
-  OFX::StringParam *_inputLensCalibrationFile[K_MAX_INPUTS];
-  OFX::DoubleParam *_inputSensorWidth[K_MAX_INPUTS];
-  OFX::Double2DParam *_inputOpticalCenter[K_MAX_INPUTS];
-  OFX::ChoiceParam *_inputFocalLengthMode[K_MAX_INPUTS];
-  OFX::DoubleParam *_inputFocalLength[K_MAX_INPUTS];
-  OFX::BooleanParam *_inputFocalLengthVarying[K_MAX_INPUTS];
-  OFX::ChoiceParam *_inputLensDistortion[K_MAX_INPUTS];
-  OFX::ChoiceParam *_inputLensDistortionMode[K_MAX_INPUTS];
-  OFX::DoubleParam *_inputLensDistortionCoef1[K_MAX_INPUTS];
-  OFX::DoubleParam *_inputLensDistortionCoef2[K_MAX_INPUTS];
-  OFX::DoubleParam *_inputLensDistortionCoef3[K_MAX_INPUTS];
-  OFX::DoubleParam *_inputLensDistortionCoef4[K_MAX_INPUTS];
-  OFX::Double3DParam *_inputRelativePoseRotateM1[K_MAX_INPUTS];
-  OFX::Double3DParam *_inputRelativePoseRotateM2[K_MAX_INPUTS];
-  OFX::Double3DParam *_inputRelativePoseRotateM3[K_MAX_INPUTS];
-  OFX::Double3DParam *_inputRelativePoseCenter[K_MAX_INPUTS];
-  OFX::GroupParam *_inputGroupRelativePose[K_MAX_INPUTS];
-  
   //Global Parameters
   OFX::ChoiceParam *_featureType = fetchChoiceParam(kParamFeaturesType);
   OFX::ChoiceParam *_featurePreset = fetchChoiceParam(kParamFeaturesPreset);
@@ -51,6 +86,11 @@ private:
   OFX::StringParam *_voctreeFile = fetchStringParam(kParamVoctreeFile);
   OFX::ChoiceParam *_rigMode = fetchChoiceParam(kParamRigMode);
   OFX::PushButtonParam *_rigCalibration = fetchPushButtonParam(kParamRigCalibration);
+  OFX::IntParam *_rigCalibrationNbFrames = fetchIntParam(kParamRigCalibrationNbFrames);
+  OFX::IntParam *_rigCalibrationNbHypotheses = fetchIntParam(kParamRigCalibrationNbHypotheses);
+  OFX::PushButtonParam *_rigCalibrationCancel = fetchPushButtonParam(kParamRigCalibrationCancel);
+  OFX::DoubleParam *_rigCalibrationProgress = fetchDoubleParam(kParamRigCalibrationProgress);
+  OFX::StringParam *_rigCalibrationStatus = fetchStringParam(kParamRigCalibrationStatus);
   OFX::StringParam *_rigCalibrationFile = fetchStringParam(kParamRigCalibrationFile);
   OFX::PushButtonParam *_rigCalibrationLoad = fetchPushButtonParam(kParamRigCalibrationLoad);
   OFX::PushButtonParam *_rigCalibrationSave = fetchPushButtonParam(kParamRigCalibrationSave);
@@ -80,6 +120,7 @@ private:
   OFX::DoubleParam *_distanceRatio = fetchDoubleParam(kParamAdvancedDistanceRatio);
   OFX::BooleanParam *_useGuidedMatching = fetchBooleanParam(kParamAdvancedUseGuidedMatching);
   OFX::StringParam *_debugFolder = fetchStringParam(kParamAdvancedDebugFolder);
+  OFX::BooleanParam *_debugTrace = fetchBooleanParam(kParamAdvancedDebugTrace);
   OFX::BooleanParam *_alwaysComputeFrame = fetchBooleanParam(kParamAdvancedDebugAlwaysComputeFrame);  
   
   OFX::StringParam *_sfMDataNbViews = fetchStringParam(kParamAdvancedSfMDataNbViews);
@@ -96,25 +137,17 @@ private:
  
   //Output Parameters
   OFX::IntParam *_cameraOutputIndex = fetchIntParam(kParamOutputIndex);
-  OFX::Double3DParam *_cameraOutputTranslate[K_MAX_INPUTS];
-  OFX::Double3DParam *_cameraOutputRotate[K_MAX_INPUTS];
-  OFX::Double3DParam *_cameraOutputScale[K_MAX_INPUTS];
-  OFX::Double2DParam *_cameraOutputOpticalCenter[K_MAX_INPUTS];
-  OFX::DoubleParam *_cameraOutputFocalLength[K_MAX_INPUTS];
-  OFX::DoubleParam *_cameraOutputNear[K_MAX_INPUTS];
-  OFX::DoubleParam *_cameraOutputFar[K_MAX_INPUTS];
-  OFX::DoubleParam *_cameraOutputLensDistortionCoef1[K_MAX_INPUTS];
-  OFX::DoubleParam *_cameraOutputLensDistortionCoef2[K_MAX_INPUTS];
-  OFX::DoubleParam *_cameraOutputLensDistortionCoef3[K_MAX_INPUTS];
-  OFX::DoubleParam *_cameraOutputLensDistortionCoef4[K_MAX_INPUTS];
-  OFX::DoubleParam *_outputStatErrorMean[K_MAX_INPUTS];
-  OFX::DoubleParam *_outputStatErrorMin[K_MAX_INPUTS];
-  OFX::DoubleParam *_outputStatErrorMax[K_MAX_INPUTS];
-  OFX::DoubleParam *_outputStatNbMatchedImages[K_MAX_INPUTS];
-  OFX::DoubleParam *_outputStatNbDetectedFeatures[K_MAX_INPUTS];
-  OFX::DoubleParam *_outputStatNbMatchedFeatures[K_MAX_INPUTS];
-  OFX::DoubleParam *_outputStatNbInlierFeatures[K_MAX_INPUTS];
-  
+
+  //Key Reduction Parameters
+  OFX::BooleanParam *_outputReduceKeys = fetchBooleanParam(kParamOutputReduceKeys);
+  OFX::DoubleParam *_outputTranslateTolerance = fetchDoubleParam(kParamOutputTranslateTolerance);
+  OFX::DoubleParam *_outputRotateTolerance = fetchDoubleParam(kParamOutputRotateTolerance);
+  OFX::DoubleParam *_outputIntrinsicsTolerance = fetchDoubleParam(kParamOutputIntrinsicsTolerance);
+
+  //Track File Parameters
+  OFX::StringParam *_outputTrackFile = fetchStringParam(kParamOutputTrackFile);
+  OFX::BooleanParam *_outputStreamTrack = fetchBooleanParam(kParamOutputStreamTrack);
+
   //Output Cache Parameters
   OFX::StringParam *_serializedResults = fetchStringParam(kParamCacheSerializedResults);
   
@@ -136,6 +169,28 @@ private:
   //Cache
   std::map<OfxTime, std::map<std::size_t, FrameData> > _framesData;
 
+  //Output values of a sequence render, committed to the host at its end
+  std::map<OfxTime, std::map<std::size_t, OutputParamValues> > _pendingOutputValues;
+  bool _isSequenceRendering = false;
+  std::mutex _pendingOutputMutex; //protects the pending values and the sequence status
+
+  //Track file written as the sequence render solves the frames
+  std::unique_ptr<TrackFileWriter> _trackFileWriter;
+
+  //Rig calibration running on the worker pool, its result is applied on a host thread
+  struct RigCalibrationTask
+  {
+    std::future<void> future;
+    std::atomic<bool> isCanceled{false};
+    std::mutex mutex; //protects progress and isProgressUpdated
+    RigCalibrationProgress progress;
+    bool isProgressUpdated = false;
+    std::vector<std::size_t> clipIndices; //connected clips at the start, the main camera first
+    RigCalibrationResult result;
+  };
+  std::unique_ptr<RigCalibrationTask> _rigCalibrationTask;
+  Common::BackgroundTaskPoller _rigCalibrationTaskPoller;
+
 public:
   
   /**
@@ -143,6 +198,14 @@ public:
    * @param handle
    */
   CameraLocalizerPlugin(OfxImageEffectHandle handle);
+
+  /**
+   * @brief Cancel and wait for the running rig calibration
+   */
+  ~CameraLocalizerPlugin();
+
+  /** @brief The sync private data action, called when the effect needs to sync any private data to persistant parameters */
+  void syncPrivateData();
   
   /**
    * @brief Update if needed the localizer param data structure
@@ -199,9 +262,25 @@ public:
   virtual void changedParam(const OFX::InstanceChangedArgs &args, const std::string &paramName);
   
   /**
-   * @brief Try to calibrate the Rig in input from cache data
+   * @brief Start the calibration of the Rig in input from cache data, on the worker pool
    */
   void calibrateRig();
+
+  /**
+   * @brief Cancel the background rig calibration and wait for it
+   */
+  void cancelRigCalibration();
+
+  /**
+   * @brief Report the background rig calibration in the parameters
+   * The host has no timer callback: called from the actions allowed to set parameters.
+   */
+  void updateBackgroundStatus();
+
+  /**
+   * @brief Report the progress of the background rig calibration and apply its result once done
+   */
+  void updateRigCalibrationTask();
   
   /**
    * @brief Load Rig Calibration From a file
@@ -230,6 +309,11 @@ public:
    */
   void serializeCacheData();
   
+  /**
+   * @brief Enable or disable the trace export regarding debug parameters
+   */
+  void updateTracing();
+  
   /**
    * @brief Update the member connected clip index collection
    */
@@ -280,6 +364,45 @@ public:
                                 std::size_t clipIndex, 
                                 const openMVG::localization::LocalizationResult& locResults, 
                                 const std::vector<openMVG::features::SIOPointFeature>& extractedFeatures);
+
+  /**
+   * @brief Set the output parameters keys of a camera at the given time
+   * @param[in] time
+   * @param[in] clipIndex
+   * @param[in] values
+   */
+  void setOutputParamValuesAtTime(double time, std::size_t clipIndex, const OutputParamValues& values);
+
+  /**
+   * @brief Set the output values buffered during the sequence render, in a single edit block
+   * With Reduce Keys, the values of a single frame render are also buffered until the cache holds the frame.
+   * The serialized cache is updated once, at the end.
+   * @return true if values were buffered, the serialized cache is then up to date
+   */
+  bool commitOutputParamValues();
+
+  /**
+   * @brief Rewrite the output parameters keys of a time range from the cache
+   * With Reduce Keys, only the keys needed to follow each curve within its tolerance are written.
+   * The range is extended to the neighbour keys of each curve, the keys outside are kept.
+   * The key interpolation is host-defined: the dropped frames are checked against the host curve.
+   * @param[in] firstTime
+   * @param[in] lastTime
+   */
+  void writeOutputParamKeys(OfxTime firstTime, OfxTime lastTime);
+
+  /**
+   * @brief Rewrite all the output parameters keys from the cache
+   */
+  void writeOutputParamKeys()
+  {
+    writeOutputParamKeys(-std::numeric_limits<OfxTime>::infinity(), std::numeric_limits<OfxTime>::infinity());
+  }
+
+  /**
+   * @brief Write all the cached cameras to the track file
+   */
+  void exportTrackFile();
   
   /**
    * @brief Set a pose from the given input
@@ -390,7 +513,7 @@ public:
   {
     for(auto input : _connectedClipIdx)
     {
-     if(_cameraOutputTranslate[input]->getKeyIndex(time, OFX::eKeySearchNear) == -1)
+     if(_inputs[input].outputTranslate->getKeyIndex(time, OFX::eKeySearchNear) == -1)
        return false;
     }
     return true;
@@ -423,6 +546,10 @@ public:
   
   void clearOutputParamValuesAtTime(OfxTime time)
   {
+    {
+      std::lock_guard<std::mutex> lock(_pendingOutputMutex);
+      _pendingOutputValues.erase(time);
+    }
     _framesData.erase(time);
     for(OFX::ValueParam* outputParam: _outputParams)
       outputParam->deleteKeyAtTime(time);
@@ -431,10 +558,16 @@ public:
   
   void clearOutputParamValues()
   {
+    {
+      std::lock_guard<std::mutex> lock(_pendingOutputMutex);
+      _pendingOutputValues.clear();
+    }
     _framesData.clear();
+    beginEditBlock("clearOutputParamValues");
     for(OFX::ValueParam* outputParam: _outputParams)
       outputParam->deleteAllKeys();
     _serializedResults->setValue("");
+    endEditBlock();
   }
 };
 
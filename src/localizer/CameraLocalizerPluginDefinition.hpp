@@ -9,6 +9,14 @@
 //Clip
 #define kClip(I) std::to_string(I + 1)
 
+/**
+ * Default number of input clips, a rig has at most one camera per input
+ * Overridden at runtime by the OFXMVG_LOCALIZER_MAX_INPUTS environment variable.
+ */
+#ifndef OFXMVG_LOCALIZER_MAX_INPUTS
+#define OFXMVG_LOCALIZER_MAX_INPUTS 5
+#endif
+
 
 //Main Parameters
 #define kParamGroupMain "groupMain"
@@ -21,6 +29,11 @@
 #define kParamVoctreeFile "voctreeFile"
 #define kParamRigMode "rigMode"
 #define kParamRigCalibration "rigCalibration"
+#define kParamRigCalibrationNbFrames "rigCalibrationNbFrames"
+#define kParamRigCalibrationNbHypotheses "rigCalibrationNbHypotheses"
+#define kParamRigCalibrationCancel "rigCalibrationCancel"
+#define kParamRigCalibrationProgress "rigCalibrationProgress"
+#define kParamRigCalibrationStatus "rigCalibrationStatus"
 #define kParamRigCalibrationFile "rigCalibrationFile"
 #define kParamRigCalibrationLoad "rigCalibrationLoad"
 #define kParamRigCalibrationSave "rigCalibrationSave"
@@ -84,6 +97,7 @@
 #define kParamAdvancedDistanceRatio "advancedDistanceRatio"
 #define kParamAdvancedUseGuidedMatching "advancedUseGuidedMatching"
 #define kParamAdvancedDebugFolder "advancedDebugFolder"
+#define kParamAdvancedDebugTrace "advancedDebugTrace"
 #define kParamAdvancedDebugAlwaysComputeFrame "advancedDebugAlwaysComputeFrame"
 
 #define kParamAdvancedGroupSfMData "groupAdvancedSfMData"
@@ -132,6 +146,17 @@
 #define kParamOutputStatNbMatchedFeatures(I) "outputStatNbMatchedFeatures_" + std::to_string(I)
 #define kParamOutputStatNbInlierFeatures(I) "outputStatNbInlierFeatures_" + std::to_string(I)
 
+//Key Reduction Parameters
+#define kParamOutputReduceKeys "outputReduceKeys"
+#define kParamOutputTranslateTolerance "outputTranslateTolerance"
+#define kParamOutputRotateTolerance "outputRotateTolerance"
+#define kParamOutputIntrinsicsTolerance "outputIntrinsicsTolerance"
+
+//Track File Parameters
+#define kParamOutputTrackFile "outputTrackFile"
+#define kParamOutputStreamTrack "outputStreamTrack"
+#define kParamOutputExportTrack "outputExportTrack"
+
 //Cache Parameters
 #define kParamCacheSerializedResults "cacheSerializedResults"
 #define kParamCacheClear "cacheClear"
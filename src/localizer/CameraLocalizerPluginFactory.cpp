@@ -52,8 +52,10 @@ void CameraLocalizerPluginFactory::describe(OFX::ImageEffectDescriptor& desc)
 
 void CameraLocalizerPluginFactory::describeInContext(OFX::ImageEffectDescriptor& desc, OFX::ContextEnum context)
 {
+  const std::size_t nbInputs = getMaxNbInputs();
+
   //Input Clips
-  for(unsigned int input = 0; input < K_MAX_INPUTS; ++input)
+  for(unsigned int input = 0; input < nbInputs; ++input)
   {
     OFX::ClipDescriptor *srcClip = desc.defineClip(kClip(input));
     srcClip->addSupportedComponent(OFX::ePixelComponentRGBA);
@@ -78,7 +80,7 @@ void CameraLocalizerPluginFactory::describeInContext(OFX::ImageEffectDescriptor&
       OFX::IntParamDescriptor *param = desc.defineIntParam(kParamOutputIndex);
       param->setLabel("Camera Output Index");
       param->setHint("The index of the input clip to expose as the output camera.");
-      param->setRange(0, K_MAX_INPUTS);
+      param->setRange(0, static_cast<int>(nbInputs));
       // DisplayRange will be updated regarding the number of connected input clips
       param->setDisplayRange(0, 0);
       param->setAnimates(false);
@@ -151,7 +153,64 @@ void CameraLocalizerPluginFactory::describeInContext(OFX::ImageEffectDescriptor&
     {
       OFX::PushButtonParamDescriptor *param = desc.definePushButtonParam(kParamRigCalibration);
       param->setLabel("Calibrate");
-      param->setHint("Calibrate RIG with computed keyframes");
+      param->setHint("Calibrate RIG with computed keyframes, in background");
+      param->setParent(*groupMain);
+    }
+
+    {
+      OFX::IntParamDescriptor *param = desc.defineIntParam(kParamRigCalibrationNbFrames);
+      param->setLabel("Rig Initialization Frames");
+      param->setHint("Number of keyframes of each initialization hypothesis, chosen to cover the poses of the main camera. "
+        "All the keyframes are used by the final refinement.");
+      param->setRange(2, 1000);
+      param->setDisplayRange(2, 100);
+      param->setDefault(30);
+      param->setAnimates(false);
+      param->setParent(*groupMain);
+    }
+
+    {
+      OFX::IntParamDescriptor *param = desc.defineIntParam(kParamRigCalibrationNbHypotheses);
+      param->setLabel("Rig Initialization Hypotheses");
+      param->setHint("Number of initializations computed concurrently on different keyframes, the best one of each camera is refined.");
+      param->setRange(1, 64);
+      param->setDisplayRange(1, 16);
+      param->setDefault(4);
+      param->setAnimates(false);
+      param->setParent(*groupMain);
+    }
+
+    {
+      OFX::PushButtonParamDescriptor *param = desc.definePushButtonParam(kParamRigCalibrationCancel);
+      param->setLabel("Cancel Rig Calibration");
+      param->setHint("Stop the running rig calibration, the relative poses are not modified.");
+      param->setEnabled(false);
+      param->setParent(*groupMain);
+    }
+
+    {
+      OFX::DoubleParamDescriptor *param = desc.defineDoubleParam(kParamRigCalibrationProgress);
+      param->setLabel("Rig Calibration Progress");
+      param->setHint("Progress of the running rig calibration.");
+      param->setRange(0, 1);
+      param->setDisplayRange(0, 1);
+      param->setDefault(0);
+      param->setEvaluateOnChange(false);
+      param->setEnabled(false);
+      param->setAnimates(false);
+      param->setCanUndo(false);
+      param->setParent(*groupMain);
+    }
+
+    {
+      OFX::StringParamDescriptor *param = desc.defineStringParam(kParamRigCalibrationStatus);
+      param->setLabel("Rig Calibration Status");
+      param->setHint("Step and reprojection error of the running rig calibration.");
+      param->setStringType(OFX::eStringTypeSingleLine);
+      param->setEvaluateOnChange(false);
+      param->setEnabled(false);
+      param->setAnimates(false);
+      param->setCanUndo(false);
       param->setParent(*groupMain);
     }
 
@@ -180,7 +239,7 @@ void CameraLocalizerPluginFactory::describeInContext(OFX::ImageEffectDescriptor&
     }
 
     //Inputs Tabs
-    for(unsigned int input = 0; input < K_MAX_INPUTS; ++input)
+    for(unsigned int input = 0; input < nbInputs; ++input)
     {
       OFX::GroupParamDescriptor *groupInput = desc.defineGroupParam(kParamGroupInput(input));
       groupInput->setLabel("Input " + kClip(input));
@@ -620,6 +679,16 @@ void CameraLocalizerPluginFactory::describeInContext(OFX::ImageEffectDescriptor&
       param->setParent(*groupAdvanced);
     }
     
+    {
+      OFX::BooleanParamDescriptor *param = desc.defineBooleanParam(kParamAdvancedDebugTrace);
+      param->setLabel("Export Trace");
+      param->setHint("Record a timeline of the plugin processing and write it as a trace-event JSON file (chrome://tracing, ui.perfetto.dev) in the debug folder.");
+      param->setAnimates(false);
+      param->setDefault(false);
+      param->setEvaluateOnChange(false);
+      param->setParent(*groupAdvanced);
+    }
+    
     {
       OFX::BooleanParamDescriptor *param = desc.defineBooleanParam(kParamAdvancedDebugAlwaysComputeFrame);
       param->setLabel("Always Compute Frame");
@@ -741,7 +810,7 @@ void CameraLocalizerPluginFactory::describeInContext(OFX::ImageEffectDescriptor&
     groupOutput->setLabel("Output");
     groupOutput->setAsTab();
     
-    for(unsigned int input = 0; input < K_MAX_INPUTS; ++input)
+    for(unsigned int input = 0; input < nbInputs; ++input)
     {
       OFX::GroupParamDescriptor *groupOutputCamera = desc.defineGroupParam(kParamGroupOutputCamera(input));
       groupOutputCamera->setLabel("Output " + kClip(input));
@@ -976,6 +1045,85 @@ void CameraLocalizerPluginFactory::describeInContext(OFX::ImageEffectDescriptor&
       }
     }
 
+    {
+      OFX::BooleanParamDescriptor *param = desc.defineBooleanParam(kParamOutputReduceKeys);
+      param->setLabel("Reduce Keys");
+      param->setHint("Write only the keys needed to follow the solved values within the tolerances, "
+                     "at the end of each sequence render. The rotation is unwrapped, constant values get a single key. "
+                     "The cache keeps the result of every frame.");
+      param->setDefault(false);
+      param->setAnimates(false);
+      param->setEvaluateOnChange(false);
+      param->setParent(*groupOutput);
+    }
+
+    {
+      OFX::DoubleParamDescriptor *param = desc.defineDoubleParam(kParamOutputTranslateTolerance);
+      param->setLabel("Translate Tolerance");
+      param->setHint("Maximal translate error of the reduced keys, in scene unit.");
+      param->setRange(0.0, kOfxFlagInfiniteMax);
+      param->setDisplayRange(0.0, 0.1);
+      param->setDefault(0.001);
+      param->setAnimates(false);
+      param->setEvaluateOnChange(false);
+      param->setParent(*groupOutput);
+    }
+
+    {
+      OFX::DoubleParamDescriptor *param = desc.defineDoubleParam(kParamOutputRotateTolerance);
+      param->setLabel("Rotate Tolerance");
+      param->setHint("Maximal rotate error of the reduced keys, in degree.");
+      param->setRange(0.0, kOfxFlagInfiniteMax);
+      param->setDisplayRange(0.0, 1.0);
+      param->setDefault(0.01);
+      param->setAnimates(false);
+      param->setEvaluateOnChange(false);
+      param->setParent(*groupOutput);
+    }
+
+    {
+      OFX::DoubleParamDescriptor *param = desc.defineDoubleParam(kParamOutputIntrinsicsTolerance);
+      param->setLabel("Intrinsics Tolerance");
+      param->setHint("Maximal focal length (mm) and optical center (pixel) error of the reduced keys.");
+      param->setRange(0.0, kOfxFlagInfiniteMax);
+      param->setDisplayRange(0.0, 1.0);
+      param->setDefault(0.01);
+      param->setAnimates(false);
+      param->setEvaluateOnChange(false);
+      param->setParent(*groupOutput);
+      param->setLayoutHint(OFX::eLayoutHintDivider);
+    }
+
+    {
+      OFX::StringParamDescriptor *param = desc.defineStringParam(kParamOutputTrackFile);
+      param->setLabel("Track File");
+      param->setHint("JSON-lines file of the solved cameras: one line per camera and frame with its pose, intrinsics and statistics.");
+      param->setStringType(OFX::eStringTypeFilePath);
+      param->setFilePathExists(false);
+      param->setAnimates(false);
+      param->setEvaluateOnChange(false);
+      param->setParent(*groupOutput);
+    }
+
+    {
+      OFX::BooleanParamDescriptor *param = desc.defineBooleanParam(kParamOutputStreamTrack);
+      param->setLabel("Stream Track");
+      param->setHint("Append the cameras to the track file as the frames are solved, during the sequence renders. "
+                     "A frame solved again is appended again, the last line is the valid one.");
+      param->setDefault(false);
+      param->setAnimates(false);
+      param->setEvaluateOnChange(false);
+      param->setParent(*groupOutput);
+    }
+
+    {
+      OFX::PushButtonParamDescriptor *param = desc.definePushButtonParam(kParamOutputExportTrack);
+      param->setLabel("Export Track");
+      param->setHint("Write all the cached cameras to the track file.");
+      param->setParent(*groupOutput);
+      param->setLayoutHint(OFX::eLayoutHintDivider);
+    }
+
     {
       OFX::PushButtonParamDescriptor *param = desc.definePushButtonParam(kParamCacheClearCurrentFrame);
       param->setLabel("Clear Current Frame");
@@ -0,0 +1,419 @@
+#include "RigCalibration.hpp"
+#include "../common/ThreadPool.hpp"
+#include "../common/Trace.hpp"
+#include "../common/Logger.hpp"
+
+#include <openMVG/rig/Rig.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <mutex>
+#include <numeric>
+#include <stdexcept>
+
+namespace openMVG_ofx {
+namespace Localizer {
+
+namespace {
+
+typedef Eigen::Matrix<double, 6, 1> Vec6;
+
+/**
+ * @brief Angle of the rotation between two orientations (radians)
+ */
+double getRotationAngle(const openMVG::Mat3 &rotationA, const openMVG::Mat3 &rotationB)
+{
+  const double cosAngle = 0.5 * ((rotationA * rotationB.transpose()).trace() - 1.0);
+  return std::acos(std::max(-1.0, std::min(1.0, cosAngle)));
+}
+
+/**
+ * @brief Apply an increment to a pose: rotation vector (radians) then center offset
+ */
+openMVG::geometry::Pose3 applyIncrement(const openMVG::geometry::Pose3 &pose, const Vec6 &increment)
+{
+  const openMVG::Vec3 rotationVector = increment.head<3>();
+  const double angle = rotationVector.norm();
+  openMVG::Mat3 rotation = openMVG::Mat3::Identity();
+  if(angle > std::numeric_limits<double>::epsilon())
+    rotation = Eigen::AngleAxisd(angle, rotationVector / angle).toRotationMatrix();
+  return openMVG::geometry::Pose3(rotation * pose.rotation(), pose.center() + increment.tail<3>());
+}
+
+/**
+ * @brief Huber cost of the residuals
+ */
+double getHuberCost(const std::vector<RelativePoseObservation> &observations, const openMVG::geometry::Pose3 &pose, double threshold)
+{
+  double cost = 0.0;
+  for(const RelativePoseObservation &observation : observations)
+  {
+    const double residual = observation.intrinsics->residual(pose, observation.point, observation.feature).norm();
+    cost += (residual <= threshold) ? 0.5 * residual * residual : threshold * (residual - 0.5 * threshold);
+  }
+  return cost;
+}
+
+} //namespace
+
+std::vector<std::size_t> selectDiverseFrames(const std::vector<openMVG::geometry::Pose3> &poses, std::size_t nbFrames, std::size_t firstFrame)
+{
+  const std::size_t nbPoses = poses.size();
+  std::vector<std::size_t> frames;
+  if(nbPoses == 0 || nbFrames == 0)
+    return frames;
+  if(nbFrames >= nbPoses)
+  {
+    frames.resize(nbPoses);
+    std::iota(frames.begin(), frames.end(), 0);
+    return frames;
+  }
+
+  //The centers distances are relative to their median spread, a static camera only uses the orientations
+  openMVG::Vec3 meanCenter = openMVG::Vec3::Zero();
+  for(const openMVG::geometry::Pose3 &pose : poses)
+    meanCenter += pose.center();
+  meanCenter /= static_cast<double>(nbPoses);
+  std::vector<double> spreads(nbPoses);
+  for(std::size_t i = 0; i < nbPoses; ++i)
+    spreads[i] = (poses[i].center() - meanCenter).norm();
+  std::nth_element(spreads.begin(), spreads.begin() + nbPoses / 2, spreads.end());
+  const double spread = spreads[nbPoses / 2];
+  const double centerScale = (spread > std::numeric_limits<double>::epsilon()) ? 1.0 / spread : 0.0;
+
+  //Farthest point sampling: each frame is the farthest from the already selected ones
+  std::vector<double> minDistances(nbPoses, std::numeric_limits<double>::max());
+  std::vector<bool> isSelected(nbPoses, false);
+  std::size_t frame = firstFrame % nbPoses;
+  frames.reserve(nbFrames);
+  for(std::size_t k = 0; k < nbFrames; ++k)
+  {
+    frames.push_back(frame);
+    isSelected[frame] = true;
+
+    std::size_t farthestFrame = nbPoses;
+    double farthestDistance = -1.0;
+    for(std::size_t i = 0; i < nbPoses; ++i)
+    {
+      if(isSelected[i])
+        continue;
+      const double distance = centerScale * (poses[i].center() - poses[frame].center()).norm()
+                            + getRotationAngle(poses[i].rotation(), poses[frame].rotation());
+      minDistances[i] = std::min(minDistances[i], distance);
+      if(minDistances[i] > farthestDistance)
+      {
+        farthestDistance = minDistances[i];
+        farthestFrame = i;
+      }
+    }
+    if(farthestFrame == nbPoses)
+      break;
+    frame = farthestFrame;
+  }
+  std::sort(frames.begin(), frames.end());
+  return frames;
+}
+
+void getRelativePoseObservations(const std::vector<openMVG::localization::LocalizationResult> &mainResults,
+                                 const std::vector<openMVG::localization::LocalizationResult> &results,
+                                 const std::vector<std::size_t> &frames,
+                                 std::vector<RelativePoseObservation> &observations)
+{
+  observations.clear();
+  for(std::size_t frame : frames)
+  {
+    const openMVG::localization::LocalizationResult &mainResult = mainResults[frame];
+    const openMVG::localization::LocalizationResult &result = results[frame];
+    if(!mainResult.isValid() || !result.isValid())
+      continue;
+
+    const openMVG::geometry::Pose3 &mainPose = mainResult.getPose();
+    const openMVG::Mat &pt2D = result.getPt2D();
+    const openMVG::Mat &pt3D = result.getPt3D();
+    for(std::size_t index : result.getInliers())
+    {
+      RelativePoseObservation observation;
+      observation.point = mainPose.rotation() * (openMVG::Vec3(pt3D.col(index)) - mainPose.center());
+      observation.feature = pt2D.col(index);
+      observation.intrinsics = &result.getIntrinsics();
+      observations.push_back(observation);
+    }
+  }
+}
+
+double getRelativePoseCost(const std::vector<RelativePoseObservation> &observations,
+                           const openMVG::geometry::Pose3 &relativePose,
+                           double maxResidualError,
+                           double &meanInlierError)
+{
+  meanInlierError = 0.0;
+  if(observations.empty())
+    return std::numeric_limits<double>::max();
+
+  double cost = 0.0;
+  std::size_t nbInliers = 0;
+  for(const RelativePoseObservation &observation : observations)
+  {
+    const double residual = observation.intrinsics->residual(relativePose, observation.point, observation.feature).norm();
+    if(residual <= maxResidualError)
+    {
+      meanInlierError += residual;
+      ++nbInliers;
+    }
+    cost += std::min(residual, maxResidualError);
+  }
+  if(nbInliers > 0)
+    meanInlierError /= nbInliers;
+  return cost / observations.size();
+}
+
+bool refineRelativePose(const std::vector<RelativePoseObservation> &observations,
+                        double maxResidualError,
+                        std::size_t maxIterations,
+                        const std::function<bool(std::size_t, double)> &callback,
+                        openMVG::geometry::Pose3 &relativePose)
+{
+  if(observations.empty())
+    return true;
+
+  double cost = getHuberCost(observations, relativePose, maxResidualError);
+  double lambda = 1e-3;
+
+  for(std::size_t iteration = 0; iteration < maxIterations; ++iteration)
+  {
+    //Normal equations with Huber weights, the jacobian is computed by central differences
+    const double centerStep = 1e-6 * std::max(1.0, relativePose.center().norm());
+    Eigen::Matrix<double, 6, 6> jtj = Eigen::Matrix<double, 6, 6>::Zero();
+    Vec6 jtr = Vec6::Zero();
+    for(const RelativePoseObservation &observation : observations)
+    {
+      const openMVG::Vec2 residual = observation.intrinsics->residual(relativePose, observation.point, observation.feature);
+      const double residualNorm = residual.norm();
+      const double weight = (residualNorm <= maxResidualError) ? 1.0 : maxResidualError / residualNorm;
+
+      Eigen::Matrix<double, 2, 6> jacobian;
+      for(int k = 0; k < 6; ++k)
+      {
+        Vec6 step = Vec6::Zero();
+        step(k) = (k < 3) ? 1e-6 : centerStep;
+        const openMVG::Vec2 residualPlus = observation.intrinsics->residual(applyIncrement(relativePose, step), observation.point, observation.feature);
+        const openMVG::Vec2 residualMinus = observation.intrinsics->residual(applyIncrement(relativePose, -step), observation.point, observation.feature);
+        jacobian.col(k) = (residualPlus - residualMinus) / (2.0 * step(k));
+      }
+      jtj += weight * jacobian.transpose() * jacobian;
+      jtr += weight * jacobian.transpose() * residual;
+    }
+
+    //Levenberg-Marquardt step, the damping grows until the cost decreases
+    bool isImproved = false;
+    while(!isImproved && lambda < 1e10)
+    {
+      Eigen::Matrix<double, 6, 6> system = jtj;
+      system.diagonal() += lambda * jtj.diagonal().cwiseMax(1e-12);
+      const Vec6 increment = system.ldlt().solve(-jtr);
+      const openMVG::geometry::Pose3 candidatePose = applyIncrement(relativePose, increment);
+      const double candidateCost = getHuberCost(observations, candidatePose, maxResidualError);
+      if(candidateCost < cost)
+      {
+        const double decrease = (cost - candidateCost) / cost;
+        relativePose = candidatePose;
+        cost = candidateCost;
+        lambda = std::max(1e-12, lambda * 0.1);
+        isImproved = true;
+        if(decrease < 1e-10)
+          lambda = 1e10; //converged
+      }
+      else
+      {
+        lambda *= 10.0;
+      }
+    }
+
+    double meanInlierError = 0.0;
+    getRelativePoseCost(observations, relativePose, maxResidualError, meanInlierError);
+    if(!callback(iteration, meanInlierError))
+      return false;
+    if(lambda >= 1e10)
+      break;
+  }
+  return true;
+}
+
+void calibrateRig(const std::vector< std::vector<openMVG::localization::LocalizationResult> > &dataPerCamera,
+                  const RigCalibrationSettings &settings,
+                  RigCalibrationResult &result,
+                  const RigCalibrationCallback &callback)
+{
+  OFXMVG_TRACE_SCOPE("calibrateRig");
+  result = RigCalibrationResult();
+
+  const std::size_t nbCameras = dataPerCamera.size();
+  if(nbCameras < 2)
+    throw std::invalid_argument("The rig calibration needs at least 2 cameras.");
+  const std::size_t nbFrames = dataPerCamera.front().size();
+  if(nbFrames == 0)
+    throw std::invalid_argument("No localized frame for the rig calibration.");
+  for(const auto &cameraData : dataPerCamera)
+  {
+    if(cameraData.size() != nbFrames)
+      throw std::invalid_argument("The rig calibration results must be aligned by frame.");
+  }
+  const std::size_t nbSecondaryCameras = nbCameras - 1;
+
+  std::vector<openMVG::geometry::Pose3> mainPoses;
+  mainPoses.reserve(nbFrames);
+  for(const auto &mainResult : dataPerCamera.front())
+    mainPoses.push_back(mainResult.getPose());
+
+  //The progress is reported concurrently by the hypotheses, then by the cameras
+  std::atomic<bool> isCanceled{false};
+  std::mutex progressMutex;
+  RigCalibrationProgress progress;
+  auto reportProgress = [&](const std::function<void(RigCalibrationProgress&)> &update)
+  {
+    RigCalibrationProgress currentProgress;
+    {
+      std::lock_guard<std::mutex> lock(progressMutex);
+      update(progress);
+      currentProgress = progress;
+    }
+    if(!callback(currentProgress))
+      isCanceled = true;
+    return !isCanceled;
+  };
+
+  //Initialization hypotheses, each one on its own pose-space diverse frames
+  const std::size_t nbHypotheses = std::max<std::size_t>(1, std::min(settings.nbHypotheses, nbFrames));
+  const std::size_t nbInitFrames = std::max<std::size_t>(1, std::min(settings.nbInitFrames, nbFrames));
+  std::vector< std::vector<openMVG::geometry::Pose3> > hypotheses(nbHypotheses);
+  progress.nbTotal = nbHypotheses;
+  Common::ThreadPool::instance().parallelFor(0, nbHypotheses, [&](std::size_t hypothesis)
+  {
+    if(isCanceled)
+      return;
+    OFXMVG_TRACE_SCOPE("calibrateRig.hypothesis");
+    const std::vector<std::size_t> frames = selectDiverseFrames(mainPoses, nbInitFrames, hypothesis * nbFrames / nbHypotheses);
+
+    openMVG::rig::Rig rig;
+    for(std::size_t camera = 0; camera < nbCameras; ++camera)
+    {
+      std::vector<openMVG::localization::LocalizationResult> cameraData;
+      cameraData.reserve(frames.size());
+      for(std::size_t frame : frames)
+        cameraData.push_back(dataPerCamera[camera][frame]);
+      rig.setTrackingResult(cameraData, camera);
+    }
+
+    if(!rig.initializeCalibration())
+    {
+      OFXMVG_LOG_DEBUG("calibrateRig") << "hypothesis not initialized" << Common::kv("hypothesis", hypothesis);
+    }
+    else
+    {
+      //The refinement on all the frames follows, a hypothesis not optimized is kept
+      if(!rig.optimizeCalibration())
+      {
+        OFXMVG_LOG_DEBUG("calibrateRig") << "hypothesis not optimized" << Common::kv("hypothesis", hypothesis);
+      }
+      if(rig.getRelativePoses().size() == nbSecondaryCameras)
+        hypotheses[hypothesis] = rig.getRelativePoses();
+    }
+    reportProgress([](RigCalibrationProgress &currentProgress) { ++currentProgress.nbDone; });
+  });
+  if(isCanceled)
+    return;
+  for(const auto &hypothesis : hypotheses)
+  {
+    if(!hypothesis.empty())
+      ++result.nbValidHypotheses;
+  }
+  if(result.nbValidHypotheses == 0)
+  {
+    OFXMVG_LOG_WARNING("calibrateRig") << "no initialization" << Common::kv("nbHypotheses", nbHypotheses);
+    return;
+  }
+
+  //Observations of all the frames, per secondary camera
+  std::vector<std::size_t> allFrames(nbFrames);
+  std::iota(allFrames.begin(), allFrames.end(), 0);
+  std::vector< std::vector<RelativePoseObservation> > observations(nbSecondaryCameras);
+  Common::ThreadPool::instance().parallelFor(0, nbSecondaryCameras, [&](std::size_t camera)
+  {
+    getRelativePoseObservations(dataPerCamera.front(), dataPerCamera[camera + 1], allFrames, observations[camera]);
+  });
+
+  //Cost of each hypothesis on all the frames, the cameras are independent given the main poses
+  std::vector<double> costs(nbHypotheses * nbSecondaryCameras, std::numeric_limits<double>::max());
+  Common::ThreadPool::instance().parallelFor(0, costs.size(), [&](std::size_t index)
+  {
+    const std::size_t hypothesis = index / nbSecondaryCameras;
+    const std::size_t camera = index % nbSecondaryCameras;
+    if(hypotheses[hypothesis].empty())
+      return;
+    double meanInlierError = 0.0;
+    costs[index] = getRelativePoseCost(observations[camera], hypotheses[hypothesis][camera], settings.maxResidualError, meanInlierError);
+  });
+
+  //Refinement of the best hypothesis of each camera, on all the frames
+  result.relativePoses.resize(nbSecondaryCameras);
+  result.errors.resize(nbSecondaryCameras, 0.0);
+  std::vector<char> isCameraInitialized(nbSecondaryCameras, false); //written concurrently
+  {
+    std::lock_guard<std::mutex> lock(progressMutex);
+    progress.step = eRigCalibrationStepRefinement;
+    progress.nbDone = 0;
+    progress.nbTotal = nbSecondaryCameras * settings.maxRefineIterations;
+  }
+  Common::ThreadPool::instance().parallelFor(0, nbSecondaryCameras, [&](std::size_t camera)
+  {
+    OFXMVG_TRACE_SCOPE("calibrateRig.refine");
+    std::size_t bestHypothesis = nbHypotheses;
+    double bestCost = std::numeric_limits<double>::max();
+    for(std::size_t hypothesis = 0; hypothesis < nbHypotheses; ++hypothesis)
+    {
+      const double cost = costs[hypothesis * nbSecondaryCameras + camera];
+      if(cost < bestCost)
+      {
+        bestCost = cost;
+        bestHypothesis = hypothesis;
+      }
+    }
+    if(bestHypothesis == nbHypotheses)
+      return;
+    isCameraInitialized[camera] = true;
+
+    openMVG::geometry::Pose3 relativePose = hypotheses[bestHypothesis][camera];
+    refineRelativePose(observations[camera], settings.maxResidualError, settings.maxRefineIterations,
+      [&](std::size_t iteration, double meanInlierError)
+      {
+        return reportProgress([meanInlierError](RigCalibrationProgress &currentProgress)
+        {
+          ++currentProgress.nbDone;
+          currentProgress.error = meanInlierError;
+        });
+      },
+      relativePose);
+    result.relativePoses[camera] = relativePose;
+    getRelativePoseCost(observations[camera], relativePose, settings.maxResidualError, result.errors[camera]);
+    OFXMVG_LOG_DEBUG("calibrateRig") << "camera refined"
+      << Common::kv("camera", camera + 1)
+      << Common::kv("hypothesis", bestHypothesis)
+      << Common::kv("initialCost", bestCost)
+      << Common::kv("meanInlierError", result.errors[camera])
+      << Common::kv("nbObservations", observations[camera].size());
+  });
+  if(isCanceled)
+    return;
+  if(std::find(isCameraInitialized.begin(), isCameraInitialized.end(), char(false)) != isCameraInitialized.end())
+  {
+    OFXMVG_LOG_WARNING("calibrateRig") << "a camera has no observation in the localized frames";
+    return;
+  }
+  result.nbFrames = nbFrames;
+  result.isCalibrated = true;
+}
+
+} //namespace Localizer
+} //namespace openMVG_ofx
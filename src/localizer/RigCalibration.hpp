@@ -0,0 +1,143 @@
+#pragma once
+
+#include <openMVG/localization/LocalizationResult.hpp>
+#include <openMVG/geometry/pose3.hpp>
+#include <openMVG/numeric/numeric.h>
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+namespace openMVG_ofx {
+namespace Localizer {
+
+/**
+ * @brief Rig calibration settings
+ */
+struct RigCalibrationSettings
+{
+  std::size_t nbInitFrames = 30; //frames of each initialization hypothesis
+  std::size_t nbHypotheses = 4; //initializations tested concurrently
+  double maxResidualError = 4.0; //residuals above are outliers (pixels)
+  std::size_t maxRefineIterations = 20;
+};
+
+/**
+ * @brief Rig calibration steps, reported by the progress
+ */
+enum ERigCalibrationStep
+{
+  eRigCalibrationStepInitialization = 0,
+  eRigCalibrationStepRefinement
+};
+
+/**
+ * @brief Rig calibration progress
+ */
+struct RigCalibrationProgress
+{
+  ERigCalibrationStep step = eRigCalibrationStepInitialization;
+  std::size_t nbDone = 0; //hypotheses initialized, or refinement iterations
+  std::size_t nbTotal = 0;
+  double error = 0.0; //mean inlier residual of the last refinement iteration (pixels)
+};
+
+/**
+ * @brief Rig calibration progress callback
+ * Called on the calibration threads, concurrently by the hypotheses.
+ * Returns false to cancel the calibration.
+ */
+typedef std::function<bool(const RigCalibrationProgress&)> RigCalibrationCallback;
+
+/**
+ * @brief Rig calibration result
+ */
+struct RigCalibrationResult
+{
+  bool isCalibrated = false;
+  std::vector<openMVG::geometry::Pose3> relativePoses; //one per secondary camera
+  std::vector<double> errors; //mean inlier residual per secondary camera (pixels)
+  std::size_t nbFrames = 0; //frames of the refinement
+  std::size_t nbValidHypotheses = 0;
+};
+
+/**
+ * @brief Select frames covering the pose space, by farthest point sampling
+ * The distance between two poses is the distance between the centers, relative to the spread of the centers,
+ * plus the angle between the orientations (radians).
+ * @param[in] poses
+ * @param[in] nbFrames - number of selected frames
+ * @param[in] firstFrame - seed of the sampling
+ * @return sorted indices of the selected poses
+ */
+std::vector<std::size_t> selectDiverseFrames(const std::vector<openMVG::geometry::Pose3> &poses, std::size_t nbFrames, std::size_t firstFrame);
+
+/**
+ * @brief Observation of a secondary camera, expressed in the main camera frame
+ */
+struct RelativePoseObservation
+{
+  openMVG::Vec3 point; //3D point in the main camera frame
+  openMVG::Vec2 feature; //observed point (pixels)
+  const openMVG::cameras::Pinhole_Intrinsic *intrinsics; //secondary camera intrinsics
+};
+
+/**
+ * @brief Get the observations of a secondary camera on the given frames, where both cameras are localized
+ * @param[in] mainResults - main camera results, one per frame
+ * @param[in] results - secondary camera results, one per frame, must outlive the observations
+ * @param[in] frames - frame indices
+ * @param[out] observations - inliers of the secondary camera
+ */
+void getRelativePoseObservations(const std::vector<openMVG::localization::LocalizationResult> &mainResults,
+                                 const std::vector<openMVG::localization::LocalizationResult> &results,
+                                 const std::vector<std::size_t> &frames,
+                                 std::vector<RelativePoseObservation> &observations);
+
+/**
+ * @brief Robust cost of a relative pose, the residuals are truncated at maxResidualError
+ * @param[in] observations
+ * @param[in] relativePose - secondary camera pose in the main camera frame
+ * @param[in] maxResidualError
+ * @param[out] meanInlierError - mean residual of the inliers (pixels)
+ * @return mean truncated residual (pixels)
+ */
+double getRelativePoseCost(const std::vector<RelativePoseObservation> &observations,
+                           const openMVG::geometry::Pose3 &relativePose,
+                           double maxResidualError,
+                           double &meanInlierError);
+
+/**
+ * @brief Refine a relative pose on all the observations, with Levenberg-Marquardt and Huber weights
+ * The main camera poses are fixed: they are localized against the reconstruction.
+ * @param[in] observations
+ * @param[in] maxResidualError - Huber threshold (pixels)
+ * @param[in] maxIterations
+ * @param[in] callback - called after each iteration with the mean inlier residual, returns false to stop
+ * @param[in,out] relativePose
+ * @return false if canceled
+ */
+bool refineRelativePose(const std::vector<RelativePoseObservation> &observations,
+                        double maxResidualError,
+                        std::size_t maxIterations,
+                        const std::function<bool(std::size_t, double)> &callback,
+                        openMVG::geometry::Pose3 &relativePose);
+
+/**
+ * @brief Calibrate the relative poses of a rig from the localized frames of its cameras
+ * Each hypothesis is an openMVG rig calibration on a pose-space diverse subset of the frames.
+ * The hypotheses are computed concurrently, then each relative pose starts from the hypothesis
+ * with the lowest cost on all the frames, and is refined on all the frames.
+ * Throws if the results are invalid, the result is not calibrated if canceled.
+ * @param[in] dataPerCamera - results per camera, aligned by frame, the first camera is the main one
+ * @param[in] settings
+ * @param[out] result
+ * @param[in] callback
+ */
+void calibrateRig(const std::vector< std::vector<openMVG::localization::LocalizationResult> > &dataPerCamera,
+                  const RigCalibrationSettings &settings,
+                  RigCalibrationResult &result,
+                  const RigCalibrationCallback &callback);
+
+} //namespace Localizer
+} //namespace openMVG_ofx
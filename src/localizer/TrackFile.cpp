@@ -0,0 +1,180 @@
+#include "TrackFile.hpp"
+#include "../common/Logger.hpp"
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+namespace openMVG_ofx {
+namespace Localizer {
+
+void getTrackRecord(double time, std::size_t camera, const FrameData &frameData, TrackRecord &record)
+{
+  const openMVG::localization::LocalizationResult &localizationResult = frameData.localizationResult;
+  const openMVG::cameras::Pinhole_Intrinsic &intrinsics = localizationResult.getIntrinsics();
+
+  record.time = time;
+  record.camera = camera;
+  record.center = localizationResult.getPose().center();
+  record.rotation = localizationResult.getPose().rotation();
+  record.width = intrinsics.w();
+  record.height = intrinsics.h();
+  record.intrinsics = intrinsics.getParams();
+
+  //The statistics are the ones of the output parameters
+  OutputParamValues values;
+  getOutputParamValues(localizationResult, frameData.extractedFeatures, 1.0, values);
+  record.hasErrorStats = values.hasErrorStats;
+  record.errorMean = values.errorMean;
+  record.errorMin = values.errorMin;
+  record.errorMax = values.errorMax;
+  record.nbMatchedImages = values.nbMatchedImages;
+  record.nbDetectedFeatures = values.nbDetectedFeatures;
+  record.nbMatchedFeatures = values.nbMatchedFeatures;
+  record.nbInlierFeatures = values.nbInlierFeatures;
+}
+
+void writeTrackRecord(std::ostream &stream, const TrackRecord &record)
+{
+  //Numbers are written in full precision, the record must be read back as solved
+  std::ostringstream line;
+  line.precision(std::numeric_limits<double>::max_digits10);
+  line << "{\"time\":" << record.time
+       << ",\"camera\":" << record.camera
+       << ",\"center\":[" << record.center(0) << "," << record.center(1) << "," << record.center(2) << "]"
+       << ",\"rotation\":[";
+  for(int i = 0; i < 9; ++i)
+    line << (i ? "," : "") << record.rotation(i / 3, i % 3);
+  line << "],\"width\":" << record.width
+       << ",\"height\":" << record.height
+       << ",\"intrinsics\":[";
+  for(std::size_t i = 0; i < record.intrinsics.size(); ++i)
+    line << (i ? "," : "") << record.intrinsics[i];
+  line << "],\"stats\":{";
+  if(record.hasErrorStats)
+  {
+    line << "\"errorMean\":" << record.errorMean
+         << ",\"errorMin\":" << record.errorMin
+         << ",\"errorMax\":" << record.errorMax << ",";
+  }
+  line << "\"nbMatchedImages\":" << record.nbMatchedImages
+       << ",\"nbDetectedFeatures\":" << record.nbDetectedFeatures
+       << ",\"nbMatchedFeatures\":" << record.nbMatchedFeatures
+       << ",\"nbInlierFeatures\":" << record.nbInlierFeatures
+       << "}}\n";
+  stream << line.str();
+}
+
+bool readTrackRecord(const std::string &line, TrackRecord &record)
+{
+  namespace pt = boost::property_tree;
+  try
+  {
+    pt::ptree tree;
+    std::istringstream stream(line);
+    pt::read_json(stream, tree);
+
+    auto readArray = [&tree](const std::string &key)
+    {
+      std::vector<double> values;
+      for(const auto &child : tree.get_child(key))
+        values.push_back(child.second.get_value<double>());
+      return values;
+    };
+
+    TrackRecord newRecord;
+    newRecord.time = tree.get<double>("time");
+    newRecord.camera = tree.get<std::size_t>("camera");
+    const std::vector<double> center = readArray("center");
+    const std::vector<double> rotation = readArray("rotation");
+    if(center.size() != 3 || rotation.size() != 9)
+      return false;
+    newRecord.center = openMVG::Vec3(center[0], center[1], center[2]);
+    for(int i = 0; i < 9; ++i)
+      newRecord.rotation(i / 3, i % 3) = rotation[i];
+    newRecord.width = tree.get<std::size_t>("width");
+    newRecord.height = tree.get<std::size_t>("height");
+    newRecord.intrinsics = readArray("intrinsics");
+
+    const pt::ptree &stats = tree.get_child("stats");
+    newRecord.hasErrorStats = (stats.count("errorMean") != 0);
+    newRecord.errorMean = stats.get<double>("errorMean", 0.0);
+    newRecord.errorMin = stats.get<double>("errorMin", 0.0);
+    newRecord.errorMax = stats.get<double>("errorMax", 0.0);
+    newRecord.nbMatchedImages = stats.get<std::size_t>("nbMatchedImages", 0);
+    newRecord.nbDetectedFeatures = stats.get<std::size_t>("nbDetectedFeatures", 0);
+    newRecord.nbMatchedFeatures = stats.get<std::size_t>("nbMatchedFeatures", 0);
+    newRecord.nbInlierFeatures = stats.get<std::size_t>("nbInlierFeatures", 0);
+    record = std::move(newRecord);
+    return true;
+  }
+  catch(pt::ptree_error &)
+  {
+    return false;
+  }
+}
+
+std::size_t readTrackFile(const std::string &filePath, std::vector<TrackRecord> &records)
+{
+  std::ifstream file(filePath);
+  if(!file.is_open())
+    throw std::runtime_error("Cannot open the track file : " + filePath);
+
+  //The last record of a camera and time wins
+  std::map<std::pair<std::size_t, double>, TrackRecord> recordPerFrame;
+  std::size_t nbInvalidLines = 0;
+  std::string line;
+  while(std::getline(file, line))
+  {
+    if(line.empty())
+      continue;
+    TrackRecord record;
+    if(!readTrackRecord(line, record))
+    {
+      ++nbInvalidLines;
+      continue;
+    }
+    recordPerFrame[std::make_pair(record.camera, record.time)] = std::move(record);
+  }
+
+  records.clear();
+  records.reserve(recordPerFrame.size());
+  for(auto &frameRecord : recordPerFrame)
+    records.push_back(std::move(frameRecord.second));
+  if(nbInvalidLines > 0)
+  {
+    OFXMVG_LOG_WARNING("readTrackFile") << "invalid lines skipped"
+      << Common::kv("path", filePath)
+      << Common::kv("nbInvalidLines", nbInvalidLines);
+  }
+  return nbInvalidLines;
+}
+
+TrackFileWriter::TrackFileWriter(const std::string &filePath, bool append)
+  : _file(filePath, append ? std::ios::app : std::ios::trunc)
+{
+  if(!_file.is_open())
+    throw std::runtime_error("Cannot write the track file : " + filePath);
+}
+
+void TrackFileWriter::write(const TrackRecord &record)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  writeTrackRecord(_file, record);
+  ++_nbRecords;
+}
+
+void TrackFileWriter::flush()
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  _file.flush();
+}
+
+} //namespace Localizer
+} //namespace openMVG_ofx
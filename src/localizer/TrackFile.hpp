@@ -0,0 +1,111 @@
+#pragma once
+
+#include "CameraLocalizer.hpp"
+
+#include <openMVG/numeric/numeric.h>
+
+#include <cstddef>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace openMVG_ofx {
+namespace Localizer {
+
+/**
+ * @brief Solved camera of a frame, one line of a track file
+ * A track file is a JSON-lines file: each line is a JSON object with the record fields.
+ * The pose follows the openMVG convention: x_camera = rotation * (X - center).
+ * A frame solved again is appended again, the last record of a camera and time is the valid one.
+ */
+struct TrackRecord
+{
+  double time = 0.0;
+  std::size_t camera = 0; //input clip index
+  openMVG::Vec3 center = openMVG::Vec3::Zero();
+  openMVG::Mat3 rotation = openMVG::Mat3::Identity();
+  std::size_t width = 0;
+  std::size_t height = 0;
+  std::vector<double> intrinsics; //focal (pixel), ppx, ppy, distortion coefficients
+  bool hasErrorStats = false;
+  double errorMean = 0.0;
+  double errorMin = 0.0;
+  double errorMax = 0.0;
+  std::size_t nbMatchedImages = 0;
+  std::size_t nbDetectedFeatures = 0;
+  std::size_t nbMatchedFeatures = 0;
+  std::size_t nbInlierFeatures = 0;
+};
+
+/**
+ * @brief Build the track record of a localized camera
+ * @param[in] time
+ * @param[in] camera
+ * @param[in] frameData - with a valid localization result
+ * @param[out] record
+ */
+void getTrackRecord(double time, std::size_t camera, const FrameData &frameData, TrackRecord &record);
+
+/**
+ * @brief Write a track record as a single JSON line
+ * @param[in,out] stream
+ * @param[in] record
+ */
+void writeTrackRecord(std::ostream &stream, const TrackRecord &record);
+
+/**
+ * @brief Read a track record from a JSON line
+ * @param[in] line
+ * @param[out] record
+ * @return false if the line is not a track record
+ */
+bool readTrackRecord(const std::string &line, TrackRecord &record);
+
+/**
+ * @brief Read a track file, keeps the last record of each camera and time
+ * Throws if the file can't be opened, the invalid lines are skipped.
+ * @param[in] filePath
+ * @param[out] records - sorted by camera then time
+ * @return number of invalid lines
+ */
+std::size_t readTrackFile(const std::string &filePath, std::vector<TrackRecord> &records);
+
+/**
+ * @brief Track file written as the frames are solved
+ * The records can be written from several threads, each one is a complete line.
+ */
+class TrackFileWriter
+{
+public:
+  /**
+   * @brief Open the track file, throws if it can't be opened
+   * @param[in] filePath
+   * @param[in] append - keep the records of the previous solves
+   */
+  TrackFileWriter(const std::string &filePath, bool append);
+
+  TrackFileWriter(const TrackFileWriter&) = delete;
+  TrackFileWriter& operator=(const TrackFileWriter&) = delete;
+
+  /**
+   * @brief Append a record
+   * @param[in] record
+   */
+  void write(const TrackRecord &record);
+
+  /**
+   * @brief Write the buffered records to the file
+   */
+  void flush();
+
+  std::size_t getNbRecords() const { return _nbRecords; }
+
+private:
+  std::ofstream _file;
+  std::size_t _nbRecords = 0;
+  std::mutex _mutex;
+};
+
+} //namespace Localizer
+} //namespace openMVG_ofx
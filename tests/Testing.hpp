@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cmath>
+#include <iostream>
+
+namespace openMVG_ofx {
+namespace Testing {
+
+/**
+ * @brief Number of failed checks of the test executable
+ */
+inline int& getNbFailures()
+{
+  static int nbFailures = 0;
+  return nbFailures;
+}
+
+/**
+ * @brief Report a failed check
+ * @param[in] file
+ * @param[in] line
+ * @param[in] expression - checked expression
+ */
+inline void reportFailure(const char* file, int line, const char* expression)
+{
+  ++getNbFailures();
+  std::cerr << file << ":" << line << ": check failed: " << expression << std::endl;
+}
+
+} //namespace Testing
+} //namespace openMVG_ofx
+
+//The checks report the failure and go on, the test returns OFXMVG_TEST_RESULT() from main
+#define OFXMVG_CHECK(condition) \
+  do { if(!(condition)) openMVG_ofx::Testing::reportFailure(__FILE__, __LINE__, #condition); } while(false)
+
+#define OFXMVG_CHECK_NEAR(a, b, tolerance) \
+  OFXMVG_CHECK(std::abs((a) - (b)) <= (tolerance))
+
+#define OFXMVG_TEST_RESULT() \
+  (openMVG_ofx::Testing::getNbFailures() == 0 ? 0 : 1)
@@ -0,0 +1,82 @@
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <opencv2/highgui/highgui.hpp>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+/**
+ * @brief Render a checkerboard sequence seen by a pinhole camera without distortion
+ * 10x7 inner corners, 640x480 images, focal length 800 pixels, principal point (320, 240).
+ * Usage: makeCheckerboardSequence <outputFolder> [nbFrames]
+ * The frames are written as <outputFolder>/checkerboard.####.png, from 1.
+ */
+int main(int argc, char **argv)
+{
+  if(argc < 2 || argc > 3)
+  {
+    std::cerr << "Usage: makeCheckerboardSequence <outputFolder> [nbFrames]" << std::endl;
+    return EXIT_FAILURE;
+  }
+  const std::string outputFolder = argv[1];
+  const int nbFrames = (argc > 2) ? std::atoi(argv[2]) : 16;
+
+  //Board image: 11x8 squares with a white margin of one square
+  const int squareSize = 60;
+  const int nbSquaresX = 11;
+  const int nbSquaresY = 8;
+  cv::Mat board((nbSquaresY + 2) * squareSize, (nbSquaresX + 2) * squareSize, CV_8UC1, cv::Scalar(255));
+  for(int y = 0; y < nbSquaresY; ++y)
+  {
+    for(int x = 0; x < nbSquaresX; ++x)
+    {
+      if((x + y) % 2 == 0)
+        board(cv::Rect((x + 1) * squareSize, (y + 1) * squareSize, squareSize, squareSize)).setTo(cv::Scalar(0));
+    }
+  }
+  //Board pixel to board plane, in squares centered on the board
+  const cv::Matx33d boardToPlane(1.0 / squareSize, 0.0, -0.5 * board.cols / squareSize,
+                                 0.0, 1.0 / squareSize, -0.5 * board.rows / squareSize,
+                                 0.0, 0.0, 1.0);
+
+  //Rendered at twice the resolution then downscaled, for antialiased edges
+  const double supersampling = 2.0;
+  const cv::Size imageSize(640, 480);
+  const cv::Matx33d K(800.0 * supersampling, 0.0, 320.0 * supersampling,
+                      0.0, 800.0 * supersampling, 240.0 * supersampling,
+                      0.0, 0.0, 1.0);
+
+  for(int frame = 0; frame < nbFrames; ++frame)
+  {
+    //Tilted views around the optical axis, at various distances
+    const double phase = 2.0 * M_PI * frame / nbFrames;
+    const cv::Vec3d rotationVector(0.45 * std::sin(phase), 0.45 * std::cos(phase), 0.2 * std::sin(2.0 * phase));
+    cv::Matx33d R;
+    cv::Rodrigues(rotationVector, R);
+    const cv::Vec3d t(0.5 * std::cos(phase), 0.3 * std::sin(phase), 20.0 + 2.0 * (frame % 3));
+
+    const cv::Matx33d planeToCamera(R(0, 0), R(0, 1), t(0),
+                                    R(1, 0), R(1, 1), t(1),
+                                    R(2, 0), R(2, 1), t(2));
+    const cv::Matx33d H = K * planeToCamera * boardToPlane;
+
+    cv::Mat image;
+    cv::warpPerspective(board, image, cv::Mat(H),
+                        cv::Size(static_cast<int>(imageSize.width * supersampling), static_cast<int>(imageSize.height * supersampling)),
+                        cv::INTER_LINEAR, cv::BORDER_CONSTANT, cv::Scalar(100));
+    cv::resize(image, image, imageSize, 0.0, 0.0, cv::INTER_AREA);
+
+    char fileName[32];
+    std::snprintf(fileName, sizeof(fileName), "checkerboard.%04d.png", frame + 1);
+    const std::string filePath = outputFolder + "/" + fileName;
+    if(!cv::imwrite(filePath, image))
+    {
+      std::cerr << "Can't write " << filePath << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,121 @@
+#include "Testing.hpp"
+
+#include "lensCalibration/CeresCalibration.hpp"
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/calib3d/calib3d.hpp>
+
+#include <cmath>
+#include <vector>
+
+using namespace openMVG_ofx;
+using namespace openMVG_ofx::LensCalibration;
+
+namespace {
+
+const double kFocalLength = 800.0;
+const cv::Point2d kPrincipalPoint(330.0, 235.0);
+const double kRadialCoef1 = -0.12;
+const double kRadialCoef2 = 0.03;
+
+/**
+ * @brief Project a 9x6 pattern seen from several poses with a known lens
+ */
+void makeViews(std::vector<std::vector<cv::Point2f> >& imagePoints,
+               std::vector<std::vector<cv::Point3f> >& objectPoints,
+               std::vector<std::size_t>& inputFrames)
+{
+  std::vector<cv::Point3f> patternPoints;
+  for(int y = 0; y < 6; ++y)
+    for(int x = 0; x < 9; ++x)
+      patternPoints.emplace_back(static_cast<float>(x), static_cast<float>(y), 0.0f);
+
+  const cv::Mat cameraMatrix = (cv::Mat_<double>(3, 3) << kFocalLength, 0.0, kPrincipalPoint.x,
+                                                          0.0, kFocalLength, kPrincipalPoint.y,
+                                                          0.0, 0.0, 1.0);
+  const cv::Mat distCoeffs = (cv::Mat_<double>(5, 1) << kRadialCoef1, kRadialCoef2, 0.0, 0.0, 0.0);
+  for(std::size_t i = 0; i < 12; ++i)
+  {
+    //Tilted views at different distances, the pattern center stays in the image
+    const cv::Mat rvec = (cv::Mat_<double>(3, 1) << 0.4 * std::sin(double(i)), 0.4 * std::cos(double(i)), 0.05 * i);
+    const cv::Mat tvec = (cv::Mat_<double>(3, 1) << -4.0, -2.5, 16.0 + 0.5 * i);
+    std::vector<cv::Point2f> points;
+    cv::projectPoints(patternPoints, rvec, tvec, cameraMatrix, distCoeffs, points);
+    imagePoints.push_back(points);
+    objectPoints.push_back(patternPoints);
+    inputFrames.push_back(10 * i);
+  }
+}
+
+void testCalibration()
+{
+  std::vector<std::vector<cv::Point2f> > imagePoints;
+  std::vector<std::vector<cv::Point3f> > objectPoints;
+  std::vector<std::size_t> inputFrames;
+  makeViews(imagePoints, objectPoints, inputFrames);
+
+  CalibrationSettings settings;
+  settings.imageSize = cv::Size(640, 480);
+  settings.nbRadialCoef = 2;
+  std::size_t nbProgress = 0;
+  CalibrationResult result;
+  const bool isCalibrated = calibrateCeres(settings, 2, 0, imagePoints, objectPoints, inputFrames, result,
+    [&nbProgress](const CalibrationProgress&)
+    {
+      ++nbProgress;
+      return true;
+    });
+
+  OFXMVG_CHECK(isCalibrated);
+  OFXMVG_CHECK(result.isCalibrated);
+  OFXMVG_CHECK(nbProgress > 0);
+  OFXMVG_CHECK(result.calibInputFrames == inputFrames);
+  OFXMVG_CHECK(result.totalAvgErr < 0.01);
+  if(!result.isCalibrated)
+    return;
+  OFXMVG_CHECK_NEAR(result.cameraMatrix.at<double>(0, 0), kFocalLength, 0.5);
+  OFXMVG_CHECK_NEAR(result.cameraMatrix.at<double>(1, 1), kFocalLength, 0.5);
+  OFXMVG_CHECK_NEAR(result.cameraMatrix.at<double>(0, 2), kPrincipalPoint.x, 0.5);
+  OFXMVG_CHECK_NEAR(result.cameraMatrix.at<double>(1, 2), kPrincipalPoint.y, 0.5);
+  OFXMVG_CHECK_NEAR(result.distCoeffs.at<double>(0), kRadialCoef1, 1e-3);
+  OFXMVG_CHECK_NEAR(result.distCoeffs.at<double>(1), kRadialCoef2, 1e-3);
+  //Not estimated
+  OFXMVG_CHECK(result.distCoeffs.at<double>(2) == 0.0);
+  OFXMVG_CHECK(result.distCoeffs.at<double>(3) == 0.0);
+  OFXMVG_CHECK(result.distCoeffs.at<double>(4) == 0.0);
+}
+
+void testCancel()
+{
+  std::vector<std::vector<cv::Point2f> > imagePoints;
+  std::vector<std::vector<cv::Point3f> > objectPoints;
+  std::vector<std::size_t> inputFrames;
+  makeViews(imagePoints, objectPoints, inputFrames);
+
+  CalibrationSettings settings;
+  settings.imageSize = cv::Size(640, 480);
+  CalibrationResult result;
+  const bool isCalibrated = calibrateCeres(settings, 2, 0, imagePoints, objectPoints, inputFrames, result,
+    [](const CalibrationProgress&) { return false; });
+  OFXMVG_CHECK(!isCalibrated);
+  OFXMVG_CHECK(!result.isCalibrated);
+}
+
+void testNoView()
+{
+  CalibrationSettings settings;
+  settings.imageSize = cv::Size(640, 480);
+  CalibrationResult result;
+  OFXMVG_CHECK(!calibrateCeres(settings, 2, 0, std::vector<std::vector<cv::Point2f> >(), std::vector<std::vector<cv::Point3f> >(),
+                               std::vector<std::size_t>(), result, CalibrationCallback()));
+}
+
+} //namespace
+
+int main()
+{
+  testCalibration();
+  testCancel();
+  testNoView();
+  return OFXMVG_TEST_RESULT();
+}
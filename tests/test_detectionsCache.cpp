@@ -0,0 +1,75 @@
+#include "Testing.hpp"
+
+#include "lensCalibration/LensCalibration.hpp"
+
+#include <exception>
+#include <map>
+#include <string>
+
+using namespace openMVG_ofx;
+using namespace openMVG_ofx::LensCalibration;
+
+namespace {
+
+void testRoundTrip()
+{
+  std::map<PatternKey, PatternDetections> detectionsPerPattern;
+  PatternDetections &chessboard = detectionsPerPattern[PatternKey(int(eParamPatternTypeChessboard), 10, 7)];
+  chessboard.checkerPerFrame[1.0] = {cv::Point2f(10.25f, 20.5f), cv::Point2f(-3.125f, 1e4f)};
+  chessboard.hashPerFrame[1.0] = 0x0123456789ABCDEFu;
+  chessboard.checkerPerFrame[12.0] = {cv::Point2f(0.0f, 0.0f)};
+  chessboard.hashPerFrame[12.0] = 42;
+  PatternDetections &circles = detectionsPerPattern[PatternKey(int(eParamPatternTypeCirclesGrid), 4, 11)];
+  circles.checkerPerFrame[-5.0] = {cv::Point2f(1.0f, 2.0f), cv::Point2f(3.0f, 4.0f), cv::Point2f(5.0f, 6.0f)};
+  circles.hashPerFrame[-5.0] = ~0ull;
+
+  const std::string serialized = serializeDetections(detectionsPerPattern);
+  OFXMVG_CHECK(!serialized.empty());
+
+  std::map<PatternKey, PatternDetections> readDetections;
+  deserializeDetections(serialized, readDetections);
+  OFXMVG_CHECK(readDetections.size() == detectionsPerPattern.size());
+  for(const auto& detections : detectionsPerPattern)
+  {
+    const auto readIt = readDetections.find(detections.first);
+    OFXMVG_CHECK(readIt != readDetections.end());
+    if(readIt == readDetections.end())
+      continue;
+    //The points are stored as floats: the values are exact
+    OFXMVG_CHECK(readIt->second.checkerPerFrame == detections.second.checkerPerFrame);
+    OFXMVG_CHECK(readIt->second.hashPerFrame == detections.second.hashPerFrame);
+  }
+}
+
+void testEmpty()
+{
+  std::map<PatternKey, PatternDetections> readDetections;
+  readDetections[PatternKey(0, 1, 1)];
+  deserializeDetections(serializeDetections(std::map<PatternKey, PatternDetections>()), readDetections);
+  OFXMVG_CHECK(readDetections.empty());
+}
+
+void testInvalidData()
+{
+  std::map<PatternKey, PatternDetections> readDetections;
+  bool isThrown = false;
+  try
+  {
+    deserializeDetections("", readDetections);
+  }
+  catch(const std::exception&)
+  {
+    isThrown = true;
+  }
+  OFXMVG_CHECK(isThrown);
+}
+
+} //namespace
+
+int main()
+{
+  testRoundTrip();
+  testEmpty();
+  testInvalidData();
+  return OFXMVG_TEST_RESULT();
+}
@@ -0,0 +1,85 @@
+#include "Testing.hpp"
+
+#include "lensCalibration/LensCalibration.hpp"
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include <cstdint>
+
+using namespace openMVG_ofx;
+using namespace openMVG_ofx::LensCalibration;
+
+namespace {
+
+/**
+ * @brief Horizontal gradient, increasing from left to right
+ */
+cv::Mat makeGradient(int offset)
+{
+  cv::Mat image(480, 640, CV_8UC1);
+  for(int y = 0; y < image.rows; ++y)
+    for(int x = 0; x < image.cols; ++x)
+      image.at<unsigned char>(y, x) = static_cast<unsigned char>(offset + x * 200 / image.cols);
+  return image;
+}
+
+/**
+ * @brief Checkerboard of 40 pixels squares
+ */
+cv::Mat makeCheckerboard()
+{
+  cv::Mat image(480, 640, CV_8UC1);
+  for(int y = 0; y < image.rows; ++y)
+    for(int x = 0; x < image.cols; ++x)
+      image.at<unsigned char>(y, x) = ((x / 40 + y / 40) % 2) ? 220 : 30;
+  return image;
+}
+
+void testImageHash()
+{
+  const cv::Mat gradient = makeGradient(20);
+  const std::uint64_t hash = computeImageHash(gradient);
+  //Each pixel of the thumbnail is darker than its right neighbour
+  OFXMVG_CHECK(hash == ~std::uint64_t(0));
+  OFXMVG_CHECK(getHashDistance(hash, computeImageHash(gradient.clone())) == 0);
+
+  //A brightness change keeps the hash
+  OFXMVG_CHECK(getHashDistance(hash, computeImageHash(makeGradient(30))) == 0);
+
+  cv::Mat flippedGradient;
+  cv::flip(gradient, flippedGradient, 1);
+  const std::uint64_t flippedHash = computeImageHash(flippedGradient);
+  OFXMVG_CHECK(flippedHash == 0);
+  OFXMVG_CHECK(getHashDistance(hash, flippedHash) == 64);
+}
+
+void testHashDistance()
+{
+  OFXMVG_CHECK(getHashDistance(0, 0) == 0);
+  OFXMVG_CHECK(getHashDistance(0x0Fu, 0x00u) == 4);
+  OFXMVG_CHECK(getHashDistance(0x8000000000000001u, 0x1u) == 1);
+}
+
+void testSharpness()
+{
+  const cv::Mat image = makeCheckerboard();
+  cv::Mat blurredImage;
+  cv::GaussianBlur(image, blurredImage, cv::Size(0, 0), 4.0);
+  const double sharpness = computeSharpness(image);
+  OFXMVG_CHECK(sharpness > 0.0);
+  OFXMVG_CHECK(computeSharpness(blurredImage) < 0.1 * sharpness);
+
+  const cv::Mat uniformImage(480, 640, CV_8UC1, cv::Scalar(128));
+  OFXMVG_CHECK_NEAR(computeSharpness(uniformImage), 0.0, 1e-9);
+}
+
+} //namespace
+
+int main()
+{
+  testImageHash();
+  testHashDistance();
+  testSharpness();
+  return OFXMVG_TEST_RESULT();
+}
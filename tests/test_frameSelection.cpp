@@ -0,0 +1,106 @@
+#include "Testing.hpp"
+
+#include "lensCalibration/LensCalibration.hpp"
+
+#include <stdexcept>
+#include <vector>
+
+using namespace openMVG_ofx;
+using namespace openMVG_ofx::LensCalibration;
+
+namespace {
+
+const cv::Size kImageSize(100, 100);
+
+/**
+ * @brief Frames on a 2x2 grid of 50 pixels cells
+ */
+std::vector<std::vector<cv::Point2f> > makeFrames()
+{
+  std::vector<std::vector<cv::Point2f> > imagePoints(5);
+  imagePoints[0] = {cv::Point2f(10.f, 10.f), cv::Point2f(20.f, 20.f)}; //top left cell
+  imagePoints[1] = {cv::Point2f(10.f, 10.f), cv::Point2f(60.f, 10.f)}; //top cells
+  imagePoints[2] = {cv::Point2f(10.f, 60.f), cv::Point2f(60.f, 60.f)}; //bottom cells
+  imagePoints[3] = {cv::Point2f(-1.f, 5.f), cv::Point2f(100.f, 50.f)}; //out of the image
+  imagePoints[4] = imagePoints[1];
+  return imagePoints;
+}
+
+void testGreedySelection()
+{
+  std::vector<float> scores;
+  const std::vector<std::size_t> selected = selectCalibrationFrames(makeFrames(), kImageSize, 2, 2, &scores);
+  //Frames 1, 2 and 4 cover two cells, the tie is broken by the frame order.
+  //Frame 4 then only brings half cells, frame 2 covers two new cells.
+  OFXMVG_CHECK(selected == std::vector<std::size_t>({1, 2}));
+  OFXMVG_CHECK(scores.size() == 2);
+  if(scores.size() == 2)
+  {
+    OFXMVG_CHECK_NEAR(scores[0], 2.f, 1e-6f);
+    OFXMVG_CHECK_NEAR(scores[1], 2.f, 1e-6f);
+  }
+}
+
+void testAllFrames()
+{
+  std::vector<float> scores;
+  const std::vector<std::size_t> selected = selectCalibrationFrames(makeFrames(), kImageSize, 2, 10, &scores);
+  //The frame out of the image is never selected, the indexes are sorted
+  OFXMVG_CHECK(selected == std::vector<std::size_t>({0, 1, 2, 4}));
+  OFXMVG_CHECK(scores.size() == 4);
+  if(scores.size() == 4)
+  {
+    //Selection order: 1, 2, 4 (two cells shared once), 0 (one cell shared twice)
+    OFXMVG_CHECK_NEAR(scores[0], 1.f / 3.f, 1e-6f);
+    OFXMVG_CHECK_NEAR(scores[1], 2.f, 1e-6f);
+    OFXMVG_CHECK_NEAR(scores[2], 2.f, 1e-6f);
+    OFXMVG_CHECK_NEAR(scores[3], 1.f, 1e-6f);
+  }
+}
+
+void testEmptySelection()
+{
+  OFXMVG_CHECK(selectCalibrationFrames(makeFrames(), kImageSize, 2, 0).empty());
+  OFXMVG_CHECK(selectCalibrationFrames(std::vector<std::vector<cv::Point2f> >(), kImageSize, 2, 10).empty());
+}
+
+void testRejection()
+{
+  CalibrationFrameSelector selector(makeFrames(), kImageSize, 2);
+  OFXMVG_CHECK(selector.select(2) == 2);
+  selector.reject(1);
+  OFXMVG_CHECK(selector.getNbSelectedFrames() == 1);
+
+  //The top cells are free again: frame 4 covers both, frame 0 only one
+  std::vector<float> scores;
+  OFXMVG_CHECK(selector.select(2) == 1);
+  OFXMVG_CHECK(selector.getSelectedFrames(&scores) == std::vector<std::size_t>({2, 4}));
+  if(scores.size() == 2)
+    OFXMVG_CHECK_NEAR(scores[1], 2.f, 1e-6f);
+
+  //The rejected frame is never selected again
+  OFXMVG_CHECK(selector.select(10) == 1);
+  OFXMVG_CHECK(selector.getSelectedFrames() == std::vector<std::size_t>({0, 2, 4}));
+
+  bool isThrown = false;
+  try
+  {
+    selector.reject(1);
+  }
+  catch(const std::logic_error&)
+  {
+    isThrown = true;
+  }
+  OFXMVG_CHECK(isThrown);
+}
+
+} //namespace
+
+int main()
+{
+  testGreedySelection();
+  testAllFrames();
+  testEmptySelection();
+  testRejection();
+  return OFXMVG_TEST_RESULT();
+}
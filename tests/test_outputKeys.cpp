@@ -0,0 +1,109 @@
+#include "Testing.hpp"
+
+#include "localizer/CameraLocalizer.hpp"
+
+#include <cmath>
+#include <vector>
+
+using namespace openMVG_ofx;
+using namespace openMVG_ofx::Localizer;
+
+namespace {
+
+/**
+ * @brief One dimension values
+ */
+std::vector<openMVG::Vec> makeValues(const std::vector<double>& samples)
+{
+  std::vector<openMVG::Vec> values;
+  for(double sample : samples)
+  {
+    openMVG::Vec value(1);
+    value(0) = sample;
+    values.push_back(value);
+  }
+  return values;
+}
+
+void testUnwrapTurn()
+{
+  //The angles wrap at 180 degrees while the camera keeps turning
+  std::vector<openMVG::Vec3> rotations = {
+    openMVG::Vec3(10.0, 20.0, 170.0),
+    openMVG::Vec3(10.0, 20.0, 179.0),
+    openMVG::Vec3(10.0, 20.0, -175.0),
+    openMVG::Vec3(10.0, 20.0, -165.0)
+  };
+  unwrapEulerAngles(rotations);
+  OFXMVG_CHECK_NEAR(rotations[1](2), 179.0, 1e-9);
+  OFXMVG_CHECK_NEAR(rotations[2](2), 185.0, 1e-9);
+  OFXMVG_CHECK_NEAR(rotations[3](2), 195.0, 1e-9);
+  OFXMVG_CHECK_NEAR(rotations[3](0), 10.0, 1e-9);
+  OFXMVG_CHECK_NEAR(rotations[3](1), 20.0, 1e-9);
+}
+
+void testUnwrapAlternateDecomposition()
+{
+  //(180, 89, 180) is the rotation (0, 91, 0), the closest to the previous one
+  std::vector<openMVG::Vec3> rotations = {
+    openMVG::Vec3(0.0, 89.0, 0.0),
+    openMVG::Vec3(180.0, 89.0, 180.0)
+  };
+  unwrapEulerAngles(rotations);
+  OFXMVG_CHECK_NEAR(rotations[1](0), 0.0, 1e-9);
+  OFXMVG_CHECK_NEAR(rotations[1](1), 91.0, 1e-9);
+  OFXMVG_CHECK_NEAR(rotations[1](2), 0.0, 1e-9);
+}
+
+void testReduceConstant()
+{
+  OFXMVG_CHECK(reduceKeys(std::vector<double>(), std::vector<openMVG::Vec>(), 0.1).empty());
+  const std::vector<double> times = {0.0, 1.0, 2.0, 3.0};
+  OFXMVG_CHECK(reduceKeys(times, makeValues({5.0, 5.05, 4.95, 5.0}), 0.1) == std::vector<std::size_t>({0}));
+}
+
+void testReduceLinear()
+{
+  //Samples within the tolerance of the line are dropped
+  const std::vector<double> times = {0.0, 1.0, 2.0, 3.0, 4.0};
+  OFXMVG_CHECK(reduceKeys(times, makeValues({0.0, 1.0, 2.05, 3.0, 4.0}), 0.1) == std::vector<std::size_t>({0, 4}));
+  OFXMVG_CHECK(reduceKeys(times, makeValues({0.0, 1.0, 2.5, 3.0, 4.0}), 0.1) == std::vector<std::size_t>({0, 1, 2, 3, 4}));
+}
+
+void testReduceCorner()
+{
+  std::vector<double> times;
+  std::vector<double> samples;
+  for(int i = 0; i <= 10; ++i)
+  {
+    times.push_back(i);
+    samples.push_back(std::abs(i - 5.0));
+  }
+  OFXMVG_CHECK(reduceKeys(times, makeValues(samples), 0.01) == std::vector<std::size_t>({0, 5, 10}));
+
+  //Uneven times: the interpolation follows the times, not the indexes
+  const std::vector<double> unevenTimes = {0.0, 1.0, 4.0, 10.0};
+  OFXMVG_CHECK(reduceKeys(unevenTimes, makeValues({0.0, 1.0, 4.0, 10.0}), 0.01) == std::vector<std::size_t>({0, 3}));
+}
+
+void testReduceDimensions()
+{
+  //A key is kept if any dimension is out of the tolerance
+  const std::vector<double> times = {0.0, 1.0, 2.0};
+  std::vector<openMVG::Vec> values(3, openMVG::Vec::Zero(2));
+  values[1](1) = 1.0;
+  OFXMVG_CHECK(reduceKeys(times, values, 0.1) == std::vector<std::size_t>({0, 1, 2}));
+}
+
+} //namespace
+
+int main()
+{
+  testUnwrapTurn();
+  testUnwrapAlternateDecomposition();
+  testReduceConstant();
+  testReduceLinear();
+  testReduceCorner();
+  testReduceDimensions();
+  return OFXMVG_TEST_RESULT();
+}
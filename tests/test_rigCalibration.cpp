@@ -0,0 +1,126 @@
+#include "Testing.hpp"
+
+#include "localizer/RigCalibration.hpp"
+
+#include <openMVG/cameras/Camera_Pinhole.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace openMVG_ofx;
+using namespace openMVG_ofx::Localizer;
+
+namespace {
+
+openMVG::Mat3 getRotation(double angle, const openMVG::Vec3 &axis)
+{
+  return Eigen::AngleAxisd(angle, axis.normalized()).toRotationMatrix();
+}
+
+double getRotationAngle(const openMVG::Mat3 &rotationA, const openMVG::Mat3 &rotationB)
+{
+  const double cosAngle = 0.5 * ((rotationA * rotationB.transpose()).trace() - 1.0);
+  return std::acos(std::max(-1.0, std::min(1.0, cosAngle)));
+}
+
+void testDiverseFramesLine()
+{
+  //Camera moving along a line, same orientation
+  std::vector<openMVG::geometry::Pose3> poses;
+  for(int i = 0; i < 10; ++i)
+    poses.emplace_back(openMVG::Mat3::Identity(), openMVG::Vec3(i, 0.0, 0.0));
+
+  //From the first frame: the last one, then the middle one
+  OFXMVG_CHECK(selectDiverseFrames(poses, 3, 0) == std::vector<std::size_t>({0, 4, 9}));
+  //The seed wraps around
+  OFXMVG_CHECK(selectDiverseFrames(poses, 2, 19) == std::vector<std::size_t>({0, 9}));
+  OFXMVG_CHECK(selectDiverseFrames(poses, 20, 3).size() == poses.size());
+  OFXMVG_CHECK(selectDiverseFrames(poses, 0, 0).empty());
+  OFXMVG_CHECK(selectDiverseFrames(std::vector<openMVG::geometry::Pose3>(), 3, 0).empty());
+}
+
+void testDiverseFramesRotation()
+{
+  //Static camera: only the orientations are compared
+  std::vector<openMVG::geometry::Pose3> poses;
+  for(int i = 0; i < 7; ++i)
+    poses.emplace_back(getRotation(0.1 * i, openMVG::Vec3(0.0, 1.0, 0.0)), openMVG::Vec3(1.0, 2.0, 3.0));
+  OFXMVG_CHECK(selectDiverseFrames(poses, 3, 6) == std::vector<std::size_t>({0, 3, 6}));
+}
+
+/**
+ * @brief Observations of a secondary camera, in front of a grid of points
+ */
+void makeObservations(const openMVG::cameras::Pinhole_Intrinsic &intrinsics,
+                      const openMVG::geometry::Pose3 &relativePose,
+                      std::vector<RelativePoseObservation> &observations)
+{
+  for(int y = -4; y <= 4; ++y)
+  {
+    for(int x = -5; x <= 5; ++x)
+    {
+      RelativePoseObservation observation;
+      observation.point = openMVG::Vec3(x, y, 8.0 + 0.3 * ((x + y) % 3));
+      observation.feature = intrinsics.project(relativePose, observation.point);
+      observation.intrinsics = &intrinsics;
+      observations.push_back(observation);
+    }
+  }
+}
+
+void testRefineRelativePose()
+{
+  const openMVG::cameras::Pinhole_Intrinsic intrinsics(1920, 1080, 1500.0, 960.0, 540.0);
+  const openMVG::geometry::Pose3 relativePose(getRotation(0.2, openMVG::Vec3(0.1, 1.0, 0.0)), openMVG::Vec3(0.5, 0.02, -0.1));
+  std::vector<RelativePoseObservation> observations;
+  makeObservations(intrinsics, relativePose, observations);
+
+  double meanInlierError = -1.0;
+  getRelativePoseCost(observations, relativePose, 4.0, meanInlierError);
+  OFXMVG_CHECK_NEAR(meanInlierError, 0.0, 1e-9);
+
+  //Some outliers: the Huber weights limit their influence
+  for(std::size_t i = 0; i < observations.size(); i += 25)
+    observations[i].feature += openMVG::Vec2(60.0, -40.0);
+
+  openMVG::geometry::Pose3 pose(getRotation(0.17, openMVG::Vec3(0.0, 1.0, 0.1)), openMVG::Vec3(0.4, 0.0, 0.0));
+  std::size_t nbIterations = 0;
+  const bool isRefined = refineRelativePose(observations, 4.0, 50,
+    [&nbIterations](std::size_t, double)
+    {
+      ++nbIterations;
+      return true;
+    }, pose);
+  OFXMVG_CHECK(isRefined);
+  OFXMVG_CHECK(nbIterations > 0);
+  OFXMVG_CHECK((pose.center() - relativePose.center()).norm() < 0.02);
+  OFXMVG_CHECK(getRotationAngle(pose.rotation(), relativePose.rotation()) < 0.005);
+
+  getRelativePoseCost(observations, pose, 4.0, meanInlierError);
+  OFXMVG_CHECK(meanInlierError < 0.5);
+}
+
+void testRefineCancel()
+{
+  const openMVG::cameras::Pinhole_Intrinsic intrinsics(1920, 1080, 1500.0, 960.0, 540.0);
+  const openMVG::geometry::Pose3 relativePose(openMVG::Mat3::Identity(), openMVG::Vec3(0.5, 0.0, 0.0));
+  std::vector<RelativePoseObservation> observations;
+  makeObservations(intrinsics, relativePose, observations);
+
+  openMVG::geometry::Pose3 pose(openMVG::Mat3::Identity(), openMVG::Vec3(0.3, 0.0, 0.0));
+  OFXMVG_CHECK(!refineRelativePose(observations, 4.0, 50, [](std::size_t, double) { return false; }, pose));
+  //Nothing to refine
+  OFXMVG_CHECK(refineRelativePose(std::vector<RelativePoseObservation>(), 4.0, 50, [](std::size_t, double) { return false; }, pose));
+}
+
+} //namespace
+
+int main()
+{
+  testDiverseFramesLine();
+  testDiverseFramesRotation();
+  testRefineRelativePose();
+  testRefineCancel();
+  return OFXMVG_TEST_RESULT();
+}
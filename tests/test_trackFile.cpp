@@ -0,0 +1,161 @@
+#include "Testing.hpp"
+
+#include "localizer/TrackFile.hpp"
+
+#include <boost/filesystem.hpp>
+
+#include <exception>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace openMVG_ofx;
+using namespace openMVG_ofx::Localizer;
+
+namespace bfs = boost::filesystem;
+
+namespace {
+
+TrackRecord makeRecord(double time, std::size_t camera, double x)
+{
+  TrackRecord record;
+  record.time = time;
+  record.camera = camera;
+  record.center = openMVG::Vec3(x, 2.0 / 3.0, -1e-7);
+  record.rotation = Eigen::AngleAxisd(0.1 * time + 0.3, openMVG::Vec3(1.0, 2.0, 3.0).normalized()).toRotationMatrix();
+  record.width = 1920;
+  record.height = 1080;
+  record.intrinsics = {1500.123456789, 960.5, 540.25, -0.1};
+  record.hasErrorStats = true;
+  record.errorMean = 0.7;
+  record.errorMin = 0.01;
+  record.errorMax = 3.9;
+  record.nbMatchedImages = 4;
+  record.nbDetectedFeatures = 5000;
+  record.nbMatchedFeatures = 800;
+  record.nbInlierFeatures = 650;
+  return record;
+}
+
+void checkRecord(const TrackRecord &record, const TrackRecord &expected)
+{
+  //The doubles are written in full precision: the values are exact
+  OFXMVG_CHECK(record.time == expected.time);
+  OFXMVG_CHECK(record.camera == expected.camera);
+  OFXMVG_CHECK(record.center == expected.center);
+  OFXMVG_CHECK(record.rotation == expected.rotation);
+  OFXMVG_CHECK(record.width == expected.width);
+  OFXMVG_CHECK(record.height == expected.height);
+  OFXMVG_CHECK(record.intrinsics == expected.intrinsics);
+  OFXMVG_CHECK(record.hasErrorStats == expected.hasErrorStats);
+  OFXMVG_CHECK(record.errorMean == expected.errorMean);
+  OFXMVG_CHECK(record.errorMin == expected.errorMin);
+  OFXMVG_CHECK(record.errorMax == expected.errorMax);
+  OFXMVG_CHECK(record.nbMatchedImages == expected.nbMatchedImages);
+  OFXMVG_CHECK(record.nbDetectedFeatures == expected.nbDetectedFeatures);
+  OFXMVG_CHECK(record.nbMatchedFeatures == expected.nbMatchedFeatures);
+  OFXMVG_CHECK(record.nbInlierFeatures == expected.nbInlierFeatures);
+}
+
+void testRecordRoundTrip()
+{
+  const TrackRecord record = makeRecord(12.0, 1, 0.1);
+  std::ostringstream stream;
+  writeTrackRecord(stream, record);
+  const std::string line = stream.str();
+  OFXMVG_CHECK(!line.empty() && line.back() == '\n');
+  OFXMVG_CHECK(line.find('\n') == line.size() - 1);
+
+  TrackRecord readRecord;
+  OFXMVG_CHECK(readTrackRecord(line, readRecord));
+  checkRecord(readRecord, record);
+
+  //Without the error statistics
+  TrackRecord noStatsRecord = makeRecord(3.0, 0, -5.0);
+  noStatsRecord.hasErrorStats = false;
+  noStatsRecord.errorMean = noStatsRecord.errorMin = noStatsRecord.errorMax = 0.0;
+  std::ostringstream noStatsStream;
+  writeTrackRecord(noStatsStream, noStatsRecord);
+  OFXMVG_CHECK(readTrackRecord(noStatsStream.str(), readRecord));
+  checkRecord(readRecord, noStatsRecord);
+}
+
+void testInvalidRecords()
+{
+  TrackRecord record;
+  OFXMVG_CHECK(!readTrackRecord("", record));
+  OFXMVG_CHECK(!readTrackRecord("{\"time\":1", record));
+  OFXMVG_CHECK(!readTrackRecord("{\"time\":1,\"camera\":0}", record));
+  //Truncated rotation
+  OFXMVG_CHECK(!readTrackRecord("{\"time\":1,\"camera\":0,\"center\":[0,0,0],\"rotation\":[1,0,0],"
+                                "\"width\":1,\"height\":1,\"intrinsics\":[],\"stats\":{}}", record));
+}
+
+void testTrackFile()
+{
+  const bfs::path filePath = bfs::temp_directory_path() / bfs::unique_path("ofxMVG_testTrackFile_%%%%-%%%%.jsonl");
+
+  const TrackRecord firstSolve = makeRecord(2.0, 0, 1.0);
+  const TrackRecord secondSolve = makeRecord(2.0, 0, 1.5);
+  const TrackRecord otherCamera = makeRecord(1.0, 1, 2.0);
+  const TrackRecord earlierFrame = makeRecord(1.0, 0, 3.0);
+  {
+    TrackFileWriter writer(filePath.string(), false);
+    writer.write(firstSolve);
+    writer.write(otherCamera);
+    OFXMVG_CHECK(writer.getNbRecords() == 2);
+  }
+  {
+    //A partial line, as written by an interrupted solve
+    std::ofstream file(filePath.string(), std::ios::app);
+    file << "{\"time\":5,\"cam\n";
+  }
+  {
+    TrackFileWriter writer(filePath.string(), true);
+    writer.write(secondSolve);
+    writer.write(earlierFrame);
+    writer.flush();
+  }
+
+  std::vector<TrackRecord> records;
+  OFXMVG_CHECK(readTrackFile(filePath.string(), records) == 1);
+  //The last solve of a frame wins, sorted by camera then time
+  OFXMVG_CHECK(records.size() == 3);
+  if(records.size() == 3)
+  {
+    checkRecord(records[0], earlierFrame);
+    checkRecord(records[1], secondSolve);
+    checkRecord(records[2], otherCamera);
+  }
+
+  //Not appended: the previous records are dropped
+  {
+    TrackFileWriter writer(filePath.string(), false);
+    writer.write(otherCamera);
+  }
+  OFXMVG_CHECK(readTrackFile(filePath.string(), records) == 0);
+  OFXMVG_CHECK(records.size() == 1);
+  bfs::remove(filePath);
+
+  bool isThrown = false;
+  try
+  {
+    readTrackFile(filePath.string(), records);
+  }
+  catch(const std::exception&)
+  {
+    isThrown = true;
+  }
+  OFXMVG_CHECK(isThrown);
+}
+
+} //namespace
+
+int main()
+{
+  testRecordRoundTrip();
+  testInvalidRecords();
+  testTrackFile();
+  return OFXMVG_TEST_RESULT();
+}